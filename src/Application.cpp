@@ -2,15 +2,30 @@
 #include "gui/MainWindow.h"
 #include "core/EventManager.h"
 #include "core/Config.h"
+#include "core/ConfigWatcher.h"
 #include "core/DriverMonitor.h"
 #include <imgui.h>
 #include <imgui_impl_win32.h>
 #include <imgui_impl_dx11.h>
 #include <tchar.h>
+#include <chrono>
 
 // Forward declare message handler from imgui_impl_win32.cpp
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
+namespace {
+    // Frames rendered after a change so hover and layout settle
+    const int kFramesAfterChange = 3;
+    
+    // Idle redraw intervals
+    const DWORD kMonitoringRedrawMs = 1000;
+    const DWORD kTextInputRedrawMs = 500;
+    const DWORD kProgressRedrawMs = 100;
+    
+    // How often the configuration file is checked for changes
+    const std::chrono::milliseconds kConfigCheckInterval(1000);
+}
+
 namespace DriverMonitor {
 
 // Window procedure
@@ -43,7 +58,9 @@ Application::Application()
     , m_pd3dDevice(nullptr)
     , m_pd3dDeviceContext(nullptr)
     , m_pSwapChain(nullptr)
-    , m_mainRenderTargetView(nullptr) {
+    , m_mainRenderTargetView(nullptr)
+    , m_wakeEvent(nullptr)
+    , m_idleWakeups(0) {
 }
 
 Application::~Application() {
@@ -99,7 +116,30 @@ bool Application::Initialize(HINSTANCE hInstance) {
 }
 
 int Application::Run() {
-    // Main loop
+    // Redraw only when something changed: window input, new events or a
+    // configuration change. Producers wake the message wait through an
+    // armed one-shot listener that signals m_wakeEvent.
+    m_wakeEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    HANDLE wakeEvent = m_wakeEvent;
+    m_eventManager->GetChangeNotifier().SetListener([wakeEvent]() { SetEvent(wakeEvent); });
+    m_config->GetChangeNotifier().SetListener([wakeEvent]() { SetEvent(wakeEvent); });
+    
+    // Edits to the configuration file apply without a restart
+    m_configWatcher = std::make_unique<ConfigWatcher>();
+    m_configWatcher->Start(m_config->GetPath(), kConfigCheckInterval,
+        [this, wakeEvent](MonitorConfig& reloaded) {
+            {
+                std::lock_guard<std::mutex> lock(m_reloadMutex);
+                m_reloadedConfig = std::make_unique<MonitorConfig>(std::move(reloaded));
+            }
+            SetEvent(wakeEvent);
+        },
+        nullptr);
+    
+    uint64_t eventGeneration = m_eventManager->GetChangeGeneration();
+    uint64_t configGeneration = m_config->GetChangeGeneration();
+    int framesToRender = kFramesAfterChange;
+    
     MSG msg;
     ZeroMemory(&msg, sizeof(msg));
     
@@ -107,6 +147,29 @@ int Application::Run() {
         if (PeekMessage(&msg, nullptr, 0U, 0U, PM_REMOVE)) {
             TranslateMessage(&msg);
             DispatchMessage(&msg);
+            framesToRender = kFramesAfterChange;
+            continue;
+        }
+        
+        ApplyReloadedConfig();
+        
+        if (HasDataChanged(eventGeneration, configGeneration) && framesToRender == 0) {
+            framesToRender = 1;
+        }
+        
+        if (framesToRender == 0) {
+            // Arm before the final check so a change in between still wakes us
+            m_eventManager->GetChangeNotifier().ArmListener();
+            m_config->GetChangeNotifier().ArmListener();
+            if (HasDataChanged(eventGeneration, configGeneration)) {
+                continue;
+            }
+            
+            DWORD result = MsgWaitForMultipleObjects(1, &wakeEvent, FALSE, GetIdleTimeout(), QS_ALLINPUT);
+            m_idleWakeups++;
+            if (result == WAIT_TIMEOUT) {
+                framesToRender = 1; // Periodic content (uptime, blinking cursor)
+            }
             continue;
         }
         
@@ -126,23 +189,70 @@ int Application::Run() {
         ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
         
         m_pSwapChain->Present(1, 0); // Present with vsync
+        framesToRender--;
     }
     
     return (int)msg.wParam;
 }
 
+bool Application::HasDataChanged(uint64_t& eventGeneration, uint64_t& configGeneration) const {
+    uint64_t events = m_eventManager->GetChangeGeneration();
+    uint64_t config = m_config->GetChangeGeneration();
+    if (events == eventGeneration && config == configGeneration) {
+        return false;
+    }
+    eventGeneration = events;
+    configGeneration = config;
+    return true;
+}
+
+void Application::ApplyReloadedConfig() {
+    std::unique_ptr<MonitorConfig> reloaded;
+    {
+        std::lock_guard<std::mutex> lock(m_reloadMutex);
+        reloaded = std::move(m_reloadedConfig);
+    }
+    if (reloaded) {
+        m_driverMonitor->ApplyConfig(*reloaded);
+    }
+}
+
+DWORD Application::GetIdleTimeout() const {
+    // Export progress advances, a focused text field blinks its cursor, the uptime counter ticks each second
+    if (m_mainWindow->IsBusy()) {
+        return kProgressRedrawMs;
+    }
+    if (ImGui::GetIO().WantTextInput) {
+        return kTextInputRedrawMs;
+    }
+    return m_driverMonitor->IsMonitoring() ? kMonitoringRedrawMs : INFINITE;
+}
+
 void Application::Shutdown() {
     // Stop monitoring
     if (m_driverMonitor) {
         m_driverMonitor->Stop();
     }
     
+    // Stop hot reload before the final save (and before the wake event closes)
+    m_configWatcher.reset();
+    
     // Save configuration
     if (m_config) {
         m_config->Save();
     }
     
     // Cleanup
+    if (m_wakeEvent) {
+        if (m_eventManager) {
+            m_eventManager->GetChangeNotifier().SetListener(nullptr);
+        }
+        if (m_config) {
+            m_config->GetChangeNotifier().SetListener(nullptr);
+        }
+        CloseHandle(m_wakeEvent);
+        m_wakeEvent = nullptr;
+    }
     m_mainWindow.reset();
     m_driverMonitor.reset();
     m_config.reset();
@@ -2,7 +2,9 @@
 
 #include <d3d11.h>
 #include <Windows.h>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 
 namespace DriverMonitor {
 
@@ -10,6 +12,8 @@ class MainWindow;
 class EventManager;
 class Config;
 class DriverMonitor;
+class ConfigWatcher;
+struct MonitorConfig;
 
 class Application {
 public:
@@ -32,6 +36,9 @@ public:
     // Get window handle
     HWND GetWindowHandle() { return m_hwnd; }
     
+    // Number of times the idle loop woke up (input, data change or timeout)
+    uint64_t GetIdleWakeups() const { return m_idleWakeups; }
+    
 private:
     HWND m_hwnd;
     ID3D11Device* m_pd3dDevice;
@@ -39,12 +46,22 @@ private:
     IDXGISwapChain* m_pSwapChain;
     ID3D11RenderTargetView* m_mainRenderTargetView;
     
+    // Idle loop: signaled by the history and config change listeners
+    HANDLE m_wakeEvent;
+    uint64_t m_idleWakeups;
+    
     // Application components
     std::unique_ptr<EventManager> m_eventManager;
     std::unique_ptr<Config> m_config;
     std::unique_ptr<DriverMonitor> m_driverMonitor;
     std::unique_ptr<MainWindow> m_mainWindow;
     
+    // Hot reload: the watcher thread parks a reloaded configuration here and
+    // wakes the loop, which applies it on the UI thread
+    std::unique_ptr<ConfigWatcher> m_configWatcher;
+    std::mutex m_reloadMutex;
+    std::unique_ptr<MonitorConfig> m_reloadedConfig;
+    
     // Initialize DirectX 11
     bool CreateDeviceD3D(HWND hWnd);
     
@@ -65,6 +82,15 @@ private:
     
     // Apply dark theme
     void ApplyDarkTheme();
+    
+    // Check (and take) new history/config generations
+    bool HasDataChanged(uint64_t& eventGeneration, uint64_t& configGeneration) const;
+    
+    // Wait timeout of the idle loop
+    DWORD GetIdleTimeout() const;
+    
+    // Apply a configuration the watcher reloaded, if any
+    void ApplyReloadedConfig();
 };
 
 } // namespace DriverMonitor
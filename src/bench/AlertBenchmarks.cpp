@@ -0,0 +1,473 @@
+#include "BenchCases.h"
+#include "../core/AlertDispatcher.h"
+#include "../core/AlertThrottle.h"
+#include "../core/Clock.h"
+#include "../core/Config.h"
+#include "../core/DriverMonitor.h"
+#include "../core/EventManager.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DriverMonitor {
+
+namespace {
+    void MakeAlertConfig(Config& config, const std::string& logFile) {
+        config.GetConfig().loggingEnabled = !logFile.empty();
+        config.GetConfig().logFile = logFile;
+        config.GetConfig().playSound = false;
+        config.GetConfig().ignoreWindowsSigned = false;
+        config.GetConfig().ignoreMicrosoft = false;
+        config.GetConfig().alertsPerMinute = 0;     // Every detection alerts
+        config.GetConfig().globalAlertsPerMinute = 0;
+        config.NotifyChanged();
+    }
+
+    // Unsigned third-party drivers installed as services: stored, never alerted
+    std::vector<DriverEvent> MakeBenignEvents(size_t count) {
+        std::vector<DriverEvent> events = MakeSampleEvents(count);
+        for (auto& event : events) {
+            event.signerInfo = "Signed by Contoso Ltd";
+            event.loadingMethod = "Registry - Service Installation";
+            event.isRemoval = false;
+        }
+        return events;
+    }
+
+    DriverEvent MakeSuspiciousEvent(const std::string& name) {
+        DriverEvent event = MakeSampleEvents(1)[0];
+        event.driverName = name;
+        event.signerInfo = "Not Signed";
+        event.loadingMethod = "Manual Map";
+        event.isRemoval = false;
+        return event;
+    }
+
+    // Detections of count distinct drivers: prefix0.sys, prefix1.sys, ...
+    std::vector<DriverEvent> MakeSuspiciousEvents(const std::string& prefix, size_t count) {
+        std::vector<DriverEvent> events(count, MakeSuspiciousEvent(prefix));
+        for (size_t i = 0; i < count; ++i) {
+            events[i].driverName = prefix + std::to_string(i) + ".sys";
+        }
+        return events;
+    }
+
+    AlertThrottleOptions MakeUnlimitedThrottle() {
+        AlertThrottleOptions options;
+        options.driverPerMinute = 0;
+        options.globalPerMinute = 0;
+        return options;
+    }
+
+    // Poll until done() or the timeout; false on timeout
+    template <typename Done>
+    bool WaitFor(Done done, std::chrono::milliseconds timeout = std::chrono::milliseconds(10000)) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!done()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    // Alerts received, for a waiting benchmark thread
+    struct AlertCounter {
+        std::mutex mutex;
+        std::condition_variable received;
+        uint64_t count = 0;
+
+        void Add() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++count;
+            }
+            received.notify_all();
+        }
+
+        void WaitFor(uint64_t target) {
+            std::unique_lock<std::mutex> lock(mutex);
+            received.wait(lock, [&]() { return count >= target; });
+        }
+    };
+}
+
+bool VerifyPriorityLane(std::string& error) {
+    std::string logPath = (std::filesystem::temp_directory_path() / "drivermonitor_alert_verify.log").string();
+    std::error_code ignored;
+    std::filesystem::remove(logPath, ignored);
+
+    Config config;
+    MakeAlertConfig(config, logPath);
+    EventManager eventManager;
+    eventManager.SetMaxEvents(100000);
+    DriverMonitor monitor(&eventManager, &config);
+
+    // The pipeline is held in the callback of the first event while the
+    // flood and the detection queue up behind it
+    std::promise<void> pipelineGate;
+    std::shared_future<void> pipelineOpen = pipelineGate.get_future().share();
+    std::atomic<bool> pipelineHeld(false);
+    std::vector<std::string> storedOrder;
+    monitor.SetEventCallback([&](const DriverEvent& event) {
+        storedOrder.push_back(event.driverName);
+        pipelineHeld = true;
+        pipelineOpen.wait();
+    });
+
+    // The alert sink is held too: the pipeline must finish without it
+    std::promise<void> alertGate;
+    std::shared_future<void> alertOpen = alertGate.get_future().share();
+    std::vector<std::string> alerted;
+    bool loggedBeforeAlert = false;
+    monitor.SetAlertCallback([&](const Alert& alert) {
+        alertOpen.wait();
+        alerted.push_back(alert.event.driverName);
+        std::ifstream log(logPath);
+        std::string text((std::istreambuf_iterator<char>(log)), std::istreambuf_iterator<char>());
+        loggedBeforeAlert = text.find(alert.event.driverName) != std::string::npos;
+    });
+
+    const size_t kBefore = 5000;
+    const size_t kAfter = 500;
+    std::vector<DriverEvent> benign = MakeBenignEvents(1 + kBefore + kAfter);
+    monitor.StartIngestion();
+    monitor.SubmitObservation(DriverEvent(benign[0]), true);
+    if (!WaitFor([&]() { return pipelineHeld.load(); })) {
+        error = "pipeline never stored the first event";
+        return false;
+    }
+    for (size_t i = 1; i <= kBefore; ++i) {
+        monitor.SubmitObservation(DriverEvent(benign[i]), true);
+    }
+    monitor.SubmitObservation(MakeSuspiciousEvent("detected.sys"), true);
+    for (size_t i = kBefore + 1; i < benign.size(); ++i) {
+        monitor.SubmitObservation(DriverEvent(benign[i]), true);
+    }
+    PipelineStats held = monitor.GetPipelineStats();
+    pipelineGate.set_value();
+
+    uint64_t total = benign.size() + 1;
+    bool drained = WaitFor([&]() { return monitor.GetPipelineStats().processed == total; });
+    alertGate.set_value();
+    monitor.Stop();
+    PipelineStats stats = monitor.GetPipelineStats();
+    if (held.queueDepth != kBefore + kAfter || held.priorityQueueDepth != 1) {
+        error = "pipeline stats reported " + std::to_string(held.queueDepth) + " bulk and " +
+                std::to_string(held.priorityQueueDepth) + " priority observations waiting";
+        return false;
+    }
+
+    std::ifstream log(logPath);
+    size_t logLines = static_cast<size_t>(std::count(std::istreambuf_iterator<char>(log), std::istreambuf_iterator<char>(), '\n'));
+    log.close();
+    std::filesystem::remove(logPath, ignored);
+
+    if (!drained) {
+        error = "pipeline waited for a held alert sink";
+        return false;
+    }
+    auto position = std::find(storedOrder.begin(), storedOrder.end(), "detected.sys") - storedOrder.begin();
+    if (position != 1 || storedOrder.size() != total) {
+        error = "detection was stored at position " + std::to_string(position) + ", behind the bulk queue";
+        return false;
+    }
+    if (stats.prioritized != 1 || stats.alerts != 1 || alerted.size() != 1 || alerted[0] != "detected.sys" ||
+        stats.alert.count != 1) {
+        error = "expected one alert for the detection, got " + std::to_string(stats.alerts);
+        return false;
+    }
+    if (!loggedBeforeAlert || logLines != total) {
+        error = "detection was not in the log before its alert, or the log has " + std::to_string(logLines) +
+                " lines, expected " + std::to_string(total);
+        return false;
+    }
+
+    // A full alert queue drops and counts instead of blocking
+    AlertDispatcher dispatcher;
+    std::promise<void> sinkGate;
+    std::shared_future<void> sinkOpen = sinkGate.get_future().share();
+    dispatcher.Start([&](const Alert&) { sinkOpen.wait(); }, MakeUnlimitedThrottle(), 4);
+    DriverEvent suspicious = MakeSuspiciousEvent("storm.sys");
+    auto now = std::chrono::steady_clock::now();
+    size_t accepted = 0;
+    for (int i = 0; i < 20; ++i) {
+        accepted += dispatcher.Submit(suspicious, now) ? 1 : 0;
+    }
+    sinkGate.set_value();
+    dispatcher.Stop();
+    AlertStats alertStats = dispatcher.GetStats();
+    if (accepted < 4 || accepted > 8 || alertStats.dropped != 20 - accepted || alertStats.delivered != accepted) {
+        error = "alert queue of 4 accepted " + std::to_string(accepted) + " of 20 alerts";
+        return false;
+    }
+    return true;
+}
+
+bool VerifyAlertThrottle(std::string& error) {
+    AlertThrottleOptions options;
+    options.driverPerMinute = 6;            // One token per 10 seconds
+    options.driverBurst = 2;
+    options.globalPerMinute = 0;
+    options.quietMicros = 5000000;
+    options.maxDelayMicros = 60000000;
+    options.maxDrivers = 8;
+    VirtualClock clock(1000);
+    AlertThrottle throttle(options);
+    std::vector<AlertSummary> summaries;
+
+    // A burst, then everything for that driver (any case) is suppressed
+    DriverEvent storm = MakeSuspiciousEvent("storm.sys");
+    DriverEvent upper = MakeSuspiciousEvent("STORM.SYS");
+    int admitted = 0;
+    for (int i = 0; i < 10; ++i) {
+        admitted += throttle.Admit(i == 5 ? upper : storm, clock.NowMicros()) ? 1 : 0;
+        clock.Advance(100000);
+    }
+    int64_t last = clock.NowMicros() - 100000;
+    uint64_t allocations = GetAllocationCount();
+    bool suppressed = !throttle.Admit(storm, last);
+    if (admitted != 2 || !suppressed || GetAllocationCount() != allocations || throttle.GetSuppressed() != 9) {
+        error = "per-driver bucket admitted " + std::to_string(admitted) + " of 10, or suppressing allocated";
+        return false;
+    }
+
+    // Summarized once quiet for the period, with every suppressed alert
+    if (throttle.GetNextDeadline() != last + options.quietMicros ||
+        throttle.CollectDue(last + options.quietMicros - 1, summaries) != 0 ||
+        throttle.CollectDue(last + options.quietMicros, summaries) != 1) {
+        error = "driver summary was not due after the quiet period";
+        return false;
+    }
+    Alert summary;
+    summary.event = summaries[0].event;
+    summary.similar = summaries[0].count;
+    summary.drivers = summaries[0].drivers;
+    summary.spanMicros = summaries[0].lastMicros - summaries[0].firstMicros;
+    if (summary.similar != 9 || summary.drivers != 1 || summary.spanMicros != 700000 ||
+        summary.Describe() != "storm.sys: 9 similar events in 1 second" || throttle.GetPending() != 0) {
+        error = "driver summary reads '" + summary.Describe() + "'";
+        return false;
+    }
+
+    // The bucket refills at its rate: the next token 10 s after the first was taken
+    int64_t refilled = 1000 + 10000000;
+    if (throttle.Admit(storm, refilled - 1000) || !throttle.Admit(storm, refilled + 1000) ||
+        throttle.Admit(storm, refilled + 2000)) {
+        error = "per-driver bucket did not refill one token per 10 seconds";
+        return false;
+    }
+
+    // The global bucket caps alerts across drivers; the rest share one summary
+    options.globalPerMinute = 60;
+    options.globalBurst = 5;
+    throttle.Reset(options);
+    summaries.clear();
+    admitted = 0;
+    for (const auto& bulk : MakeSuspiciousEvents("bulk", 20)) {
+        admitted += throttle.Admit(bulk, 0) ? 1 : 0;
+    }
+    size_t collected = throttle.CollectDue(options.quietMicros, summaries);
+    summary = Alert();
+    summary.similar = collected == 1 ? summaries[0].count : 0;
+    summary.drivers = collected == 1 ? summaries[0].drivers : 0;
+    if (admitted != 5 || collected != 1 || summary.Describe() != "15 similar events from 15 drivers in 1 second") {
+        error = "global bucket admitted " + std::to_string(admitted) + " of 20, summary '" + summary.Describe() + "'";
+        return false;
+    }
+
+    // A storm that never goes quiet is still summarized, every maximum delay
+    options.globalPerMinute = 0;
+    options.maxDelayMicros = 30000000;
+    throttle.Reset(options);
+    summaries.clear();
+    for (int64_t second = 0; second < 100; ++second) {
+        throttle.Admit(storm, second * 1000000);
+        throttle.CollectDue(second * 1000000, summaries);
+    }
+    throttle.Flush(100000000, summaries);
+    uint64_t total = 0;
+    for (const auto& pending : summaries) {
+        total += pending.count;
+    }
+    if (summaries.size() < 4 || total != throttle.GetSuppressed() ||
+        summaries[0].lastMicros - summaries[0].firstMicros > options.maxDelayMicros) {
+        error = "endless storm gave " + std::to_string(summaries.size()) + " summaries of " + std::to_string(total) + " alerts";
+        return false;
+    }
+
+    // A flood of distinct drivers: state stays bounded, alerts and summaries
+    // stay within the global rate, and no suppressed alert is lost
+    options.driverPerMinute = 6;
+    options.globalPerMinute = 60;
+    options.globalBurst = 10;
+    options.quietMicros = 1000000;
+    options.maxDelayMicros = 10000000;
+    options.maxDrivers = 64;
+    throttle.Reset(options);
+    summaries.clear();
+    std::vector<DriverEvent> flood = MakeSuspiciousEvents("flood", 5000);
+    const uint64_t kFlood = 1000000;
+    size_t maxTracked = 0;
+    int64_t now = 0;
+    for (uint64_t i = 0; i < kFlood; ++i, now += 10) {
+        throttle.Admit(flood[i % flood.size()], now);
+        if (i % 1000 == 0) {
+            throttle.CollectDue(now, summaries);
+            maxTracked = std::max(maxTracked, throttle.GetTrackedDrivers());
+        }
+    }
+    uint64_t raised = throttle.GetAdmitted() + summaries.size();
+    uint64_t summarized = 0;
+    for (const auto& pending : summaries) {
+        summarized += pending.count;
+    }
+    if (throttle.GetPending() != throttle.GetSuppressed() - summarized) {
+        error = "throttle pending count drifted from its summaries";
+        return false;
+    }
+    throttle.Flush(now, summaries);
+    total = 0;
+    for (const auto& pending : summaries) {
+        total += pending.count;
+    }
+    if (maxTracked > options.maxDrivers || throttle.GetAdmitted() + throttle.GetSuppressed() != kFlood ||
+        total != throttle.GetSuppressed() || throttle.GetPending() != 0 || raised > 30) {
+        error = "flood tracked " + std::to_string(maxTracked) + " drivers, raised " + std::to_string(raised) +
+                " alerts and summaries, summarized " + std::to_string(total) + " of " +
+                std::to_string(throttle.GetSuppressed()) + " suppressed";
+        return false;
+    }
+
+    // The dispatcher raises the burst at once and the rest as a summary at Stop
+    AlertThrottleOptions limited;
+    limited.driverPerMinute = 1;
+    limited.driverBurst = 3;
+    limited.globalPerMinute = 0;
+    limited.quietMicros = 60000000;
+    AlertDispatcher dispatcher;
+    std::vector<Alert> delivered;
+    dispatcher.Start([&](const Alert& alert) { delivered.push_back(alert); }, limited);
+    for (int i = 0; i < 50; ++i) {
+        dispatcher.Submit(storm, std::chrono::steady_clock::now());
+    }
+    dispatcher.Stop();
+    AlertStats stats = dispatcher.GetStats();
+    if (delivered.size() != 4 || delivered[2].IsSummary() || delivered[3].similar != 47 ||
+        stats.suppressed != 47 || stats.summaries != 1 || stats.delivered != 4 || stats.pending != 0) {
+        error = "dispatcher delivered " + std::to_string(delivered.size()) + " alerts for a storm of 50";
+        return false;
+    }
+
+    // The monitor reads its limits from the configuration
+    Config config;
+    MakeAlertConfig(config, std::string());
+    config.GetConfig().alertsPerMinute = 1;
+    config.GetConfig().alertBurst = 2;
+    config.NotifyChanged();
+    EventManager eventManager;
+    DriverMonitor monitor(&eventManager, &config);
+    std::vector<Alert> alerts;
+    monitor.SetAlertCallback([&](const Alert& alert) { alerts.push_back(alert); });
+    monitor.StartIngestion();
+    for (int i = 0; i < 30; ++i) {
+        monitor.SubmitObservation(MakeSuspiciousEvent("bulk.sys"), true);
+    }
+    monitor.Stop();
+    PipelineStats pipeline = monitor.GetPipelineStats();
+    if (alerts.size() != 3 || !alerts[2].IsSummary() || alerts[2].similar != 28 || pipeline.alertsSuppressed != 28 ||
+        pipeline.alertSummaries != 1 || pipeline.alerts != 3 || pipeline.alert.count != 2) {
+        error = "monitor raised " + std::to_string(alerts.size()) + " alerts for 30 detections of one driver";
+        return false;
+    }
+    return true;
+}
+
+void RunAlertBenchmarks(BenchmarkRunner& runner) {
+    // Detection submitted until its alert is delivered: idle, then with a
+    // producer flooding benign events as fast as the queue takes them
+    for (bool flood : { false, true }) {
+        const char* name = flood ? "Alert/LatencyUnderFlood" : "Alert/Latency";
+        if (!runner.IsSelected(name)) {
+            continue;
+        }
+        Config config;
+        MakeAlertConfig(config, std::string());
+        EventManager eventManager;
+        eventManager.SetMaxEvents(1000);
+        DriverMonitor monitor(&eventManager, &config);
+        AlertCounter alerts;
+        monitor.SetAlertCallback([&](const Alert&) { alerts.Add(); });
+        monitor.StartIngestion();
+
+        std::atomic<bool> stopFlood(false);
+        std::thread producer;
+        if (flood) {
+            producer = std::thread([&]() {
+                std::vector<DriverEvent> benign = MakeBenignEvents(4096);
+                for (size_t i = 0; !stopFlood; ++i) {
+                    monitor.SubmitObservation(DriverEvent(benign[i % benign.size()]), true);
+                }
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+
+        DriverEvent suspicious = MakeSuspiciousEvent("detected.sys");
+        uint64_t raised = 0;
+        runner.RunLatency(name, 2000, [&](uint64_t) {
+            monitor.SubmitObservation(DriverEvent(suspicious), true);
+            alerts.WaitFor(++raised);
+        });
+
+        stopFlood = true;
+        if (producer.joinable()) {
+            producer.join();
+        }
+        monitor.Stop();
+    }
+
+    // Per alert during a storm: one driver over its limit, and distinct
+    // drivers beyond the tracked ones (each forgets the oldest)
+    AlertThrottle throttle;
+    DriverEvent storm = MakeSuspiciousEvent("storm.sys");
+    int64_t now = 0;
+    runner.Run("Alert/Throttle/Storm", [&](uint64_t iterations) {
+        uint64_t admitted = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            admitted += throttle.Admit(storm, now++) ? 1 : 0;
+        }
+        KeepAlive(admitted);
+    });
+
+    std::vector<DriverEvent> flood = MakeSuspiciousEvents("flood", 4 * AlertThrottleOptions().maxDrivers);
+    runner.Run("Alert/Throttle/Flood", [&](uint64_t iterations) {
+        uint64_t admitted = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            admitted += throttle.Admit(flood[i % flood.size()], now++) ? 1 : 0;
+        }
+        KeepAlive(admitted);
+    });
+
+    // Dispatcher submission of a suppressed alert (the pipeline's cost)
+    AlertDispatcher dispatcher;
+    AlertCounter alerts;
+    dispatcher.Start([&](const Alert&) { alerts.Add(); });
+    runner.Run("Alert/Submit/Suppressed", [&](uint64_t iterations) {
+        auto detected = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            dispatcher.Submit(storm, detected);
+        }
+    });
+    dispatcher.Stop();
+}
+
+} // namespace DriverMonitor
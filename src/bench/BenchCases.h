@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Benchmark.h"
+#include "../core/Utils.h"
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Classified synthetic events (deterministic for a given count)
+std::vector<DriverEvent> MakeSampleEvents(size_t count);
+
+class EventManager;
+
+// Add count classified synthetic events (10% of them with distinct names)
+void FillEventManager(EventManager& eventManager, size_t count);
+
+// Self-checks of incremental structures against brute force; false + error on mismatch
+bool VerifyEventViewModel(std::string& error);
+bool VerifyEventLookup(std::string& error);
+bool VerifySyntheticSource(std::string& error);
+bool VerifyChangeNotifier(std::string& error);
+bool VerifyConfig(std::string& error);
+bool VerifyConfigSnapshots(std::string& error);
+bool VerifyEventExporter(std::string& error);
+bool VerifyLatencyHistogram(std::string& error);
+bool VerifyMetrics(std::string& error);
+bool VerifyTrace(std::string& error);
+bool VerifyMemoryAccounting(std::string& error);
+bool VerifyForwarder(std::string& error);
+bool VerifyFleetCollector(std::string& error);
+bool VerifyFilterExpression(std::string& error);
+bool VerifyProcessInfo(std::string& error);
+bool VerifyPriorityLane(std::string& error);
+bool VerifyAlertThrottle(std::string& error);
+bool VerifyDirectorySnapshot(std::string& error);
+bool VerifyKnownDriverSet(std::string& error);
+bool VerifyPollScheduler(std::string& error);
+
+// Benchmark groups
+void RunEventManagerBenchmarks(BenchmarkRunner& runner);
+void RunUtilsBenchmarks(BenchmarkRunner& runner);
+void RunConfigBenchmarks(BenchmarkRunner& runner);
+void RunViewBenchmarks(BenchmarkRunner& runner);
+void RunExportBenchmarks(BenchmarkRunner& runner);
+void RunPipelineBenchmarks(BenchmarkRunner& runner);
+void RunMetricsBenchmarks(BenchmarkRunner& runner);
+void RunForwardBenchmarks(BenchmarkRunner& runner);
+void RunCollectorBenchmarks(BenchmarkRunner& runner);
+void RunFilterBenchmarks(BenchmarkRunner& runner);
+void RunProcessBenchmarks(BenchmarkRunner& runner);
+void RunAlertBenchmarks(BenchmarkRunner& runner);
+void RunSourceBenchmarks(BenchmarkRunner& runner);
+
+} // namespace DriverMonitor
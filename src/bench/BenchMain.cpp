@@ -0,0 +1,96 @@
+// Headless microbenchmarks over the core library; prints JSON results.
+
+#include "BenchCases.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace DriverMonitor;
+
+namespace {
+
+void PrintUsage() {
+    std::cerr <<
+        "Usage: DriverMonitorBench [options]\n"
+        "  --filter TEXT     run only benchmarks whose name contains TEXT\n"
+        "  --min-batch-ms N  minimum duration of one timed batch (default 50)\n"
+        "  --repetitions N   timed batches per benchmark (default 5)\n"
+        "  --output FILE     write JSON to FILE instead of stdout\n"
+        "  --no-verify       skip the self-checks run before the benchmarks\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchmarkRunner runner;
+    std::string outputFile;
+    bool verify = true;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-verify") {
+            verify = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            PrintUsage();
+            return 2;
+        }
+        const char* value = argv[++i];
+
+        if (arg == "--filter") runner.SetFilter(value);
+        else if (arg == "--min-batch-ms") runner.SetMinBatchTime(std::chrono::milliseconds(std::atoi(value)));
+        else if (arg == "--repetitions") runner.SetRepetitions(std::atoi(value));
+        else if (arg == "--output") outputFile = value;
+        else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    // Incremental structures are checked against brute force before timing them
+    if (verify) {
+        std::string error;
+        if (!VerifyEventViewModel(error) || !VerifyEventLookup(error) ||
+            !VerifyChangeNotifier(error) || !VerifyConfig(error) ||
+            !VerifyConfigSnapshots(error) || !VerifyEventExporter(error) ||
+            !VerifyLatencyHistogram(error) || !VerifyMetrics(error) ||
+            !VerifyTrace(error) || !VerifyMemoryAccounting(error) ||
+            !VerifyForwarder(error) || !VerifyFleetCollector(error) ||
+            !VerifyFilterExpression(error) || !VerifyProcessInfo(error) ||
+            !VerifyPriorityLane(error) || !VerifyAlertThrottle(error) ||
+            !VerifyDirectorySnapshot(error) || !VerifyKnownDriverSet(error) ||
+            !VerifyPollScheduler(error) || !VerifySyntheticSource(error)) {
+            std::cerr << "Self-check failed: " << error << "\n";
+            return 1;
+        }
+    }
+
+    RunEventManagerBenchmarks(runner);
+    RunUtilsBenchmarks(runner);
+    RunConfigBenchmarks(runner);
+    RunViewBenchmarks(runner);
+    RunExportBenchmarks(runner);
+    RunPipelineBenchmarks(runner);
+    RunMetricsBenchmarks(runner);
+    RunForwardBenchmarks(runner);
+    RunCollectorBenchmarks(runner);
+    RunFilterBenchmarks(runner);
+    RunProcessBenchmarks(runner);
+    RunAlertBenchmarks(runner);
+    RunSourceBenchmarks(runner);
+
+    if (outputFile.empty()) {
+        runner.WriteJson(std::cout);
+        return 0;
+    }
+
+    std::ofstream output(outputFile);
+    if (!output.is_open()) {
+        std::cerr << "Cannot open " << outputFile << "\n";
+        return 1;
+    }
+    runner.WriteJson(output);
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <new>
+
+namespace {
+    std::atomic<uint64_t> g_allocationCount(0);
+}
+
+// Counting replacements of the global allocation functions (array, nothrow
+// and sized forms forward to these by default)
+void* operator new(std::size_t size) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+namespace DriverMonitor {
+
+namespace {
+    // Benchmark names are plain ASCII identifiers; escape the JSON specials anyway
+    std::string EscapeJson(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+}
+
+uint64_t GetAllocationCount() {
+    return g_allocationCount.load(std::memory_order_relaxed);
+}
+
+BenchmarkRunner::BenchmarkRunner()
+    : m_minBatchTime(50)
+    , m_repetitions(5) {
+}
+
+bool BenchmarkRunner::IsSelected(const std::string& name) const {
+    return m_filter.empty() || name.find(m_filter) != std::string::npos;
+}
+
+void BenchmarkRunner::AddResult(const std::string& name, uint64_t iterations, std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.repetitions = static_cast<int>(samples.size());
+    result.nsPerOp = samples[samples.size() / 2];
+    result.minNsPerOp = samples.front();
+    result.maxNsPerOp = samples.back();
+    result.p99NsPerOp = 0;
+    m_results.push_back(result);
+}
+
+void BenchmarkRunner::AddLatencyResult(const std::string& name, std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = samples.size();
+    result.repetitions = 1;
+    result.nsPerOp = samples[samples.size() / 2];
+    result.minNsPerOp = samples.front();
+    result.maxNsPerOp = samples.back();
+    result.p99NsPerOp = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    m_results.push_back(result);
+}
+
+void BenchmarkRunner::WriteJson(std::ostream& out) const {
+    char date[32] = "";
+    time_t now = time(nullptr);
+    struct tm timeInfo;
+#ifdef _WIN32
+    gmtime_s(&timeInfo, &now);
+#else
+    gmtime_r(&now, &timeInfo);
+#endif
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", &timeInfo);
+
+    out << std::fixed << std::setprecision(2);
+    out << "{\n"
+        << "  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+#if defined(_MSC_VER)
+        << "    \"compiler\": \"msvc " << _MSC_VER << "\",\n"
+#elif defined(__clang__)
+        << "    \"compiler\": \"clang " << __clang_major__ << "." << __clang_minor__ << "\",\n"
+#elif defined(__GNUC__)
+        << "    \"compiler\": \"gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "\",\n"
+#endif
+#ifdef NDEBUG
+        << "    \"optimized\": true,\n"
+#else
+        << "    \"optimized\": false,\n"
+#endif
+        << "    \"minBatchMs\": " << m_minBatchTime.count() << ",\n"
+        << "    \"repetitions\": " << m_repetitions << "\n"
+        << "  },\n"
+        << "  \"benchmarks\": [\n";
+
+    for (size_t i = 0; i < m_results.size(); ++i) {
+        const BenchmarkResult& result = m_results[i];
+        out << "    { \"name\": \"" << EscapeJson(result.name) << "\""
+            << ", \"iterations\": " << result.iterations
+            << ", \"nsPerOp\": " << result.nsPerOp
+            << ", \"minNsPerOp\": " << result.minNsPerOp
+            << ", \"maxNsPerOp\": " << result.maxNsPerOp;
+        if (result.p99NsPerOp > 0) {
+            out << ", \"p99NsPerOp\": " << result.p99NsPerOp;
+        }
+        out << " }"
+            << (i + 1 < m_results.size() ? ",\n" : "\n");
+    }
+
+    out << "  ]\n"
+        << "}\n";
+}
+
+} // namespace DriverMonitor
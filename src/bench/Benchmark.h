@@ -0,0 +1,129 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Keep a computed value alive so the optimizer cannot drop the benchmarked work
+template <typename T>
+inline void KeepAlive(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Number of global operator new calls so far (the bench replaces operator new)
+uint64_t GetAllocationCount();
+
+// Result of one benchmark case
+struct BenchmarkResult {
+    std::string name;
+    uint64_t iterations;        // Operations per repetition
+    int repetitions;
+    double nsPerOp;             // Median over repetitions
+    double minNsPerOp;
+    double maxNsPerOp;
+    double p99NsPerOp;          // Latency cases only (0 otherwise)
+};
+
+// Minimal calibrated benchmark runner.
+// Each case body performs `iterations` operations; the runner grows the
+// iteration count until one batch takes at least the minimum batch time,
+// then times several repetitions and reports the median cost per operation.
+class BenchmarkRunner {
+public:
+    BenchmarkRunner();
+
+    // Only run cases whose name contains filter
+    void SetFilter(const std::string& filter) { m_filter = filter; }
+
+    // Minimum duration of one timed batch
+    void SetMinBatchTime(std::chrono::milliseconds time) { m_minBatchTime = time; }
+
+    void SetRepetitions(int repetitions) { m_repetitions = repetitions > 0 ? repetitions : 1; }
+
+    // Check if a case is selected by the filter (skip expensive setup otherwise)
+    bool IsSelected(const std::string& name) const;
+
+    // Run a case; body(iterations) must perform that many operations
+    template <typename Body>
+    void Run(const std::string& name, Body body);
+
+    // Time count individual calls body(i) and report their latency distribution:
+    // nsPerOp is the median call, p99NsPerOp and maxNsPerOp the tail
+    template <typename Body>
+    void RunLatency(const std::string& name, size_t count, Body body);
+
+    const std::vector<BenchmarkResult>& GetResults() const { return m_results; }
+
+    // Write all results as a JSON document
+    void WriteJson(std::ostream& out) const;
+
+private:
+    std::string m_filter;
+    std::chrono::milliseconds m_minBatchTime;
+    int m_repetitions;
+    std::vector<BenchmarkResult> m_results;
+
+    void AddResult(const std::string& name, uint64_t iterations, std::vector<double>& samples);
+    void AddLatencyResult(const std::string& name, std::vector<double>& samples);
+};
+
+template <typename Body>
+void BenchmarkRunner::Run(const std::string& name, Body body) {
+    if (!IsSelected(name)) {
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    // Calibrate
+    uint64_t iterations = 1;
+    for (;;) {
+        auto start = Clock::now();
+        body(iterations);
+        auto elapsed = Clock::now() - start;
+        if (elapsed >= m_minBatchTime || iterations >= (1ULL << 40)) {
+            break;
+        }
+        iterations *= elapsed * 10 < m_minBatchTime ? 10 : 2;
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < m_repetitions; ++i) {
+        auto start = Clock::now();
+        body(iterations);
+        auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        samples.push_back(elapsed / static_cast<double>(iterations));
+    }
+
+    AddResult(name, iterations, samples);
+}
+
+template <typename Body>
+void BenchmarkRunner::RunLatency(const std::string& name, size_t count, Body body) {
+    if (!IsSelected(name) || count == 0) {
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<double> samples;
+    samples.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto start = Clock::now();
+        body(i);
+        samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+
+    AddLatencyResult(name, samples);
+}
+
+} // namespace DriverMonitor
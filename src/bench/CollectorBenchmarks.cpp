@@ -0,0 +1,511 @@
+#include "BenchCases.h"
+#include "../core/EventForwarder.h"
+#include "../core/FleetCollector.h"
+#include "../core/FleetSimulator.h"
+#include "../core/FleetStore.h"
+#include "../core/Socket.h"
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DriverMonitor {
+
+namespace {
+    // Brute-force aggregate of one driver
+    struct ExpectedDriver {
+        int64_t firstSeenUs = 0;
+        std::string firstHost;
+        std::set<std::string> hosts;
+        uint64_t events = 0;
+        uint64_t suspicious = 0;
+        ThreatLevel maxThreat = ThreatLevel::Low;
+    };
+
+    void AddExpected(std::map<std::string, ExpectedDriver>& expected, const std::string& host,
+                     const DriverEvent& event) {
+        auto inserted = expected.emplace(event.driverName, ExpectedDriver());
+        ExpectedDriver& driver = inserted.first->second;
+        if (inserted.second || event.timestampUs < driver.firstSeenUs) {
+            driver.firstSeenUs = event.timestampUs;
+            driver.firstHost = host;
+        }
+        driver.hosts.insert(host);
+        driver.events++;
+        if (event.eventType == EventType::Suspicious || event.threatLevel == ThreatLevel::High) {
+            driver.suspicious++;
+        }
+        driver.maxThreat = std::max(driver.maxThreat, event.threatLevel);
+    }
+
+    bool Matches(const std::string& name, const ExpectedDriver& expected, const FleetDriverSummary& summary) {
+        return summary.driverName == name && summary.firstSeenUs == expected.firstSeenUs &&
+               summary.firstHost == expected.firstHost && summary.hostsAffected == expected.hosts.size() &&
+               summary.events == expected.events && summary.suspiciousEvents == expected.suspicious &&
+               summary.maxThreat == expected.maxThreat;
+    }
+
+    // Read frames until the collector acknowledges sequence of stream; false
+    // if the connection closed or nothing came in time
+    bool WaitForAck(intptr_t socket, ForwardFrameReader& reader, uint64_t stream, uint64_t sequence) {
+        char buffer[4096];
+        for (;;) {
+            const char* payload;
+            size_t length;
+            uint64_t ackStream;
+            uint64_t ackSequence;
+            while (reader.Next(payload, length)) {
+                if (EventForwarder::DecodeAck(payload, length, ackStream, ackSequence) && ackStream == stream &&
+                    ackSequence >= sequence) {
+                    return true;
+                }
+            }
+            if (!Socket::WaitReadable(socket, std::chrono::milliseconds(5000))) {
+                return false;
+            }
+            int received = Socket::Receive(socket, buffer, sizeof(buffer));
+            if (received <= 0) {
+                return false;
+            }
+            reader.Append(buffer, static_cast<size_t>(received));
+        }
+    }
+
+    // True if the collector closed the connection
+    bool WaitForClose(intptr_t socket) {
+        char buffer[256];
+        return Socket::WaitReadable(socket, std::chrono::milliseconds(5000)) &&
+               Socket::Receive(socket, buffer, sizeof(buffer)) <= 0;
+    }
+
+    intptr_t ConnectHost(uint16_t port, const std::string& hostName) {
+        std::string error;
+        intptr_t socket = Socket::Connect("127.0.0.1", port, std::chrono::milliseconds(2000),
+                                          std::chrono::milliseconds(2000), error);
+        if (socket == Socket::kNoSocket) {
+            return socket;
+        }
+        std::string hello;
+        EventForwarder::EncodeHello(hostName, hello);
+        if (!Socket::SendAll(socket, hello.data(), hello.size())) {
+            Socket::Close(socket);
+            return Socket::kNoSocket;
+        }
+        return socket;
+    }
+
+    template <typename Condition>
+    bool WaitUntil(Condition condition, std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return true;
+    }
+
+    bool VerifyInPlaceDecode(std::string& error) {
+        std::vector<DriverEvent> events = MakeSampleEvents(64);
+        for (size_t i = 0; i < events.size(); ++i) {
+            events[i].sequenceId = i + 1;
+        }
+        for (bool compress : { false, true }) {
+            std::string frame;
+            EventForwarder::EncodeBatch(7, 3, events, compress, frame);
+            const char* payload = frame.data() + 4;
+            size_t length = frame.size() - 4;
+
+            std::string scratch;
+            ForwardBatchReader reader;
+            if (!reader.Open(payload, length, scratch) || reader.GetStream() != 7 || reader.GetSequence() != 3 ||
+                reader.GetEventCount() != events.size()) {
+                error = "batch reader rejected a valid batch header";
+                return false;
+            }
+            // Raw batches are read where they are; compressed ones where they were inflated to
+            const char* begin = compress ? scratch.data() : payload;
+            const char* end = begin + (compress ? scratch.size() : length);
+            ForwardEventView view;
+            size_t count = 0;
+            while (reader.Next(view)) {
+                const DriverEvent& event = events[count++];
+                if (view.driverName != event.driverName || view.signerInfo != event.signerInfo ||
+                    view.timestampUs != event.timestampUs || view.sequenceId != event.sequenceId ||
+                    view.threatLevel != event.threatLevel) {
+                    error = "batch reader decoded a different event";
+                    return false;
+                }
+                if (view.driverName.data() < begin || view.driverName.data() + view.driverName.size() > end) {
+                    error = "batch reader copied a string instead of pointing into the batch";
+                    return false;
+                }
+            }
+            if (reader.HasError() || count != events.size()) {
+                error = "batch reader stopped early";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // A small ring evicts old events but keeps the aggregates of all of them
+    bool VerifyStoreEviction(std::string& error) {
+        std::vector<DriverEvent> events = MakeSampleEvents(25);
+        for (size_t i = 0; i < events.size(); ++i) {
+            events[i].sequenceId = i + 1;
+        }
+        FleetStore store(1, 10);
+        FleetShard& shard = store.GetShard(0);
+        uint32_t host = shard.AddHost("ring-host");
+
+        std::string frame;
+        std::string scratch;
+        EventForwarder::EncodeBatch(1, 1, events, false, frame);
+        ForwardBatchReader reader;
+        if (!reader.Open(frame.data() + 4, frame.size() - 4, scratch) ||
+            shard.AddBatch(host, reader) != FleetShard::BatchResult::Stored) {
+            error = "fleet shard rejected a valid batch";
+            return false;
+        }
+
+        std::map<std::string, ExpectedDriver> expected;
+        for (const auto& event : events) {
+            AddExpected(expected, "ring-host", event);
+        }
+        for (const auto& driver : expected) {
+            FleetDriverSummary summary;
+            if (!store.GetDriverSummary(driver.first, summary) || !Matches(driver.first, driver.second, summary)) {
+                error = "fleet driver aggregate of " + driver.first + " lost evicted events";
+                return false;
+            }
+        }
+
+        FleetStoreStats stats = store.GetStats();
+        std::vector<DriverEvent> newest = store.GetHostEvents("ring-host", 100);
+        if (stats.eventsStored != 25 || stats.eventsRetained != 10 || newest.size() != 10) {
+            error = "fleet shard ring kept " + std::to_string(newest.size()) + " events instead of the newest 10";
+            return false;
+        }
+        for (size_t i = 0; i < newest.size(); ++i) {
+            if (newest[i].sequenceId != events[events.size() - 1 - i].sequenceId) {
+                error = "fleet host events are not the newest, newest first";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Unique paths, signers and initiators are freed once their events leave the ring
+    bool VerifyStoreStrings(std::string& error) {
+        const size_t kBatches = 60;
+        const size_t kBatchEvents = 200;
+        std::vector<DriverEvent> samples = MakeSampleEvents(kBatchEvents);
+        FleetStore store(1, 10);
+        FleetShard& shard = store.GetShard(0);
+        uint32_t host = shard.AddHost("churn-host");
+
+        std::map<std::string, ExpectedDriver> expected;
+        std::vector<DriverEvent> batch;
+        std::string frame;
+        std::string scratch;
+        for (uint64_t sequence = 1; sequence <= kBatches; ++sequence) {
+            batch = samples;
+            for (size_t i = 0; i < batch.size(); ++i) {
+                std::string unique = std::to_string(sequence * kBatchEvents + i);
+                batch[i].sequenceId = sequence * kBatchEvents + i;
+                batch[i].installPath = "C:\\Users\\u\\AppData\\Local\\Temp\\" + unique + "\\" + batch[i].driverName;
+                batch[i].signerInfo = "Signed by Vendor " + unique;
+                batch[i].initiatedBy = "setup-" + unique + ".exe";
+                AddExpected(expected, "churn-host", batch[i]);
+            }
+            frame.clear();
+            EventForwarder::EncodeBatch(1, sequence, batch, false, frame);
+            ForwardBatchReader reader;
+            if (!reader.Open(frame.data() + 4, frame.size() - 4, scratch) ||
+                shard.AddBatch(host, reader) != FleetShard::BatchResult::Stored) {
+                error = "fleet shard rejected a valid batch";
+                return false;
+            }
+            // A reconnecting host takes no new reference
+            if (shard.AddHost("churn-host") != host) {
+                error = "fleet shard registered a reconnecting host twice";
+                return false;
+            }
+        }
+
+        // Without release every one of the 3 * 12000 unique strings would stay
+        FleetStoreStats stats = store.GetStats();
+        if (stats.strings > 3 * 4096) {
+            error = "fleet shard kept " + std::to_string(stats.strings) + " strings of evicted events";
+            return false;
+        }
+
+        // Compaction renumbered the strings: aggregates and retained events are intact
+        for (const auto& driver : expected) {
+            FleetDriverSummary summary;
+            if (!store.GetDriverSummary(driver.first, summary) || !Matches(driver.first, driver.second, summary)) {
+                error = "fleet driver aggregate of " + driver.first + " changed after compaction";
+                return false;
+            }
+        }
+        std::vector<DriverEvent> newest = store.GetHostEvents("churn-host", 100);
+        if (newest.size() != 10) {
+            error = "fleet shard ring lost events after compaction";
+            return false;
+        }
+        for (size_t i = 0; i < newest.size(); ++i) {
+            const DriverEvent& sent = batch[batch.size() - 1 - i];
+            if (newest[i].sequenceId != sent.sequenceId || newest[i].installPath != sent.installPath ||
+                newest[i].signerInfo != sent.signerInfo || newest[i].initiatedBy != sent.initiatedBy) {
+                error = "fleet host events differ from those sent after compaction";
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool VerifyFleetCollector(std::string& error) {
+    if (!VerifyInPlaceDecode(error) || !VerifyStoreEviction(error) || !VerifyStoreStrings(error)) {
+        return false;
+    }
+
+    FleetCollectorOptions options;
+    options.loopbackOnly = true;
+    options.shards = 3;
+    options.capacity = 30000;
+    FleetCollector collector;
+    if (!collector.Start(options)) {
+        error = "fleet collector did not start: " + collector.GetLastError();
+        return false;
+    }
+
+    // Hosts share driver names, with distinct timestamps so first-seen is unambiguous
+    const size_t kHosts = 8;
+    const size_t kBatches = 3;
+    const size_t kBatchEvents = 50;
+    std::vector<DriverEvent> samples = MakeSampleEvents(kBatchEvents * 4);
+    std::map<std::string, ExpectedDriver> expected;
+    std::map<std::string, std::vector<DriverEvent>> hostEvents;
+    std::string firstBatch;
+    int64_t timestamp = 1700000000000000LL;
+    uint64_t nextSample = 0;
+
+    for (size_t h = 0; h < kHosts; ++h) {
+        std::string hostName = "host-" + std::to_string(h);
+        intptr_t socket = ConnectHost(collector.GetPort(), hostName);
+        if (socket == Socket::kNoSocket) {
+            error = "cannot connect to the fleet collector";
+            return false;
+        }
+        ForwardFrameReader reader;
+        uint64_t stream = 100 + h;
+        for (uint64_t sequence = 1; sequence <= kBatches; ++sequence) {
+            std::vector<DriverEvent> batch;
+            for (size_t i = 0; i < kBatchEvents; ++i) {
+                DriverEvent event = samples[nextSample++ % samples.size()];
+                event.sequenceId = sequence * 1000 + i;
+                event.timestampUs = timestamp -= 7;         // Later hosts see drivers first
+                batch.push_back(event);
+                AddExpected(expected, hostName, event);
+                hostEvents[hostName].push_back(event);
+            }
+            std::string frame;
+            EventForwarder::EncodeBatch(stream, sequence, batch, (sequence % 2) == 0, frame);
+            if (h == 0 && sequence == 1) {
+                firstBatch = frame;
+            }
+            if (!Socket::SendAll(socket, frame.data(), frame.size())) {
+                error = "fleet collector dropped a host connection";
+                return false;
+            }
+        }
+        if (!WaitForAck(socket, reader, stream, kBatches)) {
+            Socket::Close(socket);
+            error = "fleet collector did not acknowledge " + hostName;
+            return false;
+        }
+
+        // A resent batch is acknowledged but not stored again
+        if (h == 0) {
+            uint64_t stored = collector.GetStats().events;
+            if (!Socket::SendAll(socket, firstBatch.data(), firstBatch.size()) ||
+                !WaitForAck(socket, reader, stream, 1) || collector.GetStats().events != stored ||
+                collector.GetStore().GetStats().duplicateBatches != 1) {
+                Socket::Close(socket);
+                error = "fleet collector stored a resent batch twice";
+                return false;
+            }
+        }
+        Socket::Close(socket);
+    }
+
+    FleetCollectorStats stats = collector.GetStats();
+    if (stats.events != kHosts * kBatches * kBatchEvents || stats.connectionsMoved == 0) {
+        error = "fleet collector stored " + std::to_string(stats.events) + " events over " +
+                std::to_string(stats.connectionsMoved) + " handed-over connections";
+        return false;
+    }
+
+    // Cross-shard queries against brute force
+    const FleetStore& store = collector.GetStore();
+    for (const auto& driver : expected) {
+        FleetDriverSummary summary;
+        if (!store.GetDriverSummary(driver.first, summary) || !Matches(driver.first, driver.second, summary)) {
+            error = "fleet summary of " + driver.first + " differs from brute force";
+            return false;
+        }
+    }
+
+    std::vector<std::pair<std::string, const ExpectedDriver*>> ranked;
+    for (const auto& driver : expected) {
+        if (driver.second.suspicious > 0) {
+            ranked.emplace_back(driver.first, &driver.second);
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        if (a.second->suspicious != b.second->suspicious) {
+            return a.second->suspicious > b.second->suspicious;
+        }
+        if (a.second->hosts.size() != b.second->hosts.size()) {
+            return a.second->hosts.size() > b.second->hosts.size();
+        }
+        return a.first < b.first;
+    });
+    std::vector<FleetDriverSummary> top = store.GetTopSuspicious(10);
+    if (top.size() != std::min<size_t>(10, ranked.size())) {
+        error = "fleet top suspicious returned " + std::to_string(top.size()) + " drivers";
+        return false;
+    }
+    for (size_t i = 0; i < top.size(); ++i) {
+        if (top[i].driverName != ranked[i].first) {
+            error = "fleet top suspicious differs from brute force at rank " + std::to_string(i);
+            return false;
+        }
+    }
+
+    std::vector<std::pair<int64_t, std::string>> newest;
+    for (const auto& driver : expected) {
+        newest.emplace_back(driver.second.firstSeenUs, driver.first);
+    }
+    std::sort(newest.begin(), newest.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    std::vector<FleetDriverSummary> newestDrivers = store.GetNewestDrivers(10);
+    for (size_t i = 0; i < newestDrivers.size(); ++i) {
+        if (newestDrivers[i].driverName != newest[i].second) {
+            error = "fleet newest drivers differ from brute force at rank " + std::to_string(i);
+            return false;
+        }
+    }
+
+    std::vector<DriverEvent> recent = store.GetHostEvents("host-3", 4);
+    const std::vector<DriverEvent>& sent = hostEvents["host-3"];
+    if (recent.size() != 4) {
+        error = "fleet host query found " + std::to_string(recent.size()) + " events";
+        return false;
+    }
+    for (size_t i = 0; i < recent.size(); ++i) {
+        if (recent[i].sequenceId != sent[sent.size() - 1 - i].sequenceId) {
+            error = "fleet host events are not the newest, newest first";
+            return false;
+        }
+    }
+
+    // A corrupt batch closes its connection and stores nothing
+    intptr_t socket = ConnectHost(collector.GetPort(), "corrupt-host");
+    const char corrupt[] = { 6, 0, 0, 0, ForwardProtocol::kBatch, 1, 1, 9, 7, 1 };
+    uint64_t before = collector.GetStats().events;
+    if (socket == Socket::kNoSocket || !Socket::SendAll(socket, corrupt, sizeof(corrupt)) || !WaitForClose(socket) ||
+        !WaitUntil([&]() { return collector.GetStats().malformedFrames == 1; }, std::chrono::milliseconds(2000)) ||
+        collector.GetStats().events != before) {
+        Socket::Close(socket);
+        error = "fleet collector accepted a corrupt batch";
+        return false;
+    }
+    Socket::Close(socket);
+    collector.Stop();
+    return true;
+}
+
+void RunCollectorBenchmarks(BenchmarkRunner& runner) {
+    const size_t kBatchEvents = 256;
+    const uint64_t kSequences = 64;
+    std::vector<DriverEvent> events = MakeSampleEvents(kBatchEvents * 16);
+
+    // Raw batch frames of one stream, sequences 1..kSequences
+    std::vector<std::string> frames;
+    for (uint64_t sequence = 1; sequence <= kSequences; ++sequence) {
+        size_t offset = static_cast<size_t>((sequence - 1) % 16) * kBatchEvents;
+        std::vector<DriverEvent> batch(events.begin() + static_cast<std::ptrdiff_t>(offset),
+                                       events.begin() + static_cast<std::ptrdiff_t>(offset + kBatchEvents));
+        frames.emplace_back();
+        EventForwarder::EncodeBatch(1, sequence, batch, false, frames.back());
+    }
+
+    // Decode and store in one shard, per event (a new host every kSequences batches)
+    if (runner.IsSelected("Collector/Store")) {
+        FleetStore store(1, 1000000);
+        FleetShard& shard = store.GetShard(0);
+        uint64_t batches = 0;
+        std::string scratch;
+        runner.Run("Collector/Store", [&](uint64_t iterations) {
+            for (uint64_t stored = 0; stored < iterations; stored += kBatchEvents) {
+                uint32_t host = shard.AddHost("bench-host-" + std::to_string(batches / kSequences));
+                const std::string& frame = frames[batches++ % kSequences];
+                ForwardBatchReader reader;
+                reader.Open(frame.data() + 4, frame.size() - 4, scratch);
+                KeepAlive(shard.AddBatch(host, reader));
+            }
+        });
+    }
+
+    // Fleet-wide top suspicious over 4 shards of 1000 hosts
+    if (runner.IsSelected("Collector/Query")) {
+        FleetStore store(4, 1000000);
+        std::string scratch;
+        for (size_t h = 0; h < 1000; ++h) {
+            std::string name = "query-host-" + std::to_string(h);
+            FleetShard& shard = store.GetShard(store.GetShardIndex(name));
+            uint32_t host = shard.AddHost(name);
+            for (size_t b = 0; b < 2; ++b) {
+                const std::string& frame = frames[(h * 2 + b) % kSequences];
+                ForwardBatchReader reader;
+                reader.Open(frame.data() + 4, frame.size() - 4, scratch);
+                shard.AddBatch(host, reader);
+            }
+        }
+        runner.Run("Collector/Query", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                KeepAlive(store.GetTopSuspicious(10));
+            }
+        });
+    }
+
+    // 64 simulated hosts on loopback into a collector, per acknowledged event
+    if (runner.IsSelected("Collector/Fleet")) {
+        FleetCollectorOptions options;
+        options.loopbackOnly = true;
+        FleetCollector collector;
+        FleetSimulatorOptions fleetOptions;
+        fleetOptions.host = "127.0.0.1";
+        fleetOptions.hosts = 64;
+        FleetSimulator fleet;
+        if (collector.Start(options)) {
+            fleetOptions.port = collector.GetPort();
+            if (fleet.Start(fleetOptions)) {
+                runner.Run("Collector/Fleet", [&](uint64_t iterations) {
+                    fleet.WaitForAcked(fleet.GetStats().eventsAcked + iterations, std::chrono::milliseconds(60000));
+                });
+                fleet.Stop();
+            }
+            collector.Stop();
+        }
+    }
+}
+
+} // namespace DriverMonitor
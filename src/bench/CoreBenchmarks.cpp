@@ -0,0 +1,565 @@
+#include "BenchCases.h"
+#include "../core/EventManager.h"
+#include "../core/Config.h"
+#include "../core/ConfigWatcher.h"
+#include "../core/SyntheticSource.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DriverMonitor {
+
+std::vector<DriverEvent> MakeSampleEvents(size_t count) {
+    SyntheticProfile profile;
+    profile.nameCount = 10000;
+    SyntheticSource source(profile);
+
+    std::vector<DriverEvent> events(count);
+    int64_t timestamp = 1700000000000000LL;
+    for (auto& event : events) {
+        source.Generate(event);
+        event.timestampUs = timestamp;
+        event.timestamp = Utils::FormatTimestamp(timestamp);
+        event.eventType = Utils::DetermineEventType(event.signerInfo, event.loadingMethod);
+        event.threatLevel = Utils::AssessThreatLevel(event);
+        timestamp += 1000;
+    }
+    return events;
+}
+
+void FillEventManager(EventManager& eventManager, size_t count) {
+    SyntheticProfile profile;
+    profile.nameCount = count / 10 + 1;
+    profile.pathCount = 64;
+    SyntheticSource source(profile);
+
+    DriverEvent event;
+    int64_t timestamp = 1700000000000000LL;
+    for (size_t i = 0; i < count; ++i) {
+        source.Generate(event);
+        event.timestampUs = timestamp;
+        event.timestamp = Utils::FormatTimestamp(timestamp);
+        event.eventType = Utils::DetermineEventType(event.signerInfo, event.loadingMethod);
+        event.threatLevel = Utils::AssessThreatLevel(event);
+        eventManager.AddEvent(event);
+        timestamp += 1000;
+    }
+}
+
+bool VerifyEventLookup(std::string& error) {
+    EventManager manager;
+    manager.SetMaxEvents(1000);
+    FillEventManager(manager, 5000);
+
+    const std::vector<DriverEvent> events = manager.GetEvents();
+    DriverEvent event;
+    for (const auto& expected : events) {
+        if (!manager.GetEvent(expected.sequenceId, event) || event.sequenceId != expected.sequenceId ||
+            event.driverName != expected.driverName || event.signerInfo != expected.signerInfo) {
+            error = "GetEvent returned the wrong event for sequence " + std::to_string(expected.sequenceId);
+            return false;
+        }
+    }
+    if (manager.GetEvent(manager.GetFirstSequence() - 1, event) || manager.GetEvent(manager.GetNextSequence(), event)) {
+        error = "GetEvent found an evicted or unassigned sequence";
+        return false;
+    }
+
+    // Re-reading into the same buffers (the details panel each frame) must not allocate
+    uint64_t sequence = events.back().sequenceId;
+    manager.GetEvent(sequence, event);
+    uint64_t allocations = GetAllocationCount();
+    for (int i = 0; i < 100; ++i) {
+        manager.GetEvent(sequence, event);
+    }
+    if (GetAllocationCount() != allocations) {
+        error = "GetEvent allocated when reusing the event buffers";
+        return false;
+    }
+    return true;
+}
+
+bool VerifySyntheticSource(std::string& error) {
+    // Entry 1 has no weight: u exactly on its boundary belongs to entry 2
+    const std::vector<double> cdf = SyntheticSource::BuildCdf({1.0, 0.0, 1.0, 2.0});
+    const double boundaries[] = {0.0, 0.25, 0.5, 0.999};
+    const size_t expected[] = {0, 2, 3, 3};
+    for (size_t i = 0; i < 4; ++i) {
+        size_t index = SyntheticSource::Pick(cdf, boundaries[i]);
+        if (index != expected[i]) {
+            error = "Pick(" + std::to_string(boundaries[i]) + ") returned entry " + std::to_string(index) +
+                    ", expected " + std::to_string(expected[i]);
+            return false;
+        }
+    }
+    if (SyntheticSource::Pick(cdf, 1.0) != 3) {
+        error = "Pick past the last CDF entry did not clamp to it";
+        return false;
+    }
+    return true;
+}
+
+bool VerifyChangeNotifier(std::string& error) {
+    using namespace std::chrono;
+    EventManager manager;
+    const std::vector<DriverEvent> samples = MakeSampleEvents(16);
+
+    // A change that already happened returns at once; none times out
+    uint64_t generation = manager.GetChangeGeneration();
+    manager.AddEvent(samples[0]);
+    auto start = steady_clock::now();
+    if (!manager.WaitForChange(generation, milliseconds(1000)) || steady_clock::now() - start > milliseconds(100)) {
+        error = "WaitForChange missed a change made before the wait";
+        return false;
+    }
+    if (manager.WaitForChange(generation, milliseconds(20))) {
+        error = "WaitForChange reported a change without one";
+        return false;
+    }
+
+    // A change from another thread wakes the waiter early
+    std::thread producer([&]() {
+        std::this_thread::sleep_for(milliseconds(20));
+        manager.AddEvent(samples[1]);
+    });
+    start = steady_clock::now();
+    bool woken = manager.WaitForChange(generation, milliseconds(5000));
+    producer.join();
+    if (!woken || steady_clock::now() - start > milliseconds(2000)) {
+        error = "WaitForChange was not woken by a concurrent change";
+        return false;
+    }
+
+    // An armed listener fires once per arming
+    int calls = 0;
+    manager.GetChangeNotifier().SetListener([&calls]() { calls++; });
+    manager.AddEvent(samples[2]);
+    manager.GetChangeNotifier().ArmListener();
+    manager.AddEvent(samples[3]);
+    manager.Clear();
+    manager.GetChangeNotifier().SetListener(nullptr);
+    if (calls != 1) {
+        error = "Change listener fired " + std::to_string(calls) + " times for one arming";
+        return false;
+    }
+    return true;
+}
+
+bool VerifyConfigSnapshots(std::string& error) {
+    // Every published snapshot is self-consistent: logFile and the only
+    // whitelist entry both encode maxEvents. Readers hold their snapshot
+    // across a yield so publishes (and retirements) land mid-read.
+    const int kPublishes = 3000;
+    const int kReaders = 3;
+    auto makeConfig = [](int n) {
+        MonitorConfig config;
+        config.maxEvents = n;
+        config.logFile = "log" + std::to_string(n);
+        config.whitelist.push_back("w" + std::to_string(n) + ".sys");
+        return config;
+    };
+
+    Config config;
+    config.Apply(makeConfig(1));
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+    std::atomic<uint64_t> reads(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaders; ++r) {
+        readers.emplace_back([&]() {
+            uint64_t lastVersion = 0;
+            while (!done) {
+                RcuReadGuard guard;
+                const ConfigSnapshot& snapshot = config.GetSnapshot();
+                std::string expected = std::to_string(snapshot.config.maxEvents);
+                std::this_thread::yield();
+                if (snapshot.version < lastVersion || snapshot.config.logFile != "log" + expected ||
+                    !snapshot.IsWhitelisted("w" + expected + ".sys") || snapshot.whitelist->names.size() != 1) {
+                    failures++;
+                }
+                lastVersion = snapshot.version;
+                reads++;
+            }
+        });
+    }
+
+    size_t maxRetired = 0;
+    for (int n = 2; n <= kPublishes; ++n) {
+        config.Apply(makeConfig(n));
+        maxRetired = std::max(maxRetired, Rcu::GetRetiredCount());
+        if (n % 64 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    // No reader is inside a guard any more: everything retired can go
+    Rcu::Reclaim();
+    if (failures != 0 || reads == 0) {
+        error = "Config snapshot readers saw " + std::to_string(failures.load()) + " inconsistent snapshots";
+        return false;
+    }
+    if (Rcu::GetRetiredCount() != 0 || maxRetired > kPublishes / 4) {
+        error = "Config snapshots were not reclaimed while readers ran (max retired " + std::to_string(maxRetired) + ")";
+        return false;
+    }
+    return true;
+}
+
+bool VerifyConfig(std::string& error) {
+    // Round trip of every setting, with strings that need escaping
+    MonitorConfig config;
+    config.ignoreMicrosoft = false;
+    config.verboseMode = true;
+    config.maxEvents = 12345;
+    config.maxLogSize = 0;
+    config.driversPath = "C:\\Windows\\System32\\drivers";
+    config.logFile = "log \"quoted\"\n.txt";
+    config.whitelist = { "a.sys", "tab\there.sys", "\x01ctl.sys", "caf\xC3\xA9.sys" };
+    std::string text = Config::Serialize(config);
+    MonitorConfig parsed;
+    std::string parseError;
+    if (!Config::Parse(text.data(), text.size(), parsed, parseError) || Config::Serialize(parsed) != text ||
+        parsed.whitelist != config.whitelist || parsed.logFile != config.logFile ||
+        parsed.driversPath != config.driversPath || parsed.maxEvents != 12345 || parsed.verboseMode != true) {
+        error = "Config does not round-trip: " + parseError;
+        return false;
+    }
+
+    // Single-line documents, escapes, comments; omitted settings keep defaults
+    const char oneLine[] =
+        "{\"ui\":{\"maxEvents\":50},/* c */\"whitelist\":[\"x\\\"y\\u00e9\\ud83d\\ude00.sys\"]} // end";
+    if (!Config::Parse(oneLine, sizeof(oneLine) - 1, parsed, parseError) || parsed.maxEvents != 50 ||
+        parsed.whitelist.size() != 1 || parsed.whitelist[0] != "x\"y\xC3\xA9\xF0\x9F\x98\x80.sys" ||
+        parsed.logFile != MonitorConfig().logFile) {
+        error = "Config rejected a valid single-line document: " + parseError;
+        return false;
+    }
+
+    // Invalid documents fail with the position of the offending token
+    struct BadCase {
+        const char* text;
+        const char* expected;
+    };
+    const BadCase badCases[] = {
+        { "{\"ui\": {\"maxEvents\": \"many\"}}", "line 1, column 22: ui.maxEvents must be an integer" },
+        { "{\n  \"ui\": {\n    \"maxEvent\": 5\n  }\n}", "line 3, column 5: unknown setting 'ui.maxEvent'" },
+        { "{\"ui\": {\"maxEvents\": 0}}", "line 1, column 22: ui.maxEvents must be an integer from 1" },
+        { "{\"alerts\": {\"playSound\": 1}}", "line 1, column 26: alerts.playSound must be true or false" },
+        { "{\"whitelist\": [\"a.sys\" \"b.sys\"]}", "line 1, column 24: expected ',' or ']'" },
+        { "{\"whitelist\": [\"a\\q\"]}", "line 1, column 18: invalid escape" },
+        { "{\"whitelist\": [\"open]}", "line 1, column 16: unterminated string" },
+        { "{\"ui\": {}} x", "line 1, column 12: unexpected data after the document" },
+        { "{\"gui\": {}}", "line 1, column 2: unknown section 'gui'" },
+        { "[]", "line 1, column 1: expected an object" }
+    };
+    for (const auto& bad : badCases) {
+        if (Config::Parse(bad.text, strlen(bad.text), parsed, parseError) ||
+            parseError.compare(0, strlen(bad.expected), bad.expected) != 0) {
+            error = std::string("Config error for ") + bad.text + ": got '" + parseError + "', expected '" + bad.expected + "'";
+            return false;
+        }
+    }
+
+    // Hot reload: valid edits are delivered, invalid ones reported and skipped
+    std::string path = (std::filesystem::temp_directory_path() / "driver_monitor_verify_config.json").string();
+    Config saved;
+    saved.GetConfig() = config;
+    if (!saved.Save(path)) {
+        error = "Cannot save " + path;
+        return false;
+    }
+    MonitorConfig delivered;
+    std::string reported;
+    ConfigWatcher watcher;
+    watcher.Start(path, std::chrono::hours(1),
+                  [&](MonitorConfig& reloaded) { delivered = reloaded; },
+                  [&](const std::string& message) { reported = message; });
+    bool unchangedSkipped = !watcher.CheckNow();
+
+    saved.GetConfig().maxEvents = 777;
+    saved.GetConfig().whitelist.push_back("new.sys");
+    saved.Save(path);
+    bool reloaded = watcher.CheckNow() && delivered.maxEvents == 777 && delivered.whitelist.back() == "new.sys";
+
+    std::ofstream(path, std::ios::trunc) << "{\"ui\": {\"maxEvents\": -1}}";
+    bool rejected = !watcher.CheckNow() && delivered.maxEvents == 777 && !reported.empty();
+    watcher.Stop();
+    std::remove(path.c_str());
+
+    if (!unchangedSkipped || !reloaded || !rejected || watcher.GetReloadCount() != 1 || watcher.GetErrorCount() != 1) {
+        error = "ConfigWatcher did not reload exactly the valid change";
+        return false;
+    }
+    return true;
+}
+
+void RunEventManagerBenchmarks(BenchmarkRunner& runner) {
+    // Cost every stored event now pays to publish a change
+    {
+        ChangeNotifier notifier;
+        runner.Run("ChangeNotifier/Notify", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                notifier.Notify();
+            }
+        });
+    }
+
+    const std::vector<DriverEvent> samples = MakeSampleEvents(4096);
+
+    for (int maxEvents : { 1000, 100000 }) {
+        std::string suffix = "/" + std::to_string(maxEvents);
+
+        // Steady state: history full, every add evicts the oldest event
+        if (runner.IsSelected("EventManager/AddEvent" + suffix)) {
+            EventManager manager;
+            manager.SetMaxEvents(maxEvents);
+            for (int i = 0; i < maxEvents; ++i) {
+                manager.AddEvent(samples[i % samples.size()]);
+            }
+            size_t next = 0;
+            runner.Run("EventManager/AddEvent" + suffix, [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    manager.AddEvent(samples[next++ % samples.size()]);
+                }
+            });
+        }
+
+        if (runner.IsSelected("EventManager/GetEvents" + suffix)) {
+            EventManager manager;
+            manager.SetMaxEvents(maxEvents);
+            for (int i = 0; i < maxEvents; ++i) {
+                manager.AddEvent(samples[i % samples.size()]);
+            }
+            runner.Run("EventManager/GetEvents" + suffix, [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    std::vector<DriverEvent> events = manager.GetEvents();
+                    KeepAlive(events);
+                }
+            });
+        }
+
+        // Details panel: one event by sequence ID into reused buffers
+        if (runner.IsSelected("EventManager/GetEvent" + suffix)) {
+            EventManager manager;
+            manager.SetMaxEvents(maxEvents);
+            for (int i = 0; i < maxEvents; ++i) {
+                manager.AddEvent(samples[i % samples.size()]);
+            }
+            uint64_t sequence = manager.GetFirstSequence() + static_cast<uint64_t>(maxEvents / 2);
+            DriverEvent event;
+            runner.Run("EventManager/GetEvent" + suffix, [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    bool found = manager.GetEvent(sequence, event);
+                    KeepAlive(found);
+                }
+            });
+        }
+
+        // One GUI frame: a few new events arrive, then the incremental read
+        if (runner.IsSelected("EventManager/GetNewEvents" + suffix)) {
+            EventManager manager;
+            manager.SetMaxEvents(maxEvents);
+            for (int i = 0; i < maxEvents; ++i) {
+                manager.AddEvent(samples[i % samples.size()]);
+            }
+            manager.GetNewEvents();
+            size_t next = 0;
+            runner.Run("EventManager/GetNewEvents" + suffix + "/add10", [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    for (int j = 0; j < 10; ++j) {
+                        manager.AddEvent(samples[next++ % samples.size()]);
+                    }
+                    std::vector<DriverEvent> events = manager.GetNewEvents();
+                    KeepAlive(events);
+                }
+            });
+            runner.Run("EventManager/GetNewEvents" + suffix + "/idle", [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    std::vector<DriverEvent> events = manager.GetNewEvents();
+                    KeepAlive(events);
+                }
+            });
+        }
+    }
+}
+
+void RunUtilsBenchmarks(BenchmarkRunner& runner) {
+    const std::vector<DriverEvent> samples = MakeSampleEvents(1024);
+
+    std::string path = "C:\\Windows\\System32\\DriverStore\\FileRepository\\netrtwlane.inf_amd64_0123456789abcdef\\netrtwlane.sys";
+    runner.Run("Utils/ContainsIgnoreCase/hit", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            bool found = Utils::ContainsIgnoreCase(path, "NETRTWLANE.SYS");
+            KeepAlive(found);
+        }
+    });
+    runner.Run("Utils/ContainsIgnoreCase/miss", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            bool found = Utils::ContainsIgnoreCase(path, "mimidrv");
+            KeepAlive(found);
+        }
+    });
+
+    runner.Run("Utils/DetermineEventType", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            const DriverEvent& event = samples[i % samples.size()];
+            EventType type = Utils::DetermineEventType(event.signerInfo, event.loadingMethod);
+            KeepAlive(type);
+        }
+    });
+    runner.Run("Utils/AssessThreatLevel", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            ThreatLevel level = Utils::AssessThreatLevel(samples[i % samples.size()]);
+            KeepAlive(level);
+        }
+    });
+
+    runner.Run("Utils/FormatTimestamp", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            std::string timestamp = Utils::FormatTimestamp(samples[i % samples.size()].timestampUs);
+            KeepAlive(timestamp);
+        }
+    });
+    runner.Run("Log/FormatLogLine", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            std::string line = Utils::FormatLogLine(samples[i % samples.size()]);
+            KeepAlive(line);
+        }
+    });
+}
+
+void RunConfigBenchmarks(BenchmarkRunner& runner) {
+    const std::vector<DriverEvent> samples = MakeSampleEvents(1024);
+
+    // Detection-path read: guard, snapshot load, a setting and a whitelist lookup
+    {
+        Config config;
+        for (int i = 0; i < 1000; ++i) {
+            config.AddToWhitelist("trusted" + std::to_string(i) + ".sys");
+        }
+        auto read = [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                RcuReadGuard guard;
+                const ConfigSnapshot& snapshot = config.GetSnapshot();
+                bool filtered = snapshot.config.ignoreMicrosoft && snapshot.IsWhitelisted(samples[i % samples.size()].driverName);
+                KeepAlive(filtered);
+            }
+        };
+        runner.Run("Config/Snapshot/guard", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                RcuReadGuard guard;
+                KeepAlive(config.GetSnapshot().version);
+            }
+        });
+        runner.Run("Config/Snapshot/read", read);
+
+        // Same read while another thread publishes a new snapshot every millisecond
+        if (runner.IsSelected("Config/Snapshot/read/publishing")) {
+            std::atomic<bool> stop(false);
+            std::thread writer([&]() {
+                MonitorConfig edited = config.GetConfig();
+                while (!stop) {
+                    edited.verboseMode = !edited.verboseMode;
+                    config.Apply(edited);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+            runner.Run("Config/Snapshot/read/publishing", read);
+            stop = true;
+            writer.join();
+        }
+        runner.Run("Config/Snapshot/publish/1000", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                config.NotifyChanged();
+            }
+        });
+    }
+
+    for (int whitelistSize : { 10, 1000 }) {
+        std::string suffix = "/" + std::to_string(whitelistSize);
+
+        Config config;
+        for (int i = 0; i < whitelistSize; ++i) {
+            config.AddToWhitelist("trusted" + std::to_string(i) + ".sys");
+        }
+
+        std::string hitName = "trusted" + std::to_string(whitelistSize / 2) + ".sys";
+        runner.Run("Config/IsWhitelisted" + suffix + "/hit", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                bool whitelisted = config.IsWhitelisted(hitName);
+                KeepAlive(whitelisted);
+            }
+        });
+        runner.Run("Config/IsWhitelisted" + suffix + "/miss", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                bool whitelisted = config.IsWhitelisted(samples[i % samples.size()].driverName);
+                KeepAlive(whitelisted);
+            }
+        });
+
+        if (!runner.IsSelected("Config/Save" + suffix) && !runner.IsSelected("Config/Load" + suffix)) {
+            continue;
+        }
+
+        std::string path = (std::filesystem::temp_directory_path() /
+                            ("driver_monitor_bench_" + std::to_string(whitelistSize) + ".json")).string();
+        runner.Run("Config/Save" + suffix, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                bool saved = config.Save(path);
+                KeepAlive(saved);
+            }
+        });
+        config.Save(path);
+        runner.Run("Config/Load" + suffix, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                Config loaded;
+                bool ok = loaded.Load(path);
+                KeepAlive(ok);
+            }
+        });
+        std::remove(path.c_str());
+    }
+
+    // A large whitelist: about 5 MB of configuration
+    if (!runner.IsSelected("Config/Parse/5MB") && !runner.IsSelected("Config/Load/5MB")) {
+        return;
+    }
+    Config large;
+    for (int i = 0; i < 140000; ++i) {
+        large.GetConfig().whitelist.push_back("third_party_driver_" + std::to_string(i) + ".sys");
+    }
+    std::string text = Config::Serialize(large.GetConfig());
+    std::fprintf(stderr, "Config/5MB: %zu bytes, %zu whitelist entries\n", text.size(), large.GetConfig().whitelist.size());
+    runner.Run("Config/Parse/5MB", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            MonitorConfig parsed;
+            std::string error;
+            bool ok = Config::Parse(text.data(), text.size(), parsed, error);
+            KeepAlive(ok);
+        }
+    });
+    std::string path = (std::filesystem::temp_directory_path() / "driver_monitor_bench_5mb.json").string();
+    large.Save(path);
+    runner.Run("Config/Load/5MB", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            Config loaded;
+            bool ok = loaded.Load(path);
+            KeepAlive(ok);
+        }
+    });
+    std::remove(path.c_str());
+}
+
+} // namespace DriverMonitor
@@ -0,0 +1,203 @@
+#include "BenchCases.h"
+#include "../core/EventExporter.h"
+#include "../core/EventManager.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+namespace {
+    const size_t kExportEvents = 1000000;
+
+    std::string TemporaryPath(const char* name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    // Run one export to completion
+    ExportProgress RunExport(EventExporter& exporter, const ExportOptions& options) {
+        exporter.Start(options);
+        exporter.Wait();
+        return exporter.GetProgress();
+    }
+
+    size_t CountLines(const std::string& filePath) {
+        std::ifstream file(filePath, std::ios::binary);
+        return static_cast<size_t>(std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n'));
+    }
+
+    bool SameEvent(const DriverEvent& a, const DriverEvent& b) {
+        return a.sequenceId == b.sequenceId && a.timestampUs == b.timestampUs && a.timestamp == b.timestamp &&
+               a.driverName == b.driverName && a.installPath == b.installPath &&
+               a.loadingMethod == b.loadingMethod && a.initiatedBy == b.initiatedBy &&
+               a.processId == b.processId && a.signerInfo == b.signerInfo &&
+               a.eventType == b.eventType && a.threatLevel == b.threatLevel &&
+               a.source == b.source && a.isRemoval == b.isRemoval;
+    }
+
+    bool SameEvents(const std::vector<DriverEvent>& a, const std::vector<DriverEvent>& b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), SameEvent);
+    }
+}
+
+bool VerifyEventExporter(std::string& error) {
+    const std::string exportPath = TemporaryPath("driver_monitor_verify.dmex");
+    const std::string cursorPath = exportPath + ".cursor";
+    const std::string textPath = TemporaryPath("driver_monitor_verify.txt");
+    std::filesystem::remove(exportPath);
+    std::filesystem::remove(cursorPath);
+
+    EventManager eventManager;
+    eventManager.SetMaxEvents(100000);
+    FillEventManager(eventManager, 70000);
+    std::vector<DriverEvent> events = eventManager.GetEvents();
+    for (size_t i = 0; i < events.size(); i += 7) {
+        events[i].isRemoval = true;
+        events[i].driverName += ",\"quoted\"";
+    }
+    eventManager.Clear();
+    for (auto& event : events) {
+        eventManager.AddEvent(event);
+    }
+    events = eventManager.GetEvents();
+
+    // Columnar round trip (more than one block) through an incremental export
+    EventExporter exporter(&eventManager);
+    ExportOptions options;
+    options.filePath = exportPath;
+    options.format = ExportFormat::Columnar;
+    options.cursorPath = cursorPath;
+    ExportProgress progress = RunExport(exporter, options);
+    std::vector<DriverEvent> exported;
+    if (progress.state != ExportState::Completed || progress.written != events.size() ||
+        !EventExporter::ReadColumnar(exportPath, exported) || !SameEvents(exported, events)) {
+        error = "Columnar export does not round-trip the history";
+        return false;
+    }
+
+    // The next incremental export appends only the new events
+    std::vector<DriverEvent> added = MakeSampleEvents(500);
+    for (auto& event : added) {
+        event.timestampUs += 3600000000LL;
+        event.timestamp = Utils::FormatTimestamp(event.timestampUs);
+        eventManager.AddEvent(event);
+    }
+    progress = RunExport(exporter, options);
+    exported.clear();
+    if (progress.written != added.size() || !EventExporter::ReadColumnar(exportPath, exported) ||
+        !SameEvents(exported, eventManager.GetEvents())) {
+        error = "Incremental export did not append exactly the new events";
+        return false;
+    }
+
+    // Another history (restart): resumes after the last exported timestamp
+    EventManager restarted;
+    restarted.SetMaxEvents(100000);
+    for (const auto& event : eventManager.GetEvents()) {
+        restarted.AddEvent(event);
+    }
+    DriverEvent later = added.back();
+    later.timestampUs += 1000;
+    later.timestamp = Utils::FormatTimestamp(later.timestampUs);
+    restarted.AddEvent(later);
+    EventExporter restartedExporter(&restarted);
+    progress = RunExport(restartedExporter, options);
+    if (progress.written != 1 || progress.cursor.historyId != restarted.GetHistoryId()) {
+        error = "Export after a restart did not resume by timestamp";
+        return false;
+    }
+
+    // Table filter and time range select the same events as the brute-force checks
+    options = ExportOptions();
+    options.filePath = textPath;
+    options.format = ExportFormat::Csv;
+    options.searchText = "SYN1";
+    options.typeFilter = EventTypeFilter::Unsigned;
+    options.fromTimeUs = events[1000].timestampUs;
+    options.toTimeUs = events[50000].timestampUs;
+    size_t expected = 0;
+    for (const auto& event : eventManager.GetEvents()) {
+        expected += event.timestampUs >= options.fromTimeUs && event.timestampUs < options.toTimeUs &&
+                    MatchesEventFilter(event, "syn1", options.typeFilter);
+    }
+    progress = RunExport(exporter, options);
+    if (expected == 0 || progress.written != expected || CountLines(textPath) != expected + 1) {
+        error = "Filtered CSV export wrote " + std::to_string(progress.written) + " events, expected " + std::to_string(expected);
+        return false;
+    }
+    options.format = ExportFormat::JsonLines;
+    progress = RunExport(exporter, options);
+    if (progress.written != expected || CountLines(textPath) != expected) {
+        error = "Filtered JSON export wrote the wrong events";
+        return false;
+    }
+
+    // A cancelled export leaves complete rows and a cursor at the point reached
+    std::filesystem::remove(exportPath);
+    std::filesystem::remove(cursorPath);
+    options = ExportOptions();
+    options.filePath = exportPath;
+    options.format = ExportFormat::Columnar;
+    options.cursorPath = cursorPath;
+    exporter.Start(options);
+    exporter.Cancel();
+    exporter.Wait();
+    progress = exporter.GetProgress();
+    exported.clear();
+    ExportCursor cursor;
+    if ((progress.state != ExportState::Cancelled && progress.state != ExportState::Completed) ||
+        !EventExporter::ReadColumnar(exportPath, exported) || exported.size() != progress.written ||
+        !cursor.Load(cursorPath) || cursor.nextSequence != eventManager.GetFirstSequence() + progress.examined) {
+        error = "Cancelled export left an inconsistent file or cursor";
+        return false;
+    }
+
+    std::filesystem::remove(exportPath);
+    std::filesystem::remove(cursorPath);
+    std::filesystem::remove(textPath);
+    return true;
+}
+
+void RunExportBenchmarks(BenchmarkRunner& runner) {
+    if (!runner.IsSelected("Export/")) {
+        return;
+    }
+
+    EventManager eventManager;
+    eventManager.SetMaxEvents(static_cast<int>(kExportEvents));
+    FillEventManager(eventManager, kExportEvents);
+    EventExporter exporter(&eventManager);
+
+    struct FormatCase {
+        const char* name;
+        ExportFormat format;
+        const char* extension;
+    };
+    const FormatCase formats[] = {
+        { "csv", ExportFormat::Csv, ".csv" },
+        { "jsonl", ExportFormat::JsonLines, ".jsonl" },
+        { "columnar", ExportFormat::Columnar, ".dmex" }
+    };
+
+    // Whole 1M history per iteration (file size printed alongside)
+    for (const auto& format : formats) {
+        ExportOptions options;
+        options.format = format.format;
+        options.filePath = TemporaryPath((std::string("driver_monitor_bench") + format.extension).c_str());
+        std::string name = std::string("Export/1M/") + format.name;
+        if (!runner.IsSelected(name)) {
+            continue;
+        }
+        uint64_t bytes = 0;
+        runner.RunLatency(name, 3, [&](size_t) {
+            bytes = RunExport(exporter, options).bytes;
+        });
+        std::cerr << name << ": " << bytes << " bytes\n";
+        std::filesystem::remove(options.filePath);
+    }
+}
+
+} // namespace DriverMonitor
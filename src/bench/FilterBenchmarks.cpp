@@ -0,0 +1,239 @@
+#include "BenchCases.h"
+#include "../core/EventExporter.h"
+#include "../core/EventManager.h"
+#include "../core/EventViewModel.h"
+#include "../core/FilterExpression.h"
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+namespace {
+    // Expression and the same condition written out in C++
+    struct FilterCase {
+        const char* text;
+        std::function<bool(const DriverEvent&)> expected;
+    };
+
+    bool Contains(const std::string& haystack, const char* needle) {
+        return Utils::ContainsIgnoreCase(haystack, needle);
+    }
+
+    std::vector<FilterCase> MakeFilterCases() {
+        return {
+            { "", [](const DriverEvent&) { return true; } },
+            { "type == Suspicious", [](const DriverEvent& e) { return e.eventType == EventType::Suspicious; } },
+            { "TYPE != signed", [](const DriverEvent& e) { return e.eventType != EventType::Signed; } },
+            { "type == Suspicious && signer !~ \"Microsoft\" && path ~ \"synthetic1\"",
+              [](const DriverEvent& e) {
+                  return e.eventType == EventType::Suspicious && !Contains(e.signerInfo, "Microsoft") &&
+                         Contains(e.installPath, "synthetic1");
+              } },
+            { "threat >= Medium and not removal",
+              [](const DriverEvent& e) { return e.threatLevel >= ThreatLevel::Medium && !e.isRemoval; } },
+            { "threat < High || method == \"manual map\" && signer == \"NOT SIGNED\"",
+              [](const DriverEvent& e) {
+                  return e.threatLevel < ThreatLevel::High ||
+                         (Utils::ToLower(e.loadingMethod) == "manual map" && Utils::ToLower(e.signerInfo) == "not signed");
+              } },
+            { "!(name ~ \"syn1\" || name ~ \"syn2\") && pid > 1000",
+              [](const DriverEvent& e) {
+                  return !(Contains(e.driverName, "syn1") || Contains(e.driverName, "syn2")) && e.processId > 1000;
+              } },
+            { "\"contoso\" or source == Registry",
+              [](const DriverEvent& e) {
+                  return Contains(e.driverName, "contoso") || Contains(e.installPath, "contoso") ||
+                         Contains(e.signerInfo, "contoso") || e.source == EventSource::Registry;
+              } },
+            { "name == syn3.sys || initiator ~ \"svc\\\\\" && pid <= 1500",
+              [](const DriverEvent& e) {
+                  return Utils::ToLower(e.driverName) == "syn3.sys" ||
+                         (Contains(e.initiatedBy, "svc\\") && e.processId <= 1500);
+              } }
+        };
+    }
+
+    // Classified events with varied sources, processes and initiators
+    std::vector<DriverEvent> MakeFilterEvents(size_t count) {
+        std::vector<DriverEvent> events = MakeSampleEvents(count);
+        const EventSource sources[] = { EventSource::Registry, EventSource::FileSystem, EventSource::WMI };
+        for (size_t i = 0; i < events.size(); ++i) {
+            events[i].source = sources[i % 3];
+            events[i].processId = static_cast<unsigned long>(500 + (i * 37) % 2000);
+            events[i].initiatedBy = (i % 5 == 0) ? "svc\\host.exe" : "services.exe";
+        }
+        return events;
+    }
+}
+
+bool VerifyFilterExpression(std::string& error) {
+    std::vector<DriverEvent> events = MakeFilterEvents(4000);
+    std::vector<FilterCase> cases = MakeFilterCases();
+
+    // Every case against its C++ twin, on every event
+    FilterExpression expression;
+    for (const auto& filterCase : cases) {
+        std::string compileError;
+        if (!expression.Compile(filterCase.text, compileError)) {
+            error = std::string("filter expression '") + filterCase.text + "' rejected: " + compileError;
+            return false;
+        }
+        size_t matched = 0;
+        for (const auto& event : events) {
+            bool matches = expression.Matches(event);
+            if (matches != filterCase.expected(event)) {
+                error = std::string("filter expression '") + filterCase.text + "' disagrees on " + event.driverName;
+                return false;
+            }
+            matched += matches ? 1 : 0;
+        }
+        if (filterCase.text[0] != '\0' && (matched == 0 || matched == events.size())) {
+            error = std::string("filter expression '") + filterCase.text + "' is not selective on the sample";
+            return false;
+        }
+    }
+
+    // Errors name the column; a failed compile keeps the previous expression
+    const struct {
+        const char* text;
+        const char* expected;
+    } invalid[] = {
+        { "type ==", "column 8: " },
+        { "kind == Signed", "column 1: unknown field" },
+        { "(type == Signed", "column 1: unmatched (" },
+        { "name ~ \"abc", "column 8: unterminated string" },
+        { "type < Signed", "column 6: " },
+        { "threat == Extreme", "column 11: " },
+        { "pid == 12a", "column 8: " },
+        { "type == Signed &&", "column 18: " },
+        { "type == Signed removal", "column 16: unexpected input" },
+        { "name $ \"x\"", "column 6: " }
+    };
+    expression.Compile("type == Signed", error);
+    for (const auto& entry : invalid) {
+        std::string compileError;
+        if (expression.Compile(entry.text, compileError) || compileError.find(entry.expected) != 0) {
+            error = std::string("filter expression '") + entry.text + "' gave \"" + compileError + "\", expected \"" +
+                    entry.expected + "...\"";
+            return false;
+        }
+    }
+    if (expression.GetText() != "type == Signed") {
+        error = "a rejected filter expression replaced the previous one";
+        return false;
+    }
+    std::string nested(200, '(');
+    if (expression.Compile(nested + "type == Signed" + std::string(200, ')'), error)) {
+        error = "deeply nested filter expression was accepted";
+        return false;
+    }
+    error.clear();
+
+    // Evaluation does not allocate
+    expression.Compile(cases[3].text, error);
+    uint64_t allocations = GetAllocationCount();
+    size_t matched = 0;
+    for (const auto& event : events) {
+        matched += expression.Matches(event) ? 1 : 0;
+    }
+    if (GetAllocationCount() != allocations) {
+        error = "filter expression evaluation allocated";
+        return false;
+    }
+    KeepAlive(matched);
+
+    // The view and exports apply it on top of the search and type filter
+    EventManager eventManager;
+    eventManager.SetMaxEvents(static_cast<int>(events.size()));
+    for (const auto& event : events) {
+        eventManager.AddEvent(event);
+    }
+    std::vector<DriverEvent> stored = eventManager.GetEvents();
+    EventViewModel view(&eventManager);
+    view.SetFilter("syn", EventTypeFilter::All);
+    view.SetExpression(expression);
+    view.Update();
+    size_t expectedRows = 0;
+    for (const auto& event : stored) {
+        expectedRows += (Contains(event.driverName, "syn") || Contains(event.installPath, "syn") ||
+                         Contains(event.signerInfo, "syn")) && cases[3].expected(event) ? 1 : 0;
+    }
+    if (view.GetRowCount() != expectedRows) {
+        error = "view with a filter expression shows " + std::to_string(view.GetRowCount()) + " rows, expected " +
+                std::to_string(expectedRows);
+        return false;
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "drivermonitor_filter_verify.jsonl").string();
+    ExportOptions options;
+    options.filePath = path;
+    options.format = ExportFormat::JsonLines;
+    options.filterExpression = cases[3].text;
+    EventExporter exporter(&eventManager);
+    exporter.Start(options);
+    exporter.Wait();
+    ExportProgress progress = exporter.GetProgress();
+    size_t expectedExport = 0;
+    for (const auto& event : stored) {
+        expectedExport += cases[3].expected(event) ? 1 : 0;
+    }
+    options.filterExpression = "type ==";
+    exporter.Start(options);
+    exporter.Wait();
+    ExportProgress rejected = exporter.GetProgress();
+    std::error_code ignored;
+    std::filesystem::remove(path, ignored);
+    if (progress.state != ExportState::Completed || progress.written != expectedExport) {
+        error = "export with a filter expression wrote " + std::to_string(progress.written) + " events, expected " +
+                std::to_string(expectedExport);
+        return false;
+    }
+    if (rejected.state != ExportState::Failed) {
+        error = "export with an invalid filter expression did not fail";
+        return false;
+    }
+    return true;
+}
+
+void RunFilterBenchmarks(BenchmarkRunner& runner) {
+    std::vector<DriverEvent> events = MakeFilterEvents(4096);
+    std::vector<FilterCase> cases = MakeFilterCases();
+
+    // Compile the example expression
+    runner.Run("Filter/Compile", [&](uint64_t iterations) {
+        std::string error;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            FilterExpression expression;
+            expression.Compile(cases[3].text, error);
+            KeepAlive(expression);
+        }
+    });
+
+    // Per event evaluated
+    const struct {
+        const char* name;
+        size_t filterCase;
+    } evaluated[] = {
+        { "Filter/Evaluate/Type", 1 },
+        { "Filter/Evaluate/Example", 3 },
+        { "Filter/Evaluate/Threat", 5 },
+        { "Filter/Evaluate/Negated", 6 },
+        { "Filter/Evaluate/Search", 7 }
+    };
+    for (const auto& bench : evaluated) {
+        FilterExpression expression;
+        std::string error;
+        expression.Compile(cases[bench.filterCase].text, error);
+        runner.Run(bench.name, [&](uint64_t iterations) {
+            uint64_t matched = 0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                matched += expression.Matches(events[i % events.size()]) ? 1 : 0;
+            }
+            KeepAlive(matched);
+        });
+    }
+}
+
+} // namespace DriverMonitor
@@ -0,0 +1,533 @@
+#include "BenchCases.h"
+#include "../core/BinaryCodec.h"
+#include "../core/Compression.h"
+#include "../core/EventForwarder.h"
+#include "../core/Socket.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DriverMonitor {
+
+namespace {
+    // Loopback stand-in for the central collector: stores batches, drops
+    // those at or below a stream's acknowledged sequence, and acknowledges
+    // every batch. It can hang up once after a number of batches without
+    // acknowledging them, as a collector that crashes would.
+    class StandInCollector {
+    public:
+        StandInCollector()
+            : m_listener(Socket::kNoSocket), m_port(0), m_stop(false), m_hangUpAfter(0),
+              m_batches(0), m_duplicateEvents(0), m_hellos(0) {}
+
+        ~StandInCollector() { Stop(); }
+
+        // Listen on 127.0.0.1:port (0 = any free port)
+        bool Start(uint16_t port = 0) {
+            std::string error;
+            Socket::Init();
+            m_listener = Socket::Listen(true, port, m_port, error);
+            if (m_listener == Socket::kNoSocket) {
+                Socket::Cleanup();
+                return false;
+            }
+            m_stop = false;
+            m_thread = std::thread(&StandInCollector::Run, this);
+            return true;
+        }
+
+        void Stop() {
+            if (!m_thread.joinable()) {
+                return;
+            }
+            m_stop = true;
+            m_thread.join();
+            Socket::Close(m_listener);
+            m_listener = Socket::kNoSocket;
+            Socket::Cleanup();
+        }
+
+        uint16_t GetPort() const { return m_port; }
+
+        // Hang up (once) when this many batches arrived on a connection, before acknowledging them
+        void HangUpAfter(int batches) { m_hangUpAfter = batches; }
+
+        // Wait until count distinct events are stored
+        bool WaitForEvents(size_t count, std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, timeout, [&]() { return m_sequenceIds.size() >= count; });
+        }
+
+        // Sequence IDs of the stored events, in arrival order
+        std::vector<uint64_t> GetSequenceIds() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_sequenceIds;
+        }
+
+        std::vector<DriverEvent> GetEvents() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_events;
+        }
+
+        void Clear() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_sequenceIds.clear();
+            m_events.clear();
+        }
+
+        void KeepEvents(bool keep) { m_keepEvents = keep; }
+
+        uint64_t GetBatchCount() const { return m_batches; }
+        uint64_t GetDuplicateEvents() const { return m_duplicateEvents; }
+        uint64_t GetHelloCount() const { return m_hellos; }
+
+    private:
+        intptr_t m_listener;
+        uint16_t m_port;
+        std::thread m_thread;
+        std::atomic<bool> m_stop;
+        std::atomic<int> m_hangUpAfter;
+        std::atomic<bool> m_keepEvents{ false };
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_changed;
+        std::map<uint64_t, uint64_t> m_acked;       // Stream -> highest stored sequence
+        std::vector<uint64_t> m_sequenceIds;
+        std::vector<DriverEvent> m_events;
+        std::atomic<uint64_t> m_batches;
+        std::atomic<uint64_t> m_duplicateEvents;
+        std::atomic<uint64_t> m_hellos;
+
+        void Run() {
+            while (!m_stop) {
+                if (!Socket::WaitReadable(m_listener, std::chrono::milliseconds(20))) {
+                    continue;
+                }
+                intptr_t connection = Socket::Accept(m_listener);
+                if (connection != Socket::kNoSocket) {
+                    Serve(connection);
+                    Socket::Close(connection);
+                }
+            }
+        }
+
+        void Serve(intptr_t connection) {
+            ForwardFrameReader reader;
+            ForwardBatch batch;
+            int batchesHere = 0;
+            char buffer[65536];
+            while (!m_stop) {
+                if (!Socket::WaitReadable(connection, std::chrono::milliseconds(20))) {
+                    continue;
+                }
+                int received = Socket::Receive(connection, buffer, sizeof(buffer));
+                if (received <= 0) {
+                    return;
+                }
+                reader.Append(buffer, static_cast<size_t>(received));
+
+                std::string acks;
+                const char* payload;
+                size_t length;
+                while (reader.Next(payload, length)) {
+                    if (static_cast<uint8_t>(payload[0]) == ForwardProtocol::kHello) {
+                        m_hellos++;
+                        continue;
+                    }
+                    if (!EventForwarder::DecodeBatch(payload, length, batch)) {
+                        return;
+                    }
+                    int hangUpAfter = m_hangUpAfter;
+                    if (hangUpAfter > 0 && ++batchesHere > hangUpAfter) {
+                        m_hangUpAfter = 0;
+                        return;
+                    }
+                    m_batches++;
+                    Store(batch);
+                    EventForwarder::EncodeAck(batch.stream, batch.sequence, acks);
+                }
+                if (reader.HasError() || (!acks.empty() && !Socket::SendAll(connection, acks.data(), acks.size()))) {
+                    return;
+                }
+            }
+        }
+
+        void Store(const ForwardBatch& batch) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            uint64_t& acked = m_acked[batch.stream];
+            if (batch.sequence <= acked) {
+                m_duplicateEvents += batch.events.size();
+                return;
+            }
+            acked = batch.sequence;
+            for (const auto& event : batch.events) {
+                m_sequenceIds.push_back(event.sequenceId);
+                if (m_keepEvents) {
+                    m_events.push_back(event);
+                }
+            }
+            m_changed.notify_all();
+        }
+    };
+
+    // Classified sample events numbered 1..count like a fresh history
+    std::vector<DriverEvent> MakeForwardEvents(size_t count) {
+        std::vector<DriverEvent> events = MakeSampleEvents(count);
+        for (size_t i = 0; i < events.size(); ++i) {
+            events[i].sequenceId = i + 1;
+        }
+        return events;
+    }
+
+    ForwarderOptions MakeOptions(uint16_t port) {
+        ForwarderOptions options;
+        options.host = "127.0.0.1";
+        options.port = port;
+        options.hostName = "bench";
+        options.batchEvents = 64;
+        options.flushInterval = std::chrono::milliseconds(20);
+        options.minBackoff = std::chrono::milliseconds(10);
+        options.maxBackoff = std::chrono::milliseconds(50);
+        options.connectTimeout = std::chrono::milliseconds(500);
+        options.drainTimeout = std::chrono::milliseconds(5000);
+        return options;
+    }
+
+    // A port nothing listens on (bound once, then released)
+    uint16_t GetClosedPort() {
+        StandInCollector collector;
+        if (!collector.Start()) {
+            return 0;
+        }
+        uint16_t port = collector.GetPort();
+        collector.Stop();
+        return port;
+    }
+
+    std::string MakeSpoolDirectory(const char* name) {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+        std::error_code error;
+        std::filesystem::remove_all(path, error);
+        return path.string();
+    }
+
+    size_t CountSpoolFiles(const std::string& path) {
+        size_t count = 0;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(path, error)) {
+            count += entry.path().extension() == ".batch" ? 1 : 0;
+        }
+        return count;
+    }
+
+    // Every ID from 1 to count exactly once (in any order)
+    bool HasEveryEvent(std::vector<uint64_t> ids, size_t count) {
+        std::sort(ids.begin(), ids.end());
+        if (ids.size() != count) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (ids[i] != i + 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Submit a batch at a time with a pause in between, as the pipeline
+    // would; a burst faster than the forwarder thread is dropped instead
+    void SubmitPaced(EventForwarder& forwarder, const std::vector<DriverEvent>& events, size_t batchEvents) {
+        for (size_t i = 0; i < events.size(); ++i) {
+            forwarder.Submit(events[i]);
+            if ((i + 1) % batchEvents == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+    }
+
+    template <typename Condition>
+    bool WaitUntil(Condition condition, std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return true;
+    }
+}
+
+bool VerifyForwarder(std::string& error) {
+    // Compression round trips, including overlapping matches and incompressible data
+    {
+        std::mt19937 random(5);
+        std::string noise(70000, '\0');
+        for (auto& c : noise) {
+            c = static_cast<char>(random());
+        }
+        std::string text;
+        for (int i = 0; i < 2000; ++i) {
+            text += "\\SystemRoot\\System32\\drivers\\driver" + std::to_string(i % 37) + ".sys;";
+        }
+        const std::string inputs[] = { std::string(), "a", "abcd", std::string(100000, 'x'), noise, text };
+        for (const auto& input : inputs) {
+            std::string compressed;
+            std::string output;
+            Lz::Compress(input.data(), input.size(), compressed);
+            if (compressed.size() > Lz::GetMaxCompressedSize(input.size()) ||
+                !Lz::Decompress(compressed.data(), compressed.size(), input.size(), output) || output != input) {
+                error = "Lz round trip failed for " + std::to_string(input.size()) + " bytes";
+                return false;
+            }
+            if (!input.empty()) {
+                std::string truncated;
+                if (Lz::Decompress(compressed.data(), compressed.size() - 1, input.size(), truncated)) {
+                    error = "Lz accepted a truncated block";
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Batch frames decode to the events they were made of
+    std::vector<DriverEvent> events = MakeForwardEvents(3000);
+    {
+        std::vector<DriverEvent> slice(events.begin(), events.begin() + 300);
+        for (bool compress : { false, true }) {
+            std::string frame;
+            EventForwarder::EncodeBatch(7, 9, slice, compress, frame);
+            ForwardFrameReader reader;
+            reader.Append(frame.data(), frame.size());
+            const char* payload;
+            size_t length;
+            ForwardBatch batch;
+            if (!reader.Next(payload, length) || !EventForwarder::DecodeBatch(payload, length, batch) ||
+                batch.stream != 7 || batch.sequence != 9 || batch.events.size() != slice.size()) {
+                error = "batch frame did not decode";
+                return false;
+            }
+            for (size_t i = 0; i < slice.size(); ++i) {
+                const DriverEvent& a = slice[i];
+                const DriverEvent& b = batch.events[i];
+                if (a.sequenceId != b.sequenceId || a.timestampUs != b.timestampUs || a.timestamp != b.timestamp ||
+                    a.driverName != b.driverName || a.installPath != b.installPath || a.loadingMethod != b.loadingMethod ||
+                    a.initiatedBy != b.initiatedBy || a.signerInfo != b.signerInfo || a.processId != b.processId ||
+                    a.eventType != b.eventType || a.threatLevel != b.threatLevel || a.source != b.source ||
+                    a.isRemoval != b.isRemoval) {
+                    error = "batch event " + std::to_string(i) + " changed in the round trip";
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Collector up: everything is delivered and acknowledged
+    {
+        StandInCollector collector;
+        if (!collector.Start()) {
+            error = "cannot start the stand-in collector";
+            return false;
+        }
+        EventForwarder forwarder;
+        if (!forwarder.Start(MakeOptions(collector.GetPort()))) {
+            error = "forwarder did not start: " + forwarder.GetLastError();
+            return false;
+        }
+        for (const auto& event : events) {
+            forwarder.Submit(event);
+        }
+        forwarder.Stop();
+        ForwarderStats stats = forwarder.GetStats();
+        if (!HasEveryEvent(collector.GetSequenceIds(), events.size()) || stats.eventsAcked != events.size() ||
+            stats.eventsDropped != 0 || stats.pendingBatches != 0 || collector.GetHelloCount() != 1) {
+            error = "forwarder did not deliver every event exactly once to a healthy collector (" +
+                    std::to_string(collector.GetSequenceIds().size()) + " stored, " +
+                    std::to_string(stats.eventsAcked) + " acknowledged, " + std::to_string(stats.eventsDropped) +
+                    " dropped, " + std::to_string(collector.GetHelloCount()) + " hellos)";
+            return false;
+        }
+        if (stats.compressedBytes * 2 > stats.rawBytes) {
+            error = "batches compressed less than 2:1";
+            return false;
+        }
+    }
+
+    // Collector hangs up before acknowledging: the batches are sent again
+    {
+        StandInCollector collector;
+        collector.HangUpAfter(5);
+        if (!collector.Start()) {
+            error = "cannot start the stand-in collector";
+            return false;
+        }
+        EventForwarder forwarder;
+        ForwarderOptions options = MakeOptions(collector.GetPort());
+        options.window = 4;
+        forwarder.Start(options);
+        for (const auto& event : events) {
+            forwarder.Submit(event);
+        }
+        bool delivered = collector.WaitForEvents(events.size(), std::chrono::milliseconds(10000));
+        forwarder.Stop();
+        ForwarderStats stats = forwarder.GetStats();
+        if (!delivered || !HasEveryEvent(collector.GetSequenceIds(), events.size()) || stats.connects < 2 ||
+            stats.batchesResent == 0 || stats.eventsAcked != events.size()) {
+            error = "forwarder did not resend unacknowledged batches after the collector hung up";
+            return false;
+        }
+    }
+
+    // Collector down: batches beyond the buffer go to the spool, the rest at
+    // Stop(); reconnects back off; the next forwarder delivers the spool
+    {
+        uint16_t port = GetClosedPort();
+        std::string spool = MakeSpoolDirectory("drivermonitor_forward_spool");
+        ForwarderOptions options = MakeOptions(port);
+        options.spoolPath = spool;
+        options.bufferBytes = 16 * 1024;
+        options.minBackoff = std::chrono::milliseconds(50);
+        options.maxBackoff = std::chrono::milliseconds(200);
+        {
+            EventForwarder forwarder;
+            if (!forwarder.Start(options)) {
+                error = "forwarder did not start: " + forwarder.GetLastError();
+                return false;
+            }
+            SubmitPaced(forwarder, events, options.batchEvents);
+            bool spooling = WaitUntil([&]() { return forwarder.GetStats().batchesSpooled > 0; }, std::chrono::milliseconds(2000));
+            ForwarderStats stats = forwarder.GetStats();
+            if (!spooling || stats.bufferedBytes > options.bufferBytes) {
+                error = "forwarder buffered beyond its limit instead of spooling (" +
+                        std::to_string(stats.bufferedBytes) + " bytes, " + std::to_string(stats.batchesSpooled) +
+                        " batches spooled)";
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            forwarder.Stop();
+            stats = forwarder.GetStats();
+            // 50, 100, 200, 200, ... ms (+-25%) in one second
+            if (stats.connectFailures < 3 || stats.connectFailures > 12 || stats.eventsAcked != 0 ||
+                stats.eventsDropped != 0 || CountSpoolFiles(spool) != (events.size() + 63) / 64) {
+                error = "unreachable collector: wrong backoff or spool (" + std::to_string(stats.connectFailures) +
+                        " attempts, " + std::to_string(CountSpoolFiles(spool)) + " spool files)";
+                return false;
+            }
+        }
+
+        StandInCollector collector;
+        if (!collector.Start(port)) {
+            error = "cannot restart the stand-in collector";
+            return false;
+        }
+        EventForwarder forwarder;
+        forwarder.Start(options);
+        bool delivered = collector.WaitForEvents(events.size(), std::chrono::milliseconds(10000));
+        forwarder.Stop();
+        if (!delivered || !HasEveryEvent(collector.GetSequenceIds(), events.size()) || CountSpoolFiles(spool) != 0 ||
+            forwarder.GetStats().spooledBytes != 0) {
+            error = "spooled batches were not delivered after the collector came back";
+            return false;
+        }
+        std::error_code ignored;
+        std::filesystem::remove_all(spool, ignored);
+    }
+
+    // No spool: a full buffer drops the oldest batches, and every event is
+    // accounted for as acknowledged or dropped
+    {
+        EventForwarder forwarder;
+        ForwarderOptions options = MakeOptions(GetClosedPort());
+        options.bufferBytes = 8 * 1024;
+        forwarder.Start(options);
+        for (const auto& event : events) {
+            forwarder.Submit(event);
+        }
+        bool dropping = WaitUntil([&]() { return forwarder.GetStats().eventsDropped > 0; }, std::chrono::milliseconds(2000));
+        ForwarderStats stats = forwarder.GetStats();
+        forwarder.Stop();
+        ForwarderStats final = forwarder.GetStats();
+        if (!dropping || stats.bufferedBytes > options.bufferBytes || final.eventsDropped != events.size() ||
+            final.eventsSubmitted != events.size()) {
+            error = "forwarder without a spool did not stay within its buffer (" +
+                    std::to_string(stats.bufferedBytes) + " bytes, " + std::to_string(final.eventsDropped) + " of " +
+                    std::to_string(final.eventsSubmitted) + " dropped)";
+            return false;
+        }
+    }
+    return true;
+}
+
+void RunForwardBenchmarks(BenchmarkRunner& runner) {
+    std::vector<DriverEvent> events = MakeForwardEvents(4096);
+
+    // Compress one encoded batch of 256 events
+    {
+        std::vector<DriverEvent> batch(events.begin(), events.begin() + 256);
+        std::string frame;
+        EventForwarder::EncodeBatch(1, 1, batch, false, frame);
+        runner.Run("Forward/Compress", [&](uint64_t iterations) {
+            std::string compressed;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                compressed.clear();
+                Lz::Compress(frame.data(), frame.size(), compressed);
+                KeepAlive(compressed);
+            }
+        });
+    }
+
+    if (runner.IsSelected("Forward/Submit") || runner.IsSelected("Forward/Deliver")) {
+        StandInCollector collector;
+        if (collector.Start()) {
+            // Cost on the pipeline thread per event
+            EventForwarder forwarder;
+            forwarder.Start(MakeOptions(collector.GetPort()));
+            runner.Run("Forward/Submit", [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    forwarder.Submit(events[i % events.size()]);
+                }
+            });
+
+            // Submitted until acknowledged by the collector, per event
+            ForwarderOptions options = MakeOptions(collector.GetPort());
+            options.batchEvents = 256;
+            forwarder.Stop();
+            EventForwarder delivering;
+            delivering.Start(options);
+            runner.Run("Forward/Deliver", [&](uint64_t iterations) {
+                uint64_t target = delivering.GetStats().eventsAcked + iterations;
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    delivering.Submit(events[i % events.size()]);
+                }
+                WaitUntil([&]() { return delivering.GetStats().eventsAcked >= target; }, std::chrono::milliseconds(60000));
+            });
+        }
+    }
+
+    // Collector down: submitted, spooled at Stop() and cleared, per event
+    if (runner.IsSelected("Forward/Spool")) {
+        ForwarderOptions options = MakeOptions(GetClosedPort());
+        options.batchEvents = 256;
+        options.spoolPath = MakeSpoolDirectory("drivermonitor_forward_bench");
+        options.minBackoff = std::chrono::milliseconds(10000);
+        runner.Run("Forward/Spool", [&](uint64_t iterations) {
+            EventForwarder forwarder;
+            forwarder.Start(options);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                forwarder.Submit(events[i % events.size()]);
+            }
+            forwarder.Stop();
+            std::error_code error;
+            std::filesystem::remove_all(options.spoolPath, error);
+        });
+    }
+}
+
+} // namespace DriverMonitor
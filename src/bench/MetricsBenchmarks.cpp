@@ -0,0 +1,336 @@
+#include "BenchCases.h"
+#include "../core/Config.h"
+#include "../core/DriverMonitor.h"
+#include "../core/EventManager.h"
+#include "../core/Metrics.h"
+#include "../core/MetricsServer.h"
+#include "../core/SignerCache.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace DriverMonitor {
+
+namespace {
+    std::string TemporaryPath(const char* name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    void WriteFile(const std::string& filePath, const std::string& contents) {
+        std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+        file << contents;
+    }
+
+    std::string ReadFile(const std::string& filePath) {
+        std::ifstream file(filePath, std::ios::binary);
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    // Value of the sample line that starts with series ("name{labels}"), or -1
+    double FindSample(const std::string& exposition, const std::string& series) {
+        size_t position = 0;
+        while ((position = exposition.find(series + " ", position)) != std::string::npos) {
+            if (position == 0 || exposition[position - 1] == '\n') {
+                return std::stod(exposition.substr(position + series.size() + 1));
+            }
+            position += series.size();
+        }
+        return -1;
+    }
+
+    // One request to the loopback listener; the whole response, "" if it fails
+    std::string HttpRequest(uint16_t port, const std::string& request) {
+#ifdef _WIN32
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            return std::string();
+        }
+        SOCKET client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+#else
+        int client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+#endif
+        std::string response;
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        if (connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+            send(client, request.data(), static_cast<int>(request.size()), 0) == static_cast<int>(request.size())) {
+            char buffer[4096];
+            int received;
+            while ((received = static_cast<int>(recv(client, buffer, sizeof(buffer), 0))) > 0) {
+                response.append(buffer, static_cast<size_t>(received));
+            }
+        }
+#ifdef _WIN32
+        closesocket(client);
+        WSACleanup();
+#else
+        close(client);
+#endif
+        return response;
+    }
+
+    std::string HttpGet(uint16_t port, const char* path) {
+        return HttpRequest(port, std::string("GET ") + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+    }
+
+    // No log file or sounds from the monitors below
+    void MakeQuiet(Config& config) {
+        config.GetConfig().loggingEnabled = false;
+        config.GetConfig().playSound = false;
+        config.NotifyChanged();
+    }
+}
+
+bool VerifyMetrics(std::string& error) {
+    // Series of one family are grouped under one HELP/TYPE header; label values are escaped
+    MetricsRegistry registry;
+    MetricCounter& first = registry.AddCounter("test_events_total", "Events.", "kind=\"a\"");
+    MetricGauge& gauge = registry.AddGauge("test_depth", "Depth.");
+    MetricCounter& second = registry.AddCounter("test_events_total", "Events.",
+                                                MetricsWriter::Label("kind", "b\"\\\n"));
+    first.Increment(3);
+    second.Increment();
+    gauge.Set(-7);
+    std::string exposition = registry.Collect();
+    const std::string expected =
+        "# HELP test_events_total Events.\n"
+        "# TYPE test_events_total counter\n"
+        "test_events_total{kind=\"a\"} 3\n"
+        "test_events_total{kind=\"b\\\"\\\\\\n\"} 1\n"
+        "# HELP test_depth Depth.\n"
+        "# TYPE test_depth gauge\n"
+        "test_depth -7\n";
+    if (exposition != expected) {
+        error = "Metrics exposition is wrong:\n" + exposition;
+        return false;
+    }
+
+    // Histogram buckets are cumulative, in seconds, and +Inf equals the count
+    LatencyHistogram histogram;
+    for (uint64_t value : { 500ull, 2000ull, 2000ull, 80000ull, 3000000000ull, 50000000000ull }) {
+        histogram.Record(value);
+    }
+    std::string histogramText;
+    MetricsWriter writer(histogramText);
+    writer.Histogram("test_seconds", "stage=\"x\"", histogram);
+    if (FindSample(histogramText, "test_seconds_bucket{stage=\"x\",le=\"1e-06\"}") != 1 ||
+        FindSample(histogramText, "test_seconds_bucket{stage=\"x\",le=\"5e-06\"}") != 3 ||
+        FindSample(histogramText, "test_seconds_bucket{stage=\"x\",le=\"0.0001\"}") != 4 ||
+        FindSample(histogramText, "test_seconds_bucket{stage=\"x\",le=\"5\"}") != 5 ||
+        FindSample(histogramText, "test_seconds_bucket{stage=\"x\",le=\"10\"}") != 5 ||
+        FindSample(histogramText, "test_seconds_bucket{stage=\"x\",le=\"+Inf\"}") != 6 ||
+        FindSample(histogramText, "test_seconds_count{stage=\"x\"}") != 6 ||
+        std::abs(FindSample(histogramText, "test_seconds_sum{stage=\"x\"}") - 53.000084500) > 1e-6) {
+        error = "Metrics histogram buckets are wrong:\n" + histogramText;
+        return false;
+    }
+
+    // Signer cache: hits until the file changes, LRU eviction at capacity
+    const std::string fileA = TemporaryPath("driver_monitor_signer_a.sys");
+    const std::string fileB = TemporaryPath("driver_monitor_signer_b.sys");
+    const std::string fileC = TemporaryPath("driver_monitor_signer_c.sys");
+    WriteFile(fileA, "a");
+    WriteFile(fileB, "b");
+    WriteFile(fileC, "c");
+    size_t verifications = 0;
+    SignerCache cache(2, [&verifications](const std::string& filePath) {
+        verifications++;
+        return "Signer of " + filePath;
+    });
+    bool cacheOk = cache.GetSignerInfo(fileA) == "Signer of " + fileA && cache.GetSignerInfo(fileA) == "Signer of " + fileA &&
+                   verifications == 1 && cache.GetHits() == 1 && cache.GetMisses() == 1;
+    WriteFile(fileA, "aa");    // Size changes: verified again
+    cacheOk = cacheOk && !cache.GetSignerInfo(fileA).empty() && verifications == 2;
+    cache.GetSignerInfo(fileB);
+    cache.GetSignerInfo(fileA);    // A is now the most recently used
+    cache.GetSignerInfo(fileC);    // Evicts B
+    cacheOk = cacheOk && verifications == 4 && cache.GetSize() == 2;
+    cache.GetSignerInfo(fileA);
+    cacheOk = cacheOk && verifications == 4;
+    cache.GetSignerInfo(fileB);
+    cacheOk = cacheOk && verifications == 5;
+    cache.GetSignerInfo(TemporaryPath("driver_monitor_signer_missing.sys"));    // Never cached
+    cache.GetSignerInfo(TemporaryPath("driver_monitor_signer_missing.sys"));
+    cacheOk = cacheOk && verifications == 7 && cache.GetSize() == 2;
+    std::remove(fileA.c_str());
+    std::remove(fileB.c_str());
+    std::remove(fileC.c_str());
+    if (!cacheOk) {
+        error = "Signer cache hits, invalidation or eviction are wrong (" + std::to_string(verifications) +
+                " verifications, " + std::to_string(cache.GetHits()) + " hits)";
+        return false;
+    }
+
+    // The monitor's metrics match its pipeline statistics
+    Config config;
+    MakeQuiet(config);
+    EventManager eventManager;
+    eventManager.SetMaxEvents(1000);
+    MetricsRegistry monitorMetrics;
+    {
+        DriverMonitor monitor(&eventManager, &config);
+        monitor.RegisterMetrics(monitorMetrics);
+        std::vector<DriverEvent> samples = MakeSampleEvents(100);
+
+        // Scrape continuously while the pipeline runs
+        std::atomic<bool> done(false);
+        std::atomic<uint64_t> scrapes(0);
+        std::thread scraper([&]() {
+            while (!done) {
+                std::string text = monitorMetrics.Collect();
+                KeepAlive(text);
+                scrapes++;
+            }
+        });
+        monitor.StartIngestion();
+        for (size_t i = 0; i < 5000; ++i) {
+            DriverEvent event = samples[i % samples.size()];
+            monitor.SubmitObservation(std::move(event), true);
+        }
+        monitor.Stop();
+        done = true;
+        scraper.join();
+
+        PipelineStats stats = monitor.GetPipelineStats();
+        exposition = monitorMetrics.Collect();
+        double eventsTotal = 0;
+        for (size_t type = 0; type < 3; ++type) {
+            for (size_t source = 0; source <= static_cast<size_t>(EventSource::Synthetic); ++source) {
+                for (size_t threat = 0; threat < 3; ++threat) {
+                    std::string series = "drivermonitor_events_total{" +
+                        MetricsWriter::Label("type", Utils::GetEventTypeName(static_cast<EventType>(type))) + "," +
+                        MetricsWriter::Label("source", Utils::GetSourceName(static_cast<EventSource>(source))) + "," +
+                        MetricsWriter::Label("threat", Utils::GetThreatLevelName(static_cast<ThreatLevel>(threat))) + "}";
+                    eventsTotal += std::max(0.0, FindSample(exposition, series));
+                }
+            }
+        }
+        if (scrapes == 0 || stats.processed != 5000 ||
+            FindSample(exposition, "drivermonitor_observations_processed_total") != 5000 ||
+            eventsTotal != static_cast<double>(stats.processed - stats.filtered) ||
+            FindSample(exposition, "drivermonitor_stage_duration_seconds_count{stage=\"classify\"}") != 5000) {
+            error = "Monitor metrics do not match the pipeline statistics:\n" + exposition;
+            return false;
+        }
+    }
+    // Registered counters stay with the registry; the monitor's collector goes with it
+    if (monitorMetrics.Collect().find("drivermonitor_stage_duration_seconds") != std::string::npos) {
+        error = "Monitor metrics are still collected after the monitor is destroyed";
+        return false;
+    }
+
+    // Listener: /metrics answers with the exposition, anything else is refused
+    registry.AddCollector([](MetricsWriter& collector) {
+        collector.BeginFamily("test_collected", "From a collector.", MetricType::Gauge);
+        collector.Sample("test_collected", std::string(), 1.5);
+    });
+    MetricsServer server(&registry);
+    MetricsServerOptions options;
+    options.listen = true;
+    options.port = 0;
+    options.textFile = TemporaryPath("driver_monitor_verify.prom");
+    options.interval = std::chrono::milliseconds(50);
+    if (!server.Start(options)) {
+        error = "Metrics server does not start: " + server.GetLastError();
+        return false;
+    }
+    std::string ok = HttpGet(server.GetPort(), "/metrics");
+    std::string missing = HttpGet(server.GetPort(), "/other");
+    std::string head = HttpRequest(server.GetPort(), "HEAD /metrics HTTP/1.1\r\n\r\n");
+    std::string posted = HttpRequest(server.GetPort(), "POST /metrics HTTP/1.1\r\n\r\n");
+    while (server.GetFileWriteCount() < 2) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    server.Stop();
+    std::string fileText = ReadFile(options.textFile);
+    bool leftTemporary = std::filesystem::exists(options.textFile + ".tmp");
+    std::remove(options.textFile.c_str());
+
+    std::string body = registry.Collect();
+    if (ok.compare(0, 15, "HTTP/1.1 200 OK") != 0 ||
+        ok.find("Content-Type: text/plain; version=0.0.4") == std::string::npos ||
+        ok.substr(ok.find("\r\n\r\n") + 4) != body || body.find("test_collected 1.5\n") == std::string::npos ||
+        missing.compare(0, 12, "HTTP/1.1 404") != 0 || posted.compare(0, 12, "HTTP/1.1 405") != 0 ||
+        head.compare(0, 15, "HTTP/1.1 200 OK") != 0 || head.size() != head.find("\r\n\r\n") + 4 ||
+        server.GetScrapeCount() != 2) {
+        error = "Metrics listener responses are wrong:\n" + ok.substr(0, 200) + "\n" + missing.substr(0, 100);
+        return false;
+    }
+    if (fileText != body || leftTemporary) {
+        error = "Metrics textfile is not the exposition, or its temporary file was left behind";
+        return false;
+    }
+    return true;
+}
+
+void RunMetricsBenchmarks(BenchmarkRunner& runner) {
+    MetricsRegistry registry;
+    MetricCounter& counter = registry.AddCounter("bench_total", "Benchmark counter.");
+    runner.Run("Metrics/Counter", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            counter.Increment();
+        }
+    });
+
+    // Full exposition of a monitor that processed events (all stages populated)
+    Config config;
+    MakeQuiet(config);
+    EventManager eventManager;
+    eventManager.SetMaxEvents(1000);
+    DriverMonitor monitor(&eventManager, &config);
+    RegisterProcessMetrics(registry);
+    monitor.RegisterMetrics(registry);
+    std::vector<DriverEvent> samples = MakeSampleEvents(1000);
+    monitor.StartIngestion();
+    for (const auto& sample : samples) {
+        DriverEvent event = sample;
+        monitor.SubmitObservation(std::move(event), true);
+    }
+    monitor.Stop();
+
+    runner.Run("Metrics/Collect", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            std::string text = registry.Collect();
+            KeepAlive(text);
+        }
+    });
+
+    if (runner.IsSelected("Metrics/Scrape")) {
+        MetricsServer server(&registry);
+        MetricsServerOptions options;
+        options.listen = true;
+        options.port = 0;
+        if (server.Start(options)) {
+            runner.RunLatency("Metrics/Scrape", 200, [&](uint64_t) {
+                std::string response = HttpGet(server.GetPort(), "/metrics");
+                KeepAlive(response);
+            });
+            server.Stop();
+        }
+    }
+}
+
+} // namespace DriverMonitor
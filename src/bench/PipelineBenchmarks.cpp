@@ -0,0 +1,632 @@
+#include "BenchCases.h"
+#include "../core/DriverMonitor.h"
+#include "../core/EventManager.h"
+#include "../core/Config.h"
+#include "../core/JsonCodec.h"
+#include "../core/LatencyHistogram.h"
+#include "../core/Trace.h"
+#include "../core/KnownDriverSet.h"
+#include "../core/MemoryAccounting.h"
+#include "../core/SignerCache.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DriverMonitor {
+
+namespace {
+    // Log-uniform latencies from 10 ns to ~10 s, deterministic per seed
+    std::vector<uint64_t> MakeLatencies(size_t count, uint64_t seed) {
+        std::mt19937_64 random(seed);
+        std::uniform_real_distribution<double> exponent(1.0, 10.0);
+        std::vector<uint64_t> values(count);
+        for (auto& value : values) {
+            value = static_cast<uint64_t>(std::pow(10.0, exponent(random)));
+        }
+        return values;
+    }
+
+    // Percentile value is within one bucket (~3%) above the exact one
+    bool WithinResolution(uint64_t reported, uint64_t exact) {
+        return reported >= exact && reported - exact <= exact / 32 + 1;
+    }
+
+    struct TraceSpanRecord {
+        std::string name;
+        int64_t tid;
+        double ts;
+        double dur;
+    };
+
+    // Complete spans of a trace-event document; false if it is not valid JSON
+    bool ParseTrace(const std::string& json, std::vector<TraceSpanRecord>& spans) {
+        JsonReader reader(json.data(), json.size());
+        int depth = 0;
+        TraceSpanRecord span;
+        std::string key;
+        std::string phase;
+        for (;;) {
+            JsonToken token = reader.Next();
+            switch (token) {
+                case JsonToken::Error: return false;
+                case JsonToken::End: return true;
+                case JsonToken::BeginObject:
+                    if (++depth == 2) {
+                        span = TraceSpanRecord();
+                        phase.clear();
+                    }
+                    break;
+                case JsonToken::EndObject:
+                    if (depth-- == 2 && phase == "X") {
+                        spans.push_back(span);
+                    }
+                    break;
+                case JsonToken::Key:
+                    key = reader.GetString();
+                    break;
+                case JsonToken::String:
+                    if (depth == 2 && key == "name") span.name = reader.GetString();
+                    if (depth == 2 && key == "ph") phase = reader.GetString();
+                    break;
+                case JsonToken::Number:
+                    if (depth == 2 && key == "tid") span.tid = reader.GetInteger();
+                    if (depth == 2 && key == "ts") span.ts = reader.GetNumber();
+                    if (depth == 2 && key == "dur") span.dur = reader.GetNumber();
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    std::string TemporaryPath(const char* name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    std::string WriteTrace() {
+        std::ostringstream out;
+        Tracer::WriteJson(out);
+        return out.str();
+    }
+
+    // Process count events through an ingestion-only pipeline
+    void RunPipeline(DriverMonitor& monitor, const std::vector<DriverEvent>& samples, uint64_t count) {
+        monitor.StartIngestion();
+        for (uint64_t i = 0; i < count; ++i) {
+            DriverEvent event = samples[i % samples.size()];
+            monitor.SubmitObservation(std::move(event), true);
+        }
+        monitor.Stop();
+    }
+}
+
+bool VerifyLatencyHistogram(std::string& error) {
+    // Buckets are ordered, cover every value and stay within the resolution
+    size_t previousIndex = 0;
+    for (uint64_t value = 0; value < (uint64_t(1) << LatencyHistogram::kMaxValueBits); value = value * 9 / 8 + 1) {
+        size_t index = LatencyHistogram::GetBucketIndex(value);
+        uint64_t upper = LatencyHistogram::GetBucketUpperBound(index);
+        if (index >= LatencyHistogram::kBucketCount || index < previousIndex || !WithinResolution(upper, value)) {
+            error = "Latency bucket of " + std::to_string(value) + " is " + std::to_string(index) +
+                    " (upper bound " + std::to_string(upper) + ")";
+            return false;
+        }
+        if (index > 0 && LatencyHistogram::GetBucketUpperBound(index - 1) >= value) {
+            error = "Latency bucket " + std::to_string(index - 1) + " also covers " + std::to_string(value);
+            return false;
+        }
+        previousIndex = index;
+    }
+
+    // Percentiles against the sorted samples
+    std::vector<uint64_t> values = MakeLatencies(100000, 7);
+    LatencyHistogram histogram;
+    for (uint64_t value : values) {
+        histogram.Record(value);
+    }
+    std::vector<uint64_t> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    for (double fraction : { 0.5, 0.9, 0.99, 0.999, 1.0 }) {
+        uint64_t exact = sorted[static_cast<size_t>(fraction * sorted.size() + 0.5) - 1];
+        uint64_t reported = histogram.GetPercentile(fraction);
+        if (!WithinResolution(reported, exact)) {
+            error = "Latency percentile " + std::to_string(fraction) + " is " + std::to_string(reported) +
+                    ", expected " + std::to_string(exact);
+            return false;
+        }
+    }
+    if (histogram.GetMax() != sorted.back() || histogram.GetCount() != values.size()) {
+        error = "Latency histogram count or maximum is wrong";
+        return false;
+    }
+
+    // Threads record concurrently with a merging reader; each thread's shard
+    // outlives the thread, and the merge equals recording everything in one place
+    const size_t kThreads = 4;
+    LatencyRecorder recorder(2);
+    std::atomic<bool> done(false);
+    std::thread reader([&]() {
+        while (!done) {
+            LatencyHistogram merged = recorder.GetHistogram(0);
+            KeepAlive(merged);
+        }
+    });
+    std::vector<std::thread> writers;
+    for (size_t t = 0; t < kThreads; ++t) {
+        writers.emplace_back([&recorder, &values, t, kThreads]() {
+            for (size_t i = t; i < values.size(); i += kThreads) {
+                recorder.Record(i % 2, values[i]);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    done = true;
+    reader.join();
+
+    LatencyHistogram expected[2];
+    for (size_t i = 0; i < values.size(); ++i) {
+        expected[i % 2].Record(values[i]);
+    }
+    for (size_t stage = 0; stage < 2; ++stage) {
+        LatencyHistogram merged = recorder.GetHistogram(stage);
+        bool same = merged.GetCount() == expected[stage].GetCount() && merged.GetTotal() == expected[stage].GetTotal() &&
+                    merged.GetMax() == expected[stage].GetMax();
+        for (size_t i = 0; same && i < LatencyHistogram::kBucketCount; ++i) {
+            same = merged.GetBucketCount(i) == expected[stage].GetBucketCount(i);
+        }
+        if (!same) {
+            error = "Merged per-thread latency histograms differ from one histogram of the same samples";
+            return false;
+        }
+    }
+
+    // Every processed observation is timed once per pipeline stage it went through
+    Config config;
+    config.GetConfig().loggingEnabled = false;
+    config.NotifyChanged();
+    EventManager eventManager;
+    eventManager.SetMaxEvents(1000);
+    DriverMonitor monitor(&eventManager, &config);
+    RunPipeline(monitor, MakeSampleEvents(100), 500);
+    PipelineStats stats = monitor.GetPipelineStats();
+    uint64_t stored = stats.processed - stats.filtered;
+    if (stats.processed != 500 || monitor.GetStageTiming(PipelineStage::QueueWait).count != 500 ||
+        monitor.GetStageTiming(PipelineStage::Classify).count != 500 ||
+        monitor.GetStageTiming(PipelineStage::Filter).count != 500 ||
+        monitor.GetStageTiming(PipelineStage::Store).count != stored ||
+        monitor.GetStageTiming(PipelineStage::EndToEnd).count != stored) {
+        error = "Pipeline stage latency counts do not match the processed observations";
+        return false;
+    }
+    StageTiming endToEnd = monitor.GetStageTiming(PipelineStage::EndToEnd);
+    if (endToEnd.p50Ns > endToEnd.p99Ns || endToEnd.p99Ns > endToEnd.p999Ns || endToEnd.p999Ns > endToEnd.maxNs) {
+        error = "Pipeline end-to-end percentiles are not ordered";
+        return false;
+    }
+    return true;
+}
+
+bool VerifyTrace(std::string& error) {
+    if (!Tracer::IsAvailable()) {
+        return true;
+    }
+    Tracer::SetEnabled(false);
+    Tracer::Clear();
+
+    // Disabled: nothing is recorded
+    uint64_t recorded = Tracer::GetRecordedCount();
+    {
+        DM_TRACE_SPAN("verifyDisabled", "verify");
+    }
+    if (Tracer::GetRecordedCount() != recorded) {
+        error = "Trace span recorded while tracing is disabled";
+        return false;
+    }
+
+    // Nested spans of one thread nest in the output
+    Tracer::SetEnabled(true);
+    {
+        DM_TRACE_SPAN("verifyOuter", "verify");
+        DM_TRACE_SPAN("verifyInner", "verify");
+    }
+    std::vector<TraceSpanRecord> spans;
+    if (!ParseTrace(WriteTrace(), spans) || spans.size() != 2) {
+        error = "Trace output is not valid trace-event JSON with the recorded spans";
+        return false;
+    }
+    const TraceSpanRecord& outer = spans[0].name == "verifyOuter" ? spans[0] : spans[1];
+    const TraceSpanRecord& inner = spans[0].name == "verifyOuter" ? spans[1] : spans[0];
+    if (outer.name != "verifyOuter" || inner.name != "verifyInner" || outer.tid != inner.tid ||
+        inner.ts < outer.ts || inner.ts + inner.dur > outer.ts + outer.dur) {
+        error = "Trace spans do not nest";
+        return false;
+    }
+
+    // A full ring keeps the most recent spans (all but the slot the writer
+    // would overwrite next), in order. The
+    // writer keeps overwriting while traces are taken; every span copied must
+    // be intact: consecutive spans start 1 us apart and their durations count up.
+    Tracer::Clear();
+    const size_t kSpans = Tracer::kBufferEvents * 8;
+    auto base = std::chrono::steady_clock::now();
+    std::atomic<bool> writing(true);
+    int64_t writerTid = -1;
+    std::thread writer([&]() {
+        Tracer::SetThreadName("verifyWriter");
+        for (size_t i = 0; i < kSpans; ++i) {
+            auto start = base + std::chrono::microseconds(i);
+            Tracer::Record("verifyRing", "verify", start, start + std::chrono::nanoseconds(i % 1000));
+        }
+        writing = false;
+    });
+    bool intact = true;
+    size_t traces = 0;
+    do {
+        spans.clear();
+        intact = ParseTrace(WriteTrace(), spans) && spans.size() <= Tracer::kBufferEvents;
+        for (size_t i = 1; intact && i < spans.size(); ++i) {
+            double expectedDur = std::fmod(spans[i - 1].dur * 1000.0 + 1.0, 1000.0) / 1000.0;
+            intact = std::abs(spans[i].ts - spans[i - 1].ts - 1.0) < 0.0005 && std::abs(spans[i].dur - expectedDur) < 0.0005;
+        }
+        traces++;
+    } while (intact && writing);
+    writer.join();
+    spans.clear();
+    intact = intact && ParseTrace(WriteTrace(), spans) && spans.size() == Tracer::kBufferEvents - 1 &&
+             std::abs(spans.back().dur - static_cast<double>((kSpans - 1) % 1000) / 1000.0) < 0.0005;
+    if (!intact) {
+        error = "Trace ring buffer lost order or returned a torn span (" + std::to_string(spans.size()) +
+                " spans after " + std::to_string(traces) + " traces)";
+        return false;
+    }
+    writerTid = spans.back().tid;
+
+    // An exited thread's buffer is reused by the next thread
+    Tracer::Clear();
+    std::thread([]() {
+        auto now = std::chrono::steady_clock::now();
+        Tracer::Record("verifyReuse", "verify", now, now);
+    }).join();
+    spans.clear();
+    if (!ParseTrace(WriteTrace(), spans) || spans.size() != 1 || spans[0].tid != writerTid) {
+        error = "Trace buffer of an exited thread was not reused";
+        return false;
+    }
+
+    // A slow cycle dumps once per cooldown; fast cycles do not
+    const std::string tracePath = TemporaryPath("driver_monitor_verify_trace.json");
+    const std::string slowPath = TemporaryPath("driver_monitor_verify_trace-slow-0.json");
+    std::remove(slowPath.c_str());
+    uint64_t slowDumps = Tracer::GetSlowDumpCount();
+    Tracer::SetSlowCycleDump(std::chrono::milliseconds(5), tracePath);
+    auto cycleStart = std::chrono::steady_clock::now();
+    Tracer::EndCycle("verifyCycle", cycleStart, cycleStart + std::chrono::milliseconds(1));
+    bool fastDumped = Tracer::GetSlowDumpCount() != slowDumps;
+    Tracer::EndCycle("verifyCycle", cycleStart, cycleStart + std::chrono::milliseconds(10));
+    Tracer::EndCycle("verifyCycle", cycleStart, cycleStart + std::chrono::milliseconds(20));
+    Tracer::SetSlowCycleDump(std::chrono::milliseconds(0), std::string());
+    bool slowDumped = std::filesystem::exists(slowPath) && Tracer::GetSlowDumpCount() == slowDumps + 1;
+    std::remove(slowPath.c_str());
+    if (fastDumped || !slowDumped) {
+        error = "Slow-cycle trace dumps are wrong (fast cycle dumped, slow cycle not dumped, or no cooldown)";
+        return false;
+    }
+
+    // The pipeline traces every processed observation with its stages inside
+    Tracer::Clear();
+    Config config;
+    config.GetConfig().loggingEnabled = false;
+    config.NotifyChanged();
+    EventManager eventManager;
+    eventManager.SetMaxEvents(1000);
+    {
+        DriverMonitor monitor(&eventManager, &config);
+        RunPipeline(monitor, MakeSampleEvents(100), 200);
+    }
+    Tracer::SetEnabled(false);
+    spans.clear();
+    bool parsed = ParseTrace(WriteTrace(), spans);
+    Tracer::Clear();
+    std::map<std::string, size_t> counts;
+    for (const auto& span : spans) {
+        counts[span.name]++;
+    }
+    if (!parsed || counts["process"] != 200 || counts["classify"] != 200 || counts["filter"] != 200 ||
+        counts.count("queueWait") || counts.count("endToEnd")) {
+        error = "Pipeline trace does not have one process/classify/filter span per observation";
+        return false;
+    }
+    return true;
+}
+
+bool VerifyMemoryAccounting(std::string& error) {
+    // Event history: charged as events are stored, evicted and cleared
+    uint64_t historyBefore = MemoryAccounting::GetBytes(MemorySubsystem::EventHistory);
+    {
+        EventManager eventManager;
+        eventManager.SetMaxEvents(10000);
+        FillEventManager(eventManager, 2000);
+        size_t held = eventManager.GetMemoryBytes();
+        if (held < 2000 * sizeof(DriverEvent) ||
+            MemoryAccounting::GetBytes(MemorySubsystem::EventHistory) - historyBefore != held) {
+            error = "event history charge does not match the stored events";
+            return false;
+        }
+        uint64_t firstSequence = eventManager.GetFirstSequence();
+        size_t evicted = eventManager.EvictOldestBytes(held / 2);
+        if (evicted == 0 || eventManager.GetMemoryBytes() > held / 2 ||
+            eventManager.GetFirstSequence() != firstSequence + evicted || eventManager.GetEventCount() != 2000 - evicted) {
+            error = "EvictOldestBytes did not evict the oldest events down to the requested bytes";
+            return false;
+        }
+        eventManager.Clear();
+        if (eventManager.GetMemoryBytes() != 0 || MemoryAccounting::GetBytes(MemorySubsystem::EventHistory) != historyBefore) {
+            error = "event history still charged after Clear";
+            return false;
+        }
+        FillEventManager(eventManager, 100);
+    }
+    if (MemoryAccounting::GetBytes(MemorySubsystem::EventHistory) != historyBefore) {
+        error = "event history still charged after the manager was destroyed";
+        return false;
+    }
+
+    // Known-driver sets: the charge follows inserts and sweeps
+    uint64_t knownBefore = MemoryAccounting::GetBytes(MemorySubsystem::KnownDrivers);
+    {
+        KnownDriverSet known;
+        known.BeginScan();
+        for (uint64_t i = 1; i <= 500; ++i) {
+            known.Insert(i * 0x9E3779B97F4A7C15ULL, "\\SystemRoot\\System32\\drivers\\known_driver_" + std::to_string(i) + ".sys");
+        }
+        size_t inserted = known.GetMemoryBytes();
+        known.BeginScan();
+        known.Sweep([](const std::string&, uint32_t) {});
+        if (known.GetSize() != 0 || known.GetMemoryBytes() >= inserted ||
+            MemoryAccounting::GetBytes(MemorySubsystem::KnownDrivers) - knownBefore != known.GetMemoryBytes()) {
+            error = "known-driver charge does not follow inserts and sweeps";
+            return false;
+        }
+    }
+    if (MemoryAccounting::GetBytes(MemorySubsystem::KnownDrivers) != knownBefore) {
+        error = "known-driver set still charged after it was destroyed";
+        return false;
+    }
+
+    // Configuration: a larger whitelist is charged when published
+    {
+        Config config;
+        uint64_t configBefore = MemoryAccounting::GetBytes(MemorySubsystem::Config);
+        for (int i = 0; i < 200; ++i) {
+            config.AddToWhitelist("whitelisted_driver_with_a_long_name_" + std::to_string(i) + ".sys");
+        }
+        if (MemoryAccounting::GetBytes(MemorySubsystem::Config) < configBefore + 200 * 40) {
+            error = "published whitelist is not charged to config";
+            return false;
+        }
+    }
+
+    // Signer cache: Trim evicts the least recently used entries
+    std::vector<std::string> paths;
+    for (int i = 0; i < 64; ++i) {
+        paths.push_back(TemporaryPath(("drivermonitor_memory_" + std::to_string(i) + ".sys").c_str()));
+        std::ofstream(paths.back()) << i;
+    }
+    struct RemoveFiles {
+        const std::vector<std::string>& paths;
+        ~RemoveFiles() { for (const auto& path : paths) std::remove(path.c_str()); }
+    } removeFiles{ paths };
+    {
+        uint64_t cacheBefore = MemoryAccounting::GetBytes(MemorySubsystem::SignerCache);
+        SignerCache cache(16, [](const std::string& path) { return "CN=Memory Accounting Test Publisher, " + path; });
+        cache.GetSignerInfo(paths[0]);
+        cache.GetSignerInfo(paths[1]);
+        cache.GetSignerInfo(paths[2]);
+        cache.GetSignerInfo(paths[0]);
+        size_t held = cache.GetMemoryBytes();
+        if (held == 0 || MemoryAccounting::GetBytes(MemorySubsystem::SignerCache) - cacheBefore != held) {
+            error = "signer cache charge does not match its entries";
+            return false;
+        }
+        size_t freed = cache.Trim(1);
+        uint64_t misses = cache.GetMisses();
+        cache.GetSignerInfo(paths[0]);
+        cache.GetSignerInfo(paths[2]);
+        if (freed == 0 || freed != held - cache.GetMemoryBytes() || cache.GetMisses() != misses) {
+            error = "signer cache Trim did not evict only the least recently used entry";
+            return false;
+        }
+        cache.GetSignerInfo(paths[1]);
+        if (cache.GetMisses() != misses + 1) {
+            error = "signer cache entry evicted by Trim is still served";
+            return false;
+        }
+    }
+
+    // Budget: the signer cache is trimmed before any event is evicted, then
+    // the oldest events go until the total is back under the budget
+    Config config;
+    config.GetConfig().loggingEnabled = false;
+    config.GetConfig().playSound = false;
+    config.GetConfig().ignoreWindowsSigned = false;
+    config.GetConfig().ignoreMicrosoft = false;
+    config.GetConfig().memoryBudgetMB = static_cast<int>(MemoryAccounting::GetTotalBytes() >> 20) + 2;
+    config.NotifyChanged();
+    EventManager eventManager;
+    eventManager.SetMaxEvents(1000000);
+    DriverMonitor monitor(&eventManager, &config);
+
+    std::vector<DriverEvent> samples = MakeSampleEvents(4096);
+    monitor.StartIngestion();
+    for (const auto& path : paths) {
+        DriverEvent event = samples[0];
+        event.installPath = path;
+        event.signerInfo.clear();
+        monitor.SubmitObservation(std::move(event), true);
+    }
+    monitor.Stop();
+    MemoryStats filled = monitor.GetMemoryStats();
+    if (monitor.GetSignerCache().GetSize() != paths.size() || filled.eventsEvicted != 0 || filled.overBudget != 0) {
+        error = "budget enforced before the total reached it";
+        return false;
+    }
+
+    const uint64_t kBudgetEvents = 40000;
+    RunPipeline(monitor, samples, kBudgetEvents);
+    MemoryStats stats = monitor.GetMemoryStats();
+    uint64_t stored = eventManager.GetNextSequence() - 1;
+    if (stats.budgetBytes != static_cast<uint64_t>(config.GetConfig().memoryBudgetMB) << 20 ||
+        stats.overBudget == 0 || stats.eventsEvicted == 0) {
+        error = "budget was never exceeded or nothing was evicted";
+        return false;
+    }
+    if (monitor.GetSignerCache().GetSize() != 0 || stats.cacheBytesReclaimed < filled.bytes[static_cast<size_t>(MemorySubsystem::SignerCache)]) {
+        error = "events evicted while the signer cache still held entries";
+        return false;
+    }
+    if (stats.totalBytes > stats.budgetBytes || eventManager.GetFirstSequence() != 1 + stats.eventsEvicted ||
+        eventManager.GetEventCount() != stored - stats.eventsEvicted) {
+        error = "budget did not evict the oldest events down to the budget";
+        return false;
+    }
+    return true;
+}
+
+void RunPipelineBenchmarks(BenchmarkRunner& runner) {
+    std::vector<uint64_t> values = MakeLatencies(4096, 11);
+
+    {
+        LatencyRecorder recorder(static_cast<size_t>(PipelineStage::Count));
+        runner.Run("Latency/Record", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                recorder.Record(i % 8, values[i % values.size()]);
+            }
+        });
+
+        // Two threads' shards per stage, as in the monitor
+        std::thread([&]() { recorder.Record(0, values[0]); }).join();
+        runner.Run("Latency/Merge", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                LatencyHistogram merged = recorder.GetHistogram(0);
+                KeepAlive(merged);
+            }
+        });
+    }
+
+    LatencyHistogram histogram;
+    for (uint64_t value : values) {
+        histogram.Record(value);
+    }
+    runner.Run("Latency/Percentile", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            uint64_t p99 = histogram.GetPercentile(0.99);
+            KeepAlive(p99);
+        }
+    });
+
+    if (Tracer::IsAvailable()) {
+        Tracer::SetEnabled(false);
+        runner.Run("Trace/SpanDisabled", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                DM_TRACE_SPAN("benchSpan", "bench");
+            }
+        });
+
+        Tracer::SetEnabled(true);
+        runner.Run("Trace/Span", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                DM_TRACE_SPAN("benchSpan", "bench");
+            }
+        });
+        auto now = std::chrono::steady_clock::now();
+        runner.Run("Trace/Record", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                DM_TRACE_RECORD("benchSpan", "bench", now, now);
+            }
+        });
+
+        // One full ring buffer to JSON
+        runner.Run("Trace/Write", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                std::string json = WriteTrace();
+                KeepAlive(json);
+            }
+        });
+        Tracer::SetEnabled(false);
+        Tracer::Clear();
+    }
+
+    // Whole pipeline per observation (every stage timed), producer on this thread
+    if (runner.IsSelected("Pipeline/Process")) {
+        std::vector<DriverEvent> samples = MakeSampleEvents(4096);
+        Config config;
+        config.GetConfig().loggingEnabled = false;
+        config.GetConfig().playSound = false;
+        config.NotifyChanged();
+        EventManager eventManager;
+        eventManager.SetMaxEvents(1000);
+        DriverMonitor monitor(&eventManager, &config);
+        runner.Run("Pipeline/Process", [&](uint64_t iterations) {
+            RunPipeline(monitor, samples, iterations);
+        });
+    }
+
+    // The same with span tracing enabled
+    if (Tracer::IsAvailable() && runner.IsSelected("Pipeline/ProcessTraced")) {
+        std::vector<DriverEvent> samples = MakeSampleEvents(4096);
+        Config config;
+        config.GetConfig().loggingEnabled = false;
+        config.GetConfig().playSound = false;
+        config.NotifyChanged();
+        EventManager eventManager;
+        eventManager.SetMaxEvents(1000);
+        DriverMonitor monitor(&eventManager, &config);
+        Tracer::SetEnabled(true);
+        runner.Run("Pipeline/ProcessTraced", [&](uint64_t iterations) {
+            RunPipeline(monitor, samples, iterations);
+        });
+        Tracer::SetEnabled(false);
+        Tracer::Clear();
+    }
+    
+    // Charge and release one event's bytes
+    {
+        MemoryCharge charge(MemorySubsystem::EventHistory);
+        runner.Run("Memory/Charge", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                charge.Add(384);
+                charge.Subtract(384);
+            }
+        });
+    }
+    
+    // Pipeline held at its memory budget: every stored event evicts the oldest
+    if (runner.IsSelected("Pipeline/ProcessBudget")) {
+        std::vector<DriverEvent> samples = MakeSampleEvents(4096);
+        Config config;
+        config.GetConfig().loggingEnabled = false;
+        config.GetConfig().playSound = false;
+        config.GetConfig().memoryBudgetMB = static_cast<int>(MemoryAccounting::GetTotalBytes() >> 20) + 1;
+        config.NotifyChanged();
+        EventManager eventManager;
+        eventManager.SetMaxEvents(1000000);
+        DriverMonitor monitor(&eventManager, &config);
+        RunPipeline(monitor, samples, 20000);
+        runner.Run("Pipeline/ProcessBudget", [&](uint64_t iterations) {
+            RunPipeline(monitor, samples, iterations);
+        });
+    }
+}
+
+} // namespace DriverMonitor
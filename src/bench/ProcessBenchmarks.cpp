@@ -0,0 +1,255 @@
+#include "BenchCases.h"
+#include "../core/Config.h"
+#include "../core/DriverMonitor.h"
+#include "../core/EventManager.h"
+#include "../core/ProcessInfo.h"
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace DriverMonitor {
+
+namespace {
+    // Scripted process table that counts the queries made of it
+    class FakeProcessInfoProvider : public ProcessInfoProvider {
+    public:
+        FakeProcessInfoProvider() : startTimeCalls(0), queryCalls(0) {}
+
+        bool GetStartTime(unsigned long pid, uint64_t& startTime) override {
+            ++startTimeCalls;
+            auto it = processes.find(pid);
+            if (it == processes.end()) {
+                return false;
+            }
+            startTime = it->second.startTime;
+            return true;
+        }
+
+        bool Query(unsigned long pid, ProcessInfo& info) override {
+            ++queryCalls;
+            auto it = processes.find(pid);
+            if (it == processes.end()) {
+                return false;
+            }
+            info = it->second;
+            return true;
+        }
+
+        void Start(unsigned long pid, const std::string& imagePath, uint64_t startTime) {
+            ProcessInfo& info = processes[pid];
+            info.processId = pid;
+            info.imagePath = imagePath;
+            info.imageName = imagePath.substr(imagePath.find_last_of('\\') + 1);
+            info.startTime = startTime;
+        }
+
+        std::map<unsigned long, ProcessInfo> processes;
+        uint64_t startTimeCalls;
+        uint64_t queryCalls;
+    };
+
+    unsigned long GetOwnProcessId() {
+#ifdef _WIN32
+        return GetCurrentProcessId();
+#else
+        return static_cast<unsigned long>(getpid());
+#endif
+    }
+
+    const int64_t kRevalidateMicros = 1000000;
+}
+
+bool VerifyProcessInfo(std::string& error) {
+    FakeProcessInfoProvider provider;
+    VirtualClock clock(1000);
+    ProcessInfoCache cache(4, &provider, &clock, kRevalidateMicros);
+    provider.Start(100, "C:\\Windows\\System32\\services.exe", 7);
+
+    // A miss queries once; hits within the interval make no query and do not allocate
+    const ProcessInfo* info = cache.Lookup(100);
+    if (!info || info->imageName != "services.exe" || provider.queryCalls != 1) {
+        error = "process cache miss did not query the provider";
+        return false;
+    }
+    uint64_t allocations = GetAllocationCount();
+    for (int i = 0; i < 100; ++i) {
+        info = cache.Lookup(100);
+    }
+    if (GetAllocationCount() != allocations || provider.queryCalls != 1 || provider.startTimeCalls != 0 ||
+        cache.GetHits() != 100) {
+        error = "process cache hit queried the provider or allocated";
+        return false;
+    }
+    KeepAlive(info);
+
+    // After the interval only the start time is checked
+    clock.Advance(kRevalidateMicros);
+    info = cache.Lookup(100);
+    if (!info || provider.startTimeCalls != 1 || provider.queryCalls != 1) {
+        error = "process cache revalidation re-queried an unchanged process";
+        return false;
+    }
+
+    // A reused PID keeps the old image until revalidated, then is queried again
+    provider.Start(100, "C:\\Users\\Public\\loader.exe", 9);
+    info = cache.Lookup(100);
+    if (!info || info->imageName != "services.exe") {
+        error = "process cache revalidated before the interval";
+        return false;
+    }
+    clock.Advance(kRevalidateMicros);
+    info = cache.Lookup(100);
+    if (!info || info->imageName != "loader.exe" || info->startTime != 9 || cache.GetReused() != 1 ||
+        provider.queryCalls != 2) {
+        error = "process cache missed a reused PID";
+        return false;
+    }
+
+    // Invalidate forgets at once; an exited process is dropped
+    provider.Start(100, "C:\\Tools\\next.exe", 11);
+    cache.Invalidate(100);
+    info = cache.Lookup(100);
+    if (!info || info->imageName != "next.exe") {
+        error = "process cache kept an invalidated PID";
+        return false;
+    }
+    provider.processes.erase(100);
+    clock.Advance(kRevalidateMicros);
+    if (cache.Lookup(100) || cache.GetSize() != 0 || cache.GetMemoryBytes() != 0) {
+        error = "process cache kept an exited process";
+        return false;
+    }
+    if (cache.Lookup(4242)) {
+        error = "process cache found a process that does not exist";
+        return false;
+    }
+
+    // Least recently used eviction, attribution and trimming
+    for (unsigned long pid = 1; pid <= 5; ++pid) {
+        provider.Start(pid, "C:\\Apps\\app" + std::to_string(pid) + ".exe", pid);
+        cache.Lookup(pid);
+        if (pid == 3) {
+            cache.Lookup(1);
+        }
+    }
+    uint64_t queries = provider.queryCalls;
+    DriverEvent event;
+    event.processId = 1;
+    if (cache.GetSize() != 4 || !cache.Attribute(event) || event.initiatedBy != "app1.exe" ||
+        provider.queryCalls != queries || (cache.Lookup(2), provider.queryCalls != queries + 1)) {
+        error = "process cache evicted the wrong entry";
+        return false;
+    }
+    uint64_t charged = MemoryAccounting::GetBytes(MemorySubsystem::ProcessCache);
+    size_t bytes = cache.GetMemoryBytes();
+    if (bytes == 0 || charged < bytes || cache.Trim(bytes) < bytes || cache.GetSize() != 0 ||
+        MemoryAccounting::GetBytes(MemorySubsystem::ProcessCache) != charged - bytes) {
+        error = "process cache memory was not charged and released";
+        return false;
+    }
+
+    // The system provider finds this process, agrees with itself and rejects a PID that cannot exist
+    SystemProcessInfoProvider system;
+    ProcessInfo self;
+    uint64_t startTime = 0;
+    if (!system.Query(GetOwnProcessId(), self) || self.imageName.find("DriverMonitorBench") != 0 ||
+        !system.GetStartTime(GetOwnProcessId(), startTime) || startTime != self.startTime) {
+        error = "system process provider did not find this process (image '" + self.imageName + "')";
+        return false;
+    }
+    if (system.Query(0xFFFFFFF0ul, self)) {
+        error = "system process provider found a process that does not exist";
+        return false;
+    }
+
+    // The pipeline names the initiator of events that only carry its PID
+    Config config;
+    config.GetConfig().loggingEnabled = false;
+    config.GetConfig().playSound = false;
+    config.NotifyChanged();
+    EventManager eventManager;
+    DriverMonitor monitor(&eventManager, &config);
+    std::vector<DriverEvent> samples = MakeSampleEvents(2);
+    samples[0].initiatedBy.clear();
+    samples[0].processId = GetOwnProcessId();
+    samples[1].initiatedBy.clear();
+    samples[1].processId = 0;
+    for (auto& sample : samples) {
+        sample.signerInfo = "Not Signed";
+    }
+    monitor.StartIngestion();
+    for (auto& sample : samples) {
+        monitor.SubmitObservation(std::move(sample), true);
+    }
+    monitor.Stop();
+    std::vector<DriverEvent> stored = eventManager.GetEvents();
+    if (stored.size() != 2 || stored[0].initiatedBy.find("DriverMonitorBench") != 0 ||
+        stored[1].initiatedBy != "Unknown" || monitor.GetProcessCache().GetMisses() != 1) {
+        error = "pipeline did not attribute an event to its initiating process";
+        return false;
+    }
+    return true;
+}
+
+void RunProcessBenchmarks(BenchmarkRunner& runner) {
+    // Per lookup: cached, within the revalidation interval
+    FakeProcessInfoProvider provider;
+    for (unsigned long pid = 0; pid < 256; ++pid) {
+        provider.Start(pid * 4, "C:\\Windows\\System32\\svc" + std::to_string(pid) + ".exe", pid);
+    }
+    VirtualClock clock(0);
+    ProcessInfoCache cache(ProcessInfoCache::kDefaultCapacity, &provider, &clock, kRevalidateMicros);
+    runner.Run("Process/Lookup/Hit", [&](uint64_t iterations) {
+        uint64_t found = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            found += cache.Lookup(static_cast<unsigned long>((i % 256) * 4)) ? 1 : 0;
+        }
+        KeepAlive(found);
+    });
+
+    // Per lookup against the system: cached, every one revalidated, and uncached
+    unsigned long self = GetOwnProcessId();
+    ProcessInfoCache systemCache;
+    runner.Run("Process/Lookup/System", [&](uint64_t iterations) {
+        uint64_t found = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            found += systemCache.Lookup(self) ? 1 : 0;
+        }
+        KeepAlive(found);
+    });
+
+    ProcessInfoCache revalidating(ProcessInfoCache::kDefaultCapacity, nullptr, nullptr, 0);
+    runner.Run("Process/Lookup/Revalidate", [&](uint64_t iterations) {
+        uint64_t found = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            found += revalidating.Lookup(self) ? 1 : 0;
+        }
+        KeepAlive(found);
+    });
+
+    SystemProcessInfoProvider system;
+    runner.Run("Process/Query", [&](uint64_t iterations) {
+        ProcessInfo info;
+        uint64_t found = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            found += system.Query(self, info) ? 1 : 0;
+        }
+        KeepAlive(found);
+    });
+
+    // The uncached baseline: Utils::GetProcessName opens the process per call
+    runner.Run("Process/GetProcessName", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            std::string name = Utils::GetProcessName(self);
+            KeepAlive(name);
+        }
+    });
+}
+
+} // namespace DriverMonitor
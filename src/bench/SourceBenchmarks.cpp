@@ -0,0 +1,586 @@
+#include "BenchCases.h"
+#include "../core/KnownDriverSet.h"
+#include "../core/PollScheduler.h"
+#include "../monitoring/DirectorySnapshot.h"
+#include "../monitoring/DirectoryWatcher.h"
+#include "../monitoring/FileSystemMonitor.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace DriverMonitor {
+
+namespace {
+    std::string MakeVerifyDirectory(const char* name) {
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / name;
+        std::error_code ignored;
+        std::filesystem::remove_all(directory, ignored);
+        std::filesystem::create_directories(directory, ignored);
+        return directory.string();
+    }
+
+    void WriteFile(const std::string& directory, const std::string& name, size_t size) {
+        std::ofstream file((std::filesystem::path(directory) / name).string(), std::ios::binary | std::ios::trunc);
+        file << std::string(size, 'x');
+    }
+
+    void RemoveFile(const std::string& directory, const std::string& name) {
+        std::error_code ignored;
+        std::filesystem::remove(std::filesystem::path(directory) / name, ignored);
+    }
+
+    bool IsDriverFile(const std::string& name) {
+        return name.size() >= 3 && Utils::HashIgnoreCase(name.substr(name.size() - 3)) == Utils::HashIgnoreCase(".ko");
+    }
+
+    // Sorted (kind, name) pairs, for comparing diffs regardless of order
+    std::vector<std::pair<int, std::string>> Normalize(const std::vector<FileChange>& changes) {
+        std::vector<std::pair<int, std::string>> normalized;
+        for (const auto& change : changes) {
+            normalized.emplace_back(static_cast<int>(change.kind), change.fileName);
+        }
+        std::sort(normalized.begin(), normalized.end());
+        return normalized;
+    }
+
+    // Every event queued by one poll of monitor (names of added / removed files)
+    void Drain(FileSystemMonitor& monitor, std::set<std::string>& added, std::set<std::string>& removed) {
+        for (DriverEvent event = monitor.CheckForNewDrivers(); !event.driverName.empty();
+             event = monitor.CheckForNewDrivers()) {
+            (event.isRemoval ? removed : added).insert(event.driverName);
+        }
+    }
+
+    // Registry-style service names, as RegistryMonitor enumerates them
+    std::vector<std::string> MakeServiceNames(size_t count) {
+        std::vector<std::string> names;
+        names.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            names.push_back("DriverService" + std::to_string(i));
+        }
+        return names;
+    }
+
+    // Random scans of known against a brute-force map keyed by folded name;
+    // hashBits < 64 truncates the hash so distinct names collide
+    bool VerifyKnownDriverScans(int hashBits, std::string& error) {
+        std::vector<std::string> names = MakeServiceNames(300);
+        auto hashOf = [hashBits](const std::string& name) {
+            uint64_t hash = Utils::HashIgnoreCase(name);
+            return hashBits < 64 ? hash & ((1ULL << hashBits) - 1) : hash;
+        };
+
+        std::minstd_rand random(28);
+        KnownDriverSet known;
+        std::map<std::string, uint32_t> expected;
+        for (int scan = 0; scan < 40; ++scan) {
+            known.BeginScan();
+            std::set<std::string> seen;
+            for (const auto& base : names) {
+                if (random() % 4 == 0) {
+                    continue;
+                }
+                // Enumeration may return any casing of a known name
+                std::string name = base;
+                if (random() % 3 == 0) {
+                    std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+                }
+                uint32_t flags = 0;
+                bool isKnown = known.Mark(hashOf(name), name, &flags);
+                auto it = expected.find(base);
+                if (isKnown != (it != expected.end()) || (isKnown && flags != it->second)) {
+                    error = "known-driver set mark differs from brute force for " + name;
+                    return false;
+                }
+                if (!isKnown) {
+                    flags = random() % 2;
+                    known.Insert(hashOf(name), name, flags);
+                    expected[base] = flags;
+                } else if (random() % 8 == 0) {
+                    flags ^= 1;
+                    known.SetFlags(hashOf(name), name, flags);
+                    expected[base] = flags;
+                }
+                seen.insert(base);
+            }
+
+            std::vector<std::pair<std::string, uint32_t>> removed;
+            known.Sweep([&removed](const std::string& name, uint32_t flags) {
+                removed.emplace_back(Utils::FoldCase(name), flags);
+            });
+            std::vector<std::pair<std::string, uint32_t>> expectedRemoved;
+            for (auto it = expected.begin(); it != expected.end();) {
+                if (seen.count(it->first) == 0) {
+                    expectedRemoved.emplace_back(Utils::FoldCase(it->first), it->second);
+                    it = expected.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            std::sort(removed.begin(), removed.end());
+            std::sort(expectedRemoved.begin(), expectedRemoved.end());
+            if (removed != expectedRemoved || known.GetSize() != expected.size()) {
+                error = "known-driver set sweep differs from brute force in scan " + std::to_string(scan);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Stand-in change notification: an auto-reset event / a non-blocking pipe
+    class NotifySignal {
+    public:
+        NotifySignal() {
+#ifdef _WIN32
+            m_event = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+#else
+            m_pipe[0] = -1;
+            m_pipe[1] = -1;
+            if (pipe(m_pipe) == 0) {
+                for (int fd : m_pipe) {
+                    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                }
+            }
+#endif
+        }
+
+        ~NotifySignal() {
+#ifdef _WIN32
+            CloseHandle(m_event);
+#else
+            for (int fd : m_pipe) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+#endif
+        }
+
+        void Signal() {
+#ifdef _WIN32
+            SetEvent(m_event);
+#else
+            char byte = 1;
+            ssize_t written = write(m_pipe[1], &byte, 1);
+            (void)written;
+#endif
+        }
+
+        // Consume pending signals (the source's poll)
+        void Drain() {
+#ifndef _WIN32
+            char buffer[64];
+            while (read(m_pipe[0], buffer, sizeof(buffer)) > 0) {
+            }
+#endif
+        }
+
+        bool GetWaitHandle(NativeWaitHandle& handle) const {
+#ifdef _WIN32
+            handle = m_event;
+#else
+            handle = m_pipe[0];
+#endif
+            return true;
+        }
+
+    private:
+#ifdef _WIN32
+        void* m_event;
+#else
+        int m_pipe[2];
+#endif
+    };
+
+    // Stand-in source: records when it is polled, detects a change on chosen polls
+    struct RecordingSource {
+        std::vector<std::chrono::steady_clock::time_point> polls;
+        std::atomic<size_t> pollCount;
+        size_t detectOn;                        // 1-based poll that reports a change (0 = none)
+        NotifySignal signal;
+
+        RecordingSource() : pollCount(0), detectOn(0) {}
+
+        PollSource MakeSource(std::chrono::milliseconds minInterval, std::chrono::milliseconds maxInterval) {
+            PollSource source;
+            source.name = "stand-in";
+            source.minInterval = minInterval;
+            source.maxInterval = maxInterval;
+            source.poll = [this]() {
+                signal.Drain();
+                polls.push_back(std::chrono::steady_clock::now());
+                return ++pollCount == detectOn;
+            };
+            source.waitHandle = [this](NativeWaitHandle& handle) { return signal.GetWaitHandle(handle); };
+            return source;
+        }
+
+        bool WaitForPolls(size_t count, std::chrono::milliseconds timeout) const {
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (pollCount < count) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return true;
+        }
+    };
+
+#ifdef __linux__
+    bool VerifyDirectoryWatcher(std::string& error) {
+        std::string directory = MakeVerifyDirectory("driver_monitor_verify_watch");
+        std::string moved = directory + ".moved";
+        std::error_code ignored;
+        std::filesystem::remove_all(moved, ignored);
+
+        DirectoryWatcher watcher;
+        if (!watcher.Start(directory) || watcher.ConsumeChanges()) {
+            error = "directory watcher reported a change before any";
+            return false;
+        }
+        {
+            // Not while it is being written: the scan would see a half-written file
+            std::ofstream file((std::filesystem::path(directory) / "a.ko").string(), std::ios::binary);
+            file << "partial";
+            file.flush();
+            if (watcher.ConsumeChanges()) {
+                error = "directory watcher reported a file still being written";
+                return false;
+            }
+        }
+        if (!watcher.ConsumeChanges() || watcher.ConsumeChanges()) {
+            error = "directory watcher missed a new file";
+            return false;
+        }
+
+        // Deleted: rescan on every call while the directory is missing, re-arm once it is back
+        std::filesystem::remove_all(directory, ignored);
+        if (!watcher.ConsumeChanges() || watcher.IsActive() || !watcher.ConsumeChanges()) {
+            error = "directory watcher did not fall back to rescanning after the directory was deleted";
+            return false;
+        }
+        std::filesystem::create_directories(directory, ignored);
+        if (!watcher.ConsumeChanges() || !watcher.IsActive() || watcher.ConsumeChanges()) {
+            error = "directory watcher did not re-arm on the recreated directory";
+            return false;
+        }
+        WriteFile(directory, "b.ko", 1);
+        if (!watcher.ConsumeChanges()) {
+            error = "directory watcher missed a file in the recreated directory";
+            return false;
+        }
+
+        // Moved away and back: the watch follows the path, not the old inode
+        std::filesystem::rename(directory, moved, ignored);
+        if (!watcher.ConsumeChanges() || watcher.IsActive()) {
+            error = "directory watcher kept watching a moved directory";
+            return false;
+        }
+        std::filesystem::rename(moved, directory, ignored);
+        if (!watcher.ConsumeChanges() || !watcher.IsActive() || watcher.ConsumeChanges()) {
+            error = "directory watcher did not re-arm after the directory moved back";
+            return false;
+        }
+        watcher.Stop();
+
+        // End to end: files in a recreated drivers directory are reported
+        FileSystemMonitor monitor(directory);
+        std::set<std::string> added;
+        std::set<std::string> removed;
+        Drain(monitor, added, removed);
+        std::filesystem::remove_all(directory, ignored);
+        Drain(monitor, added, removed);
+        std::filesystem::create_directories(directory, ignored);
+        WriteFile(directory, "c.ko", 1);
+        Drain(monitor, added, removed);
+        WriteFile(directory, "d.ko", 1);
+        Drain(monitor, added, removed);
+        NativeWaitHandle handle;
+        bool rearmed = monitor.GetWaitHandle(handle);
+        std::filesystem::remove_all(directory, ignored);
+
+        if (added != std::set<std::string>{ "c.ko", "d.ko" } ||
+            removed != std::set<std::string>{ "b.ko" } || !rearmed) {
+            error = "file system monitor missed drivers in a recreated directory";
+            return false;
+        }
+        return true;
+    }
+#endif
+}
+
+bool VerifyKnownDriverSet(std::string& error) {
+    if (!VerifyKnownDriverScans(64, error) || !VerifyKnownDriverScans(4, error)) {
+        return false;
+    }
+
+    // A name forged to collide with a known driver is still new
+    KnownDriverSet known;
+    known.BeginScan();
+    known.Insert(42, "trusted.sys");
+    if (known.Mark(42, "forged.sys") || !known.Mark(42, "TRUSTED.SYS")) {
+        error = "known-driver set matched a colliding name";
+        return false;
+    }
+    known.Insert(42, "forged.sys");
+    known.BeginScan();
+    known.Mark(42, "forged.sys");
+    std::vector<std::string> removed;
+    known.Sweep([&removed](const std::string& name, uint32_t) { removed.push_back(name); });
+    if (removed != std::vector<std::string>{ "trusted.sys" } || !known.Mark(42, "forged.sys")) {
+        error = "known-driver set swept the wrong one of two colliding names";
+        return false;
+    }
+    return true;
+}
+
+bool VerifyPollScheduler(std::string& error) {
+    using std::chrono::milliseconds;
+    // Timer wakeups are never early; late ones get generous slack for loaded machines
+    const milliseconds kMinInterval(10);
+    const milliseconds kMaxInterval(80);
+    const double kSlackMs = 150.0;
+
+    // Idle: the interval doubles up to the maximum; the 7th poll detects a
+    // change, so the next one comes after the minimum and backs off again
+    {
+        RecordingSource recording;
+        recording.detectOn = 7;
+        PollScheduler scheduler;
+        scheduler.AddSource(recording.MakeSource(kMinInterval, kMaxInterval));
+        scheduler.Start();
+        bool polled = recording.WaitForPolls(9, std::chrono::seconds(10));
+        scheduler.Stop();
+        if (!polled) {
+            error = "poll scheduler stopped polling an idle source";
+            return false;
+        }
+
+        const long long kExpected[] = { 20, 40, 80, 80, 80, 80, 10, 20 };
+        for (size_t i = 0; i < 8; ++i) {
+            double gap = std::chrono::duration<double, std::milli>(recording.polls[i + 1] - recording.polls[i]).count();
+            double expected = static_cast<double>(kExpected[i]);
+            if (gap < expected * 0.9 - 1.0 || gap > expected * 1.1 + kSlackMs) {
+                error = "poll scheduler interval " + std::to_string(i + 1) + " was " + std::to_string(gap) +
+                        " ms, expected " + std::to_string(kExpected[i]) + " ms +/-10%";
+                return false;
+            }
+        }
+        std::vector<PollSourceStats> stats = scheduler.GetStats();
+        if (stats[0].polls != recording.pollCount || stats[0].detections != 1 ||
+            scheduler.GetWakeupCount() > recording.pollCount + 1) {
+            error = "poll scheduler woke " + std::to_string(scheduler.GetWakeupCount()) + " times for " +
+                    std::to_string(recording.pollCount.load()) + " polls";
+            return false;
+        }
+    }
+
+    // Fully backed off: Wake() and the source's notification poll it at once,
+    // and Stop() does not wait for the next deadline
+    {
+        RecordingSource recording;
+        PollScheduler scheduler;
+        int id = scheduler.AddSource(recording.MakeSource(std::chrono::seconds(60), std::chrono::seconds(60)));
+        scheduler.Start();
+        if (!recording.WaitForPolls(1, std::chrono::seconds(5))) {
+            scheduler.Stop();
+            error = "poll scheduler did not poll a new source right away";
+            return false;
+        }
+        scheduler.Wake(id);
+        if (!recording.WaitForPolls(2, std::chrono::seconds(5))) {
+            scheduler.Stop();
+            error = "poll scheduler ignored Wake()";
+            return false;
+        }
+        recording.signal.Signal();
+        if (!recording.WaitForPolls(3, std::chrono::seconds(5))) {
+            scheduler.Stop();
+            error = "poll scheduler ignored the source's change notification";
+            return false;
+        }
+        auto stopStart = std::chrono::steady_clock::now();
+        scheduler.Stop();
+        if (std::chrono::steady_clock::now() - stopStart > std::chrono::seconds(1) || recording.pollCount != 3) {
+            error = "poll scheduler Stop() waited for the next deadline";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VerifyDirectorySnapshot(std::string& error) {
+    // Diff of two captures against a brute-force diff of the files written
+    std::string directory = MakeVerifyDirectory("driver_monitor_verify_snapshot");
+    std::vector<std::string> names;
+    for (int i = 0; i < 40; ++i) {
+        names.push_back("drv" + std::to_string(i) + ".ko");
+#ifndef _WIN32
+        names.push_back("DRV" + std::to_string(i) + ".KO");     // Same hash, different name
+#endif
+        names.push_back("drv" + std::to_string(i) + ".txt");    // Not a driver
+    }
+
+    std::minstd_rand random(26);
+    std::map<std::string, size_t> files;
+    DirectorySnapshot previous;
+    previous.Capture(directory, ".ko");
+    for (int round = 0; round < 20; ++round) {
+        std::map<std::string, size_t> before = files;
+        std::set<std::string> touched;                          // Once per round, so inode reuse cannot hide
+        for (int step = 0; step < 30; ++step) {
+            const std::string& name = names[random() % names.size()];
+            if (!touched.insert(name).second) {
+                continue;
+            }
+            auto it = files.find(name);
+            if (it == files.end()) {
+                files[name] = 1 + random() % 64;
+                WriteFile(directory, name, files[name]);
+            } else if (random() % 2 == 0) {
+                RemoveFile(directory, name);
+                files.erase(it);
+            } else {
+                it->second += 1 + random() % 64;                // Size differs, whatever the mtime granularity
+                WriteFile(directory, name, it->second);
+            }
+        }
+
+        std::vector<FileChange> expected;
+        for (const auto& file : files) {
+            if (!IsDriverFile(file.first)) {
+                continue;
+            }
+            auto old = before.find(file.first);
+            if (old == before.end()) {
+                expected.push_back({ FileChangeKind::Added, file.first });
+            } else if (old->second != file.second) {
+                expected.push_back({ FileChangeKind::Modified, file.first });
+            }
+        }
+        for (const auto& file : before) {
+            if (IsDriverFile(file.first) && files.find(file.first) == files.end()) {
+                expected.push_back({ FileChangeKind::Removed, file.first });
+            }
+        }
+
+        DirectorySnapshot current;
+        std::vector<FileChange> changes;
+        if (!current.Capture(directory, ".ko")) {
+            error = "directory snapshot could not capture the verify directory";
+            return false;
+        }
+        DirectorySnapshot::Diff(previous, current, changes);
+        if (Normalize(changes) != Normalize(expected)) {
+            error = "directory snapshot diff differs from brute force in round " + std::to_string(round);
+            return false;
+        }
+        previous.Swap(current);
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+
+#ifdef __linux__
+    if (!VerifyDirectoryWatcher(error)) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+void RunSourceBenchmarks(BenchmarkRunner& runner) {
+    // One file system rescan of 10k driver files with nothing changed:
+    // enumerate and stat, then diff against the previous snapshot
+    if (runner.IsSelected("Directory/Scan/10k")) {
+        std::string directory = MakeVerifyDirectory("driver_monitor_bench_scan");
+        for (int i = 0; i < 10000; ++i) {
+            WriteFile(directory, "driver" + std::to_string(i) + ".ko", 1);
+        }
+        DirectorySnapshot previous;
+        previous.Capture(directory, ".ko");
+        std::vector<FileChange> changes;
+        runner.Run("Directory/Scan/10k", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                DirectorySnapshot current;
+                current.Capture(directory, ".ko");
+                DirectorySnapshot::Diff(previous, current, changes);
+                previous.Swap(current);
+            }
+            KeepAlive(changes);
+        });
+        std::error_code ignored;
+        std::filesystem::remove_all(directory, ignored);
+    }
+
+    // One registry poll with nothing changed: hash, mark every service, sweep
+    const size_t kKnownCounts[] = { 1000, 50000 };
+    for (size_t count : kKnownCounts) {
+        std::string name = "Known/Scan/" + std::to_string(count / 1000) + "k";
+        if (!runner.IsSelected(name)) {
+            continue;
+        }
+        std::vector<std::string> names = MakeServiceNames(count);
+        KnownDriverSet known;
+        known.BeginScan();
+        for (const auto& service : names) {
+            known.Insert(Utils::HashIgnoreCase(service), service);
+        }
+        runner.Run(name, [&](uint64_t iterations) {
+            size_t marked = 0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                known.BeginScan();
+                for (const auto& service : names) {
+                    marked += known.Mark(Utils::HashIgnoreCase(service), service) ? 1 : 0;
+                }
+                known.Sweep([](const std::string&, uint32_t) {});
+            }
+            KeepAlive(marked);
+        });
+    }
+
+    // Change notification or Wake() to poll, with the source fully backed off
+    // (the detection latency of a burst that starts while idle)
+    if (runner.IsSelected("Poll/Notify") || runner.IsSelected("Poll/Wake")) {
+        RecordingSource recording;
+        PollScheduler scheduler;
+        int id = scheduler.AddSource(recording.MakeSource(std::chrono::seconds(60), std::chrono::seconds(60)));
+        scheduler.Start();
+        recording.WaitForPolls(1, std::chrono::seconds(5));
+        runner.RunLatency("Poll/Notify", 1000, [&](uint64_t) {
+            size_t next = recording.pollCount + 1;
+            recording.signal.Signal();
+            while (recording.pollCount < next) {
+                std::this_thread::yield();
+            }
+        });
+        runner.RunLatency("Poll/Wake", 1000, [&](uint64_t) {
+            size_t next = recording.pollCount + 1;
+            scheduler.Wake(id);
+            while (recording.pollCount < next) {
+                std::this_thread::yield();
+            }
+        });
+        scheduler.Stop();
+    }
+}
+
+} // namespace DriverMonitor
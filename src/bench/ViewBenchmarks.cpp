@@ -0,0 +1,293 @@
+#include "BenchCases.h"
+#include "../core/EventManager.h"
+#include "../core/EventViewModel.h"
+#include "../core/SyntheticSource.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+namespace {
+    const size_t kViewEvents = 1000000;
+
+    // Column value compared by the brute-force sort (strings case-folded)
+    std::string SortValue(const DriverEvent& event, EventSortColumn column) {
+        switch (column) {
+            case EventSortColumn::Sequence: break;
+            case EventSortColumn::Type: return std::string(1, static_cast<char>(event.eventType));
+            case EventSortColumn::Threat: return std::string(1, static_cast<char>(event.threatLevel));
+            case EventSortColumn::Name: return Utils::FoldCase(event.driverName);
+            case EventSortColumn::Method: return Utils::FoldCase(event.loadingMethod);
+            case EventSortColumn::Signer: return Utils::FoldCase(event.signerInfo);
+            case EventSortColumn::Initiator: return Utils::FoldCase(event.initiatedBy);
+        }
+        return std::string();
+    }
+
+    // Rows a brute-force scan and sort of the whole history produces
+    std::vector<uint64_t> ExpectedRows(const EventManager& eventManager, const EventViewModel& view) {
+        std::vector<DriverEvent> events;
+        for (const auto& event : eventManager.GetEvents()) {
+            if (view.Matches(event)) {
+                events.push_back(event);
+            }
+        }
+
+        EventSortColumn column = view.GetSortColumn();
+        bool descending = view.IsSortDescending();
+        if (column == EventSortColumn::Sequence) {
+            if (descending) {
+                std::reverse(events.begin(), events.end());
+            }
+        } else {
+            // Stable: ties keep arrival order in both directions
+            std::stable_sort(events.begin(), events.end(), [&](const DriverEvent& a, const DriverEvent& b) {
+                std::string left = SortValue(a, column);
+                std::string right = SortValue(b, column);
+                return descending ? right < left : left < right;
+            });
+        }
+
+        std::vector<uint64_t> rows;
+        for (const auto& event : events) {
+            rows.push_back(event.sequenceId);
+        }
+        return rows;
+    }
+
+    // Random substring of a random event's name, path or signer
+    std::string PickQuery(const std::vector<DriverEvent>& events, size_t length, std::mt19937& random) {
+        for (;;) {
+            const DriverEvent& event = events[random() % events.size()];
+            const std::string* fields[] = { &event.driverName, &event.installPath, &event.signerInfo };
+            const std::string& field = *fields[random() % 3];
+            if (field.size() >= length) {
+                return field.substr(random() % (field.size() - length + 1), length);
+            }
+        }
+    }
+}
+
+bool VerifyEventViewModel(std::string& error) {
+    EventManager eventManager;
+    eventManager.SetMaxEvents(5000);
+    EventViewModel view(&eventManager);
+
+    // Enough distinct names that evictions leave dead strings to compact
+    const std::vector<DriverEvent> samples = MakeSampleEvents(30000);
+    const char* const queries[] = { "", "syn1", "SYN42", ".sys", "synthetic3", "nomatch", "Microsoft", "sy" };
+    std::mt19937 random(7);
+
+    std::string search;
+    EventTypeFilter type = EventTypeFilter::All;
+    size_t next = 0;
+    for (int step = 0; step < 4000; ++step) {
+        // Random burst of arrivals, occasionally a filter change or a clear
+        size_t arrivals = random() % 64;
+        for (size_t i = 0; i < arrivals; ++i) {
+            eventManager.AddEvent(samples[next++ % samples.size()]);
+        }
+        switch (random() % 50) {
+            case 0:
+                search = queries[random() % 8];
+                type = static_cast<EventTypeFilter>(random() % 4);
+                break;
+            case 1:
+                search = PickQuery(samples, 1 + random() % 8, random);
+                break;
+            case 2: case 3: case 4:
+                // Typing: extend the current search
+                search += PickQuery(samples, 1, random);
+                break;
+            case 5:
+                if (!search.empty()) {
+                    search.pop_back();
+                }
+                break;
+            case 6: case 7:
+                view.SetSort(static_cast<EventSortColumn>(random() % 7), random() % 2 == 0);
+                break;
+        }
+        view.SetFilter(search, type);
+        if (random() % 400 == 0) {
+            eventManager.Clear();
+        }
+        if (random() % 10 == 0) {
+            eventManager.SetMaxEvents(1000 + static_cast<int>(random() % 5000));
+        }
+
+        view.Update();
+
+        std::vector<uint64_t> expected = ExpectedRows(eventManager, view);
+        bool same = expected.size() == view.GetRowCount();
+        for (size_t row = 0; same && row < expected.size(); ++row) {
+            same = expected[row] == view.GetSequence(row);
+        }
+
+        // Row lookup by sequence and a visited window agree with the row order
+        if (same && !expected.empty()) {
+            size_t probe = random() % expected.size();
+            size_t found = 0;
+            same = view.FindRow(expected[probe], found) && found == probe;
+
+            std::vector<uint64_t> visited;
+            view.VisitRows(probe, probe + 20, [&](const DriverEvent& event) {
+                visited.push_back(event.sequenceId);
+            });
+            same = same && std::equal(visited.begin(), visited.end(), expected.begin() + static_cast<ptrdiff_t>(probe));
+        }
+        if (!same) {
+            error = "EventViewModel rows differ from brute force at step " + std::to_string(step);
+            return false;
+        }
+    }
+    if (view.GetRebuildCount() == 0 || view.GetSortCount() == 0 || view.GetIndex().GetStringCount() == 0) {
+        error = "EventViewModel self-check did not exercise rebuilds";
+        return false;
+    }
+    return true;
+}
+
+void RunViewBenchmarks(BenchmarkRunner& runner) {
+    if (!runner.IsSelected("EventView/")) {
+        return;
+    }
+
+    EventManager eventManager;
+    eventManager.SetMaxEvents(static_cast<int>(kViewEvents));
+    FillEventManager(eventManager, kViewEvents);
+
+    struct FilterCase {
+        const char* name;
+        const char* search;
+        EventTypeFilter type;
+    };
+    const FilterCase filters[] = {
+        { "all", "", EventTypeFilter::All },
+        { "suspicious", "", EventTypeFilter::Suspicious },
+        { "search3", "syn", EventTypeFilter::All },
+        { "search6", "syn123", EventTypeFilter::All },
+        { "search10", "synthetic7", EventTypeFilter::All },
+        { "nomatch", "mimidrv", EventTypeFilter::All }
+    };
+
+    // Full rebuild after a filter change
+    for (const auto& filter : filters) {
+        EventViewModel view(&eventManager);
+        view.SetFilter(filter.search, filter.type);
+        runner.Run(std::string("EventView/Rebuild/1M/") + filter.name, [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                view.Invalidate();
+                view.Update();
+            }
+        });
+    }
+
+    // Query latency: a fresh 3-10 character query, then the update that applies it
+    std::mt19937 random(11);
+    const std::vector<DriverEvent> events = eventManager.GetEvents();
+    for (size_t length : { 3, 6, 10 }) {
+        std::vector<std::string> queries;
+        for (int i = 0; i < 200; ++i) {
+            queries.push_back(PickQuery(events, length, random));
+        }
+        EventViewModel view(&eventManager);
+        view.Update();
+        runner.RunLatency("EventView/Query/1M/len" + std::to_string(length), queries.size(), [&](size_t i) {
+            view.SetFilter(queries[i], EventTypeFilter::All);
+            view.Update();
+        });
+    }
+
+    // Typing a 10 character query one key at a time (each key refines the rows)
+    {
+        std::vector<std::string> words;
+        for (int i = 0; i < 40; ++i) {
+            words.push_back(PickQuery(events, 10, random));
+        }
+        EventViewModel view(&eventManager);
+        view.Update();
+        runner.RunLatency("EventView/Typing/1M/10keys", words.size() * 10, [&](size_t i) {
+            view.SetFilter(words[i / 10].substr(0, i % 10 + 1), EventTypeFilter::All);
+            view.Update();
+        });
+    }
+
+    // Switching the sort column over all 1M rows (first switch ranks every string)
+    {
+        struct SortCase {
+            const char* name;
+            EventSortColumn column;
+            bool descending;
+        };
+        const SortCase sorts[] = {
+            { "name", EventSortColumn::Name, false },
+            { "threat", EventSortColumn::Threat, true },
+            { "signer", EventSortColumn::Signer, false },
+            { "initiator", EventSortColumn::Initiator, true },
+            { "name-desc", EventSortColumn::Name, true }
+        };
+        EventViewModel view(&eventManager);
+        view.Update();
+        view.SetSort(EventSortColumn::Name, false);
+        view.Update();
+        for (const auto& sort : sorts) {
+            runner.RunLatency(std::string("EventView/SortSwitch/1M/") + sort.name, 10, [&](size_t) {
+                view.SetSort(EventSortColumn::Sequence, false);
+                view.Update();
+                view.SetSort(sort.column, sort.descending);
+                view.Update();
+            });
+        }
+    }
+
+    // Per-frame cost: new arrivals (with eviction) then update
+    const std::vector<DriverEvent> samples = MakeSampleEvents(4096);
+    EventViewModel view(&eventManager);
+    view.SetFilter("syn1", EventTypeFilter::All);
+    view.Update();
+
+    size_t next = 0;
+    runner.Run("EventView/Update/1M/add100", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            for (int j = 0; j < 100; ++j) {
+                eventManager.AddEvent(samples[next++ % samples.size()]);
+            }
+            view.Update();
+        }
+    });
+    if (runner.IsSelected("EventView/Update/1M/sorted/add100")) {
+        EventViewModel sortedView(&eventManager);
+        sortedView.SetSort(EventSortColumn::Name, false);
+        sortedView.Update();
+        runner.RunLatency("EventView/Update/1M/sorted/add100", 2000, [&](size_t) {
+            for (int j = 0; j < 100; ++j) {
+                eventManager.AddEvent(samples[next++ % samples.size()]);
+            }
+            sortedView.Update();
+        });
+        view.Update();
+    }
+    runner.Run("EventView/Update/1M/idle", [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            bool changed = view.Update();
+            KeepAlive(changed);
+        }
+    });
+
+    // Visible rows of one frame
+    runner.Run("EventView/VisitRows/1M/50", [&](uint64_t iterations) {
+        size_t first = view.GetRowCount() / 2;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            size_t length = 0;
+            view.VisitRows(first, first + 50, [&](const DriverEvent& event) {
+                length += event.driverName.size();
+            });
+            KeepAlive(length);
+        }
+    });
+}
+
+} // namespace DriverMonitor
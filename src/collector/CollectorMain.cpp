@@ -0,0 +1,262 @@
+// Fleet collector: receives the events that monitoring hosts forward
+// (forwarding.endpoint), stores them sharded by host and reports fleet-wide
+// driver aggregates as JSON lines on stdout.
+//
+// POSIX: SIGINT/SIGTERM stop, SIGUSR1 prints a report.
+// Windows: Ctrl+C / console close stop.
+
+#include "../core/FleetCollector.h"
+#include "../core/Utils.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <csignal>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+using namespace DriverMonitor;
+
+namespace {
+
+struct CollectorOptions {
+    int port;
+    bool loopbackOnly;
+    size_t shards;              // 0 = one per core
+    size_t capacity;
+    int statsInterval;          // Seconds between reports (0 = on SIGUSR1 and at exit only)
+    size_t top;
+    std::vector<std::string> drivers;   // Reported by name in every report
+
+    CollectorOptions() : port(7450), loopbackOnly(false), shards(0), capacity(1000000), statsInterval(0), top(10) {}
+};
+
+enum class ControlAction {
+    None,
+    Stop,
+    Report
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+        "Usage: DriverMonitorCollector [options]\n"
+        "  --port PORT            listen port (default 7450)\n"
+        "  --loopback             accept connections from this machine only\n"
+        "  --shards N             reactor threads and store shards (default: one per core)\n"
+        "  --capacity N           events retained across all shards (default 1000000)\n"
+        "  --stats-interval SEC   print a report every SEC seconds\n"
+        "  --top N                suspicious and newest drivers per report (default 10)\n"
+        "  --driver NAME          include this driver's fleet summary in reports (repeatable)\n");
+}
+
+bool ParseOptions(int argc, char* argv[], CollectorOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--loopback") {
+            options.loopbackOnly = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--port") options.port = std::atoi(value);
+        else if (arg == "--shards") options.shards = std::strtoull(value, nullptr, 10);
+        else if (arg == "--capacity") options.capacity = std::strtoull(value, nullptr, 10);
+        else if (arg == "--stats-interval") options.statsInterval = std::atoi(value);
+        else if (arg == "--top") options.top = std::strtoull(value, nullptr, 10);
+        else if (arg == "--driver") options.drivers.push_back(value);
+        else return false;
+    }
+    return options.port > 0 && options.port <= 65535 && options.capacity > 0;
+}
+
+void AppendDriver(std::string& out, const FleetDriverSummary& driver) {
+    out += "{\"driver\":";
+    Utils::AppendJsonString(out, driver.driverName);
+    out += ",\"firstSeen\":";
+    Utils::AppendJsonString(out, Utils::FormatTimestamp(driver.firstSeenUs));
+    out += ",\"firstHost\":";
+    Utils::AppendJsonString(out, driver.firstHost);
+    out += ",\"hostsAffected\":" + std::to_string(driver.hostsAffected) +
+           ",\"events\":" + std::to_string(driver.events) +
+           ",\"suspiciousEvents\":" + std::to_string(driver.suspiciousEvents) +
+           ",\"maxThreat\":\"" + Utils::GetThreatLevelName(driver.maxThreat) + "\"}";
+}
+
+void AppendDrivers(std::string& out, const char* name, const std::vector<FleetDriverSummary>& drivers) {
+    out += ",\"";
+    out += name;
+    out += "\":[";
+    for (size_t i = 0; i < drivers.size(); ++i) {
+        out += i ? "," : "";
+        AppendDriver(out, drivers[i]);
+    }
+    out += "]";
+}
+
+// One line: {"collector":{...},"topSuspicious":[...],"newestDrivers":[...],"drivers":[...]}
+void Report(const char* phase, const FleetCollector& collector, const CollectorOptions& options,
+            std::chrono::steady_clock::time_point start) {
+    static uint64_t lastEvents = 0;
+    static auto lastReport = start;
+
+    auto now = std::chrono::steady_clock::now();
+    FleetCollectorStats stats = collector.GetStats();
+    FleetStoreStats store = collector.GetStore().GetStats();
+    double seconds = std::chrono::duration<double>(now - lastReport).count();
+    double rate = seconds > 0.0 ? (stats.events - lastEvents) / seconds : 0.0;
+    lastEvents = stats.events;
+    lastReport = now;
+
+    char buffer[768];
+    std::snprintf(buffer, sizeof(buffer),
+        "{\"collector\":{\"phase\":\"%s\",\"uptimeSeconds\":%.0f,\"port\":%u,\"shards\":%zu,"
+        "\"connections\":%llu,\"accepted\":%llu,\"moved\":%llu,\"hosts\":%llu,"
+        "\"batches\":%llu,\"events\":%llu,\"eventsPerSecond\":%.0f,\"bytesReceived\":%llu,"
+        "\"duplicateBatches\":%llu,\"malformedFrames\":%llu,\"eventsRetained\":%llu,\"memoryBytes\":%llu}",
+        phase, std::chrono::duration<double>(now - start).count(), collector.GetPort(),
+        collector.GetStore().GetShardCount(),
+        static_cast<unsigned long long>(stats.connections),
+        static_cast<unsigned long long>(stats.connectionsAccepted),
+        static_cast<unsigned long long>(stats.connectionsMoved),
+        static_cast<unsigned long long>(store.hosts),
+        static_cast<unsigned long long>(stats.batches),
+        static_cast<unsigned long long>(stats.events), rate,
+        static_cast<unsigned long long>(stats.bytesReceived),
+        static_cast<unsigned long long>(store.duplicateBatches),
+        static_cast<unsigned long long>(stats.malformedFrames),
+        static_cast<unsigned long long>(store.eventsRetained),
+        static_cast<unsigned long long>(store.memoryBytes));
+    std::string line = buffer;
+
+    AppendDrivers(line, "topSuspicious", collector.GetStore().GetTopSuspicious(options.top));
+    AppendDrivers(line, "newestDrivers", collector.GetStore().GetNewestDrivers(options.top));
+    if (!options.drivers.empty()) {
+        std::vector<FleetDriverSummary> drivers;
+        for (const auto& name : options.drivers) {
+            FleetDriverSummary summary;
+            if (collector.GetStore().GetDriverSummary(name, summary)) {
+                drivers.push_back(summary);
+            }
+        }
+        AppendDrivers(line, "drivers", drivers);
+    }
+    line += "}\n";
+    std::fputs(line.c_str(), stdout);
+    std::fflush(stdout);
+}
+
+#ifdef _WIN32
+
+HANDLE g_stopEvent = nullptr;
+
+BOOL WINAPI ConsoleHandler(DWORD type) {
+    SetEvent(g_stopEvent);
+    // Give the main thread time to stop cleanly before the console closes the process
+    if (type == CTRL_CLOSE_EVENT || type == CTRL_SHUTDOWN_EVENT) {
+        Sleep(5000);
+    }
+    return TRUE;
+}
+
+bool InitControl() {
+    g_stopEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    return g_stopEvent && SetConsoleCtrlHandler(ConsoleHandler, TRUE);
+}
+
+void ArmStatsTimer(int seconds) {
+    (void)seconds; // WaitForControl times out instead
+}
+
+ControlAction WaitForControl(int statsInterval) {
+    DWORD timeout = statsInterval > 0 ? static_cast<DWORD>(statsInterval) * 1000 : INFINITE;
+    return WaitForSingleObject(g_stopEvent, timeout) == WAIT_TIMEOUT ? ControlAction::Report : ControlAction::Stop;
+}
+
+#else
+
+sigset_t g_controlSignals;
+
+bool InitControl() {
+    // Block before the reactors start so only sigwait() on the main thread sees the signals
+    sigemptyset(&g_controlSignals);
+    sigaddset(&g_controlSignals, SIGINT);
+    sigaddset(&g_controlSignals, SIGTERM);
+    sigaddset(&g_controlSignals, SIGUSR1);
+    sigaddset(&g_controlSignals, SIGALRM);
+
+    sigset_t blocked = g_controlSignals;
+    sigaddset(&blocked, SIGPIPE);
+    return pthread_sigmask(SIG_BLOCK, &blocked, nullptr) == 0;
+}
+
+void ArmStatsTimer(int seconds) {
+    if (seconds > 0) {
+        alarm(static_cast<unsigned int>(seconds));
+    }
+}
+
+ControlAction WaitForControl(int statsInterval) {
+    (void)statsInterval; // Driven by SIGALRM
+    int signal = 0;
+    if (sigwait(&g_controlSignals, &signal) != 0) {
+        return ControlAction::Stop;
+    }
+    return signal == SIGUSR1 || signal == SIGALRM ? ControlAction::Report : ControlAction::Stop;
+}
+
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto start = std::chrono::steady_clock::now();
+
+    CollectorOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+    if (!InitControl()) {
+        std::fprintf(stderr, "Cannot install control handlers\n");
+        return 1;
+    }
+
+    FleetCollectorOptions collectorOptions;
+    collectorOptions.loopbackOnly = options.loopbackOnly;
+    collectorOptions.port = static_cast<uint16_t>(options.port);
+    collectorOptions.shards = options.shards;
+    collectorOptions.capacity = options.capacity;
+
+    FleetCollector collector;
+    if (!collector.Start(collectorOptions)) {
+        std::fprintf(stderr, "Cannot start the collector: %s\n", collector.GetLastError().c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "Collecting on %s:%u with %zu shards\n", options.loopbackOnly ? "127.0.0.1" : "*",
+                 collector.GetPort(), collector.GetStore().GetShardCount());
+
+    ArmStatsTimer(options.statsInterval);
+    for (;;) {
+        ControlAction action = WaitForControl(options.statsInterval);
+        if (action == ControlAction::Stop) {
+            break;
+        }
+        if (action == ControlAction::Report) {
+            Report("running", collector, options, start);
+            ArmStatsTimer(options.statsInterval);
+        }
+    }
+
+    collector.Stop();
+    Report("exit", collector, options, start);
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include "AlertDispatcher.h"
+#include "Trace.h"
+#include <algorithm>
+#include <limits>
+
+namespace DriverMonitor {
+
+std::string Alert::Describe() const {
+    if (!IsSummary()) {
+        return event.driverName + ": " + event.loadingMethod;
+    }
+    // Whole seconds, rounded up: a burst within one second reads "in 1 second"
+    int64_t seconds = std::max<int64_t>((spanMicros + 999999) / 1000000, 1);
+    std::string text = std::to_string(similar) + " similar events";
+    if (drivers > 1) {
+        text += " from " + std::to_string(drivers) + " drivers";
+    } else {
+        text = event.driverName + ": " + text;
+    }
+    return text + " in " + std::to_string(seconds) + (seconds == 1 ? " second" : " seconds");
+}
+
+AlertDispatcher::AlertDispatcher(Clock* clock)
+    : m_capacity(kDefaultCapacity)
+    , m_clock(clock ? clock : &m_systemClock)
+    , m_stop(false)
+    , m_wakeMicros(std::numeric_limits<int64_t>::max())
+    , m_submitted(0)
+    , m_delivered(0)
+    , m_dropped(0)
+    , m_queueDepth(0)
+    , m_suppressed(0)
+    , m_summaries(0)
+    , m_pending(0)
+    , m_trackedDrivers(0) {
+}
+
+AlertDispatcher::~AlertDispatcher() {
+    Stop();
+}
+
+bool AlertDispatcher::Start(Sink sink, const AlertThrottleOptions& throttle, size_t capacity) {
+    if (m_thread || !sink) {
+        return false;
+    }
+
+    m_sink = std::move(sink);
+    m_capacity = capacity > 0 ? capacity : 1;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.clear();
+        m_queue.reserve(m_capacity);
+        m_stop = false;
+        m_throttle.Reset(throttle);
+        m_wakeMicros = std::numeric_limits<int64_t>::max();
+        m_queueDepth.store(0, std::memory_order_relaxed);
+        PublishThrottleStats();
+    }
+    m_submitted = 0;
+    m_delivered = 0;
+    m_dropped = 0;
+
+    try {
+        m_thread = std::make_unique<std::thread>(&AlertDispatcher::Run, this);
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+void AlertDispatcher::Stop() {
+    if (!m_thread) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_notEmpty.notify_one();
+    if (m_thread->joinable()) {
+        m_thread->join();
+    }
+    m_thread.reset();
+}
+
+bool AlertDispatcher::Submit(const DriverEvent& event, std::chrono::steady_clock::time_point detected) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_thread || m_stop) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        int64_t now = m_clock->NowMicros();
+        bool admitted = m_throttle.Admit(event, now);
+        PublishThrottleStats();
+        if (!admitted) {
+            // Counted into a summary. The thread only needs waking if that
+            // summary could fall due before it does: during a storm it
+            // already waits for the first one.
+            const AlertThrottleOptions& options = m_throttle.GetOptions();
+            if (now + std::min(options.quietMicros, options.maxDelayMicros) >= m_wakeMicros) {
+                return true;
+            }
+        } else if (m_queue.size() >= m_capacity) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            Alert alert;
+            alert.event = event;
+            alert.detected = detected;
+            m_queue.push_back(std::move(alert));
+            m_queueDepth.store(m_queue.size(), std::memory_order_relaxed);
+            m_submitted.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    m_notEmpty.notify_one();
+    return true;
+}
+
+AlertStats AlertDispatcher::GetStats() const {
+    AlertStats stats;
+    stats.queueDepth = m_queueDepth.load(std::memory_order_relaxed);
+    stats.suppressed = m_suppressed.load(std::memory_order_relaxed);
+    stats.summaries = m_summaries.load(std::memory_order_relaxed);
+    stats.pending = m_pending.load(std::memory_order_relaxed);
+    stats.trackedDrivers = m_trackedDrivers.load(std::memory_order_relaxed);
+    stats.submitted = m_submitted.load(std::memory_order_relaxed);
+    stats.delivered = m_delivered.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AlertDispatcher::PublishThrottleStats() {
+    m_suppressed.store(m_throttle.GetSuppressed(), std::memory_order_relaxed);
+    m_summaries.store(m_throttle.GetSummaries(), std::memory_order_relaxed);
+    m_pending.store(m_throttle.GetPending(), std::memory_order_relaxed);
+    m_trackedDrivers.store(m_throttle.GetTrackedDrivers(), std::memory_order_relaxed);
+}
+
+void AlertDispatcher::Run() {
+    Tracer::SetThreadName("alerts");
+    std::vector<Alert> batch;
+    std::vector<AlertSummary> summaries;
+    batch.reserve(m_capacity);
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;) {
+                int64_t now = m_clock->NowMicros();
+                if (m_stop) {
+                    m_throttle.Flush(now, summaries);
+                    PublishThrottleStats();
+                    break;
+                }
+                if (m_throttle.CollectDue(now, summaries) != 0) {
+                    PublishThrottleStats();
+                    break;
+                }
+                if (!m_queue.empty()) {
+                    break;
+                }
+                m_wakeMicros = m_throttle.GetNextDeadline();
+                if (m_wakeMicros == std::numeric_limits<int64_t>::max()) {
+                    m_notEmpty.wait(lock);
+                } else {
+                    m_notEmpty.wait_for(lock, std::chrono::microseconds(m_wakeMicros - now));
+                }
+            }
+            m_wakeMicros = std::numeric_limits<int64_t>::max();
+            if (m_queue.empty() && summaries.empty()) {
+                break; // Stopping and fully delivered
+            }
+            batch.swap(m_queue);
+            m_queueDepth.store(0, std::memory_order_relaxed);
+        }
+
+        for (const auto& alert : batch) {
+            DM_TRACE_SPAN("deliverAlert", "alerts");
+            m_sink(alert);
+            m_delivered.fetch_add(1, std::memory_order_relaxed);
+        }
+        batch.clear();
+        DeliverSummaries(summaries);
+    }
+}
+
+void AlertDispatcher::DeliverSummaries(std::vector<AlertSummary>& summaries) {
+    for (auto& summary : summaries) {
+        DM_TRACE_SPAN("deliverAlert", "alerts");
+        Alert alert;
+        alert.event = std::move(summary.event);
+        alert.detected = std::chrono::steady_clock::now();
+        alert.similar = summary.count;
+        alert.drivers = summary.drivers;
+        alert.spanMicros = summary.lastMicros - summary.firstMicros;
+        m_sink(alert);
+        m_delivered.fetch_add(1, std::memory_order_relaxed);
+    }
+    summaries.clear();
+}
+
+} // namespace DriverMonitor
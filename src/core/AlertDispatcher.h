@@ -0,0 +1,116 @@
+#pragma once
+
+#include "AlertThrottle.h"
+#include "Clock.h"
+#include "Utils.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DriverMonitor {
+
+// An alert raised for a stored event, or a summary of suppressed ones
+struct Alert {
+    DriverEvent event;                                  // For a summary, the first one suppressed
+    std::chrono::steady_clock::time_point detected;     // Observation submitted (summary: raised)
+    uint64_t similar;           // Summary: alerts suppressed (0 = a single alert)
+    uint64_t drivers;           // Summary: distinct drivers among them
+    int64_t spanMicros;         // Summary: first to last suppressed
+
+    Alert() : similar(0), drivers(0), spanMicros(0) {}
+
+    bool IsSummary() const { return similar != 0; }
+
+    // One line for a notification: "x.sys: Manual Map" or
+    // "x.sys: 48 similar events in 12 seconds"
+    std::string Describe() const;
+};
+
+struct AlertStats {
+    uint64_t submitted;         // Accepted into the queue
+    uint64_t delivered;         // Passed to the sink, summaries included
+    uint64_t dropped;           // Queue full (sink behind)
+    uint64_t suppressed;        // Rate limited, counted into summaries
+    uint64_t summaries;         // Summaries raised
+    uint64_t pending;           // Suppressed, summary not yet raised
+    size_t queueDepth;
+    size_t trackedDrivers;      // Throttle state held
+
+    AlertStats() : submitted(0), delivered(0), dropped(0), suppressed(0), summaries(0), pending(0),
+                   queueDepth(0), trackedDrivers(0) {}
+};
+
+// Delivers alerts (sound, notifications) on its own thread, so a slow sink
+// never holds up the pipeline that raised them. Alerts pass an AlertThrottle
+// first: during a storm only a few are raised, the rest are coalesced into
+// summaries the thread raises when they fall due (and all at Stop). The
+// queue is bounded: while the sink is behind, further alerts are dropped and
+// counted.
+class AlertDispatcher {
+public:
+    using Sink = std::function<void(const Alert& alert)>;
+
+    static const size_t kDefaultCapacity = 1024;
+
+    // clock: the system's unless replaced; must outlive the dispatcher
+    explicit AlertDispatcher(Clock* clock = nullptr);
+    ~AlertDispatcher();
+
+    // Start the thread with fresh throttle state; false if it is already
+    // running or cannot start
+    bool Start(Sink sink, const AlertThrottleOptions& throttle = AlertThrottleOptions(),
+               size_t capacity = kDefaultCapacity);
+
+    // Deliver what is queued and every pending summary, and stop the thread
+    void Stop();
+
+    bool IsRunning() const { return m_thread != nullptr; }
+
+    // Queue an alert for event unless the throttle suppresses it (any thread,
+    // never waits); false if dropped
+    bool Submit(const DriverEvent& event, std::chrono::steady_clock::time_point detected);
+
+    // Lock free, safe to call from a metrics scrape
+    AlertStats GetStats() const;
+
+private:
+    Sink m_sink;
+    size_t m_capacity;
+    SystemClock m_systemClock;
+    Clock* m_clock;
+    std::unique_ptr<std::thread> m_thread;
+
+    std::vector<Alert> m_queue;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    bool m_stop;                            // Guarded by m_mutex
+    AlertThrottle m_throttle;               // Guarded by m_mutex
+    int64_t m_wakeMicros;                   // Guarded by m_mutex: when the waiting thread wakes
+
+    std::atomic<uint64_t> m_submitted;
+    std::atomic<uint64_t> m_delivered;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<size_t> m_queueDepth;       // Written under m_mutex, read by GetStats
+
+    // Throttle counters as of its last change, so GetStats takes no lock
+    std::atomic<uint64_t> m_suppressed;
+    std::atomic<uint64_t> m_summaries;
+    std::atomic<uint64_t> m_pending;
+    std::atomic<size_t> m_trackedDrivers;
+
+    void Run();
+
+    // Copy the throttle counters to the atomics (m_mutex held)
+    void PublishThrottleStats();
+
+    // Deliver summaries as alerts
+    void DeliverSummaries(std::vector<AlertSummary>& summaries);
+};
+
+} // namespace DriverMonitor
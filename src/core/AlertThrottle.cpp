@@ -0,0 +1,186 @@
+#include "AlertThrottle.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+    const double kMicrosPerMinute = 60000000.0;
+}
+
+namespace DriverMonitor {
+
+AlertThrottle::AlertThrottle(const AlertThrottleOptions& options) {
+    Reset(options);
+}
+
+void AlertThrottle::Reset(const AlertThrottleOptions& options) {
+    m_options = options;
+    m_options.driverBurst = std::max(m_options.driverBurst, 1);
+    m_options.globalBurst = std::max(m_options.globalBurst, 1);
+    m_options.maxDrivers = std::max<size_t>(m_options.maxDrivers, 1);
+
+    m_entries.clear();
+    m_order.clear();
+    m_global.tokens = m_options.globalBurst;
+    m_global.updatedMicros = std::numeric_limits<int64_t>::min();
+    m_globalPending = AlertSummary();
+    m_globalGeneration = 1;
+    m_admitted = 0;
+    m_suppressed = 0;
+    m_summaries = 0;
+    m_pending = 0;
+}
+
+bool AlertThrottle::Admit(const DriverEvent& event, int64_t nowMicros) {
+    uint64_t key = Utils::HashIgnoreCase(event.driverName);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        if (m_entries.size() >= m_options.maxDrivers) {
+            // Forget the least recently alerted driver, keeping its count
+            auto victim = m_entries.find(m_order.back());
+            if (victim->second.pending.count != 0) {
+                MergeIntoGlobal(victim->second, nowMicros);
+            }
+            m_order.pop_back();
+            m_entries.erase(victim);
+        }
+        m_order.push_front(key);
+        Entry entry;
+        entry.bucket.tokens = m_options.driverBurst;
+        entry.bucket.updatedMicros = nowMicros;
+        entry.globalGeneration = 0;
+        entry.order = m_order.begin();
+        it = m_entries.emplace(key, std::move(entry)).first;
+    } else {
+        m_order.splice(m_order.begin(), m_order, it->second.order);
+    }
+
+    Entry& entry = it->second;
+    if (!HasToken(entry.bucket, m_options.driverPerMinute, m_options.driverBurst, nowMicros)) {
+        AddPending(entry.pending, event, nowMicros);
+        entry.pending.drivers = 1;
+        ++m_suppressed;
+        ++m_pending;
+        return false;
+    }
+    if (!HasToken(m_global, m_options.globalPerMinute, m_options.globalBurst, nowMicros)) {
+        AddPending(m_globalPending, event, nowMicros);
+        if (entry.globalGeneration != m_globalGeneration) {
+            entry.globalGeneration = m_globalGeneration;
+            ++m_globalPending.drivers;
+        }
+        ++m_suppressed;
+        ++m_pending;
+        return false;
+    }
+
+    TakeToken(entry.bucket, m_options.driverPerMinute);
+    TakeToken(m_global, m_options.globalPerMinute);
+    ++m_admitted;
+    return true;
+}
+
+size_t AlertThrottle::CollectDue(int64_t nowMicros, std::vector<AlertSummary>& out) {
+    return Collect(nowMicros, false, out);
+}
+
+size_t AlertThrottle::Flush(int64_t nowMicros, std::vector<AlertSummary>& out) {
+    return Collect(nowMicros, true, out);
+}
+
+int64_t AlertThrottle::GetNextDeadline() const {
+    int64_t deadline = std::numeric_limits<int64_t>::max();
+    for (const auto& entry : m_entries) {
+        if (entry.second.pending.count != 0) {
+            deadline = std::min(deadline, GetDeadline(entry.second.pending));
+        }
+    }
+    if (m_globalPending.count != 0) {
+        deadline = std::min(deadline, GetDeadline(m_globalPending));
+    }
+    return deadline;
+}
+
+bool AlertThrottle::HasToken(Bucket& bucket, int perMinute, int burst, int64_t nowMicros) {
+    if (perMinute <= 0) {
+        return true;
+    }
+    if (nowMicros > bucket.updatedMicros) {
+        double elapsed = static_cast<double>(nowMicros) - static_cast<double>(bucket.updatedMicros);
+        bucket.tokens = std::min<double>(burst, bucket.tokens + elapsed * perMinute / kMicrosPerMinute);
+        bucket.updatedMicros = nowMicros;
+    }
+    return bucket.tokens >= 1.0;
+}
+
+void AlertThrottle::TakeToken(Bucket& bucket, int perMinute) {
+    if (perMinute > 0) {
+        bucket.tokens -= 1.0;
+    }
+}
+
+bool AlertThrottle::IsDue(const AlertSummary& pending, int64_t nowMicros) const {
+    return nowMicros >= GetDeadline(pending);
+}
+
+int64_t AlertThrottle::GetDeadline(const AlertSummary& pending) const {
+    return std::min(pending.lastMicros + m_options.quietMicros, pending.firstMicros + m_options.maxDelayMicros);
+}
+
+void AlertThrottle::AddPending(AlertSummary& pending, const DriverEvent& event, int64_t nowMicros) {
+    if (pending.count == 0) {
+        pending.event = event;
+        pending.firstMicros = nowMicros;
+    }
+    ++pending.count;
+    pending.lastMicros = nowMicros;
+}
+
+void AlertThrottle::MergeIntoGlobal(Entry& entry, int64_t nowMicros) {
+    AlertSummary& pending = entry.pending;
+    if (m_globalPending.count == 0) {
+        m_globalPending.event = std::move(pending.event);
+        m_globalPending.firstMicros = pending.firstMicros;
+    } else {
+        m_globalPending.firstMicros = std::min(m_globalPending.firstMicros, pending.firstMicros);
+    }
+    // Merging counts as activity: the global summary stays quiet for a whole
+    // period after the last merge, so staggered driver summaries coalesce
+    m_globalPending.lastMicros = std::max(m_globalPending.lastMicros, nowMicros);
+    m_globalPending.count += pending.count;
+    if (entry.globalGeneration != m_globalGeneration) {
+        entry.globalGeneration = m_globalGeneration;
+        ++m_globalPending.drivers;
+    }
+    pending = AlertSummary();
+}
+
+void AlertThrottle::Emit(AlertSummary& pending, std::vector<AlertSummary>& out) {
+    m_pending -= pending.count;
+    out.push_back(std::move(pending));
+    pending = AlertSummary();
+    ++m_summaries;
+}
+
+size_t AlertThrottle::Collect(int64_t nowMicros, bool all, std::vector<AlertSummary>& out) {
+    size_t before = out.size();
+    for (auto& entry : m_entries) {
+        AlertSummary& pending = entry.second.pending;
+        if (pending.count == 0 || (!all && !IsDue(pending, nowMicros))) {
+            continue;
+        }
+        if (HasToken(m_global, m_options.globalPerMinute, m_options.globalBurst, nowMicros)) {
+            TakeToken(m_global, m_options.globalPerMinute);
+            Emit(pending, out);
+        } else {
+            MergeIntoGlobal(entry.second, nowMicros);
+        }
+    }
+
+    if (m_globalPending.count != 0 && (all || IsDue(m_globalPending, nowMicros))) {
+        Emit(m_globalPending, out);
+        ++m_globalGeneration;
+    }
+    return out.size() - before;
+}
+
+} // namespace DriverMonitor
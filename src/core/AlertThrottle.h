@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Utils.h"
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace DriverMonitor {
+
+struct AlertThrottleOptions {
+    int driverPerMinute;        // Alerts per driver, sustained (0 = no per-driver limit)
+    int driverBurst;            // Alerts per driver before the rate applies
+    int globalPerMinute;        // Alerts across all drivers, sustained (0 = no global limit)
+    int globalBurst;
+    int64_t quietMicros;        // A storm is summarized once it has been quiet this long
+    int64_t maxDelayMicros;     // ... or once its first suppressed alert is this old
+    size_t maxDrivers;          // Drivers tracked; the least recently alerted is forgotten
+
+    AlertThrottleOptions()
+        : driverPerMinute(2)
+        , driverBurst(3)
+        , globalPerMinute(30)
+        , globalBurst(10)
+        , quietMicros(30000000)
+        , maxDelayMicros(300000000)
+        , maxDrivers(1024) {}
+};
+
+// Alerts suppressed by AlertThrottle, coalesced into one
+struct AlertSummary {
+    DriverEvent event;          // The first one suppressed
+    uint64_t count;             // Alerts suppressed
+    uint64_t drivers;           // Distinct drivers among them (a forgotten driver counts again)
+    int64_t firstMicros;
+    int64_t lastMicros;
+
+    AlertSummary() : count(0), drivers(0), firstMicros(0), lastMicros(0) {}
+};
+
+// Token-bucket rate limits for alerts, per driver and overall, so a bulk
+// install of unsigned drivers raises a handful of alerts and summaries
+// instead of one alert per driver. An alert takes a token from its driver's
+// bucket and from the global one; without both it is suppressed and counted:
+//  - over its driver's limit, into that driver's summary;
+//  - over the global limit, into a single summary across drivers.
+// A summary is due once no alert has joined it for the quiet period, or once
+// its first alert reaches the maximum delay, so a storm that never ends is
+// still reported. A due driver summary needs a global token too, else it is
+// merged into the global summary; the global summary itself is never limited.
+// Every suppressed alert ends up in exactly one summary.
+//
+// Memory is bounded by maxDrivers entries (one event each) whatever the
+// flood: drivers are keyed by their case-folded name hash, and the least
+// recently alerted driver is forgotten at capacity, its pending count
+// moving to the global summary.
+//
+// Not thread safe; times are passed in (Clock::NowMicros), so a virtual
+// clock can drive it.
+class AlertThrottle {
+public:
+    explicit AlertThrottle(const AlertThrottleOptions& options = AlertThrottleOptions());
+
+    // Replace the limits and forget all state; pending counts are dropped,
+    // so Flush first to keep them
+    void Reset(const AlertThrottleOptions& options);
+
+    const AlertThrottleOptions& GetOptions() const { return m_options; }
+
+    // True to raise an alert for event now; false when it was suppressed
+    bool Admit(const DriverEvent& event, int64_t nowMicros);
+
+    // Append the summaries due at now to out; returns how many
+    size_t CollectDue(int64_t nowMicros, std::vector<AlertSummary>& out);
+
+    // Append every pending summary, due or not (shutdown); returns how many
+    size_t Flush(int64_t nowMicros, std::vector<AlertSummary>& out);
+
+    // When the next pending summary is due (INT64_MAX when none is).
+    // Scans the tracked drivers.
+    int64_t GetNextDeadline() const;
+
+    uint64_t GetAdmitted() const { return m_admitted; }
+    uint64_t GetSuppressed() const { return m_suppressed; }
+    uint64_t GetSummaries() const { return m_summaries; }
+    uint64_t GetPending() const { return m_pending; }   // Suppressed, not yet summarized
+    size_t GetTrackedDrivers() const { return m_entries.size(); }
+
+private:
+    struct Bucket {
+        double tokens;
+        int64_t updatedMicros;
+    };
+
+    struct Entry {
+        Bucket bucket;
+        AlertSummary pending;
+        uint64_t globalGeneration;          // Counted in the global summary of this generation
+        std::list<uint64_t>::iterator order;
+    };
+
+    AlertThrottleOptions m_options;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::list<uint64_t> m_order;            // Most recently alerted first
+    Bucket m_global;
+    AlertSummary m_globalPending;
+    uint64_t m_globalGeneration;
+
+    uint64_t m_admitted;
+    uint64_t m_suppressed;
+    uint64_t m_summaries;
+    uint64_t m_pending;
+
+    // Refill bucket to now; true if it holds a token (always without a limit)
+    static bool HasToken(Bucket& bucket, int perMinute, int burst, int64_t nowMicros);
+    static void TakeToken(Bucket& bucket, int perMinute);
+    bool IsDue(const AlertSummary& pending, int64_t nowMicros) const;
+    int64_t GetDeadline(const AlertSummary& pending) const;
+
+    // Count one suppressed event into pending
+    static void AddPending(AlertSummary& pending, const DriverEvent& event, int64_t nowMicros);
+
+    // Move entry's pending count to the global summary, as of now
+    void MergeIntoGlobal(Entry& entry, int64_t nowMicros);
+
+    void Emit(AlertSummary& pending, std::vector<AlertSummary>& out);
+    size_t Collect(int64_t nowMicros, bool all, std::vector<AlertSummary>& out);
+};
+
+} // namespace DriverMonitor
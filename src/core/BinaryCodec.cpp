@@ -0,0 +1,108 @@
+#include "BinaryCodec.h"
+#include <cstring>
+
+namespace DriverMonitor {
+
+void BinaryWriter::WriteVarint(uint64_t value) {
+    while (value >= 0x80) {
+        m_buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    m_buffer.push_back(static_cast<char>(value));
+}
+
+void BinaryWriter::WriteSignedVarint(int64_t value) {
+    // Zigzag so small negative deltas stay small
+    WriteVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void BinaryWriter::WriteString(const std::string& value) {
+    WriteVarint(value.size());
+    m_buffer.append(value);
+}
+
+void BinaryWriter::WriteBytes(const void* data, size_t length) {
+    m_buffer.append(static_cast<const char*>(data), length);
+}
+
+void BinaryWriter::WriteFixed32(uint32_t value) {
+    char bytes[4] = {
+        static_cast<char>(value & 0xFF),
+        static_cast<char>((value >> 8) & 0xFF),
+        static_cast<char>((value >> 16) & 0xFF),
+        static_cast<char>((value >> 24) & 0xFF)
+    };
+    m_buffer.append(bytes, sizeof(bytes));
+}
+
+uint8_t BinaryReader::ReadByte() {
+    if (m_offset >= m_length) {
+        m_error = true;
+        return 0;
+    }
+    return static_cast<uint8_t>(m_data[m_offset++]);
+}
+
+uint64_t BinaryReader::ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (m_offset >= m_length) {
+            m_error = true;
+            return 0;
+        }
+        uint8_t byte = static_cast<uint8_t>(m_data[m_offset++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    m_error = true;
+    return 0;
+}
+
+int64_t BinaryReader::ReadSignedVarint() {
+    uint64_t value = ReadVarint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+std::string BinaryReader::ReadString() {
+    size_t length = 0;
+    const char* data = ReadStringView(length);
+    return data ? std::string(data, length) : std::string();
+}
+
+const char* BinaryReader::ReadStringView(size_t& length) {
+    uint64_t size = ReadVarint();
+    if (m_error || size > m_length - m_offset) {
+        m_error = true;
+        length = 0;
+        return nullptr;
+    }
+    const char* data = m_data + m_offset;
+    m_offset += static_cast<size_t>(size);
+    length = static_cast<size_t>(size);
+    return data;
+}
+
+bool BinaryReader::ReadBytes(void* out, size_t length) {
+    if (length > m_length - m_offset) {
+        m_error = true;
+        return false;
+    }
+    memcpy(out, m_data + m_offset, length);
+    m_offset += length;
+    return true;
+}
+
+uint32_t BinaryReader::ReadFixed32() {
+    unsigned char bytes[4] = {0};
+    if (!ReadBytes(bytes, sizeof(bytes))) {
+        return 0;
+    }
+    return static_cast<uint32_t>(bytes[0]) |
+           (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) |
+           (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+} // namespace DriverMonitor
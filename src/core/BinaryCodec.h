@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DriverMonitor {
+
+// Appends LEB128 varints and length-prefixed strings to a byte buffer
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::string& buffer) : m_buffer(buffer) {}
+
+    void WriteByte(uint8_t value) { m_buffer.push_back(static_cast<char>(value)); }
+    void WriteVarint(uint64_t value);
+    void WriteSignedVarint(int64_t value);
+    void WriteString(const std::string& value);
+    void WriteBytes(const void* data, size_t length);
+    void WriteFixed32(uint32_t value);
+
+private:
+    std::string& m_buffer;
+};
+
+// Reads what BinaryWriter wrote; any overrun sets the error flag and yields zeros
+class BinaryReader {
+public:
+    BinaryReader(const char* data, size_t length) : m_data(data), m_length(length), m_offset(0), m_error(false) {}
+
+    uint8_t ReadByte();
+    uint64_t ReadVarint();
+    int64_t ReadSignedVarint();
+    std::string ReadString();
+    bool ReadBytes(void* out, size_t length);
+    uint32_t ReadFixed32();
+
+    // Skip a length-prefixed string without copying; returns its bytes
+    const char* ReadStringView(size_t& length);
+
+    bool AtEnd() const { return m_offset >= m_length; }
+    bool HasError() const { return m_error; }
+    size_t GetOffset() const { return m_offset; }
+
+private:
+    const char* m_data;
+    size_t m_length;
+    size_t m_offset;
+    bool m_error;
+};
+
+} // namespace DriverMonitor
@@ -0,0 +1,38 @@
+#include "ChangeNotifier.h"
+
+namespace DriverMonitor {
+
+ChangeNotifier::ChangeNotifier()
+    : m_generation(0)
+    , m_waiters(0)
+    , m_listenerArmed(false) {
+}
+
+void ChangeNotifier::Notify() {
+    // Sequentially consistent with the waiter count: a waiter that registered
+    // after this increment re-checks the generation before sleeping
+    m_generation.fetch_add(1, std::memory_order_seq_cst);
+
+    if (m_waiters.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_condition.notify_all();
+    }
+
+    if (m_listenerArmed.load(std::memory_order_relaxed) && m_listenerArmed.exchange(false) && m_listener) {
+        m_listener();
+    }
+}
+
+bool ChangeNotifier::WaitForChange(uint64_t& generation, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+    bool changed = m_condition.wait_for(lock, timeout, [&]() {
+        return m_generation.load(std::memory_order_seq_cst) != generation;
+    });
+    m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+
+    generation = m_generation.load(std::memory_order_acquire);
+    return changed;
+}
+
+} // namespace DriverMonitor
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace DriverMonitor {
+
+// Monotonically increasing change generation with a blocking wait.
+// Notify() is an atomic increment plus two relaxed checks unless someone is
+// waiting, so it is cheap enough for every stored event. Consumers either
+// block in WaitForChange() or, when they wait on something else (a window
+// message loop), arm a one-shot listener that Notify() calls once.
+class ChangeNotifier {
+public:
+    ChangeNotifier();
+
+    // Current generation (starts at 0)
+    uint64_t GetGeneration() const { return m_generation.load(std::memory_order_acquire); }
+
+    // Record a change and wake waiters
+    void Notify();
+
+    // Wait until the generation differs from generation or the timeout
+    // expires; updates generation and returns true if it changed
+    bool WaitForChange(uint64_t& generation, std::chrono::milliseconds timeout);
+
+    // Listener called (on the notifying thread) by the first Notify() after
+    // ArmListener(); set it before any thread calls Notify()
+    void SetListener(std::function<void()> listener) { m_listener = std::move(listener); }
+    void ArmListener() { m_listenerArmed.store(true, std::memory_order_seq_cst); }
+
+private:
+    std::atomic<uint64_t> m_generation;
+    std::atomic<int> m_waiters;
+    std::atomic<bool> m_listenerArmed;
+    std::function<void()> m_listener;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+};
+
+} // namespace DriverMonitor
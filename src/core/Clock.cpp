@@ -0,0 +1,85 @@
+#include "Clock.h"
+#include <chrono>
+
+namespace {
+    int64_t SystemNowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    int64_t SteadyNowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+namespace DriverMonitor {
+
+SystemClock::SystemClock() : m_interrupted(false) {
+}
+
+int64_t SystemClock::NowMicros() {
+    return SystemNowMicros();
+}
+
+bool SystemClock::SleepUntil(int64_t micros) {
+    return SleepFor(micros - SystemNowMicros());
+}
+
+bool SystemClock::SleepFor(int64_t micros) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(micros > 0 ? micros : 0);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait_until(lock, deadline, [this]() { return m_interrupted; });
+    return !m_interrupted;
+}
+
+void SystemClock::Interrupt() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_interrupted = true;
+    m_condition.notify_all();
+}
+
+ScaledClock::ScaledClock(int64_t originMicros, double speed)
+    : m_origin(originMicros)
+    , m_realStart(SteadyNowMicros())
+    , m_speed(speed > 0.0 ? speed : 1.0) {
+}
+
+int64_t ScaledClock::NowMicros() {
+    return m_origin + static_cast<int64_t>((SteadyNowMicros() - m_realStart) * m_speed);
+}
+
+bool ScaledClock::SleepUntil(int64_t micros) {
+    int64_t realDeadline = m_realStart + static_cast<int64_t>((micros - m_origin) / m_speed);
+    return SleepFor(realDeadline - SteadyNowMicros());
+}
+
+VirtualClock::VirtualClock(int64_t startMicros)
+    : m_now(startMicros)
+    , m_interrupted(false) {
+}
+
+int64_t VirtualClock::NowMicros() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_now;
+}
+
+bool VirtualClock::SleepUntil(int64_t micros) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (micros > m_now) {
+        m_now = micros;
+    }
+    return !m_interrupted;
+}
+
+void VirtualClock::Interrupt() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_interrupted = true;
+}
+
+void VirtualClock::Advance(int64_t micros) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_now += micros;
+}
+
+} // namespace DriverMonitor
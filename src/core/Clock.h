@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace DriverMonitor {
+
+// Time source for the pipeline, in microseconds since the Unix epoch.
+// Live monitoring uses the system clock; replays inject a scaled or virtual clock.
+class Clock {
+public:
+    virtual ~Clock() {}
+
+    // Current time
+    virtual int64_t NowMicros() = 0;
+
+    // Block until time is reached; returns false if interrupted
+    virtual bool SleepUntil(int64_t micros) = 0;
+
+    // Wake any SleepUntil caller (and all future ones) immediately
+    virtual void Interrupt() = 0;
+};
+
+// Wall clock
+class SystemClock : public Clock {
+public:
+    SystemClock();
+
+    int64_t NowMicros() override;
+    bool SleepUntil(int64_t micros) override;
+    void Interrupt() override;
+
+protected:
+    // Block for a duration measured on the monotonic clock, so a wall clock
+    // step (NTP, manual change) neither stretches nor cuts the wait short
+    bool SleepFor(int64_t micros);
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_interrupted;
+};
+
+// Runs a recorded timeline at speed x real time, starting at origin
+class ScaledClock : public SystemClock {
+public:
+    ScaledClock(int64_t originMicros, double speed);
+
+    int64_t NowMicros() override;
+    bool SleepUntil(int64_t micros) override;
+
+private:
+    int64_t m_origin;
+    int64_t m_realStart;    // Monotonic clock, so wall clock steps do not skew replay
+    double m_speed;
+};
+
+// Never waits: SleepUntil jumps time forward (as-fast-as-possible replay, tests)
+class VirtualClock : public Clock {
+public:
+    explicit VirtualClock(int64_t startMicros = 0);
+
+    int64_t NowMicros() override;
+    bool SleepUntil(int64_t micros) override;
+    void Interrupt() override;
+
+    // Move time forward
+    void Advance(int64_t micros);
+
+private:
+    std::mutex m_mutex;
+    int64_t m_now;
+    bool m_interrupted;
+};
+
+} // namespace DriverMonitor
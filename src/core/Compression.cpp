@@ -0,0 +1,150 @@
+#include "Compression.h"
+#include <cstring>
+
+namespace {
+    const size_t kMinMatch = 4;
+    const size_t kMaxOffset = 65535;
+    const int kHashBits = 12;
+
+    // The last bytes are always literals, so match search never reads past the end
+    const size_t kTailLiterals = 5;
+
+    uint32_t Read32(const char* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint32_t Hash(uint32_t prefix) {
+        return (prefix * 2654435761u) >> (32 - kHashBits);
+    }
+
+    // Length beyond what fits the token nibble: 255s, then the remainder
+    void WriteLength(std::string& out, size_t length) {
+        while (length >= 255) {
+            out.push_back(static_cast<char>(255));
+            length -= 255;
+        }
+        out.push_back(static_cast<char>(length));
+    }
+
+    void WriteSequence(std::string& out, const char* literals, size_t literalLength, size_t offset, size_t matchLength) {
+        size_t matchCode = matchLength >= kMinMatch ? matchLength - kMinMatch : 0;
+        uint8_t token = static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4);
+        if (matchLength > 0) {
+            token |= static_cast<uint8_t>(matchCode < 15 ? matchCode : 15);
+        }
+        out.push_back(static_cast<char>(token));
+        if (literalLength >= 15) {
+            WriteLength(out, literalLength - 15);
+        }
+        out.append(literals, literalLength);
+        if (matchLength > 0) {
+            out.push_back(static_cast<char>(offset & 0xff));
+            out.push_back(static_cast<char>(offset >> 8));
+            if (matchCode >= 15) {
+                WriteLength(out, matchCode - 15);
+            }
+        }
+    }
+
+    // Token nibble plus any extra length bytes; false on overrun
+    bool ReadLength(const uint8_t*& in, const uint8_t* end, size_t& length) {
+        if (length != 15) {
+            return true;
+        }
+        for (;;) {
+            if (in >= end) {
+                return false;
+            }
+            uint8_t extra = *in++;
+            length += extra;
+            if (extra != 255) {
+                return true;
+            }
+        }
+    }
+}
+
+namespace DriverMonitor {
+
+void Lz::Compress(const char* data, size_t length, std::string& out) {
+    out.reserve(out.size() + GetMaxCompressedSize(length));
+    size_t literalStart = 0;
+    if (length > kMinMatch + kTailLiterals) {
+        uint32_t table[1 << kHashBits] = {};    // Position + 1 of the last prefix with this hash
+        size_t limit = length - kTailLiterals;
+        size_t position = 0;
+        while (position + kMinMatch <= limit) {
+            uint32_t prefix = Read32(data + position);
+            uint32_t hash = Hash(prefix);
+            size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(position + 1);
+            if (candidate == 0 || position - (candidate - 1) > kMaxOffset || Read32(data + candidate - 1) != prefix) {
+                position++;
+                continue;
+            }
+            size_t match = candidate - 1;
+            size_t matchLength = kMinMatch;
+            while (position + matchLength < limit && data[match + matchLength] == data[position + matchLength]) {
+                matchLength++;
+            }
+            WriteSequence(out, data + literalStart, position - literalStart, position - match, matchLength);
+            position += matchLength;
+            literalStart = position;
+        }
+    }
+    WriteSequence(out, data + literalStart, length - literalStart, 0, 0);
+}
+
+bool Lz::Decompress(const char* data, size_t length, size_t rawLength, std::string& out) {
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = in + length;
+    size_t base = out.size();
+    out.resize(base + rawLength);
+    char* output = &out[0] + base;
+    size_t written = 0;
+
+    while (in < end) {
+        uint8_t token = *in++;
+        size_t literalLength = token >> 4;
+        if (!ReadLength(in, end, literalLength) || literalLength > static_cast<size_t>(end - in) ||
+            literalLength > rawLength - written) {
+            break;
+        }
+        std::memcpy(output + written, in, literalLength);
+        in += literalLength;
+        written += literalLength;
+        if (in == end) {
+            // Last sequence: literals only
+            if (written == rawLength) {
+                return true;
+            }
+            break;
+        }
+
+        if (end - in < 2) {
+            break;
+        }
+        size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        size_t matchLength = token & 0x0f;
+        if (!ReadLength(in, end, matchLength)) {
+            break;
+        }
+        matchLength += kMinMatch;
+        if (offset == 0 || offset > written || matchLength > rawLength - written) {
+            break;
+        }
+        // Byte by byte: the match may overlap the bytes it produces
+        const char* source = output + written - offset;
+        for (size_t i = 0; i < matchLength; ++i) {
+            output[written + i] = source[i];
+        }
+        written += matchLength;
+    }
+    out.resize(base);
+    return false;
+}
+
+} // namespace DriverMonitor
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DriverMonitor {
+
+// LZ77 block compression in the LZ4 block layout: sequences of a token byte
+// (literal length << 4 | match length - 4, 15 = more length bytes follow),
+// the literals, a 2-byte little-endian match offset and the extra match
+// length bytes; the last sequence has literals only. One greedy pass with a
+// 4096-entry hash of 4-byte prefixes and a 64 KiB window, no entropy coding:
+// fast enough for the pipeline's batches and good on repetitive records
+// (driver paths, signers, loading methods). Blocks do not store their raw
+// size; the container does.
+class Lz {
+public:
+    // Append the compressed form of data to out
+    static void Compress(const char* data, size_t length, std::string& out);
+
+    // Append the rawLength bytes that data decompresses to; false if data
+    // is malformed or does not decompress to exactly rawLength bytes
+    static bool Decompress(const char* data, size_t length, size_t rawLength, std::string& out);
+
+    // Compressed size of length bytes in the worst case (incompressible)
+    static size_t GetMaxCompressedSize(size_t length) { return length + length / 255 + 16; }
+};
+
+} // namespace DriverMonitor
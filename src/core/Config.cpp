@@ -1,190 +1,365 @@
 #include "Config.h"
+#include "JsonCodec.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
-#include <algorithm>
 
-// Simple JSON parser (minimal implementation for our needs)
+// Configuration schema: every setting, its section, type and valid range.
+// Parse() and Serialize() both walk this table, so they cannot disagree.
 namespace {
-    std::string trim(const std::string& str) {
-        size_t first = str.find_first_not_of(" \t\n\r");
-        if (first == std::string::npos) return "";
-        size_t last = str.find_last_not_of(" \t\n\r");
-        return str.substr(first, last - first + 1);
-    }
-    
-    std::string unquote(const std::string& str) {
-        std::string s = trim(str);
-        if (s.length() >= 2 && s[0] == '"' && s[s.length()-1] == '"') {
-            return s.substr(1, s.length()-2);
+    using DriverMonitor::MonitorConfig;
+
+    struct Setting {
+        const char* section;
+        const char* key;
+        bool MonitorConfig::* boolValue;
+        int MonitorConfig::* intValue;
+        std::string MonitorConfig::* stringValue;
+        int minValue;
+        int maxValue;
+    };
+
+    Setting BoolSetting(const char* section, const char* key, bool MonitorConfig::* value) {
+        return { section, key, value, nullptr, nullptr, 0, 0 };
+    }
+
+    Setting IntSetting(const char* section, const char* key, int MonitorConfig::* value, int minValue, int maxValue) {
+        return { section, key, nullptr, value, nullptr, minValue, maxValue };
+    }
+
+    Setting StringSetting(const char* section, const char* key, std::string MonitorConfig::* value) {
+        return { section, key, nullptr, nullptr, value, 0, 0 };
+    }
+
+    const Setting kSettings[] = {
+        BoolSetting("monitoring", "ignoreWindowsSigned", &MonitorConfig::ignoreWindowsSigned),
+        BoolSetting("monitoring", "ignoreMicrosoft", &MonitorConfig::ignoreMicrosoft),
+        BoolSetting("monitoring", "blockUnsigned", &MonitorConfig::blockUnsigned),
+        BoolSetting("monitoring", "verboseMode", &MonitorConfig::verboseMode),
+        StringSetting("monitoring", "driversPath", &MonitorConfig::driversPath),
+        IntSetting("monitoring", "memoryBudgetMB", &MonitorConfig::memoryBudgetMB, 0, 1048576),
+        BoolSetting("alerts", "playSound", &MonitorConfig::playSound),
+        BoolSetting("alerts", "showNotifications", &MonitorConfig::showNotifications),
+        IntSetting("alerts", "perDriverPerMinute", &MonitorConfig::alertsPerMinute, 0, 60000),
+        IntSetting("alerts", "perDriverBurst", &MonitorConfig::alertBurst, 1, 10000),
+        IntSetting("alerts", "globalPerMinute", &MonitorConfig::globalAlertsPerMinute, 0, 60000),
+        IntSetting("alerts", "globalBurst", &MonitorConfig::globalAlertBurst, 1, 10000),
+        IntSetting("alerts", "quietSeconds", &MonitorConfig::alertQuietSeconds, 1, 86400),
+        BoolSetting("ui", "autoScroll", &MonitorConfig::autoScroll),
+        IntSetting("ui", "maxEvents", &MonitorConfig::maxEvents, 1, 10000000),
+        BoolSetting("logging", "enabled", &MonitorConfig::loggingEnabled),
+        StringSetting("logging", "logFile", &MonitorConfig::logFile),
+        IntSetting("logging", "maxLogSize", &MonitorConfig::maxLogSize, 0, INT_MAX),
+        StringSetting("forwarding", "endpoint", &MonitorConfig::forwardEndpoint),
+        StringSetting("forwarding", "spoolPath", &MonitorConfig::forwardSpoolPath),
+        IntSetting("forwarding", "batchEvents", &MonitorConfig::forwardBatchEvents, 1, 65536),
+        IntSetting("forwarding", "flushIntervalMs", &MonitorConfig::forwardFlushIntervalMs, 10, 600000),
+        IntSetting("forwarding", "bufferMB", &MonitorConfig::forwardBufferMB, 1, 4096),
+        IntSetting("forwarding", "spoolMB", &MonitorConfig::forwardSpoolMB, 1, 1048576)
+    };
+
+    const char* const kSections[] = { "monitoring", "alerts", "ui", "logging", "forwarding" };
+    const char kWhitelist[] = "whitelist";
+
+    const Setting* FindSetting(const std::string& section, const std::string& key) {
+        for (const auto& setting : kSettings) {
+            if (section == setting.section && key == setting.key) {
+                return &setting;
+            }
+        }
+        return nullptr;
+    }
+
+    // Names, their hash set nodes and buckets
+    size_t GetWhitelistBytes(const DriverMonitor::ConfigWhitelist& whitelist) {
+        using DriverMonitor::MemoryAccounting;
+        size_t bytes = whitelist.names.capacity() * sizeof(std::string) +
+                       whitelist.lookup.bucket_count() * sizeof(void*) +
+                       whitelist.lookup.size() * (sizeof(std::string) + 2 * sizeof(void*));
+        for (const auto& name : whitelist.names) {
+            bytes += 2 * MemoryAccounting::GetHeapBytes(name);
+        }
+        return bytes;
+    }
+
+    bool IsSection(const std::string& name) {
+        return std::find_if(std::begin(kSections), std::end(kSections),
+                            [&](const char* section) { return name == section; }) != std::end(kSections);
+    }
+
+    // Read one setting's value into config
+    bool ReadSetting(DriverMonitor::JsonReader& reader, const Setting& setting, MonitorConfig& config) {
+        using DriverMonitor::JsonToken;
+        std::string name = std::string(setting.section) + "." + setting.key;
+        JsonToken token = reader.Next();
+        if (token == JsonToken::Error) {
+            return false;
         }
-        return s;
-    }
-    
-    bool parseBool(const std::string& str) {
-        std::string s = trim(str);
-        return s == "true";
-    }
-    
-    int parseInt(const std::string& str) {
-        try {
-            return std::stoi(trim(str));
-        } catch (...) {
-            return 0;
+
+        if (setting.boolValue) {
+            if (token != JsonToken::True && token != JsonToken::False) {
+                reader.Fail(name + " must be true or false");
+                return false;
+            }
+            config.*setting.boolValue = token == JsonToken::True;
+        } else if (setting.intValue) {
+            if (token != JsonToken::Number || !reader.IsInteger() ||
+                reader.GetInteger() < setting.minValue || reader.GetInteger() > setting.maxValue) {
+                reader.Fail(name + " must be an integer from " + std::to_string(setting.minValue) +
+                            " to " + std::to_string(setting.maxValue));
+                return false;
+            }
+            config.*setting.intValue = static_cast<int>(reader.GetInteger());
+        } else {
+            if (token != JsonToken::String) {
+                reader.Fail(name + " must be a string");
+                return false;
+            }
+            config.*setting.stringValue = reader.GetString();
         }
+        return true;
     }
 }
 
 namespace DriverMonitor {
 
-Config::Config() {
+Config::Config() : m_snapshot(nullptr) {
     m_configPath = "config.json";
+
+    ConfigSnapshot* snapshot = new ConfigSnapshot();
+    snapshot->version = 1;
+    snapshot->whitelist = std::make_shared<const ConfigWhitelist>();
+    snapshot->memory.Set(sizeof(ConfigSnapshot));
+    m_snapshot = snapshot;
 }
 
 Config::~Config() {
+    // Readers are gone by now, but a retired snapshot may still be waiting for one
+    Rcu::Retire(m_snapshot.exchange(nullptr));
 }
 
-bool Config::Load(const std::string& filePath) {
-    m_configPath = filePath;
-    
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        // File doesn't exist, use defaults
+void Config::PublishLocked() {
+    const ConfigSnapshot* previous = m_snapshot.load(std::memory_order_relaxed);
+
+    // Copy everything but the whitelist, which is only rebuilt when it changed
+    ConfigSnapshot* snapshot = new ConfigSnapshot();
+    std::vector<std::string> whitelist;
+    whitelist.swap(m_config.whitelist);
+    snapshot->config = m_config;
+    whitelist.swap(m_config.whitelist);
+    snapshot->version = previous->version + 1;
+
+    if (m_config.whitelist == previous->whitelist->names) {
+        snapshot->whitelist = previous->whitelist;
+    } else {
+        auto published = std::make_shared<ConfigWhitelist>();
+        published->names = m_config.whitelist;
+        published->lookup.reserve(published->names.size());
+        published->lookup.insert(published->names.begin(), published->names.end());
+        published->memory.Set(GetWhitelistBytes(*published));
+        snapshot->whitelist = std::move(published);
+    }
+    snapshot->memory.Set(sizeof(ConfigSnapshot) + MemoryAccounting::GetHeapBytes(snapshot->config.driversPath) +
+                         MemoryAccounting::GetHeapBytes(snapshot->config.logFile));
+
+    // Readers that loaded the previous snapshot keep it until their guards end
+    m_snapshot.exchange(snapshot, std::memory_order_seq_cst);
+    Rcu::Retire(previous);
+    m_changes.Notify();
+}
+
+void Config::Apply(const MonitorConfig& config) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config = config;
+    PublishLocked();
+}
+
+void Config::NotifyChanged() {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    PublishLocked();
+}
+
+bool Config::Parse(const char* data, size_t length, MonitorConfig& config, std::string& error) {
+    JsonReader reader(data, length);
+    MonitorConfig parsed;
+
+    auto fail = [&]() {
+        error = reader.GetError();
         return false;
+    };
+
+    JsonToken token = reader.Next();
+    if (token != JsonToken::BeginObject) {
+        if (token != JsonToken::Error) {
+            reader.Fail("expected an object");
+        }
+        return fail();
     }
-    
-    // Simple JSON parsing (basic implementation)
-    std::string line;
-    std::string section;
-    
-    while (std::getline(file, line)) {
-        line = trim(line);
-        
-        // Skip empty lines and comments
-        if (line.empty() || line[0] == '#' || line[0] == '/' || line == "{" || line == "}") {
-            continue;
+
+    for (;;) {
+        token = reader.Next();
+        if (token == JsonToken::EndObject) {
+            break;
         }
-        
-        // Check for section headers
-        if (line.find("\"monitoring\"") != std::string::npos) {
-            section = "monitoring";
-            continue;
-        } else if (line.find("\"alerts\"") != std::string::npos) {
-            section = "alerts";
-            continue;
-        } else if (line.find("\"ui\"") != std::string::npos) {
-            section = "ui";
-            continue;
-        } else if (line.find("\"logging\"") != std::string::npos) {
-            section = "logging";
-            continue;
-        } else if (line.find("\"whitelist\"") != std::string::npos) {
-            section = "whitelist";
-            continue;
+        if (token != JsonToken::Key) {
+            return fail();
         }
-        
-        // Parse key-value pairs
-        size_t colonPos = line.find(':');
-        if (colonPos != std::string::npos) {
-            std::string key = line.substr(0, colonPos);
-            std::string value = line.substr(colonPos + 1);
-            
-            // Remove quotes and trailing comma
-            key = unquote(key);
-            if (value.back() == ',') {
-                value = value.substr(0, value.length() - 1);
+        std::string section = reader.GetString();
+
+        if (section == kWhitelist) {
+            if (reader.Next() != JsonToken::BeginArray) {
+                reader.Fail("whitelist must be an array");
+                return fail();
             }
-            value = trim(value);
-            
-            // Parse based on section
-            if (section == "monitoring") {
-                if (key == "ignoreWindowsSigned") m_config.ignoreWindowsSigned = parseBool(value);
-                else if (key == "ignoreMicrosoft") m_config.ignoreMicrosoft = parseBool(value);
-                else if (key == "blockUnsigned") m_config.blockUnsigned = parseBool(value);
-                else if (key == "verboseMode") m_config.verboseMode = parseBool(value);
-            } else if (section == "alerts") {
-                if (key == "playSound") m_config.playSound = parseBool(value);
-                else if (key == "showNotifications") m_config.showNotifications = parseBool(value);
-            } else if (section == "ui") {
-                if (key == "autoScroll") m_config.autoScroll = parseBool(value);
-                else if (key == "maxEvents") m_config.maxEvents = parseInt(value);
-            } else if (section == "logging") {
-                if (key == "enabled") m_config.loggingEnabled = parseBool(value);
-                else if (key == "logFile") m_config.logFile = unquote(value);
-                else if (key == "maxLogSize") m_config.maxLogSize = parseInt(value);
+            parsed.whitelist.clear();
+            while ((token = reader.Next()) != JsonToken::EndArray) {
+                if (token != JsonToken::String || reader.GetString().empty()) {
+                    reader.Fail("whitelist entries must be non-empty strings");
+                    return fail();
+                }
+                parsed.whitelist.push_back(reader.GetString());
             }
+            continue;
         }
-        
-        // Parse whitelist array items
-        if (section == "whitelist" && line.find('"') != std::string::npos) {
-            std::string item = unquote(line);
-            if (!item.empty() && item != "[" && item != "]") {
-                m_config.whitelist.push_back(item);
+
+        if (!IsSection(section)) {
+            reader.Fail("unknown section '" + section + "'");
+            return fail();
+        }
+        if (reader.Next() != JsonToken::BeginObject) {
+            reader.Fail(section + " must be an object");
+            return fail();
+        }
+        while ((token = reader.Next()) != JsonToken::EndObject) {
+            if (token != JsonToken::Key) {
+                return fail();
+            }
+            const Setting* setting = FindSetting(section, reader.GetString());
+            if (!setting) {
+                reader.Fail("unknown setting '" + section + "." + reader.GetString() + "'");
+                return fail();
+            }
+            if (!ReadSetting(reader, *setting, parsed)) {
+                return fail();
             }
         }
     }
-    
-    file.close();
+
+    if (reader.Next() != JsonToken::End) {
+        return fail();
+    }
+    config = std::move(parsed);
     return true;
 }
 
-bool Config::Save(const std::string& filePath) {
-    std::ofstream file(filePath.empty() ? m_configPath : filePath);
+std::string Config::Serialize(const MonitorConfig& config) {
+    std::string text;
+    JsonWriter writer(text);
+    writer.BeginObject();
+    for (const char* section : kSections) {
+        writer.Key(section);
+        writer.BeginObject();
+        for (const auto& setting : kSettings) {
+            if (std::string(setting.section) != section) {
+                continue;
+            }
+            writer.Key(setting.key);
+            if (setting.boolValue) {
+                writer.Bool(config.*setting.boolValue);
+            } else if (setting.intValue) {
+                writer.Int(config.*setting.intValue);
+            } else {
+                writer.String(config.*setting.stringValue);
+            }
+        }
+        writer.EndObject();
+    }
+    writer.Key(kWhitelist);
+    writer.BeginArray();
+    for (const auto& driverName : config.whitelist) {
+        writer.String(driverName);
+    }
+    writer.EndArray();
+    writer.EndObject();
+    return text;
+}
+
+bool Config::Load(const std::string& filePath) {
+    m_configPath = filePath;
+
+    std::ifstream file(filePath, std::ios::binary);
     if (!file.is_open()) {
+        // File doesn't exist, use defaults
+        m_lastError = filePath + ": cannot open";
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string text = contents.str();
+
+    // Parse into a copy so an invalid file leaves the current settings untouched
+    MonitorConfig parsed;
+    std::string error;
+    if (!Parse(text.data(), text.size(), parsed, error)) {
+        m_lastError = filePath + ": " + error;
         return false;
     }
-    
-    file << "{\n";
-    file << "  \"monitoring\": {\n";
-    file << "    \"ignoreWindowsSigned\": " << (m_config.ignoreWindowsSigned ? "true" : "false") << ",\n";
-    file << "    \"ignoreMicrosoft\": " << (m_config.ignoreMicrosoft ? "true" : "false") << ",\n";
-    file << "    \"blockUnsigned\": " << (m_config.blockUnsigned ? "true" : "false") << ",\n";
-    file << "    \"verboseMode\": " << (m_config.verboseMode ? "true" : "false") << "\n";
-    file << "  },\n";
-    file << "  \"alerts\": {\n";
-    file << "    \"playSound\": " << (m_config.playSound ? "true" : "false") << ",\n";
-    file << "    \"showNotifications\": " << (m_config.showNotifications ? "true" : "false") << "\n";
-    file << "  },\n";
-    file << "  \"ui\": {\n";
-    file << "    \"autoScroll\": " << (m_config.autoScroll ? "true" : "false") << ",\n";
-    file << "    \"maxEvents\": " << m_config.maxEvents << "\n";
-    file << "  },\n";
-    file << "  \"logging\": {\n";
-    file << "    \"enabled\": " << (m_config.loggingEnabled ? "true" : "false") << ",\n";
-    file << "    \"logFile\": \"" << m_config.logFile << "\",\n";
-    file << "    \"maxLogSize\": " << m_config.maxLogSize << "\n";
-    file << "  },\n";
-    file << "  \"whitelist\": [\n";
-    
-    for (size_t i = 0; i < m_config.whitelist.size(); ++i) {
-        file << "    \"" << m_config.whitelist[i] << "\"";
-        if (i < m_config.whitelist.size() - 1) {
-            file << ",";
+
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config = std::move(parsed);
+    m_lastError.clear();
+    PublishLocked();
+    return true;
+}
+
+bool Config::Save(const std::string& filePath) {
+    std::string path = filePath.empty() ? m_configPath : filePath;
+    std::string text = Serialize(m_config);
+
+    // Replace atomically: a reader (or the hot-reload watcher) never sees half a file
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!file) {
+            return false;
         }
-        file << "\n";
     }
-    
-    file << "  ]\n";
-    file << "}\n";
-    
-    file.close();
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
     return true;
 }
 
 void Config::AddToWhitelist(const std::string& driverName) {
-    if (!IsWhitelisted(driverName)) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (std::find(m_config.whitelist.begin(), m_config.whitelist.end(), driverName) == m_config.whitelist.end()) {
         m_config.whitelist.push_back(driverName);
+        PublishLocked();
     }
 }
 
 void Config::RemoveFromWhitelist(const std::string& driverName) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
     auto it = std::find(m_config.whitelist.begin(), m_config.whitelist.end(), driverName);
     if (it != m_config.whitelist.end()) {
         m_config.whitelist.erase(it);
+        PublishLocked();
     }
 }
 
 bool Config::IsWhitelisted(const std::string& driverName) const {
-    return std::find(m_config.whitelist.begin(), m_config.whitelist.end(), driverName) != m_config.whitelist.end();
+    RcuReadGuard guard;
+    return GetSnapshot().IsWhitelisted(driverName);
 }
 
 } // namespace DriverMonitor
@@ -1,37 +1,112 @@
 #pragma once
 
 #include "Utils.h"
+#include "ChangeNotifier.h"
+#include "Rcu.h"
+#include "MemoryAccounting.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 namespace DriverMonitor {
 
+// Published whitelist: the names in order, and hashed for lookups
+struct ConfigWhitelist {
+    std::vector<std::string> names;
+    std::unordered_set<std::string> lookup;
+    MemoryCharge memory{ MemorySubsystem::Config };
+};
+
+// Immutable published configuration. The detection path processes each
+// event against one snapshot, so it never sees a half-applied change.
+struct ConfigSnapshot {
+    MonitorConfig config;           // Everything but the whitelist (left empty)
+    uint64_t version;               // 1 for the defaults, +1 per publish
+
+    // Shared between snapshots while it is unchanged
+    std::shared_ptr<const ConfigWhitelist> whitelist;
+    
+    MemoryCharge memory{ MemorySubsystem::Config };
+
+    bool IsWhitelisted(const std::string& driverName) const {
+        return whitelist->lookup.count(driverName) != 0;
+    }
+};
+
+// Configuration owner. GetConfig() is the owning (UI) thread's working copy;
+// every change is published as a new ConfigSnapshot that any thread reads
+// lock-free (see Rcu.h):
+//
+//     RcuReadGuard guard;
+//     const ConfigSnapshot& snapshot = config.GetSnapshot();
 class Config {
 public:
     Config();
     ~Config();
     
-    // Load configuration from JSON file
+    // Load configuration from JSON file; on a missing or invalid file the
+    // current configuration is kept and GetLastError() says why
     bool Load(const std::string& filePath = "config.json");
     
-    // Save configuration to JSON file
+    // Save configuration to JSON file (written to a temporary file and renamed)
     bool Save(const std::string& filePath = "config.json");
     
-    // Get configuration
+    // File the configuration was last loaded from
+    const std::string& GetPath() const { return m_configPath; }
+    
+    // Error of the last failed Load ("config.json: line 3, column 18: ...")
+    const std::string& GetLastError() const { return m_lastError; }
+    
+    // Parse and validate a configuration document; settings it omits keep
+    // their defaults. Unknown settings, wrong types and out-of-range values
+    // are errors, reported with line and column.
+    static bool Parse(const char* data, size_t length, MonitorConfig& config, std::string& error);
+    
+    // Serialize a configuration as Parse() reads it
+    static std::string Serialize(const MonitorConfig& config);
+    
+    // Working copy (owning thread only; publish edits with NotifyChanged)
     MonitorConfig& GetConfig() { return m_config; }
     const MonitorConfig& GetConfig() const { return m_config; }
     
+    // Current snapshot: one atomic load; valid while an RcuReadGuard is held
+    const ConfigSnapshot& GetSnapshot() const { return *m_snapshot.load(std::memory_order_seq_cst); }
+    
+    // Replace the whole configuration and publish it (any thread)
+    void Apply(const MonitorConfig& config);
+    
     // Add driver to whitelist
     void AddToWhitelist(const std::string& driverName);
     
     // Remove driver from whitelist
     void RemoveFromWhitelist(const std::string& driverName);
     
-    // Check if driver is whitelisted
+    // Check if driver is whitelisted (published whitelist, hashed)
     bool IsWhitelisted(const std::string& driverName) const;
     
+    // Publish edits made through GetConfig()
+    void NotifyChanged();
+    
+    // Change generation: bumped by every publish
+    uint64_t GetChangeGeneration() const { return m_changes.GetGeneration(); }
+    ChangeNotifier& GetChangeNotifier() { return m_changes; }
+    
 private:
     MonitorConfig m_config;
     std::string m_configPath;
+    std::string m_lastError;
+    ChangeNotifier m_changes;
+    
+    // Serializes writers (publishes and whitelist edits)
+    std::mutex m_writeMutex;
+    std::atomic<const ConfigSnapshot*> m_snapshot;
+    
+    // Build a snapshot of m_config, swap it in and retire the previous one
+    // (m_writeMutex held); then notify change listeners
+    void PublishLocked();
 };
 
 } // namespace DriverMonitor
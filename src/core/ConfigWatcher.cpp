@@ -0,0 +1,105 @@
+#include "ConfigWatcher.h"
+#include "Config.h"
+#include <filesystem>
+
+namespace DriverMonitor {
+
+ConfigWatcher::ConfigWatcher()
+    : m_interval(1000)
+    , m_stamp{ 0, 0, false }
+    , m_stop(false)
+    , m_reloadCount(0)
+    , m_errorCount(0) {
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    Stop();
+}
+
+ConfigWatcher::FileStamp ConfigWatcher::ReadStamp() const {
+    std::error_code error;
+    FileStamp stamp{ 0, 0, false };
+    auto modified = std::filesystem::last_write_time(m_filePath, error);
+    if (error) {
+        return stamp;
+    }
+    uint64_t size = std::filesystem::file_size(m_filePath, error);
+    if (error) {
+        return stamp;
+    }
+    stamp.modified = static_cast<int64_t>(modified.time_since_epoch().count());
+    stamp.size = size;
+    stamp.exists = true;
+    return stamp;
+}
+
+bool ConfigWatcher::Start(const std::string& filePath, std::chrono::milliseconds interval,
+                          ReloadCallback onReload, ErrorCallback onError) {
+    if (m_thread) {
+        return false;
+    }
+    m_filePath = filePath;
+    m_interval = interval;
+    m_onReload = std::move(onReload);
+    m_onError = std::move(onError);
+    m_stamp = ReadStamp();
+    m_stop = false;
+
+    try {
+        m_thread = std::make_unique<std::thread>(&ConfigWatcher::WatchThread, this);
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+void ConfigWatcher::Stop() {
+    if (!m_thread) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_stopMutex);
+        m_stop = true;
+    }
+    m_stopCondition.notify_all();
+    m_thread->join();
+    m_thread.reset();
+}
+
+bool ConfigWatcher::CheckNow() {
+    std::lock_guard<std::mutex> lock(m_checkMutex);
+    FileStamp stamp = ReadStamp();
+    if (stamp == m_stamp) {
+        return false;
+    }
+    m_stamp = stamp;
+    if (!stamp.exists) {
+        // Deleted (or mid-rename): keep the current settings until it returns
+        return false;
+    }
+
+    Config loaded;
+    if (!loaded.Load(m_filePath)) {
+        m_errorCount++;
+        if (m_onError) {
+            m_onError(loaded.GetLastError());
+        }
+        return false;
+    }
+    m_reloadCount++;
+    if (m_onReload) {
+        m_onReload(loaded.GetConfig());
+    }
+    return true;
+}
+
+void ConfigWatcher::WatchThread() {
+    std::unique_lock<std::mutex> lock(m_stopMutex);
+    while (!m_stopCondition.wait_for(lock, m_interval, [this]() { return m_stop; })) {
+        lock.unlock();
+        CheckNow();
+        lock.lock();
+    }
+}
+
+} // namespace DriverMonitor
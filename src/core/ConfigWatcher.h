@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Utils.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace DriverMonitor {
+
+// Reloads a configuration file when it changes on disk.
+// A background thread compares the file's modification time and size once
+// per interval (one stat, no read); a changed file is parsed into a fresh
+// configuration, and only a valid one is handed to the reload callback.
+// An invalid file is reported once per change and the current settings stay.
+class ConfigWatcher {
+public:
+    // Called on the watcher thread; the callback may adjust the configuration
+    using ReloadCallback = std::function<void(MonitorConfig& config)>;
+    using ErrorCallback = std::function<void(const std::string& error)>;
+
+    ConfigWatcher();
+    ~ConfigWatcher();
+
+    // Start watching; the file's current state counts as already loaded
+    bool Start(const std::string& filePath, std::chrono::milliseconds interval,
+               ReloadCallback onReload, ErrorCallback onError);
+    void Stop();
+
+    // Check once on the calling thread (watching or not); true if reloaded
+    bool CheckNow();
+
+    uint64_t GetReloadCount() const { return m_reloadCount; }
+    uint64_t GetErrorCount() const { return m_errorCount; }
+
+private:
+    // What identifies a version of the file without reading it
+    struct FileStamp {
+        int64_t modified;
+        uint64_t size;
+        bool exists;
+
+        bool operator==(const FileStamp& other) const {
+            return modified == other.modified && size == other.size && exists == other.exists;
+        }
+    };
+
+    std::string m_filePath;
+    std::chrono::milliseconds m_interval;
+    ReloadCallback m_onReload;
+    ErrorCallback m_onError;
+    FileStamp m_stamp;
+    std::mutex m_checkMutex;        // Serializes CheckNow() with the thread
+
+    std::unique_ptr<std::thread> m_thread;
+    std::mutex m_stopMutex;
+    std::condition_variable m_stopCondition;
+    bool m_stop;
+
+    std::atomic<uint64_t> m_reloadCount;
+    std::atomic<uint64_t> m_errorCount;
+
+    FileStamp ReadStamp() const;
+    void WatchThread();
+};
+
+} // namespace DriverMonitor
@@ -1,21 +1,135 @@
 #include "DriverMonitor.h"
+#include "ObservationRecorder.h"
+#include "ReplaySource.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Socket.h"
+#include "../monitoring/FileSystemMonitor.h"
+#include <algorithm>
+
+#ifdef _WIN32
 #include "../monitoring/ETWConsumer.h"
 #include "../monitoring/RegistryMonitor.h"
-#include "../monitoring/FileSystemMonitor.h"
 #include "../monitoring/WMIMonitor.h"
 #include <Windows.h>
-#include <fstream>
+#endif
+
+namespace {
+    // Polling intervals: minimum after a detection, maximum after idle back-off
+    const std::chrono::milliseconds kRegistryMinInterval(500);
+    // Registry and file system sources are also woken by change notifications
+    const std::chrono::milliseconds kRegistryMaxInterval(15000);
+    const std::chrono::milliseconds kFileSystemMinInterval(1000);
+    const std::chrono::milliseconds kFileSystemMaxInterval(30000);
+    const std::chrono::milliseconds kWMIMinInterval(2000);
+    const std::chrono::milliseconds kWMIMaxInterval(30000);
+    
+    const int kMaxEventsPerPoll = 256;
+    
+    const size_t kDefaultQueueCapacity = 65536;
+    
+    // A storm that never goes quiet is summarized every this many quiet periods
+    const int64_t kAlertMaxDelayPeriods = 10;
+    
+    uint64_t ElapsedNs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+    
+    const char* const kStageNames[] = {
+        "registryScan", "fileSystemScan", "wmiScan", "queueWait", "enrich", "signerInfo",
+        "classify", "filter", "store", "log", "endToEnd", "alert"
+    };
+    static_assert(sizeof(kStageNames) / sizeof(kStageNames[0]) == static_cast<size_t>(DriverMonitor::PipelineStage::Count),
+                  "every pipeline stage needs a name");
+    
+    // Label values of the events_total metric
+    const DriverMonitor::EventType kEventTypes[] = {
+        DriverMonitor::EventType::Signed, DriverMonitor::EventType::Unsigned, DriverMonitor::EventType::Suspicious
+    };
+    const DriverMonitor::EventSource kEventSources[] = {
+        DriverMonitor::EventSource::Unknown, DriverMonitor::EventSource::Registry, DriverMonitor::EventSource::FileSystem,
+        DriverMonitor::EventSource::WMI, DriverMonitor::EventSource::ETW, DriverMonitor::EventSource::Synthetic
+    };
+    const DriverMonitor::ThreatLevel kThreatLevels[] = {
+        DriverMonitor::ThreatLevel::Low, DriverMonitor::ThreatLevel::Medium, DriverMonitor::ThreatLevel::High
+    };
+    const size_t kSourceCount = sizeof(kEventSources) / sizeof(kEventSources[0]);
+    const size_t kThreatCount = sizeof(kThreatLevels) / sizeof(kThreatLevels[0]);
+    
+    // Known to be Suspicious before enrichment: the loading method alone decides it
+    bool IsPriorityObservation(const DriverMonitor::DriverEvent& event) {
+        return !event.isRemoval &&
+               DriverMonitor::Utils::DetermineEventType(event.signerInfo, event.loadingMethod) == DriverMonitor::EventType::Suspicious;
+    }
+    
+    // Stored events that raise an alert
+    bool IsAlertEvent(const DriverMonitor::DriverEvent& event) {
+        return !event.isRemoval &&
+               (event.eventType == DriverMonitor::EventType::Suspicious || event.threatLevel == DriverMonitor::ThreatLevel::High);
+    }
+    
+    size_t GetEventCounterIndex(const DriverMonitor::DriverEvent& event) {
+        return (static_cast<size_t>(event.eventType) * kSourceCount + static_cast<size_t>(event.source)) * kThreatCount +
+               static_cast<size_t>(event.threatLevel);
+    }
+    
+    DriverMonitor::PipelineStage GetScanStage(DriverMonitor::EventSource source) {
+        switch (source) {
+            case DriverMonitor::EventSource::Registry: return DriverMonitor::PipelineStage::RegistryScan;
+            case DriverMonitor::EventSource::WMI: return DriverMonitor::PipelineStage::WMIScan;
+            default: return DriverMonitor::PipelineStage::FileSystemScan;
+        }
+    }
+    
+    // Trace span of one poll of a source
+    const char* GetPollCycleName(DriverMonitor::EventSource source) {
+        switch (source) {
+            case DriverMonitor::EventSource::Registry: return "registryPoll";
+            case DriverMonitor::EventSource::WMI: return "wmiPoll";
+            default: return "fileSystemPoll";
+        }
+    }
+}
 
 namespace DriverMonitor {
 
+const char* GetPipelineStageName(PipelineStage stage) {
+    size_t index = static_cast<size_t>(stage);
+    return index < static_cast<size_t>(PipelineStage::Count) ? kStageNames[index] : "unknown";
+}
+
 DriverMonitor::DriverMonitor(EventManager* eventManager, Config* config)
     : m_eventManager(eventManager)
     , m_config(config)
-    , m_isMonitoring(false) {
+    , m_isMonitoring(false)
+    , m_recorder(nullptr)
+    , m_replayComplete(false)
+    , m_replayedCount(0)
+    , m_queueCapacity(kDefaultQueueCapacity)
+    , m_queueDepth(0)
+    , m_maxQueueDepth(0)
+    , m_priorityDepth(0)
+    , m_stopPipeline(false)
+    , m_submittedCount(0)
+    , m_droppedCount(0)
+    , m_processedCount(0)
+    , m_filteredCount(0)
+    , m_prioritizedCount(0)
+    , m_logFile(nullptr)
+    , m_latency(static_cast<size_t>(PipelineStage::Count))
+    , m_overBudgetCount(0)
+    , m_cacheBytesReclaimed(0)
+    , m_eventsEvicted(0)
+    , m_forwarding(false)
+    , m_metrics(nullptr)
+    , m_metricsCollector(0) {
 }
 
 DriverMonitor::~DriverMonitor() {
     Stop();
+    if (m_metrics) {
+        m_metrics->RemoveCollector(m_metricsCollector);
+    }
 }
 
 bool DriverMonitor::Start() {
@@ -23,19 +137,71 @@ bool DriverMonitor::Start() {
         return false; // Already monitoring
     }
     
+    if (!StartPipeline()) {
+        return false;
+    }
+    
     m_isMonitoring = true;
     m_startTime = std::chrono::steady_clock::now();
     
-    // Start monitoring threads
-    try {
-        m_registryThread = std::make_unique<std::thread>(&DriverMonitor::RegistryMonitoringThread, this);
-        m_fileSystemThread = std::make_unique<std::thread>(&DriverMonitor::FileSystemMonitoringThread, this);
-        m_wmiThread = std::make_unique<std::thread>(&DriverMonitor::WMIMonitoringThread, this);
-    } catch (...) {
+    std::string driversPath;
+    {
+        RcuReadGuard guard;
+        driversPath = m_config->GetSnapshot().config.driversPath;
+    }
+    m_fileSystemMonitor = std::make_unique<FileSystemMonitor>(driversPath);
+    m_scheduler = std::make_unique<PollScheduler>();
+    
+#ifdef _WIN32
+    m_registryMonitor = std::make_unique<RegistryMonitor>();
+    m_wmiMonitor = std::make_unique<WMIMonitor>();
+    
+    PollSource registrySource;
+    registrySource.name = "Registry";
+    registrySource.poll = [this]() { return PollMonitor(*m_registryMonitor, EventSource::Registry); };
+    registrySource.waitHandle = [this](NativeWaitHandle& handle) { return m_registryMonitor->GetWaitHandle(handle); };
+    registrySource.minInterval = kRegistryMinInterval;
+    registrySource.maxInterval = kRegistryMaxInterval;
+    m_scheduler->AddSource(registrySource);
+#endif
+    
+    PollSource fileSystemSource;
+    fileSystemSource.name = "FileSystem";
+    fileSystemSource.poll = [this]() { return PollMonitor(*m_fileSystemMonitor, EventSource::FileSystem); };
+    fileSystemSource.waitHandle = [this](NativeWaitHandle& handle) { return m_fileSystemMonitor->GetWaitHandle(handle); };
+    fileSystemSource.minInterval = kFileSystemMinInterval;
+    fileSystemSource.maxInterval = kFileSystemMaxInterval;
+    m_scheduler->AddSource(fileSystemSource);
+    
+#ifdef _WIN32
+    PollSource wmiSource;
+    wmiSource.name = "WMI";
+    wmiSource.poll = [this]() { return PollMonitor(*m_wmiMonitor, EventSource::WMI); };
+    wmiSource.minInterval = kWMIMinInterval;
+    wmiSource.maxInterval = kWMIMaxInterval;
+    m_scheduler->AddSource(wmiSource);
+#endif
+    
+    if (!m_scheduler->Start()) {
         m_isMonitoring = false;
+        StopPipeline();
+        return false;
+    }
+    
+    return true;
+}
+
+bool DriverMonitor::StartIngestion() {
+    if (m_isMonitoring) {
         return false;
     }
     
+    if (!StartPipeline()) {
+        return false;
+    }
+    
+    m_isMonitoring = true;
+    m_startTime = std::chrono::steady_clock::now();
     return true;
 }
 
@@ -46,116 +212,667 @@ void DriverMonitor::Stop() {
     
     m_isMonitoring = false;
     
-    // Wait for threads to finish
-    if (m_registryThread && m_registryThread->joinable()) {
-        m_registryThread->join();
-    }
-    if (m_fileSystemThread && m_fileSystemThread->joinable()) {
-        m_fileSystemThread->join();
+    // Interrupts the scheduler wait; returns once the current poll finishes
+    if (m_scheduler) {
+        m_scheduler->Stop();
+        m_scheduler.reset();
     }
-    if (m_wmiThread && m_wmiThread->joinable()) {
-        m_wmiThread->join();
+    
+    if (m_replayThread) {
+        m_replayClock->Interrupt();
+        if (m_replayThread->joinable()) {
+            m_replayThread->join();
+        }
+        m_replayThread.reset();
     }
+    
+    // Producers are gone; process what they queued
+    StopPipeline();
 }
 
-int DriverMonitor::GetUptimeSeconds() const {
-    if (!m_isMonitoring) {
-        return 0;
+void DriverMonitor::SetQueueCapacity(size_t capacity) {
+    if (m_isMonitoring || capacity == 0) {
+        return;
     }
     
-    auto now = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - m_startTime);
-    return static_cast<int>(duration.count());
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_queueCapacity = capacity;
+}
+
+void DriverMonitor::SetEventCallback(EventCallback callback) {
+    if (m_isMonitoring) {
+        return;
+    }
+    m_eventCallback = std::move(callback);
 }
 
-void DriverMonitor::RegistryMonitoringThread() {
-    RegistryMonitor monitor;
+void DriverMonitor::SetAlertCallback(AlertCallback callback) {
+    if (m_isMonitoring) {
+        return;
+    }
+    m_alertCallback = std::move(callback);
+}
+
+void DriverMonitor::ApplyConfig(const MonitorConfig& config) {
+    m_config->Apply(config);
+    m_eventManager->SetMaxEvents(config.maxEvents);
+}
+
+bool DriverMonitor::SubmitObservation(DriverEvent&& event, bool wait) {
+    auto submitted = std::chrono::steady_clock::now();
     
-    while (m_isMonitoring) {
-        DriverEvent event = monitor.CheckForNewDrivers();
+    // Bulk ingestion never delays a detection: it has a queue of its own
+    bool priority = IsPriorityObservation(event);
+    std::vector<QueuedObservation>& queue = priority ? m_priorityQueue : m_queue;
+    
+    {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        if (queue.size() >= m_queueCapacity) {
+            if (wait) {
+                // Stop() releases waiting producers; their observation is dropped
+                m_queueNotFull.wait(lock, [this, &queue]() {
+                    return queue.size() < m_queueCapacity || m_stopPipeline || !m_isMonitoring;
+                });
+            }
+            if (queue.size() >= m_queueCapacity || m_stopPipeline) {
+                m_droppedCount++;
+                return false;
+            }
+        }
         
-        if (!event.driverName.empty()) {
-            ProcessDriverEvent(event);
+        bool wasEmpty = queue.empty();
+        queue.push_back({ std::move(event), submitted });
+        m_submittedCount++;
+        if (priority) {
+            m_priorityDepth.store(queue.size(), std::memory_order_relaxed);
+            m_prioritizedCount++;
+        } else {
+            m_queueDepth.store(queue.size(), std::memory_order_relaxed);
+            if (queue.size() > m_maxQueueDepth.load(std::memory_order_relaxed)) {
+                m_maxQueueDepth.store(queue.size(), std::memory_order_relaxed);
+            }
         }
         
-        // Sleep to avoid excessive CPU usage
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (!wasEmpty) {
+            // Consumer is already awake or will find this in its next batch
+            return true;
+        }
     }
+    
+    m_queueNotEmpty.notify_one();
+    return true;
 }
 
-void DriverMonitor::FileSystemMonitoringThread() {
-    FileSystemMonitor monitor;
+bool DriverMonitor::StartPipeline() {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_queue.clear();
+        m_priorityQueue.clear();
+        m_queueDepth = 0;
+        m_maxQueueDepth = 0;
+        m_priorityDepth = 0;
+        m_stopPipeline = false;
+    }
     
-    while (m_isMonitoring) {
-        DriverEvent event = monitor.CheckForNewDrivers();
+    m_submittedCount = 0;
+    m_droppedCount = 0;
+    m_processedCount = 0;
+    m_filteredCount = 0;
+    m_prioritizedCount = 0;
+    m_latency.Reset();
+    StartForwarding();
+    StartAlerts();
+    
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    try {
+        m_pipelineThread = std::make_unique<std::thread>(&DriverMonitor::PipelineThread, this);
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+void DriverMonitor::StopPipeline() {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopPipeline = true;
+    }
+    m_queueNotEmpty.notify_all();
+    m_queueNotFull.notify_all();
+    
+    if (m_pipelineThread && m_pipelineThread->joinable()) {
+        m_pipelineThread->join();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_pipelineThread.reset();
+    }
+    
+    // Every stored event has been submitted; send or spool the rest
+    m_forwarder.Stop();
+    m_forwarding = false;
+    m_alerts.Stop();
+    CloseLog();
+}
+
+void DriverMonitor::StartForwarding() {
+    ForwarderOptions options;
+    {
+        RcuReadGuard guard;
+        const MonitorConfig& config = m_config->GetSnapshot().config;
+        if (config.forwardEndpoint.empty()) {
+            return;
+        }
+        Socket::ParseEndpoint(config.forwardEndpoint, options.host, options.port);
+        options.spoolPath = config.forwardSpoolPath;
+        options.batchEvents = static_cast<size_t>(config.forwardBatchEvents);
+        options.flushInterval = std::chrono::milliseconds(config.forwardFlushIntervalMs);
+        options.bufferBytes = static_cast<size_t>(config.forwardBufferMB) << 20;
+        options.spoolBytes = static_cast<uint64_t>(config.forwardSpoolMB) << 20;
+    }
+    m_forwarding = m_forwarder.Start(options);
+}
+
+void DriverMonitor::StartAlerts() {
+    AlertThrottleOptions throttle;
+    {
+        RcuReadGuard guard;
+        const MonitorConfig& config = m_config->GetSnapshot().config;
+        throttle.driverPerMinute = config.alertsPerMinute;
+        throttle.driverBurst = config.alertBurst;
+        throttle.globalPerMinute = config.globalAlertsPerMinute;
+        throttle.globalBurst = config.globalAlertBurst;
+        throttle.quietMicros = static_cast<int64_t>(config.alertQuietSeconds) * 1000000;
+        throttle.maxDelayMicros = throttle.quietMicros * kAlertMaxDelayPeriods;
+    }
+    m_alerts.Start([this](const Alert& alert) { DeliverAlert(alert); }, throttle);
+}
+
+void DriverMonitor::PipelineThread() {
+    std::vector<QueuedObservation> batch;
+    Tracer::SetThreadName("pipeline");
+    
+    std::vector<QueuedObservation> priorityBatch;
+    
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueNotEmpty.wait(lock, [this]() {
+                return !m_queue.empty() || !m_priorityQueue.empty() || m_stopPipeline;
+            });
+            if (m_queue.empty() && m_priorityQueue.empty()) {
+                break; // Stopping and fully drained
+            }
+            // Take the whole queue; producers refill the (recycled) batch storage
+            batch.swap(m_queue);
+            m_queueDepth.store(0, std::memory_order_relaxed);
+        }
         
-        if (!event.driverName.empty()) {
-            ProcessDriverEvent(event);
+        m_queueNotFull.notify_all();
+        
+        // Detections submitted meanwhile go ahead of the next bulk observation,
+        // so a flood delays them by at most one observation
+        DrainPriorityQueue(priorityBatch);
+        for (auto& item : batch) {
+            if (m_priorityDepth.load(std::memory_order_relaxed) != 0) {
+                DrainPriorityQueue(priorityBatch);
+            }
+            ProcessQueued(item);
+        }
+        batch.clear();
+        FlushLog(false);
+    }
+}
+
+void DriverMonitor::ProcessQueued(QueuedObservation& item) {
+    auto dequeued = std::chrono::steady_clock::now();
+    DM_TRACE_SPAN("process", "pipeline", dequeued);
+    RecordLatency(PipelineStage::QueueWait, item.submitted, dequeued);
+    ProcessDriverEvent(item.event, item.submitted, dequeued);
+}
+
+void DriverMonitor::DrainPriorityQueue(std::vector<QueuedObservation>& batch) {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (m_priorityQueue.empty()) {
+            return;
         }
+        batch.swap(m_priorityQueue);
+        m_priorityDepth.store(0, std::memory_order_relaxed);
+    }
+    m_queueNotFull.notify_all();
+    
+    for (auto& item : batch) {
+        ProcessQueued(item);
+    }
+    batch.clear();
+}
+
+void DriverMonitor::DeliverAlert(const Alert& alert) {
+#ifdef _WIN32
+    bool playSound;
+    {
+        RcuReadGuard guard;
+        playSound = m_config->GetSnapshot().config.playSound;
+    }
+    if (playSound) {
+        MessageBeep(MB_ICONWARNING);
+    }
+#endif
+    if (m_alertCallback) {
+        m_alertCallback(alert);
+    }
+    if (!alert.IsSummary()) {
+        RecordLatency(PipelineStage::Alert, alert.detected, std::chrono::steady_clock::now());
+    }
+}
+
+PipelineStats DriverMonitor::GetPipelineStats() const {
+    PipelineStats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        stats.queueCapacity = m_queueCapacity;
+    }
+    stats.queueDepth = m_queueDepth.load(std::memory_order_relaxed);
+    stats.priorityQueueDepth = m_priorityDepth.load(std::memory_order_relaxed);
+    stats.maxQueueDepth = m_maxQueueDepth.load(std::memory_order_relaxed);
+    
+    stats.submitted = m_submittedCount;
+    stats.dropped = m_droppedCount;
+    stats.processed = m_processedCount;
+    stats.filtered = m_filteredCount;
+    stats.prioritized = m_prioritizedCount;
+    AlertStats alerts = m_alerts.GetStats();
+    stats.alerts = alerts.delivered;
+    stats.alertsDropped = alerts.dropped;
+    stats.alertsSuppressed = alerts.suppressed;
+    stats.alertSummaries = alerts.summaries;
+    stats.queueWait = GetStageTiming(PipelineStage::QueueWait);
+    stats.enrich = GetStageTiming(PipelineStage::Enrich);
+    stats.filter = GetStageTiming(PipelineStage::Filter);
+    stats.store = GetStageTiming(PipelineStage::Store);
+    stats.log = GetStageTiming(PipelineStage::Log);
+    stats.endToEnd = GetStageTiming(PipelineStage::EndToEnd);
+    stats.alert = GetStageTiming(PipelineStage::Alert);
+    return stats;
+}
+
+MemoryStats DriverMonitor::GetMemoryStats() const {
+    MemoryStats stats;
+    for (size_t i = 0; i < static_cast<size_t>(MemorySubsystem::Count); ++i) {
+        stats.bytes[i] = MemoryAccounting::GetBytes(static_cast<MemorySubsystem>(i));
+        stats.totalBytes += stats.bytes[i];
+    }
+    {
+        RcuReadGuard guard;
+        stats.budgetBytes = static_cast<uint64_t>(m_config->GetSnapshot().config.memoryBudgetMB) << 20;
+    }
+    stats.overBudget = m_overBudgetCount.load(std::memory_order_relaxed);
+    stats.cacheBytesReclaimed = m_cacheBytesReclaimed.load(std::memory_order_relaxed);
+    stats.eventsEvicted = m_eventsEvicted.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void DriverMonitor::EnforceMemoryBudget(uint64_t budgetBytes) {
+    uint64_t total = MemoryAccounting::GetTotalBytes();
+    if (total <= budgetBytes) {
+        return;
+    }
+    m_overBudgetCount.fetch_add(1, std::memory_order_relaxed);
+    
+    // Caches can be rebuilt; history cannot, so it goes last
+    uint64_t excess = total - budgetBytes;
+    size_t reclaimed = m_signerCache.Trim(static_cast<size_t>(excess));
+    if (reclaimed < excess) {
+        reclaimed += m_processCache.Trim(static_cast<size_t>(excess - reclaimed));
+    }
+    m_cacheBytesReclaimed.fetch_add(reclaimed, std::memory_order_relaxed);
+    if (reclaimed >= excess) {
+        return;
+    }
+    size_t evicted = m_eventManager->EvictOldestBytes(static_cast<size_t>(excess - reclaimed));
+    m_eventsEvicted.fetch_add(evicted, std::memory_order_relaxed);
+}
+
+StageTiming DriverMonitor::GetStageTiming(PipelineStage stage) const {
+    LatencyHistogram histogram = GetStageHistogram(stage);
+    StageTiming timing;
+    timing.count = histogram.GetCount();
+    timing.totalNs = histogram.GetTotal();
+    timing.maxNs = histogram.GetMax();
+    timing.p50Ns = histogram.GetPercentile(0.5);
+    timing.p99Ns = histogram.GetPercentile(0.99);
+    timing.p999Ns = histogram.GetPercentile(0.999);
+    return timing;
+}
+
+LatencyHistogram DriverMonitor::GetStageHistogram(PipelineStage stage) const {
+    return m_latency.GetHistogram(static_cast<size_t>(stage));
+}
+
+void DriverMonitor::RegisterMetrics(MetricsRegistry& registry) {
+    if (m_isMonitoring || m_metrics) {
+        return;
+    }
+    m_metrics = &registry;
+    
+    // Stored events, one series per type, source and threat level
+    for (EventType type : kEventTypes) {
+        for (EventSource source : kEventSources) {
+            for (ThreatLevel threat : kThreatLevels) {
+                std::string labels = MetricsWriter::Label("type", Utils::GetEventTypeName(type)) + "," +
+                                     MetricsWriter::Label("source", Utils::GetSourceName(source)) + "," +
+                                     MetricsWriter::Label("threat", Utils::GetThreatLevelName(threat));
+                m_eventCounters.push_back(&registry.AddCounter("drivermonitor_events_total",
+                                                               "Events stored, by type, source and threat level.", labels));
+            }
+        }
+    }
+    
+    // Everything else is read at scrape time from atomics the pipeline already keeps
+    m_metricsCollector = registry.AddCollector([this](MetricsWriter& writer) {
+        writer.BeginFamily("drivermonitor_monitoring", "1 while monitoring or ingesting.", MetricType::Gauge);
+        writer.Sample("drivermonitor_monitoring", std::string(), static_cast<uint64_t>(m_isMonitoring ? 1 : 0));
+        
+        struct CounterMetric {
+            const char* name;
+            const char* help;
+            const std::atomic<uint64_t>& value;
+        };
+        const CounterMetric counters[] = {
+            { "drivermonitor_observations_submitted_total", "Observations accepted into the ingestion queue.", m_submittedCount },
+            { "drivermonitor_observations_dropped_total", "Observations dropped because the ingestion queue was full.", m_droppedCount },
+            { "drivermonitor_observations_processed_total", "Observations fully processed.", m_processedCount },
+            { "drivermonitor_observations_filtered_total", "Observations processed but filtered out.", m_filteredCount },
+            { "drivermonitor_observations_prioritized_total", "Observations submitted through the priority lane.", m_prioritizedCount }
+        };
+        for (const auto& counter : counters) {
+            writer.BeginFamily(counter.name, counter.help, MetricType::Counter);
+            writer.Sample(counter.name, std::string(), counter.value.load(std::memory_order_relaxed));
+        }
+        
+        AlertStats alerts = m_alerts.GetStats();
+        writer.BeginFamily("drivermonitor_alerts_total", "Alerts raised for Suspicious or High events, by outcome.", MetricType::Counter);
+        writer.Sample("drivermonitor_alerts_total", MetricsWriter::Label("state", "delivered"), alerts.delivered);
+        writer.Sample("drivermonitor_alerts_total", MetricsWriter::Label("state", "dropped"), alerts.dropped);
+        writer.Sample("drivermonitor_alerts_total", MetricsWriter::Label("state", "suppressed"), alerts.suppressed);
+        writer.BeginFamily("drivermonitor_alert_summaries_total", "Summaries raised for rate-limited alerts.", MetricType::Counter);
+        writer.Sample("drivermonitor_alert_summaries_total", std::string(), alerts.summaries);
+        writer.BeginFamily("drivermonitor_alerts_pending", "Rate-limited alerts not yet summarized.", MetricType::Gauge);
+        writer.Sample("drivermonitor_alerts_pending", std::string(), alerts.pending);
         
-        // Sleep to avoid excessive CPU usage
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        writer.BeginFamily("drivermonitor_queue_depth", "Observations waiting in the ingestion queue.", MetricType::Gauge);
+        writer.Sample("drivermonitor_queue_depth", std::string(), static_cast<uint64_t>(m_queueDepth.load(std::memory_order_relaxed)));
+        writer.BeginFamily("drivermonitor_priority_queue_depth", "Observations waiting in the priority lane.", MetricType::Gauge);
+        writer.Sample("drivermonitor_priority_queue_depth", std::string(), static_cast<uint64_t>(m_priorityDepth.load(std::memory_order_relaxed)));
+        writer.BeginFamily("drivermonitor_queue_max_depth", "Deepest the ingestion queue has been since the start.", MetricType::Gauge);
+        writer.Sample("drivermonitor_queue_max_depth", std::string(), static_cast<uint64_t>(m_maxQueueDepth.load(std::memory_order_relaxed)));
+        
+        writer.BeginFamily("drivermonitor_stage_duration_seconds",
+                           "Time spent per pipeline stage; source scans are registryScan, fileSystemScan and wmiScan.",
+                           MetricType::Histogram);
+        for (size_t i = 0; i < static_cast<size_t>(PipelineStage::Count); ++i) {
+            PipelineStage stage = static_cast<PipelineStage>(i);
+            writer.Histogram("drivermonitor_stage_duration_seconds", MetricsWriter::Label("stage", GetPipelineStageName(stage)),
+                             GetStageHistogram(stage));
+        }
+        
+        writer.BeginFamily("drivermonitor_memory_bytes", "Accounted memory per subsystem (a floor: allocator overhead is excluded).",
+                           MetricType::Gauge);
+        for (size_t i = 0; i < static_cast<size_t>(MemorySubsystem::Count); ++i) {
+            MemorySubsystem subsystem = static_cast<MemorySubsystem>(i);
+            writer.Sample("drivermonitor_memory_bytes", MetricsWriter::Label("subsystem", GetMemorySubsystemName(subsystem)),
+                          MemoryAccounting::GetBytes(subsystem));
+        }
+        writer.BeginFamily("drivermonitor_memory_budget_bytes", "Configured memory budget; 0 when unlimited.", MetricType::Gauge);
+        {
+            RcuReadGuard guard;
+            writer.Sample("drivermonitor_memory_budget_bytes", std::string(),
+                          static_cast<uint64_t>(m_config->GetSnapshot().config.memoryBudgetMB) << 20);
+        }
+        writer.BeginFamily("drivermonitor_memory_cache_reclaimed_bytes_total", "Signer and process cache bytes trimmed to meet the memory budget.",
+                           MetricType::Counter);
+        writer.Sample("drivermonitor_memory_cache_reclaimed_bytes_total", std::string(), m_cacheBytesReclaimed.load(std::memory_order_relaxed));
+        writer.BeginFamily("drivermonitor_memory_evicted_events_total", "Oldest events evicted to meet the memory budget.",
+                           MetricType::Counter);
+        writer.Sample("drivermonitor_memory_evicted_events_total", std::string(), m_eventsEvicted.load(std::memory_order_relaxed));
+        
+        ForwarderStats forward = m_forwarder.GetStats();
+        writer.BeginFamily("drivermonitor_forward_events_total", "Events given to the collector forwarder, by outcome.", MetricType::Counter);
+        writer.Sample("drivermonitor_forward_events_total", MetricsWriter::Label("state", "submitted"), forward.eventsSubmitted);
+        writer.Sample("drivermonitor_forward_events_total", MetricsWriter::Label("state", "acked"), forward.eventsAcked);
+        writer.Sample("drivermonitor_forward_events_total", MetricsWriter::Label("state", "dropped"), forward.eventsDropped);
+        writer.BeginFamily("drivermonitor_forward_sent_bytes_total", "Batch frames sent to the collector, resends included.", MetricType::Counter);
+        writer.Sample("drivermonitor_forward_sent_bytes_total", std::string(), forward.bytesSent);
+        writer.BeginFamily("drivermonitor_forward_connect_failures_total", "Failed connection attempts to the collector.", MetricType::Counter);
+        writer.Sample("drivermonitor_forward_connect_failures_total", std::string(), forward.connectFailures);
+        writer.BeginFamily("drivermonitor_forward_connected", "1 while connected to the collector.", MetricType::Gauge);
+        writer.Sample("drivermonitor_forward_connected", std::string(), static_cast<uint64_t>(forward.connected ? 1 : 0));
+        writer.BeginFamily("drivermonitor_forward_spooled_bytes", "Unacknowledged batches in the spool directory.", MetricType::Gauge);
+        writer.Sample("drivermonitor_forward_spooled_bytes", std::string(), forward.spooledBytes);
+        
+        writer.BeginFamily("drivermonitor_signer_cache_hits_total", "Signer verdicts served from the cache.", MetricType::Counter);
+        writer.Sample("drivermonitor_signer_cache_hits_total", std::string(), m_signerCache.GetHits());
+        writer.BeginFamily("drivermonitor_signer_cache_misses_total", "Signer verdicts that needed a verification.", MetricType::Counter);
+        writer.Sample("drivermonitor_signer_cache_misses_total", std::string(), m_signerCache.GetMisses());
+        writer.BeginFamily("drivermonitor_signer_cache_entries", "Files in the signer verdict cache.", MetricType::Gauge);
+        writer.Sample("drivermonitor_signer_cache_entries", std::string(), static_cast<uint64_t>(m_signerCache.GetSize()));
+        
+        writer.BeginFamily("drivermonitor_process_cache_hits_total", "Initiator images served from the cache.", MetricType::Counter);
+        writer.Sample("drivermonitor_process_cache_hits_total", std::string(), m_processCache.GetHits());
+        writer.BeginFamily("drivermonitor_process_cache_misses_total", "Initiator lookups that queried the process.", MetricType::Counter);
+        writer.Sample("drivermonitor_process_cache_misses_total", std::string(), m_processCache.GetMisses());
+        writer.BeginFamily("drivermonitor_process_cache_reused_total", "Cached PIDs found reused by a new process.", MetricType::Counter);
+        writer.Sample("drivermonitor_process_cache_reused_total", std::string(), m_processCache.GetReused());
+        writer.BeginFamily("drivermonitor_process_cache_entries", "Processes in the initiator image cache.", MetricType::Gauge);
+        writer.Sample("drivermonitor_process_cache_entries", std::string(), static_cast<uint64_t>(m_processCache.GetSize()));
+    });
+}
+
+void DriverMonitor::RecordLatency(PipelineStage stage, std::chrono::steady_clock::time_point start,
+                                  std::chrono::steady_clock::time_point end) {
+    m_latency.Record(static_cast<size_t>(stage), ElapsedNs(start, end));
+    
+    // Queue wait and end-to-end start on the producer, overlapping earlier events' spans
+    if (stage != PipelineStage::QueueWait && stage != PipelineStage::EndToEnd) {
+        DM_TRACE_RECORD(GetPipelineStageName(stage), stage <= PipelineStage::WMIScan ? "source" : "pipeline", start, end);
     }
 }
 
-void DriverMonitor::WMIMonitoringThread() {
-    WMIMonitor monitor;
+bool DriverMonitor::StartReplay(std::unique_ptr<ReplaySource> source, std::unique_ptr<Clock> clock) {
+    if (m_isMonitoring || !source || !clock) {
+        return false;
+    }
     
-    while (m_isMonitoring) {
-        DriverEvent event = monitor.CheckForNewDrivers();
+    if (!StartPipeline()) {
+        return false;
+    }
+    
+    m_isMonitoring = true;
+    m_startTime = std::chrono::steady_clock::now();
+    m_replaySource = std::move(source);
+    m_replayClock = std::move(clock);
+    m_replayComplete = false;
+    m_replayedCount = 0;
+    
+    try {
+        m_replayThread = std::make_unique<std::thread>(&DriverMonitor::ReplayThread, this);
+    } catch (...) {
+        m_isMonitoring = false;
+        StopPipeline();
+        return false;
+    }
+    
+    return true;
+}
+
+void DriverMonitor::ReplayThread() {
+    ReplayRecord record;
+    Tracer::SetThreadName("replay");
+    
+    while (m_isMonitoring && m_replaySource->Next(record)) {
+        if (!m_replayClock->SleepUntil(record.timeMicros)) {
+            break;
+        }
         
-        if (!event.driverName.empty()) {
-            ProcessDriverEvent(event);
+        // Recorded signer verdicts are kept; Authenticode may not exist here
+        if (!SubmitObservation(std::move(record.event), true)) {
+            break;
+        }
+        m_replayedCount++;
+    }
+    
+    m_replayComplete = true;
+}
+
+int DriverMonitor::GetUptimeSeconds() const {
+    if (!m_isMonitoring) {
+        return 0;
+    }
+    
+    auto now = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - m_startTime);
+    return static_cast<int>(duration.count());
+}
+
+template <typename Monitor>
+bool DriverMonitor::PollMonitor(Monitor& monitor, EventSource source) {
+    bool detected = false;
+    
+    // Drain bursts in one poll, bounded so Stop() stays responsive
+    PipelineStage scanStage = GetScanStage(source);
+    auto cycleStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < kMaxEventsPerPoll && m_isMonitoring; ++i) {
+        auto scanStart = i == 0 ? cycleStart : std::chrono::steady_clock::now();
+        DriverEvent event = monitor.CheckForNewDrivers();
+        RecordLatency(scanStage, scanStart, std::chrono::steady_clock::now());
+        if (event.driverName.empty()) {
+            break;
         }
         
-        // Sleep to avoid excessive CPU usage
-        std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+        event.source = source;
+        event.timestampUs = m_systemClock.NowMicros();
+        
+        SubmitObservation(std::move(event), true);
+        detected = true;
     }
+    
+    // A slow cycle dumps the trace (when enabled), showing which scan or enqueue took the time
+    DM_TRACE_CYCLE(GetPollCycleName(source), cycleStart, std::chrono::steady_clock::now());
+    return detected;
 }
 
-void DriverMonitor::ProcessDriverEvent(DriverEvent& event) {
+void DriverMonitor::ProcessDriverEvent(DriverEvent& event, std::chrono::steady_clock::time_point submitted,
+                                       std::chrono::steady_clock::time_point dequeued) {
+    // Each stage ends where the next starts: one clock read per stage
+    auto stageStart = dequeued;
+    
     // Set timestamp
-    event.timestamp = Utils::GetTimestamp();
+    if (event.timestampUs == 0) {
+        event.timestampUs = m_systemClock.NowMicros();
+    }
+    event.timestamp = Utils::FormatTimestamp(event.timestampUs);
     
-    // Get signer info if path is available
-    if (!event.installPath.empty()) {
-        event.signerInfo = Utils::GetSignerInfo(event.installPath);
+    // Get signer info if path is available (removed files cannot be verified).
+    // Replayed and synthetic observations arrive with their verdict preset.
+    if (event.signerInfo.empty() && !event.installPath.empty() && !event.isRemoval) {
+        auto signerStart = std::chrono::steady_clock::now();
+        event.signerInfo = m_signerCache.GetSignerInfo(event.installPath);
+        RecordLatency(PipelineStage::SignerInfo, signerStart, std::chrono::steady_clock::now());
     }
     
+    // Sources that know the initiating PID but not its image leave initiatedBy
+    // empty; resolved before recording, since the process will be gone on replay
+    if (event.initiatedBy.empty()) {
+        if (event.processId == 0 || !m_processCache.Attribute(event)) {
+            event.initiatedBy = "Unknown";
+        }
+    }
+    
+    if (ObservationRecorder* recorder = m_recorder) {
+        recorder->RecordObservation(event, event.timestampUs);
+    }
+    
+    auto classifyStart = std::chrono::steady_clock::now();
+    
     // Determine event type
     event.eventType = Utils::DetermineEventType(event.signerInfo, event.loadingMethod);
     
     // Assess threat level
     event.threatLevel = Utils::AssessThreatLevel(event);
     
+    auto stageEnd = std::chrono::steady_clock::now();
+    RecordLatency(PipelineStage::Classify, classifyStart, stageEnd);
+    RecordLatency(PipelineStage::Enrich, stageStart, stageEnd);
+    stageStart = stageEnd;
+    
+    // The rest of this event sees one configuration, however it is edited meanwhile
+    RcuReadGuard configGuard;
+    const ConfigSnapshot& snapshot = m_config->GetSnapshot();
+    const MonitorConfig& config = snapshot.config;
+    
     // Check if should be filtered
-    if (ShouldFilter(event)) {
-        if (m_config->GetConfig().verboseMode) {
+    bool filtered = ShouldFilter(event, snapshot);
+    stageEnd = std::chrono::steady_clock::now();
+    RecordLatency(PipelineStage::Filter, stageStart, stageEnd);
+    
+    if (filtered) {
+        if (config.verboseMode) {
             // Log filtered events in verbose mode
-            LogEvent(event);
+            LogEvent(event, config);
         }
+        m_filteredCount++;
+        m_processedCount++;
         return;
     }
     
     // Add to event manager
-    m_eventManager->AddEvent(event);
+    stageStart = stageEnd;
+    event.sequenceId = m_eventManager->AddEvent(event);
+    stageEnd = std::chrono::steady_clock::now();
+    RecordLatency(PipelineStage::Store, stageStart, stageEnd);
+    RecordLatency(PipelineStage::EndToEnd, submitted, stageEnd);
+    if (!m_eventCounters.empty()) {
+        m_eventCounters[GetEventCounterIndex(event)]->Increment();
+    }
+    if (m_forwarding) {
+        m_forwarder.Submit(event);
+    }
     
-    // Log to file
-    if (m_config->GetConfig().loggingEnabled) {
-        LogEvent(event);
+    // Storing is the only step that grows memory for good, so the budget is checked here
+    if (config.memoryBudgetMB > 0) {
+        EnforceMemoryBudget(static_cast<uint64_t>(config.memoryBudgetMB) << 20);
     }
     
-    // Play sound alert for critical events
-    if (m_config->GetConfig().playSound && event.eventType == EventType::Suspicious) {
-        MessageBeep(MB_ICONWARNING);
+    // Log to file; a detection is on disk before its alert is raised
+    bool alert = IsAlertEvent(event);
+    if (config.loggingEnabled) {
+        stageStart = stageEnd;
+        LogEvent(event, config);
+        if (alert) {
+            FlushLog(true);
+        }
+        RecordLatency(PipelineStage::Log, stageStart, std::chrono::steady_clock::now());
     }
+    
+    if (m_eventCallback) {
+        m_eventCallback(event);
+    }
+    
+    // Sound and notification on the alert thread
+    if (alert) {
+        m_alerts.Submit(event, submitted);
+    }
+    
+    m_processedCount++;
 }
 
-bool DriverMonitor::ShouldFilter(const DriverEvent& event) const {
-    const auto& config = m_config->GetConfig();
+bool DriverMonitor::ShouldFilter(const DriverEvent& event, const ConfigSnapshot& snapshot) const {
+    const auto& config = snapshot.config;
     
     // Check whitelist
-    if (m_config->IsWhitelisted(event.driverName)) {
+    if (snapshot.IsWhitelisted(event.driverName)) {
         return true;
     }
     
@@ -172,31 +889,42 @@ bool DriverMonitor::ShouldFilter(const DriverEvent& event) const {
     return false;
 }
 
-void DriverMonitor::LogEvent(const DriverEvent& event) {
-    const auto& config = m_config->GetConfig();
-    
+void DriverMonitor::LogEvent(const DriverEvent& event, const MonitorConfig& config) {
     if (!config.loggingEnabled) {
         return;
     }
     
-    std::ofstream logFile(config.logFile, std::ios::app);
-    if (!logFile.is_open()) {
-        return;
+    // Kept open between events; reopened when the configured path changes
+    if (!m_logFile || m_logPath != config.logFile) {
+        CloseLog();
+        m_logFile = std::fopen(config.logFile.c_str(), "a");
+        if (!m_logFile) {
+            return;
+        }
+        m_logPath = config.logFile;
     }
     
-    std::string eventTypeStr;
-    switch (event.eventType) {
-        case EventType::Signed: eventTypeStr = "SIGNED"; break;
-        case EventType::Unsigned: eventTypeStr = "UNSIGNED"; break;
-        case EventType::Suspicious: eventTypeStr = "SUSPICIOUS"; break;
+    std::string line = Utils::FormatLogLine(event);
+    std::fwrite(line.data(), 1, line.size(), m_logFile);
+}
+
+void DriverMonitor::FlushLog(bool durable) {
+    if (!m_logFile) {
+        return;
     }
-    
-    logFile << event.timestamp << " [" << eventTypeStr << "] "
-            << event.driverName << " - "
-            << event.loadingMethod << " - "
-            << event.signerInfo << "\n";
-    
-    logFile.close();
+    if (durable) {
+        Utils::SyncFile(m_logFile);
+    } else {
+        std::fflush(m_logFile);
+    }
+}
+
+void DriverMonitor::CloseLog() {
+    if (m_logFile) {
+        std::fclose(m_logFile);
+        m_logFile = nullptr;
+    }
+    m_logPath.clear();
 }
 
 } // namespace DriverMonitor
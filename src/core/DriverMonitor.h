@@ -2,10 +2,23 @@
 
 #include "EventManager.h"
 #include "Config.h"
+#include "PollScheduler.h"
+#include "Clock.h"
+#include "LatencyHistogram.h"
+#include "AlertDispatcher.h"
+#include "ProcessInfo.h"
+#include "SignerCache.h"
+#include "MemoryAccounting.h"
+#include "EventForwarder.h"
 #include <memory>
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <vector>
 
 namespace DriverMonitor {
 
@@ -14,6 +27,91 @@ class ETWConsumer;
 class RegistryMonitor;
 class FileSystemMonitor;
 class WMIMonitor;
+class ObservationRecorder;
+class ReplaySource;
+class MetricsRegistry;
+class MetricCounter;
+
+// Pipeline stages with a latency histogram
+enum class PipelineStage : uint8_t {
+    RegistryScan,       // One CheckForNewDrivers call of a source
+    FileSystemScan,
+    WMIScan,
+    QueueWait,          // Submission to dequeue
+    Enrich,             // Timestamp, signer resolution, classification
+    SignerInfo,         // Utils::GetSignerInfo (observations without a verdict)
+    Classify,           // Event type and threat level
+    Filter,             // ShouldFilter
+    Store,              // EventManager::AddEvent
+    Log,                // LogEvent
+    EndToEnd,           // Submission to stored
+    Alert,              // Submission to alert delivered (Suspicious / High events)
+    Count
+};
+
+// Short stage name ("registryScan", "queueWait", ...)
+const char* GetPipelineStageName(PipelineStage stage);
+
+// Timing of one pipeline stage: totals and percentiles (within ~3%)
+struct StageTiming {
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    uint64_t p50Ns;
+    uint64_t p99Ns;
+    uint64_t p999Ns;
+    
+    StageTiming() : count(0), totalNs(0), maxNs(0), p50Ns(0), p99Ns(0), p999Ns(0) {}
+};
+
+// Ingestion pipeline counters
+struct PipelineStats {
+    uint64_t submitted;         // Observations accepted into the queue
+    uint64_t dropped;           // Rejected because the queue was full
+    uint64_t processed;         // Observations fully processed
+    uint64_t filtered;          // Processed but filtered out
+    uint64_t prioritized;       // Submitted through the priority lane
+    uint64_t alerts;            // Alerts delivered, summaries included
+    uint64_t alertsDropped;     // Alert queue full
+    uint64_t alertsSuppressed;  // Rate limited, counted into summaries
+    uint64_t alertSummaries;    // Summaries delivered
+    size_t queueDepth;
+    size_t priorityQueueDepth;  // Waiting in the priority lane
+    size_t maxQueueDepth;
+    size_t queueCapacity;
+    
+    StageTiming queueWait;      // Submission to dequeue
+    StageTiming enrich;         // Signer resolution, classification
+    StageTiming filter;         // ShouldFilter
+    StageTiming store;          // EventManager::AddEvent
+    StageTiming log;            // LogEvent
+    StageTiming endToEnd;       // Submission to stored
+    StageTiming alert;          // Submission to alert delivered
+    
+    PipelineStats() : submitted(0), dropped(0), processed(0), filtered(0), prioritized(0), alerts(0),
+                      alertsDropped(0), alertsSuppressed(0), alertSummaries(0), queueDepth(0), priorityQueueDepth(0), maxQueueDepth(0),
+                      queueCapacity(0) {}
+};
+
+// Accounted memory per subsystem (process-wide, see MemoryAccounting.h) and
+// what the budget has reclaimed since the monitor was created
+struct MemoryStats {
+    uint64_t bytes[static_cast<size_t>(MemorySubsystem::Count)];
+    uint64_t totalBytes;
+    uint64_t budgetBytes;           // 0 = no budget
+    uint64_t overBudget;            // Stored events that found the total over budget
+    uint64_t cacheBytesReclaimed;   // Trimmed from the signer and process caches
+    uint64_t eventsEvicted;         // Oldest events evicted from the history
+    
+    MemoryStats() : bytes(), totalBytes(0), budgetBytes(0), overBudget(0), cacheBytesReclaimed(0), eventsEvicted(0) {}
+};
+
+// Called on the pipeline thread for every stored event
+using EventCallback = std::function<void(const DriverEvent&)>;
+
+// Called on the alert thread for every alert raised, after the alert sound.
+// Rate-limited alerts arrive later as summaries (Alert::IsSummary).
+using AlertCallback = std::function<void(const Alert&)>;
 
 class DriverMonitor {
 public:
@@ -23,40 +121,214 @@ public:
     // Start monitoring
     bool Start();
     
-    // Stop monitoring
+    // Feed a recorded observation log through the pipeline instead of the live
+    // sources. The clock paces the replay: ScaledClock for real time or N x,
+    // VirtualClock for as fast as possible.
+    bool StartReplay(std::unique_ptr<ReplaySource> source, std::unique_ptr<Clock> clock);
+    
+    // Start only the processing pipeline; observations are supplied
+    // through SubmitObservation (synthetic load, external producers)
+    bool StartIngestion();
+    
+    // Stop monitoring (observations already queued are still processed)
     void Stop();
     
+    // Queue a raw observation for processing (thread-safe). When the queue is
+    // full, waits for room if wait is set, otherwise drops the observation.
+    // Returns false if the observation was dropped. Observations already
+    // Suspicious by their loading method go to a priority queue that the
+    // pipeline takes before the next bulk observation.
+    bool SubmitObservation(DriverEvent&& event, bool wait);
+    
+    // Set ingestion queue capacity (only while stopped)
+    void SetQueueCapacity(size_t capacity);
+    
+    // Set the stored-event callback (only while stopped)
+    void SetEventCallback(EventCallback callback);
+    
+    // Set the alert callback (only while stopped)
+    void SetAlertCallback(AlertCallback callback);
+    
+    // Replace the configuration (any thread). It is published as a new
+    // snapshot; events already being processed finish with the previous one.
+    // Source settings (driversPath) take effect on the next Start().
+    void ApplyConfig(const MonitorConfig& config);
+    
+    // Get ingestion pipeline counters
+    PipelineStats GetPipelineStats() const;
+    
+    // Get memory usage per subsystem and budget evictions
+    MemoryStats GetMemoryStats() const;
+    
+    // Latency of one stage since the last start, merged over all threads
+    StageTiming GetStageTiming(PipelineStage stage) const;
+    LatencyHistogram GetStageHistogram(PipelineStage stage) const;
+    
     // Check if monitoring is active
     bool IsMonitoring() const { return m_isMonitoring; }
     
+    // Check if a replay has consumed its whole log
+    bool IsReplayComplete() const { return m_replayComplete; }
+    
+    // Get number of observations replayed
+    uint64_t GetReplayedCount() const { return m_replayedCount; }
+    
+    // Record raw source observations; recorder must outlive monitoring (nullptr to detach)
+    void SetRecorder(ObservationRecorder* recorder) { m_recorder = recorder; }
+    
     // Get uptime in seconds
     int GetUptimeSeconds() const;
     
+    // Signer verdict cache of the pipeline (hit and miss counters)
+    const SignerCache& GetSignerCache() const { return m_signerCache; }
+    
+    // Initiator images by PID (hit, miss and PID reuse counters)
+    const ProcessInfoCache& GetProcessCache() const { return m_processCache; }
+    
+    // Collector forwarding (forwarding.endpoint), started with the pipeline;
+    // GetForwarder().GetLastError() tells why it did not start
+    bool IsForwarding() const { return m_forwarding; }
+    const EventForwarder& GetForwarder() const { return m_forwarder; }
+    
+    // Export counters, queue gauges, stage histograms and signer cache
+    // statistics through registry (only while stopped). Scrapes read atomics
+    // only; the registry must outlive this monitor.
+    void RegisterMetrics(MetricsRegistry& registry);
+    
+    // Get polling statistics per source
+    std::vector<PollSourceStats> GetPollStats() const { return m_scheduler ? m_scheduler->GetStats() : std::vector<PollSourceStats>(); }
+    
 private:
     EventManager* m_eventManager;
     Config* m_config;
     
     std::atomic<bool> m_isMonitoring;
     std::chrono::steady_clock::time_point m_startTime;
+    SystemClock m_systemClock;
+    
+    // Monitoring sources, all polled from one scheduler thread
+    std::unique_ptr<PollScheduler> m_scheduler;
+#ifdef _WIN32
+    std::unique_ptr<RegistryMonitor> m_registryMonitor;
+    std::unique_ptr<WMIMonitor> m_wmiMonitor;
+#endif
+    std::unique_ptr<FileSystemMonitor> m_fileSystemMonitor;
+    
+    // Record and replay
+    std::atomic<ObservationRecorder*> m_recorder;
+    std::unique_ptr<ReplaySource> m_replaySource;
+    std::unique_ptr<Clock> m_replayClock;
+    std::unique_ptr<std::thread> m_replayThread;
+    std::atomic<bool> m_replayComplete;
+    std::atomic<uint64_t> m_replayedCount;
+    
+    // Ingestion queue: sources produce, the pipeline thread consumes in batches
+    struct QueuedObservation {
+        DriverEvent event;
+        std::chrono::steady_clock::time_point submitted;
+    };
+    
+    std::vector<QueuedObservation> m_queue;
+    std::vector<QueuedObservation> m_priorityQueue;     // Same capacity, taken first
+    size_t m_queueCapacity;
+    std::atomic<size_t> m_queueDepth;       // Written under m_queueMutex, read by metrics
+    std::atomic<size_t> m_maxQueueDepth;
+    std::atomic<size_t> m_priorityDepth;    // Checked by the pipeline between bulk observations
+    mutable std::mutex m_queueMutex;
+    std::condition_variable m_queueNotEmpty;
+    std::condition_variable m_queueNotFull;
+    std::unique_ptr<std::thread> m_pipelineThread;
+    bool m_stopPipeline;                    // Guarded by m_queueMutex
+    EventCallback m_eventCallback;
+    
+    std::atomic<uint64_t> m_submittedCount;
+    std::atomic<uint64_t> m_droppedCount;
+    std::atomic<uint64_t> m_processedCount;
+    std::atomic<uint64_t> m_filteredCount;
+    std::atomic<uint64_t> m_prioritizedCount;
+    
+    // Alerts for Suspicious / High events, delivered off the pipeline thread
+    AlertDispatcher m_alerts;
+    AlertCallback m_alertCallback;
+    
+    // Event log, kept open by the pipeline thread: flushed after each batch,
+    // synced to disk after each alerting event
+    std::FILE* m_logFile;
+    std::string m_logPath;
+    
+    // Per-stage latency, recorded lock-free by the scheduler and pipeline threads
+    LatencyRecorder m_latency;
+    
+    void RecordLatency(PipelineStage stage, std::chrono::steady_clock::time_point start,
+                       std::chrono::steady_clock::time_point end);
+    
+    // Signer verdicts by file (pipeline thread)
+    SignerCache m_signerCache;
     
-    // Monitoring threads
-    std::unique_ptr<std::thread> m_registryThread;
-    std::unique_ptr<std::thread> m_fileSystemThread;
-    std::unique_ptr<std::thread> m_wmiThread;
+    // Initiator images by PID (pipeline thread)
+    ProcessInfoCache m_processCache;
     
-    // Monitoring methods
-    void RegistryMonitoringThread();
-    void FileSystemMonitoringThread();
-    void WMIMonitoringThread();
+    // Memory budget (monitoring.memoryBudgetMB) enforcement, pipeline thread
+    std::atomic<uint64_t> m_overBudgetCount;
+    std::atomic<uint64_t> m_cacheBytesReclaimed;
+    std::atomic<uint64_t> m_eventsEvicted;
     
-    // Process detected driver
-    void ProcessDriverEvent(DriverEvent& event);
+    // Over budget: trim the caches first, then evict the oldest events
+    void EnforceMemoryBudget(uint64_t budgetBytes);
+    
+    // Stored events to the collector (pipeline thread submits)
+    EventForwarder m_forwarder;
+    std::atomic<bool> m_forwarding;
+    
+    // Start the forwarder if the configuration names a collector
+    void StartForwarding();
+    
+    // Metrics: stored events by type x source x threat (empty until registered)
+    MetricsRegistry* m_metrics;
+    int m_metricsCollector;
+    std::vector<MetricCounter*> m_eventCounters;
+    
+    // Reset counters and start the pipeline thread
+    bool StartPipeline();
+    
+    // Drain the queue and join the pipeline thread
+    void StopPipeline();
+    
+    // Pipeline thread body
+    void PipelineThread();
+    
+    // Process one dequeued observation
+    void ProcessQueued(QueuedObservation& item);
+    
+    // Take and process the priority queue (batch: recycled storage)
+    void DrainPriorityQueue(std::vector<QueuedObservation>& batch);
+    
+    // Alert thread: sound, callback, detection-to-alert latency
+    void DeliverAlert(const Alert& alert);
+    
+    // Start the alert thread with the configured rate limits
+    void StartAlerts();
+    
+    // Drain pending detections from a source; returns true if any were found
+    template <typename Monitor>
+    bool PollMonitor(Monitor& monitor, EventSource source);
+    
+    // Replay thread body
+    void ReplayThread();
+    
+    // Process detected driver (dequeued: when the pipeline took it off the queue)
+    void ProcessDriverEvent(DriverEvent& event, std::chrono::steady_clock::time_point submitted,
+                            std::chrono::steady_clock::time_point dequeued);
     
     // Check if event should be filtered
-    bool ShouldFilter(const DriverEvent& event) const;
+    bool ShouldFilter(const DriverEvent& event, const ConfigSnapshot& snapshot) const;
     
     // Log event to file
-    void LogEvent(const DriverEvent& event);
+    void LogEvent(const DriverEvent& event, const MonitorConfig& config);
+    
+    // Flush the event log; durable also syncs it to disk
+    void FlushLog(bool durable);
+    void CloseLog();
 };
 
 } // namespace DriverMonitor
@@ -0,0 +1,494 @@
+#include "EventExporter.h"
+#include "BinaryCodec.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+    // Events copied from the history per lock acquisition
+    const uint64_t kChunkEvents = 4096;
+
+    // Rows per columnar block, and output buffered before each write
+    const size_t kBlockRows = 65536;
+    const size_t kWriteThreshold = 1 << 20;
+
+    const char kCsvHeader[] =
+        "sequenceId,time,timestampUs,driverName,installPath,loadingMethod,initiatedBy,"
+        "processId,signerInfo,eventType,threatLevel,source,removal\n";
+}
+
+namespace DriverMonitor {
+
+namespace {
+
+void AppendCsvField(std::string& out, const std::string& value) {
+    if (value.find_first_of(",\"\r\n") == std::string::npos) {
+        out += value;
+        return;
+    }
+    out += '"';
+    for (char c : value) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+void AppendCsvLine(std::string& out, const DriverEvent& event) {
+    out += std::to_string(event.sequenceId);
+    out += ',';
+    AppendCsvField(out, event.timestamp);
+    out += ',';
+    out += std::to_string(event.timestampUs);
+    out += ',';
+    AppendCsvField(out, event.driverName);
+    out += ',';
+    AppendCsvField(out, event.installPath);
+    out += ',';
+    AppendCsvField(out, event.loadingMethod);
+    out += ',';
+    AppendCsvField(out, event.initiatedBy);
+    out += ',';
+    out += std::to_string(event.processId);
+    out += ',';
+    AppendCsvField(out, event.signerInfo);
+    out += ',';
+    out += Utils::GetEventTypeName(event.eventType);
+    out += ',';
+    out += Utils::GetThreatLevelName(event.threatLevel);
+    out += ',';
+    out += Utils::GetSourceName(event.source);
+    out += event.isRemoval ? ",true\n" : ",false\n";
+}
+
+// Accumulates rows of one columnar block
+class ColumnarBlock {
+public:
+    ColumnarBlock() : m_rows(0) {}
+
+    size_t GetRowCount() const { return m_rows; }
+
+    void Add(const DriverEvent& event) {
+        m_sequences.push_back(event.sequenceId);
+        m_timestamps.push_back(event.timestampUs);
+        m_types.push_back(static_cast<char>(event.eventType));
+        m_threats.push_back(static_cast<char>(event.threatLevel));
+        m_sources.push_back(static_cast<char>(event.source));
+        m_flags.push_back(static_cast<char>(event.isRemoval ? ColumnarExport::kFlagRemoval : 0));
+        m_processIds.push_back(event.processId);
+        m_strings[0].Add(event.driverName);
+        m_strings[1].Add(event.installPath);
+        m_strings[2].Add(event.loadingMethod);
+        m_strings[3].Add(event.initiatedBy);
+        m_strings[4].Add(event.signerInfo);
+        m_rows++;
+    }
+
+    // Append the block (length-prefixed) to out and reset
+    void Encode(std::string& out) {
+        m_payload.clear();
+        BinaryWriter writer(m_payload);
+        writer.WriteVarint(m_rows);
+
+        uint64_t previousSequence = 0;
+        for (size_t i = 0; i < m_rows; ++i) {
+            writer.WriteVarint(m_sequences[i] - previousSequence);
+            previousSequence = m_sequences[i];
+        }
+        int64_t previousTime = 0;
+        for (size_t i = 0; i < m_rows; ++i) {
+            writer.WriteSignedVarint(m_timestamps[i] - previousTime);
+            previousTime = m_timestamps[i];
+        }
+        m_payload += m_types;
+        m_payload += m_threats;
+        m_payload += m_sources;
+        m_payload += m_flags;
+        for (size_t i = 0; i < m_rows; ++i) {
+            writer.WriteVarint(m_processIds[i]);
+        }
+        for (auto& column : m_strings) {
+            column.Encode(writer);
+        }
+
+        BinaryWriter(out).WriteFixed32(static_cast<uint32_t>(m_payload.size()));
+        out += m_payload;
+
+        m_sequences.clear();
+        m_timestamps.clear();
+        m_types.clear();
+        m_threats.clear();
+        m_sources.clear();
+        m_flags.clear();
+        m_processIds.clear();
+        m_rows = 0;
+    }
+
+private:
+    // Dictionary-encoded string column
+    struct StringColumn {
+        std::unordered_map<std::string, uint32_t> ids;
+        std::vector<const std::string*> dictionary;
+        std::vector<uint32_t> indices;
+
+        void Add(const std::string& value) {
+            auto it = ids.find(value);
+            if (it == ids.end()) {
+                it = ids.emplace(value, static_cast<uint32_t>(dictionary.size())).first;
+                dictionary.push_back(&it->first);
+            }
+            indices.push_back(it->second);
+        }
+
+        void Encode(BinaryWriter& writer) {
+            writer.WriteVarint(dictionary.size());
+            for (const std::string* value : dictionary) {
+                writer.WriteString(*value);
+            }
+            for (uint32_t index : indices) {
+                writer.WriteVarint(index);
+            }
+            ids.clear();
+            dictionary.clear();
+            indices.clear();
+        }
+    };
+
+    size_t m_rows;
+    std::vector<uint64_t> m_sequences;
+    std::vector<int64_t> m_timestamps;
+    std::string m_types;
+    std::string m_threats;
+    std::string m_sources;
+    std::string m_flags;
+    std::vector<uint64_t> m_processIds;
+    StringColumn m_strings[5];
+    std::string m_payload;
+};
+
+} // namespace
+
+bool ExportCursor::Load(const std::string& filePath) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        return false;
+    }
+    ExportCursor cursor;
+    if (!(file >> cursor.historyId >> cursor.nextSequence >> cursor.lastTimestampUs)) {
+        return false;
+    }
+    *this = cursor;
+    return true;
+}
+
+bool ExportCursor::Save(const std::string& filePath) const {
+    // Write a temporary file and rename it, so a crash never leaves a torn cursor
+    std::string temporaryPath = filePath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << historyId << ' ' << nextSequence << ' ' << lastTimestampUs << '\n';
+        if (!file) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, filePath, error);
+    return !error;
+}
+
+EventExporter::EventExporter(const EventManager* eventManager)
+    : m_eventManager(eventManager)
+    , m_cancel(false) {
+}
+
+EventExporter::~EventExporter() {
+    Cancel();
+    Wait();
+}
+
+bool EventExporter::Start(const ExportOptions& options) {
+    if (IsRunning()) {
+        return false;
+    }
+    Wait();
+
+    // The snapshot: everything stored right now
+    uint64_t firstSequence = m_eventManager->GetFirstSequence();
+    uint64_t nextSequence = m_eventManager->GetNextSequence();
+
+    {
+        std::lock_guard<std::mutex> lock(m_progressMutex);
+        m_progress = ExportProgress();
+        m_progress.state = ExportState::Running;
+    }
+    m_cancel = false;
+    m_thread = std::make_unique<std::thread>(&EventExporter::ExportThread, this, options, firstSequence, nextSequence);
+    return true;
+}
+
+void EventExporter::Cancel() {
+    m_cancel = true;
+}
+
+void EventExporter::Wait() {
+    if (m_thread) {
+        m_thread->join();
+        m_thread.reset();
+    }
+}
+
+bool EventExporter::IsRunning() const {
+    std::lock_guard<std::mutex> lock(m_progressMutex);
+    return m_progress.state == ExportState::Running;
+}
+
+ExportProgress EventExporter::GetProgress() const {
+    std::lock_guard<std::mutex> lock(m_progressMutex);
+    return m_progress;
+}
+
+void EventExporter::Finish(ExportState state, const std::string& error) {
+    std::lock_guard<std::mutex> lock(m_progressMutex);
+    m_progress.state = state;
+    m_progress.error = error;
+}
+
+void EventExporter::ExportThread(ExportOptions options, uint64_t firstSequence, uint64_t nextSequence) {
+    auto started = std::chrono::steady_clock::now();
+    uint64_t historyId = m_eventManager->GetHistoryId();
+
+    FilterExpression expression;
+    std::string expressionError;
+    if (!expression.Compile(options.filterExpression, expressionError)) {
+        Finish(ExportState::Failed, "Filter expression: " + expressionError);
+        return;
+    }
+
+    // Resume point
+    ExportCursor cursor;
+    bool resumeByTime = false;
+    uint64_t from = firstSequence;
+    if (!options.cursorPath.empty()) {
+        options.append = true;
+        if (cursor.Load(options.cursorPath)) {
+            if (cursor.historyId == historyId) {
+                from = std::max(from, cursor.nextSequence);
+            } else {
+                resumeByTime = true;
+            }
+        }
+    }
+    int64_t resumeAfterUs = cursor.lastTimestampUs;
+    cursor.historyId = historyId;
+    cursor.nextSequence = std::max(cursor.nextSequence, from);
+    if (resumeByTime) {
+        cursor.nextSequence = from;
+    }
+
+    std::error_code sizeError;
+    bool fileHasData = options.append && std::filesystem::file_size(options.filePath, sizeError) > 0 && !sizeError;
+    std::ofstream file(options.filePath, std::ios::binary | (options.append ? std::ios::app : std::ios::trunc));
+    if (!file.is_open()) {
+        Finish(ExportState::Failed, "Cannot open " + options.filePath);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_progressMutex);
+        m_progress.total = nextSequence > from ? nextSequence - from : 0;
+        m_progress.cursor = cursor;
+    }
+
+    std::string buffer;
+    if (!fileHasData) {
+        if (options.format == ExportFormat::Csv) {
+            buffer += kCsvHeader;
+        } else if (options.format == ExportFormat::Columnar) {
+            BinaryWriter writer(buffer);
+            writer.WriteBytes(ColumnarExport::kMagic, sizeof(ColumnarExport::kMagic));
+            writer.WriteByte(ColumnarExport::kVersion);
+        }
+    }
+
+    std::string foldedSearch = Utils::FoldCase(options.searchText);
+    ColumnarBlock block;
+    std::vector<DriverEvent> chunk(kChunkEvents);
+    uint64_t examined = 0;
+    uint64_t written = 0;
+    uint64_t evicted = 0;
+    uint64_t bytes = 0;
+    bool failed = false;
+
+    auto writeBuffer = [&]() {
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        bytes += buffer.size();
+        buffer.clear();
+        failed = failed || !file;
+    };
+
+    for (uint64_t sequence = from; sequence < nextSequence && !m_cancel && !failed;) {
+        uint64_t chunkEnd = std::min(nextSequence, sequence + kChunkEvents);
+
+        // Copy under the history lock (assignment reuses the chunk's string buffers)
+        size_t copied = 0;
+        m_eventManager->VisitRange(sequence, chunkEnd, [&](const DriverEvent& event) {
+            chunk[copied++] = event;
+        });
+        evicted += (chunkEnd - sequence) - copied;
+
+        for (size_t i = 0; i < copied; ++i) {
+            const DriverEvent& event = chunk[i];
+            cursor.lastTimestampUs = std::max(cursor.lastTimestampUs, event.timestampUs);
+
+            if (resumeByTime && event.timestampUs <= resumeAfterUs) {
+                continue;
+            }
+            if ((options.fromTimeUs != 0 && event.timestampUs < options.fromTimeUs) ||
+                (options.toTimeUs != 0 && event.timestampUs >= options.toTimeUs) ||
+                !MatchesEventFilter(event, foldedSearch, options.typeFilter) || !expression.Matches(event)) {
+                continue;
+            }
+
+            switch (options.format) {
+                case ExportFormat::Csv: AppendCsvLine(buffer, event); break;
+                case ExportFormat::JsonLines: Utils::AppendJsonLine(buffer, event); break;
+                case ExportFormat::Columnar:
+                    block.Add(event);
+                    if (block.GetRowCount() == kBlockRows) {
+                        block.Encode(buffer);
+                    }
+                    break;
+            }
+            written++;
+        }
+        examined += chunkEnd - sequence;
+        sequence = chunkEnd;
+        cursor.nextSequence = chunkEnd;
+
+        if (buffer.size() >= kWriteThreshold) {
+            writeBuffer();
+        }
+
+        std::lock_guard<std::mutex> lock(m_progressMutex);
+        m_progress.examined = examined;
+        m_progress.written = written;
+        m_progress.evicted = evicted;
+        m_progress.bytes = bytes + buffer.size();
+        m_progress.cursor = cursor;
+        m_progress.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    }
+
+    // Everything examined so far is complete on disk before the cursor moves
+    if (block.GetRowCount() > 0) {
+        block.Encode(buffer);
+    }
+    writeBuffer();
+    file.flush();
+    failed = failed || !file;
+    file.close();
+
+    if (failed) {
+        Finish(ExportState::Failed, "Write to " + options.filePath + " failed");
+        return;
+    }
+    if (!options.cursorPath.empty() && !cursor.Save(options.cursorPath)) {
+        Finish(ExportState::Failed, "Cannot save cursor " + options.cursorPath);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_progressMutex);
+        m_progress.bytes = bytes;
+        m_progress.cursor = cursor;
+        m_progress.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    }
+    Finish(m_cancel ? ExportState::Cancelled : ExportState::Completed, std::string());
+}
+
+bool EventExporter::ReadColumnar(const std::string& filePath, std::vector<DriverEvent>& events) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string data = contents.str();
+
+    BinaryReader reader(data.data(), data.size());
+    char magic[sizeof(ColumnarExport::kMagic)];
+    if (!reader.ReadBytes(magic, sizeof(magic)) ||
+        memcmp(magic, ColumnarExport::kMagic, sizeof(magic)) != 0 ||
+        reader.ReadByte() != ColumnarExport::kVersion) {
+        return false;
+    }
+
+    size_t offset = reader.GetOffset();
+    while (offset < data.size()) {
+        BinaryReader prefix(data.data() + offset, data.size() - offset);
+        uint32_t length = prefix.ReadFixed32();
+        if (prefix.HasError() || length > data.size() - offset - prefix.GetOffset()) {
+            return false;
+        }
+        BinaryReader block(data.data() + offset + prefix.GetOffset(), length);
+        offset += prefix.GetOffset() + length;
+
+        size_t rows = static_cast<size_t>(block.ReadVarint());
+        if (block.HasError() || rows > length) {
+            return false;
+        }
+        size_t base = events.size();
+        events.resize(base + rows);
+
+        uint64_t sequence = 0;
+        for (size_t i = 0; i < rows; ++i) {
+            sequence += block.ReadVarint();
+            events[base + i].sequenceId = sequence;
+        }
+        int64_t timestamp = 0;
+        for (size_t i = 0; i < rows; ++i) {
+            timestamp += block.ReadSignedVarint();
+            events[base + i].timestampUs = timestamp;
+            events[base + i].timestamp = Utils::FormatTimestamp(timestamp);
+        }
+        for (size_t i = 0; i < rows; ++i) events[base + i].eventType = static_cast<EventType>(block.ReadByte());
+        for (size_t i = 0; i < rows; ++i) events[base + i].threatLevel = static_cast<ThreatLevel>(block.ReadByte());
+        for (size_t i = 0; i < rows; ++i) events[base + i].source = static_cast<EventSource>(block.ReadByte());
+        for (size_t i = 0; i < rows; ++i) events[base + i].isRemoval = (block.ReadByte() & ColumnarExport::kFlagRemoval) != 0;
+        for (size_t i = 0; i < rows; ++i) events[base + i].processId = static_cast<unsigned long>(block.ReadVarint());
+
+        std::string DriverEvent::* const columns[] = {
+            &DriverEvent::driverName, &DriverEvent::installPath, &DriverEvent::loadingMethod,
+            &DriverEvent::initiatedBy, &DriverEvent::signerInfo
+        };
+        for (auto column : columns) {
+            std::vector<std::string> dictionary(static_cast<size_t>(block.ReadVarint()));
+            if (block.HasError() || dictionary.size() > length) {
+                return false;
+            }
+            for (auto& value : dictionary) {
+                value = block.ReadString();
+            }
+            for (size_t i = 0; i < rows; ++i) {
+                uint64_t index = block.ReadVarint();
+                if (index >= dictionary.size()) {
+                    return false;
+                }
+                events[base + i].*column = dictionary[static_cast<size_t>(index)];
+            }
+        }
+        if (block.HasError()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace DriverMonitor
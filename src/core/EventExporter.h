@@ -0,0 +1,133 @@
+#pragma once
+
+#include "EventManager.h"
+#include "EventViewModel.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DriverMonitor {
+
+enum class ExportFormat {
+    Csv,
+    JsonLines,
+    Columnar
+};
+
+// Columnar export file layout (little endian, LEB128 varints):
+//   header: "DMEX" magic, u8 version
+//   blocks: fixed32 payload length, then the payload:
+//     varint rows
+//     sequence:  varint first, varint deltas
+//     timestamp: signed varint first, signed varint deltas (us)
+//     type, threat, source, flags: one byte per row each
+//     processId: varint per row
+//     name, path, method, initiatedBy, signer: varint dictionary size,
+//       dictionary strings, then a varint dictionary index per row
+// Blocks are self-contained (own dictionaries), so exports can be appended.
+namespace ColumnarExport {
+    const char kMagic[4] = { 'D', 'M', 'E', 'X' };
+    const uint8_t kVersion = 1;
+    const uint8_t kFlagRemoval = 1;
+}
+
+// Position up to which a destination has been exported. Sequence IDs only
+// apply within the same history (process); after a restart the export
+// resumes after the last exported timestamp instead.
+struct ExportCursor {
+    uint64_t historyId;
+    uint64_t nextSequence;      // First sequence not exported yet
+    int64_t lastTimestampUs;    // Timestamp of the last exported event
+
+    ExportCursor() : historyId(0), nextSequence(0), lastTimestampUs(0) {}
+
+    // Cursor file: one text line "historyId nextSequence lastTimestampUs"
+    bool Load(const std::string& filePath);
+    bool Save(const std::string& filePath) const;
+};
+
+struct ExportOptions {
+    std::string filePath;
+    ExportFormat format;
+    bool append;                // Append to the file instead of replacing it
+
+    // Filters: the event table's filter (search, type and expression; see
+    // FilterExpression.h), and a time range (0 = unbounded)
+    std::string searchText;
+    EventTypeFilter typeFilter;
+    std::string filterExpression;
+    int64_t fromTimeUs;
+    int64_t toTimeUs;
+
+    // Incremental export: resume from and update this cursor file (implies append)
+    std::string cursorPath;
+
+    ExportOptions()
+        : format(ExportFormat::Csv), append(false), typeFilter(EventTypeFilter::All),
+          fromTimeUs(0), toTimeUs(0) {}
+};
+
+enum class ExportState {
+    Idle,
+    Running,
+    Completed,
+    Cancelled,
+    Failed
+};
+
+struct ExportProgress {
+    ExportState state;
+    uint64_t total;             // Events in the snapshot range
+    uint64_t examined;
+    uint64_t written;
+    uint64_t evicted;           // Dropped from the history before they were reached
+    uint64_t bytes;
+    double elapsedMs;
+    std::string error;
+    ExportCursor cursor;        // Position reached so far
+
+    ExportProgress()
+        : state(ExportState::Idle), total(0), examined(0), written(0), evicted(0), bytes(0), elapsedMs(0) {}
+};
+
+// Streams events to a file on a background thread.
+// The snapshot is the sequence range stored when the export starts; it is
+// copied from the history in chunks, so the history lock is only held for
+// one chunk at a time and the history keeps growing (and evicting) meanwhile.
+class EventExporter {
+public:
+    explicit EventExporter(const EventManager* eventManager);
+    ~EventExporter();
+
+    // Start an export; false if one is still running
+    bool Start(const ExportOptions& options);
+
+    // Request cancellation; the cursor is saved at the point reached
+    void Cancel();
+
+    // Wait for the running export to finish
+    void Wait();
+
+    bool IsRunning() const;
+    ExportProgress GetProgress() const;
+
+    // Read a columnar export back (for verification and tools)
+    static bool ReadColumnar(const std::string& filePath, std::vector<DriverEvent>& events);
+
+private:
+    const EventManager* m_eventManager;
+    std::unique_ptr<std::thread> m_thread;
+    std::atomic<bool> m_cancel;
+
+    mutable std::mutex m_progressMutex;
+    ExportProgress m_progress;
+
+    void ExportThread(ExportOptions options, uint64_t firstSequence, uint64_t nextSequence);
+    void Finish(ExportState state, const std::string& error);
+};
+
+} // namespace DriverMonitor
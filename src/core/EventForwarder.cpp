@@ -0,0 +1,899 @@
+#include "EventForwarder.h"
+#include "BinaryCodec.h"
+#include "Compression.h"
+#include "Socket.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    // How long the thread waits for acknowledgements before checking for new batches
+    const std::chrono::milliseconds kAckPollInterval(20);
+
+    // Compressed payloads may expand to at most this much (decompression bombs)
+    const size_t kMaxRawBatchSize = 256 << 20;
+
+    const char kSpoolExtension[] = ".batch";
+
+    using DriverMonitor::BinaryWriter;
+    using DriverMonitor::BinaryReader;
+    using DriverMonitor::DriverEvent;
+    namespace ForwardProtocol = DriverMonitor::ForwardProtocol;
+
+    void EncodeEvent(const DriverEvent& event, int64_t& previousTimestamp, std::string& out) {
+        BinaryWriter writer(out);
+        writer.WriteVarint(event.sequenceId);
+        writer.WriteSignedVarint(event.timestampUs - previousTimestamp);
+        previousTimestamp = event.timestampUs;
+        writer.WriteByte(static_cast<uint8_t>(event.eventType));
+        writer.WriteByte(static_cast<uint8_t>(event.threatLevel));
+        writer.WriteByte(static_cast<uint8_t>(event.source));
+        writer.WriteByte(event.isRemoval ? ForwardProtocol::kFlagRemoval : 0);
+        writer.WriteVarint(event.processId);
+        writer.WriteString(event.driverName);
+        writer.WriteString(event.installPath);
+        writer.WriteString(event.loadingMethod);
+        writer.WriteString(event.initiatedBy);
+        writer.WriteString(event.signerInfo);
+    }
+
+    void WriteFrameLength(std::string& out, size_t frameStart) {
+        uint32_t length = static_cast<uint32_t>(out.size() - frameStart - 4);
+        for (int i = 0; i < 4; ++i) {
+            out[frameStart + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+        }
+    }
+
+    uint32_t ReadFrameLength(const char* data) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+               (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    }
+
+    // Batch frame around already encoded events; falls back to raw when
+    // compression does not pay. Returns the payload bytes after the header.
+    size_t AppendBatchFrame(uint64_t stream, uint64_t sequence, uint32_t count, const std::string& events, bool compress,
+                            std::string& out) {
+        size_t frameStart = out.size();
+        out.append(4, '\0');
+        BinaryWriter writer(out);
+        writer.WriteByte(ForwardProtocol::kBatch);
+        writer.WriteVarint(stream);
+        writer.WriteVarint(sequence);
+        writer.WriteVarint(count);
+        size_t codecOffset = out.size();
+        if (compress) {
+            writer.WriteByte(ForwardProtocol::kLz);
+            writer.WriteVarint(events.size());
+            size_t dataStart = out.size();
+            DriverMonitor::Lz::Compress(events.data(), events.size(), out);
+            if (out.size() - dataStart < events.size()) {
+                WriteFrameLength(out, frameStart);
+                return out.size() - dataStart;
+            }
+            out.resize(codecOffset);
+        }
+        writer.WriteByte(ForwardProtocol::kRaw);
+        writer.WriteVarint(events.size());
+        out += events;
+        WriteFrameLength(out, frameStart);
+        return events.size();
+    }
+
+    // Stream and sequence from a spool file name; false if it is not one
+    bool ParseSpoolName(const std::string& name, uint64_t& stream, uint64_t& sequence) {
+        size_t extensionLength = sizeof(kSpoolExtension) - 1;
+        if (name.size() != 33 + extensionLength || name[16] != '-' ||
+            name.compare(33, extensionLength, kSpoolExtension) != 0) {
+            return false;
+        }
+        stream = 0;
+        sequence = 0;
+        for (size_t i = 0; i < 33; ++i) {
+            if (i == 16) {
+                continue;
+            }
+            char c = name[i];
+            uint64_t digit;
+            if (c >= '0' && c <= '9') {
+                digit = static_cast<uint64_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                digit = static_cast<uint64_t>(c - 'a' + 10);
+            } else {
+                return false;
+            }
+            uint64_t& value = i < 16 ? stream : sequence;
+            value = (value << 4) | digit;
+        }
+        return sequence != 0;
+    }
+}
+
+namespace DriverMonitor {
+
+void ForwardFrameReader::Append(const char* data, size_t length) {
+    size_t available;
+    std::memcpy(Reserve(length, available), data, length);
+    Commit(length);
+}
+
+char* ForwardFrameReader::Reserve(size_t minimum, size_t& available) {
+    if (m_buffer.size() - m_end < minimum) {
+        // Move the unread bytes to the front, and grow if that is not enough
+        size_t unread = m_end - m_begin;
+        if (m_begin > 0) {
+            std::memmove(&m_buffer[0], m_buffer.data() + m_begin, unread);
+            m_begin = 0;
+            m_end = unread;
+        }
+        if (m_buffer.size() - m_end < minimum) {
+            m_buffer.resize(std::max(m_buffer.size() * 2, m_end + minimum));
+        }
+    }
+    available = m_buffer.size() - m_end;
+    return &m_buffer[0] + m_end;
+}
+
+bool ForwardFrameReader::Next(const char*& payload, size_t& length) {
+    if (m_error || m_end - m_begin < 4) {
+        return false;
+    }
+    uint32_t frameLength = ReadFrameLength(m_buffer.data() + m_begin);
+    if (frameLength == 0 || frameLength > ForwardProtocol::kMaxFrameSize) {
+        m_error = true;
+        return false;
+    }
+    if (m_end - m_begin - 4 < frameLength) {
+        return false;
+    }
+    payload = m_buffer.data() + m_begin + 4;
+    length = frameLength;
+    m_begin += 4 + frameLength;
+    if (m_begin == m_end) {
+        m_begin = 0;
+        m_end = 0;
+    }
+    return true;
+}
+
+ForwardBatchReader::ForwardBatchReader()
+    : m_reader(nullptr, 0)
+    , m_stream(0)
+    , m_sequence(0)
+    , m_count(0)
+    , m_remaining(0)
+    , m_timestamp(0)
+    , m_error(false) {
+}
+
+bool ForwardBatchReader::Open(const char* payload, size_t length, std::string& scratch) {
+    m_remaining = 0;
+    m_timestamp = 0;
+    m_error = true;
+    BinaryReader header(payload, length);
+    if (header.ReadByte() != ForwardProtocol::kBatch) {
+        return false;
+    }
+    m_stream = header.ReadVarint();
+    m_sequence = header.ReadVarint();
+    m_count = header.ReadVarint();
+    uint8_t codec = header.ReadByte();
+    uint64_t rawSize = header.ReadVarint();
+    if (header.HasError() || rawSize > kMaxRawBatchSize || m_count > rawSize) {
+        return false;
+    }
+
+    const char* data = payload + header.GetOffset();
+    size_t dataLength = length - header.GetOffset();
+    if (codec == ForwardProtocol::kLz) {
+        scratch.clear();
+        if (!Lz::Decompress(data, dataLength, static_cast<size_t>(rawSize), scratch)) {
+            return false;
+        }
+        data = scratch.data();
+        dataLength = scratch.size();
+    } else if (codec != ForwardProtocol::kRaw || dataLength != rawSize) {
+        return false;
+    }
+    m_reader = BinaryReader(data, dataLength);
+    m_remaining = m_count;
+    m_error = m_count == 0 && dataLength != 0;
+    return !m_error;
+}
+
+bool ForwardBatchReader::Next(ForwardEventView& event) {
+    if (m_remaining == 0 || m_error) {
+        return false;
+    }
+    size_t length;
+    const char* text;
+    event.sequenceId = m_reader.ReadVarint();
+    m_timestamp += m_reader.ReadSignedVarint();
+    event.timestampUs = m_timestamp;
+    event.eventType = static_cast<EventType>(m_reader.ReadByte());
+    event.threatLevel = static_cast<ThreatLevel>(m_reader.ReadByte());
+    event.source = static_cast<EventSource>(m_reader.ReadByte());
+    event.isRemoval = (m_reader.ReadByte() & ForwardProtocol::kFlagRemoval) != 0;
+    event.processId = static_cast<unsigned long>(m_reader.ReadVarint());
+    text = m_reader.ReadStringView(length);
+    event.driverName = std::string_view(text, length);
+    text = m_reader.ReadStringView(length);
+    event.installPath = std::string_view(text, length);
+    text = m_reader.ReadStringView(length);
+    event.loadingMethod = std::string_view(text, length);
+    text = m_reader.ReadStringView(length);
+    event.initiatedBy = std::string_view(text, length);
+    text = m_reader.ReadStringView(length);
+    event.signerInfo = std::string_view(text, length);
+
+    // The last event must end the payload
+    m_remaining--;
+    m_error = m_reader.HasError() || (m_remaining == 0 && !m_reader.AtEnd());
+    return !m_error;
+}
+
+EventForwarder::EventForwarder()
+    : m_stream(0)
+    , m_nextSequence(1)
+    , m_random(std::random_device()())
+    , m_openEvents(0)
+    , m_openLastTimestamp(0)
+    , m_sealedBytes(0)
+    , m_stop(true)
+    , m_inFlight(0)
+    , m_memoryBytes(0)
+    , m_socket(Socket::kNoSocket)
+    , m_memory(MemorySubsystem::Forwarder)
+    , m_eventsSubmitted(0)
+    , m_eventsAcked(0)
+    , m_eventsDropped(0)
+    , m_batchesSent(0)
+    , m_batchesResent(0)
+    , m_batchesAcked(0)
+    , m_batchesSpooled(0)
+    , m_rawBytes(0)
+    , m_compressedBytes(0)
+    , m_bytesSent(0)
+    , m_connects(0)
+    , m_connectFailures(0)
+    , m_pendingCount(0)
+    , m_bufferedBytes(0)
+    , m_spooledBytes(0)
+    , m_connected(false) {
+}
+
+EventForwarder::~EventForwarder() {
+    Stop();
+}
+
+bool EventForwarder::Start(const ForwarderOptions& options) {
+    if (m_thread) {
+        return false;
+    }
+    m_options = options;
+    m_options.batchEvents = std::max<size_t>(m_options.batchEvents, 1);
+    m_options.window = std::max<size_t>(m_options.window, 1);
+    m_lastError.clear();
+    if (m_options.host.empty() || m_options.port == 0) {
+        m_lastError = "invalid collector endpoint";
+        return false;
+    }
+    if (!m_options.spoolPath.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(m_options.spoolPath, error);
+        if (!std::filesystem::is_directory(m_options.spoolPath, error)) {
+            m_lastError = "cannot create spool directory " + m_options.spoolPath;
+            return false;
+        }
+    }
+    if (!Socket::Init()) {
+        m_lastError = "cannot initialize sockets";
+        return false;
+    }
+    if (m_options.hostName.empty()) {
+        m_options.hostName = Socket::GetHostName();
+    }
+
+    // Later streams get higher IDs, so spooled batches sort oldest first
+    auto sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+    m_stream = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count());
+    m_nextSequence = 1;
+    m_pending.clear();
+    m_inFlight = 0;
+    m_memoryBytes = 0;
+    m_spooledBytes = 0;
+    LoadSpool();
+    UpdateGauges();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open.clear();
+        m_openEvents = 0;
+        m_sealed.clear();
+        m_sealedBytes = 0;
+        m_stop = false;
+    }
+    try {
+        m_thread = std::make_unique<std::thread>(&EventForwarder::Run, this);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_lastError = "cannot start thread";
+        Socket::Cleanup();
+        return false;
+    }
+    return true;
+}
+
+void EventForwarder::Stop() {
+    if (!m_thread) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_thread->joinable()) {
+        m_thread->join();
+    }
+    m_thread.reset();
+    Socket::Cleanup();
+}
+
+void EventForwarder::Submit(const DriverEvent& event) {
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop) {
+            return;
+        }
+        m_eventsSubmitted.fetch_add(1, std::memory_order_relaxed);
+        // The thread is not keeping up (a stalled send): hold no more than the buffer
+        if (m_sealedBytes + m_open.size() > m_options.bufferBytes) {
+            m_eventsDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (m_openEvents == 0) {
+            m_openSince = std::chrono::steady_clock::now();
+            m_openLastTimestamp = 0;
+            wake = true;                    // Arms the flush deadline
+        }
+        EncodeEvent(event, m_openLastTimestamp, m_open);
+        m_openEvents++;
+        if (m_openEvents >= m_options.batchEvents) {
+            SealOpenLocked();
+            wake = true;
+        }
+    }
+    if (wake) {
+        m_wake.notify_one();
+    }
+}
+
+void EventForwarder::SealOpenLocked() {
+    if (m_openEvents == 0) {
+        return;
+    }
+    m_sealedBytes += m_open.size();
+    m_sealed.push_back({ std::move(m_open), m_openEvents });
+    m_open = std::string();
+    m_open.reserve(m_sealed.back().events.size() + m_sealed.back().events.size() / 8);
+    m_openEvents = 0;
+}
+
+ForwarderStats EventForwarder::GetStats() const {
+    ForwarderStats stats;
+    stats.eventsSubmitted = m_eventsSubmitted.load(std::memory_order_relaxed);
+    stats.eventsAcked = m_eventsAcked.load(std::memory_order_relaxed);
+    stats.eventsDropped = m_eventsDropped.load(std::memory_order_relaxed);
+    stats.batchesSent = m_batchesSent.load(std::memory_order_relaxed);
+    stats.batchesResent = m_batchesResent.load(std::memory_order_relaxed);
+    stats.batchesAcked = m_batchesAcked.load(std::memory_order_relaxed);
+    stats.batchesSpooled = m_batchesSpooled.load(std::memory_order_relaxed);
+    stats.rawBytes = m_rawBytes.load(std::memory_order_relaxed);
+    stats.compressedBytes = m_compressedBytes.load(std::memory_order_relaxed);
+    stats.bytesSent = m_bytesSent.load(std::memory_order_relaxed);
+    stats.connects = m_connects.load(std::memory_order_relaxed);
+    stats.connectFailures = m_connectFailures.load(std::memory_order_relaxed);
+    stats.pendingBatches = m_pendingCount.load(std::memory_order_relaxed);
+    stats.bufferedBytes = m_bufferedBytes.load(std::memory_order_relaxed);
+    stats.spooledBytes = m_spooledBytes.load(std::memory_order_relaxed);
+    stats.connected = m_connected.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::string EventForwarder::GetLastError() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastError;
+}
+
+void EventForwarder::SetLastError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lastError = error;
+}
+
+void EventForwarder::EncodeBatch(uint64_t stream, uint64_t sequence, const std::vector<DriverEvent>& events, bool compress,
+                                 std::string& out) {
+    std::string encoded;
+    int64_t previousTimestamp = 0;
+    for (const auto& event : events) {
+        EncodeEvent(event, previousTimestamp, encoded);
+    }
+    AppendBatchFrame(stream, sequence, static_cast<uint32_t>(events.size()), encoded, compress, out);
+}
+
+bool EventForwarder::DecodeBatch(const char* payload, size_t length, ForwardBatch& batch) {
+    ForwardBatchReader reader;
+    std::string scratch;
+    if (!reader.Open(payload, length, scratch)) {
+        return false;
+    }
+    batch.stream = reader.GetStream();
+    batch.sequence = reader.GetSequence();
+    batch.events.resize(static_cast<size_t>(reader.GetEventCount()));
+    ForwardEventView view;
+    for (auto& event : batch.events) {
+        if (!reader.Next(view)) {
+            return false;
+        }
+        event.sequenceId = view.sequenceId;
+        event.timestampUs = view.timestampUs;
+        event.timestamp = Utils::FormatTimestamp(view.timestampUs);
+        event.eventType = view.eventType;
+        event.threatLevel = view.threatLevel;
+        event.source = view.source;
+        event.isRemoval = view.isRemoval;
+        event.processId = view.processId;
+        event.driverName.assign(view.driverName);
+        event.installPath.assign(view.installPath);
+        event.loadingMethod.assign(view.loadingMethod);
+        event.initiatedBy.assign(view.initiatedBy);
+        event.signerInfo.assign(view.signerInfo);
+    }
+    return true;
+}
+
+void EventForwarder::EncodeHello(const std::string& hostName, std::string& out) {
+    size_t frameStart = out.size();
+    out.append(4, '\0');
+    BinaryWriter writer(out);
+    writer.WriteByte(ForwardProtocol::kHello);
+    writer.WriteBytes(ForwardProtocol::kMagic, sizeof(ForwardProtocol::kMagic));
+    writer.WriteByte(ForwardProtocol::kVersion);
+    writer.WriteString(hostName);
+    WriteFrameLength(out, frameStart);
+}
+
+bool EventForwarder::DecodeHello(const char* payload, size_t length, std::string_view& hostName) {
+    BinaryReader reader(payload, length);
+    char magic[sizeof(ForwardProtocol::kMagic)];
+    if (reader.ReadByte() != ForwardProtocol::kHello || !reader.ReadBytes(magic, sizeof(magic)) ||
+        std::memcmp(magic, ForwardProtocol::kMagic, sizeof(magic)) != 0 ||
+        reader.ReadByte() != ForwardProtocol::kVersion) {
+        return false;
+    }
+    size_t nameLength;
+    const char* name = reader.ReadStringView(nameLength);
+    if (reader.HasError() || nameLength == 0) {
+        return false;
+    }
+    hostName = std::string_view(name, nameLength);
+    return true;
+}
+
+void EventForwarder::EncodeAck(uint64_t stream, uint64_t sequence, std::string& out) {
+    size_t frameStart = out.size();
+    out.append(4, '\0');
+    BinaryWriter writer(out);
+    writer.WriteByte(ForwardProtocol::kAck);
+    writer.WriteVarint(stream);
+    writer.WriteVarint(sequence);
+    WriteFrameLength(out, frameStart);
+}
+
+bool EventForwarder::DecodeAck(const char* payload, size_t length, uint64_t& stream, uint64_t& sequence) {
+    BinaryReader reader(payload, length);
+    if (reader.ReadByte() != ForwardProtocol::kAck) {
+        return false;
+    }
+    stream = reader.ReadVarint();
+    sequence = reader.ReadVarint();
+    return !reader.HasError();
+}
+
+void EventForwarder::Run() {
+    Tracer::SetThreadName("forwarder");
+    auto backoff = m_options.minBackoff;
+    auto nextConnect = std::chrono::steady_clock::now();
+
+    // Failed attempt or lost connection: next try after the backoff, +-25% jitter
+    auto scheduleReconnect = [&]() {
+        std::uniform_real_distribution<double> jitter(0.75, 1.25);
+        auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(backoff * jitter(m_random));
+        nextConnect = std::chrono::steady_clock::now() + delay;
+        backoff = std::min(backoff * 2, m_options.maxBackoff);
+    };
+
+    for (;;) {
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            stopping = m_stop;
+            if (m_openEvents > 0 && (stopping || std::chrono::steady_clock::now() - m_openSince >= m_options.flushInterval)) {
+                SealOpenLocked();
+            }
+        }
+        TakeSealed();
+        UpdateGauges();
+        if (stopping) {
+            break;
+        }
+
+        if (m_socket == Socket::kNoSocket && std::chrono::steady_clock::now() >= nextConnect) {
+            if (!Connect()) {
+                m_connectFailures.fetch_add(1, std::memory_order_relaxed);
+                scheduleReconnect();
+            }
+        }
+
+        if (m_socket != Socket::kNoSocket) {
+            if (!SendPending()) {
+                Disconnect();
+                scheduleReconnect();
+                continue;
+            }
+            if (m_inFlight > 0) {
+                size_t acked = 0;
+                if (Socket::WaitReadable(m_socket, kAckPollInterval) && !ReadAcks(acked)) {
+                    Disconnect();
+                    scheduleReconnect();
+                    continue;
+                }
+                if (acked > 0) {
+                    backoff = m_options.minBackoff;
+                }
+                continue;
+            }
+        }
+
+        // Nothing in flight: sleep until a batch is sealed, the open batch is
+        // due, the next connection attempt or Stop()
+        auto deadline = m_socket == Socket::kNoSocket ? nextConnect : std::chrono::steady_clock::time_point::max();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop && m_sealed.empty()) {
+            auto until = deadline;
+            if (m_openEvents > 0) {
+                until = std::min(until, m_openSince + m_options.flushInterval);
+            }
+            if (std::chrono::steady_clock::now() >= until) {
+                break;
+            }
+            if (until == std::chrono::steady_clock::time_point::max()) {
+                m_wake.wait(lock);
+            } else {
+                m_wake.wait_until(lock, until);
+            }
+        }
+    }
+
+    // Give the collector a chance to take the rest (one more connection
+    // attempt unless it is backing off: a collector known to be down is not
+    // waited for)
+    auto drainEnd = std::chrono::steady_clock::now() + m_options.drainTimeout;
+    if (m_socket == Socket::kNoSocket && !m_pending.empty() && std::chrono::steady_clock::now() >= nextConnect &&
+        !Connect()) {
+        m_connectFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+    while (m_socket != Socket::kNoSocket && !m_pending.empty() && std::chrono::steady_clock::now() < drainEnd) {
+        size_t acked = 0;
+        if (!SendPending() || (Socket::WaitReadable(m_socket, kAckPollInterval) && !ReadAcks(acked))) {
+            break;
+        }
+    }
+    Disconnect();
+
+    // Whatever is left waits in the spool for the next run
+    for (auto& batch : m_pending) {
+        if (batch.spooled) {
+            continue;
+        }
+        if (m_options.spoolPath.empty() || !SpoolBatch(batch)) {
+            m_eventsDropped.fetch_add(batch.events, std::memory_order_relaxed);
+        }
+    }
+    m_pending.clear();
+    m_memoryBytes = 0;
+    UpdateGauges();
+}
+
+void EventForwarder::TakeSealed() {
+    std::vector<RawBatch> sealed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_sealed.empty()) {
+            return;
+        }
+        sealed.swap(m_sealed);
+        m_sealedBytes = 0;
+    }
+
+    for (auto& raw : sealed) {
+        DM_TRACE_SPAN("compressBatch", "forward");
+        PendingBatch batch;
+        batch.stream = m_stream;
+        batch.sequence = m_nextSequence++;
+        batch.events = raw.count;
+        size_t payload = AppendBatchFrame(batch.stream, batch.sequence, raw.count, raw.events, m_options.compress, batch.frame);
+        batch.frameSize = batch.frame.size();
+        batch.spooled = false;
+        batch.sentBefore = false;
+        m_rawBytes.fetch_add(raw.events.size(), std::memory_order_relaxed);
+        m_compressedBytes.fetch_add(payload, std::memory_order_relaxed);
+        m_memoryBytes += batch.frameSize;
+        m_pending.push_back(std::move(batch));
+    }
+    EnforceLimits();
+}
+
+void EventForwarder::EnforceLimits() {
+    // Over the memory limit: spool the newest batches (they are sent last);
+    // without a spool, or if it cannot be written, drop the oldest unsent ones
+    for (size_t index = m_pending.size(); m_memoryBytes > m_options.bufferBytes && index > m_inFlight;) {
+        PendingBatch& batch = m_pending[--index];
+        if (!batch.frame.empty() && !m_options.spoolPath.empty()) {
+            SpoolBatch(batch);
+        }
+    }
+    size_t index = m_inFlight;
+    while (m_memoryBytes > m_options.bufferBytes && index < m_pending.size()) {
+        if (m_pending[index].frame.empty()) {
+            index++;
+        } else {
+            DropBatch(index);
+        }
+    }
+
+    // Spool over its limit: drop the oldest spooled batches
+    index = m_inFlight;
+    while (m_spooledBytes.load(std::memory_order_relaxed) > m_options.spoolBytes && index < m_pending.size()) {
+        if (m_pending[index].spooled) {
+            DropBatch(index);
+        } else {
+            index++;
+        }
+    }
+}
+
+void EventForwarder::DropBatch(size_t index) {
+    PendingBatch& batch = m_pending[index];
+    m_eventsDropped.fetch_add(batch.events, std::memory_order_relaxed);
+    m_memoryBytes -= batch.frame.size();
+    if (batch.spooled) {
+        RemoveSpooled(batch);
+    }
+    m_pending.erase(m_pending.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+bool EventForwarder::Connect() {
+    std::string error;
+    m_socket = Socket::Connect(m_options.host, m_options.port, m_options.connectTimeout, m_options.sendTimeout, error);
+    if (m_socket == Socket::kNoSocket) {
+        SetLastError(error);
+        return false;
+    }
+
+    std::string hello;
+    EncodeHello(m_options.hostName, hello);
+    if (!Socket::SendAll(m_socket, hello.data(), hello.size())) {
+        Socket::Close(m_socket);
+        m_socket = Socket::kNoSocket;
+        SetLastError("collector closed the connection");
+        return false;
+    }
+
+    m_reader = ForwardFrameReader();
+    m_inFlight = 0;
+    m_connects.fetch_add(1, std::memory_order_relaxed);
+    m_connected.store(true, std::memory_order_relaxed);
+    SetLastError(std::string());
+    return true;
+}
+
+void EventForwarder::Disconnect() {
+    if (m_socket == Socket::kNoSocket) {
+        return;
+    }
+    Socket::Close(m_socket);
+    m_socket = Socket::kNoSocket;
+    for (size_t i = 0; i < m_inFlight && i < m_pending.size(); ++i) {
+        m_pending[i].sentBefore = true;
+    }
+    m_inFlight = 0;
+    m_connected.store(false, std::memory_order_relaxed);
+}
+
+bool EventForwarder::SendPending() {
+    while (m_inFlight < m_options.window && m_inFlight < m_pending.size()) {
+        PendingBatch& batch = m_pending[m_inFlight];
+        if (batch.frame.empty() && !LoadSpooled(batch)) {
+            DropBatch(m_inFlight);
+            continue;
+        }
+        {
+            DM_TRACE_SPAN("sendBatch", "forward");
+            if (!Socket::SendAll(m_socket, batch.frame.data(), batch.frame.size())) {
+                SetLastError("lost the connection to the collector");
+                return false;
+            }
+        }
+        m_batchesSent.fetch_add(1, std::memory_order_relaxed);
+        m_bytesSent.fetch_add(batch.frame.size(), std::memory_order_relaxed);
+        if (batch.sentBefore) {
+            m_batchesResent.fetch_add(1, std::memory_order_relaxed);
+        }
+        // A spooled batch is read again if it has to be resent
+        if (batch.spooled) {
+            m_memoryBytes -= batch.frame.size();
+            std::string().swap(batch.frame);
+        }
+        m_inFlight++;
+    }
+    return true;
+}
+
+bool EventForwarder::ReadAcks(size_t& acked) {
+    char buffer[4096];
+    int received = Socket::Receive(m_socket, buffer, sizeof(buffer));
+    if (received <= 0) {
+        SetLastError("collector closed the connection");
+        return false;
+    }
+    m_reader.Append(buffer, static_cast<size_t>(received));
+
+    const char* payload;
+    size_t length;
+    uint64_t stream;
+    uint64_t sequence;
+    while (m_reader.Next(payload, length)) {
+        if (DecodeAck(payload, length, stream, sequence)) {
+            acked += ApplyAck(stream, sequence);
+        }
+    }
+    if (m_reader.HasError()) {
+        SetLastError("malformed frame from the collector");
+        return false;
+    }
+    UpdateGauges();
+    return true;
+}
+
+size_t EventForwarder::ApplyAck(uint64_t stream, uint64_t sequence) {
+    size_t acked = 0;
+    while (m_inFlight > 0 && m_pending.front().stream == stream && m_pending.front().sequence <= sequence) {
+        PendingBatch& batch = m_pending.front();
+        m_eventsAcked.fetch_add(batch.events, std::memory_order_relaxed);
+        m_batchesAcked.fetch_add(1, std::memory_order_relaxed);
+        m_memoryBytes -= batch.frame.size();
+        if (batch.spooled) {
+            RemoveSpooled(batch);
+        }
+        m_pending.pop_front();
+        m_inFlight--;
+        acked++;
+    }
+    return acked;
+}
+
+std::string EventForwarder::GetSpoolFile(uint64_t stream, uint64_t sequence) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%016llx%s", static_cast<unsigned long long>(stream),
+                  static_cast<unsigned long long>(sequence), kSpoolExtension);
+    return (std::filesystem::path(m_options.spoolPath) / name).string();
+}
+
+bool EventForwarder::SpoolBatch(PendingBatch& batch) {
+    DM_TRACE_SPAN("spoolBatch", "forward");
+    std::string path = GetSpoolFile(batch.stream, batch.sequence);
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(batch.frame.data(), static_cast<std::streamsize>(batch.frame.size()));
+        if (!file) {
+            file.close();
+            std::remove(temporaryPath.c_str());
+            SetLastError("cannot write spool file " + temporaryPath);
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::remove(temporaryPath.c_str());
+        SetLastError("cannot write spool file " + path);
+        return false;
+    }
+    batch.spooled = true;
+    m_memoryBytes -= batch.frame.size();
+    std::string().swap(batch.frame);
+    m_spooledBytes.fetch_add(batch.frameSize, std::memory_order_relaxed);
+    m_batchesSpooled.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool EventForwarder::LoadSpooled(PendingBatch& batch) {
+    std::ifstream file(GetSpoolFile(batch.stream, batch.sequence), std::ios::binary);
+    batch.frame.resize(batch.frameSize);
+    if (!file.read(&batch.frame[0], static_cast<std::streamsize>(batch.frameSize)) ||
+        ReadFrameLength(batch.frame.data()) + 4 != batch.frameSize) {
+        std::string().swap(batch.frame);
+        SetLastError("cannot read spool file " + GetSpoolFile(batch.stream, batch.sequence));
+        return false;
+    }
+    m_memoryBytes += batch.frameSize;
+    return true;
+}
+
+void EventForwarder::RemoveSpooled(const PendingBatch& batch) {
+    std::remove(GetSpoolFile(batch.stream, batch.sequence).c_str());
+    m_spooledBytes.fetch_sub(batch.frameSize, std::memory_order_relaxed);
+}
+
+void EventForwarder::LoadSpool() {
+    if (m_options.spoolPath.empty()) {
+        return;
+    }
+
+    // Only the batch header is read now; frames are read when they are sent
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(m_options.spoolPath, error)) {
+        PendingBatch batch;
+        std::string name = entry.path().filename().string();
+        if (!ParseSpoolName(name, batch.stream, batch.sequence)) {
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0) {
+                std::filesystem::remove(entry.path(), error);   // Interrupted spool write
+            }
+            continue;
+        }
+        char header[64];
+        std::ifstream file(entry.path(), std::ios::binary);
+        file.read(header, sizeof(header));
+        size_t headerLength = static_cast<size_t>(file.gcount());
+        BinaryReader reader(header + 4, headerLength >= 4 ? headerLength - 4 : 0);
+        uint8_t type = reader.ReadByte();
+        uint64_t stream = reader.ReadVarint();
+        uint64_t sequence = reader.ReadVarint();
+        uint64_t events = reader.ReadVarint();
+        uint64_t size = entry.file_size(error);
+        if (headerLength < 4 || reader.HasError() || type != ForwardProtocol::kBatch || stream != batch.stream ||
+            sequence != batch.sequence || error || ReadFrameLength(header) + 4 != size) {
+            SetLastError("skipped corrupt spool file " + name);
+            continue;
+        }
+        batch.events = static_cast<uint32_t>(events);
+        batch.frameSize = static_cast<size_t>(size);
+        batch.spooled = true;
+        batch.sentBefore = true;            // It may have reached the collector before the restart
+        m_spooledBytes.fetch_add(batch.frameSize, std::memory_order_relaxed);
+        m_pending.push_back(std::move(batch));
+    }
+    std::sort(m_pending.begin(), m_pending.end(), [](const PendingBatch& a, const PendingBatch& b) {
+        return a.stream != b.stream ? a.stream < b.stream : a.sequence < b.sequence;
+    });
+}
+
+void EventForwarder::UpdateGauges() {
+    size_t queued;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        queued = m_sealedBytes + m_open.capacity();
+    }
+    m_pendingCount.store(m_pending.size(), std::memory_order_relaxed);
+    m_bufferedBytes.store(m_memoryBytes, std::memory_order_relaxed);
+    m_memory.Set(m_memoryBytes + queued + m_pending.size() * sizeof(PendingBatch));
+}
+
+} // namespace DriverMonitor
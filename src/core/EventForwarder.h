@@ -0,0 +1,336 @@
+#pragma once
+
+#include "Utils.h"
+#include "BinaryCodec.h"
+#include "MemoryAccounting.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Forwarding protocol (TCP, little endian, LEB128 varints). Both directions
+// are frames: fixed32 payload length, then the payload, whose first byte is
+// the frame type.
+//
+// A forwarder numbers its batches 1, 2, ... within a stream (an ID taken
+// from the time the forwarder started, so streams sort by age; batches
+// spooled by an earlier run keep theirs). The collector acknowledges the
+// highest batch of a stream it has stored; anything unacknowledged is sent
+// again after a reconnect, so the collector sees every batch at least once
+// and drops those at or below the stream's acknowledged sequence.
+namespace ForwardProtocol {
+    const char kMagic[4] = { 'D', 'M', 'F', 'W' };
+    const uint8_t kVersion = 1;
+    const uint32_t kMaxFrameSize = 16 << 20;
+
+    enum FrameType : uint8_t {
+        // Forwarder, first frame: magic, u8 version, str host name
+        kHello = 1,
+        // Forwarder: varint stream, varint sequence, varint events, u8 codec,
+        // varint raw size, then the (compressed) events. Each event: varint
+        // sequence ID, signed varint timestamp (us, delta from the previous
+        // event), u8 type, u8 threat, u8 source, u8 flags, varint process ID,
+        // str name, str path, str method, str initiatedBy, str signer
+        kBatch = 2,
+        // Collector: varint stream, varint sequence (every batch of the
+        // stream up to it is stored)
+        kAck = 3
+    };
+
+    enum Codec : uint8_t {
+        kRaw = 0,
+        kLz = 1                 // See Compression.h
+    };
+
+    const uint8_t kFlagRemoval = 1;
+}
+
+// One decoded batch frame
+struct ForwardBatch {
+    uint64_t stream;
+    uint64_t sequence;
+    std::vector<DriverEvent> events;
+
+    ForwardBatch() : stream(0), sequence(0) {}
+};
+
+// Splits a byte stream into frames. Bytes can be received straight into
+// the buffer (Reserve + Commit) so frames are parsed where they landed.
+class ForwardFrameReader {
+public:
+    ForwardFrameReader() : m_begin(0), m_end(0), m_error(false) {}
+
+    void Append(const char* data, size_t length);
+
+    // Room for at least minimum more bytes at the end of the buffer; Commit
+    // the bytes written there. Invalidates payloads returned by Next().
+    char* Reserve(size_t minimum, size_t& available);
+    void Commit(size_t length) { m_end += length; }
+
+    // Next complete frame payload (valid until the next Append or Reserve);
+    // false when more bytes are needed or the stream is corrupt (HasError)
+    bool Next(const char*& payload, size_t& length);
+
+    bool HasError() const { return m_error; }
+
+    // Bytes received but not returned as frames yet
+    size_t GetBufferedBytes() const { return m_end - m_begin; }
+
+private:
+    std::string m_buffer;           // Used as a byte array; [m_begin, m_end) is unread
+    size_t m_begin;
+    size_t m_end;
+    bool m_error;
+};
+
+// One event of a batch, decoded in place: the strings point into the batch
+// payload (or into the buffer it was decompressed to)
+struct ForwardEventView {
+    uint64_t sequenceId;
+    int64_t timestampUs;
+    EventType eventType;
+    ThreatLevel threatLevel;
+    EventSource source;
+    bool isRemoval;
+    unsigned long processId;
+    std::string_view driverName;
+    std::string_view installPath;
+    std::string_view loadingMethod;
+    std::string_view initiatedBy;
+    std::string_view signerInfo;
+};
+
+// Decodes a batch frame payload without copying it. A compressed payload is
+// decompressed once into a buffer the caller owns (and reuses).
+class ForwardBatchReader {
+public:
+    ForwardBatchReader();
+
+    // Read the header; false if the payload is not a well-formed batch
+    bool Open(const char* payload, size_t length, std::string& scratch);
+
+    uint64_t GetStream() const { return m_stream; }
+    uint64_t GetSequence() const { return m_sequence; }
+    uint64_t GetEventCount() const { return m_count; }
+
+    // Next event; false after the last one, or if an event is malformed (HasError)
+    bool Next(ForwardEventView& event);
+
+    bool HasError() const { return m_error; }
+
+private:
+    BinaryReader m_reader;
+    uint64_t m_stream;
+    uint64_t m_sequence;
+    uint64_t m_count;
+    uint64_t m_remaining;
+    int64_t m_timestamp;
+    bool m_error;
+};
+
+struct ForwarderOptions {
+    std::string host;
+    uint16_t port;
+    std::string hostName;                   // Sent in the hello ("" = this machine's name)
+    std::string spoolPath;                  // Spool directory ("" = none: drop when full)
+    size_t batchEvents;                     // Events per batch
+    std::chrono::milliseconds flushInterval; // A partial batch is sent after this long
+    size_t bufferBytes;                     // Batches held in memory before spooling
+    uint64_t spoolBytes;                    // Spool size limit; the oldest batches go first
+    size_t window;                          // Batches sent without an acknowledgement
+    bool compress;
+    std::chrono::milliseconds connectTimeout;
+    std::chrono::milliseconds sendTimeout;  // A collector that stops reading is dropped
+    std::chrono::milliseconds minBackoff;   // Reconnect delay, doubled per failure
+    std::chrono::milliseconds maxBackoff;
+    std::chrono::milliseconds drainTimeout; // Stop() waits this long for acknowledgements
+
+    ForwarderOptions()
+        : port(0), batchEvents(256), flushInterval(1000), bufferBytes(4 << 20), spoolBytes(256ULL << 20),
+          window(32), compress(true), connectTimeout(2000), sendTimeout(5000), minBackoff(100),
+          maxBackoff(30000), drainTimeout(2000) {}
+};
+
+struct ForwarderStats {
+    uint64_t eventsSubmitted;
+    uint64_t eventsAcked;
+    uint64_t eventsDropped;                 // Buffer full without a spool, or spool over its limit
+    uint64_t batchesSent;                   // Including resends
+    uint64_t batchesResent;
+    uint64_t batchesAcked;
+    uint64_t batchesSpooled;
+    uint64_t rawBytes;                      // Encoded events before compression
+    uint64_t compressedBytes;               // Batch payloads after compression
+    uint64_t bytesSent;
+    uint64_t connects;
+    uint64_t connectFailures;
+    size_t pendingBatches;                  // Not acknowledged yet (memory and spool)
+    size_t bufferedBytes;                   // Pending batches held in memory
+    uint64_t spooledBytes;
+    bool connected;
+
+    ForwarderStats()
+        : eventsSubmitted(0), eventsAcked(0), eventsDropped(0), batchesSent(0), batchesResent(0), batchesAcked(0),
+          batchesSpooled(0), rawBytes(0), compressedBytes(0), bytesSent(0), connects(0), connectFailures(0),
+          pendingBatches(0), bufferedBytes(0), spooledBytes(0), connected(false) {}
+};
+
+// Ships stored events to a collector in batched, compressed frames.
+//
+// Submit() appends the event to the open batch under a short lock (the
+// pipeline thread never waits for the network). The forwarder thread seals
+// batches (full, or after the flush interval), compresses them and sends
+// up to window of them ahead of the acknowledgements. Pending batches
+// beyond bufferBytes, and everything still pending at Stop(), go to the
+// spool directory (one file per batch, written through a temporary file and
+// a rename); a later forwarder on the same directory sends them first.
+// Failed connections are retried after a backoff doubling from minBackoff
+// to maxBackoff, with jitter.
+class EventForwarder {
+public:
+    EventForwarder();
+    ~EventForwarder();
+
+    // Load the spool and start the thread; false + GetLastError() on failure
+    bool Start(const ForwarderOptions& options);
+
+    // Seal the open batch, wait up to drainTimeout for acknowledgements,
+    // spool what is left and stop the thread
+    void Stop();
+
+    bool IsRunning() const { return m_thread != nullptr; }
+
+    // Queue one stored event (any thread)
+    void Submit(const DriverEvent& event);
+
+    ForwarderStats GetStats() const;
+
+    // Last connection or spool error ("" if none)
+    std::string GetLastError() const;
+
+    // Encode one batch frame (length prefix included) into out
+    static void EncodeBatch(uint64_t stream, uint64_t sequence, const std::vector<DriverEvent>& events, bool compress,
+                            std::string& out);
+
+    // Decode a batch frame payload (after the length prefix) into owned
+    // events; see ForwardBatchReader to decode in place
+    static bool DecodeBatch(const char* payload, size_t length, ForwardBatch& batch);
+
+    // Encode a hello frame (length prefix included) into out
+    static void EncodeHello(const std::string& hostName, std::string& out);
+
+    // Decode a hello frame payload; hostName points into it. False if it is
+    // not a hello of this protocol version or names no host.
+    static bool DecodeHello(const char* payload, size_t length, std::string_view& hostName);
+
+    // Encode an acknowledgement frame (length prefix included) into out
+    static void EncodeAck(uint64_t stream, uint64_t sequence, std::string& out);
+
+    // Decode an acknowledgement frame payload; false if it is not one
+    static bool DecodeAck(const char* payload, size_t length, uint64_t& stream, uint64_t& sequence);
+
+private:
+    struct PendingBatch {
+        uint64_t stream;
+        uint64_t sequence;
+        uint32_t events;
+        std::string frame;                  // Empty while only in the spool
+        size_t frameSize;
+        bool spooled;                       // Has a spool file
+        bool sentBefore;                    // Sent on an earlier connection
+    };
+
+    ForwarderOptions m_options;
+    std::unique_ptr<std::thread> m_thread;
+    uint64_t m_stream;
+    uint64_t m_nextSequence;
+    std::mt19937_64 m_random;
+
+    // Open batch and sealed raw batches, filled by Submit()
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::string m_open;                     // Encoded events of the open batch
+    uint32_t m_openEvents;
+    int64_t m_openLastTimestamp;
+    std::chrono::steady_clock::time_point m_openSince;
+    struct RawBatch {
+        std::string events;
+        uint32_t count;
+    };
+    std::vector<RawBatch> m_sealed;
+    size_t m_sealedBytes;
+    bool m_stop;
+    std::string m_lastError;
+
+    // Forwarder thread only. The first m_inFlight pending batches have been
+    // sent on the current connection; the rest are sent in order.
+    std::deque<PendingBatch> m_pending;
+    size_t m_inFlight;
+    size_t m_memoryBytes;                   // Frames of pending batches held in memory
+    intptr_t m_socket;
+    ForwardFrameReader m_reader;
+    std::string m_scratch;
+
+    MemoryCharge m_memory;
+
+    std::atomic<uint64_t> m_eventsSubmitted;
+    std::atomic<uint64_t> m_eventsAcked;
+    std::atomic<uint64_t> m_eventsDropped;
+    std::atomic<uint64_t> m_batchesSent;
+    std::atomic<uint64_t> m_batchesResent;
+    std::atomic<uint64_t> m_batchesAcked;
+    std::atomic<uint64_t> m_batchesSpooled;
+    std::atomic<uint64_t> m_rawBytes;
+    std::atomic<uint64_t> m_compressedBytes;
+    std::atomic<uint64_t> m_bytesSent;
+    std::atomic<uint64_t> m_connects;
+    std::atomic<uint64_t> m_connectFailures;
+    std::atomic<size_t> m_pendingCount;
+    std::atomic<size_t> m_bufferedBytes;
+    std::atomic<uint64_t> m_spooledBytes;
+    std::atomic<bool> m_connected;
+
+    void Run();
+
+    // Move the open batch to the sealed list (m_mutex held)
+    void SealOpenLocked();
+
+    // Compress sealed batches into pending frames; keep memory within bufferBytes
+    void TakeSealed();
+
+    bool Connect();
+    void Disconnect();
+
+    // Send pending batches up to the window; false if the connection failed
+    bool SendPending();
+
+    // Read and apply acknowledgements; false if the connection failed
+    bool ReadAcks(size_t& acked);
+    size_t ApplyAck(uint64_t stream, uint64_t sequence);
+
+    // Spool files: <spool>/<stream>-<sequence>.batch (hexadecimal)
+    std::string GetSpoolFile(uint64_t stream, uint64_t sequence) const;
+    bool SpoolBatch(PendingBatch& batch);
+    bool LoadSpooled(PendingBatch& batch);
+    void RemoveSpooled(const PendingBatch& batch);
+    void LoadSpool();
+
+    // Keep memory within bufferBytes (spool or drop) and the spool within spoolBytes
+    void EnforceLimits();
+    void DropBatch(size_t index);
+
+    void UpdateGauges();
+    void SetLastError(const std::string& error);
+};
+
+} // namespace DriverMonitor
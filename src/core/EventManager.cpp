@@ -1,24 +1,52 @@
 #include "EventManager.h"
 #include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace {
+    // Element plus the heap buffers of its strings
+    size_t GetEventBytes(const DriverMonitor::DriverEvent& event) {
+        using DriverMonitor::MemoryAccounting;
+        return sizeof(DriverMonitor::DriverEvent) +
+               MemoryAccounting::GetHeapBytes(event.driverName) + MemoryAccounting::GetHeapBytes(event.installPath) +
+               MemoryAccounting::GetHeapBytes(event.loadingMethod) + MemoryAccounting::GetHeapBytes(event.initiatedBy) +
+               MemoryAccounting::GetHeapBytes(event.signerInfo) + MemoryAccounting::GetHeapBytes(event.timestamp);
+    }
+}
 
 namespace DriverMonitor {
 
 EventManager::EventManager() 
-    : m_lastReadIndex(0)
+    : m_firstSequence(1)
+    , m_lastReadSequence(0)
     , m_maxEvents(1000)
+    , m_historyId(0)
+    , m_memory(MemorySubsystem::EventHistory)
     , m_signedCount(0)
     , m_unsignedCount(0)
     , m_suspiciousCount(0) {
+    std::random_device device;
+    m_historyId = (static_cast<uint64_t>(device()) << 32 | device()) ^
+                  static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
 }
 
 EventManager::~EventManager() {
 }
 
-void EventManager::AddEvent(const DriverEvent& event) {
+uint64_t EventManager::AddEvent(const DriverEvent& event) {
+    uint64_t sequence = StoreEvent(event);
+    m_changes.Notify();
+    return sequence;
+}
+
+uint64_t EventManager::StoreEvent(const DriverEvent& event) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
     // Add event
+    uint64_t sequence = m_firstSequence + m_events.size();
     m_events.push_back(event);
+    m_events.back().sequenceId = sequence;
+    m_memory.Add(GetEventBytes(m_events.back()));
     
     // Update statistics
     switch (event.eventType) {
@@ -35,33 +63,15 @@ void EventManager::AddEvent(const DriverEvent& event) {
     
     // Enforce max events limit
     if (m_events.size() > static_cast<size_t>(m_maxEvents)) {
-        // Remove oldest event
-        EventType removedType = m_events.front().eventType;
-        m_events.erase(m_events.begin());
-        
-        // Update statistics
-        switch (removedType) {
-            case EventType::Signed:
-                if (m_signedCount > 0) m_signedCount--;
-                break;
-            case EventType::Unsigned:
-                if (m_unsignedCount > 0) m_unsignedCount--;
-                break;
-            case EventType::Suspicious:
-                if (m_suspiciousCount > 0) m_suspiciousCount--;
-                break;
-        }
-        
-        // Adjust read index if necessary
-        if (m_lastReadIndex > 0) {
-            m_lastReadIndex--;
-        }
+        EvictOldest();
     }
+    
+    return sequence;
 }
 
 std::vector<DriverEvent> EventManager::GetEvents() const {
     std::lock_guard<std::mutex> lock(m_mutex);
-    return m_events;
+    return std::vector<DriverEvent>(m_events.begin(), m_events.end());
 }
 
 std::vector<DriverEvent> EventManager::GetNewEvents() {
@@ -69,23 +79,30 @@ std::vector<DriverEvent> EventManager::GetNewEvents() {
     
     std::vector<DriverEvent> newEvents;
     
-    if (m_lastReadIndex < m_events.size()) {
+    uint64_t next = m_firstSequence + m_events.size();
+    uint64_t from = std::max(m_lastReadSequence + 1, m_firstSequence);
+    if (from < next) {
         newEvents.insert(newEvents.end(), 
-                        m_events.begin() + m_lastReadIndex, 
+                        m_events.begin() + static_cast<ptrdiff_t>(from - m_firstSequence), 
                         m_events.end());
-        m_lastReadIndex = m_events.size();
     }
+    m_lastReadSequence = next - 1;
     
     return newEvents;
 }
 
 void EventManager::Clear() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_events.clear();
-    m_lastReadIndex = 0;
-    m_signedCount = 0;
-    m_unsignedCount = 0;
-    m_suspiciousCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_firstSequence += m_events.size();
+        m_events.clear();
+        m_memory.Set(0);
+        m_lastReadSequence = m_firstSequence - 1;
+        m_signedCount = 0;
+        m_unsignedCount = 0;
+        m_suspiciousCount = 0;
+    }
+    m_changes.Notify();
 }
 
 size_t EventManager::GetEventCount() const {
@@ -93,6 +110,26 @@ size_t EventManager::GetEventCount() const {
     return m_events.size();
 }
 
+bool EventManager::GetEvent(uint64_t sequence, DriverEvent& event) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (sequence < m_firstSequence || sequence >= m_firstSequence + m_events.size()) {
+        return false;
+    }
+    event = m_events[static_cast<size_t>(sequence - m_firstSequence)];
+    return true;
+}
+
+uint64_t EventManager::GetFirstSequence() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_firstSequence;
+}
+
+uint64_t EventManager::GetNextSequence() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_firstSequence + m_events.size();
+}
+
 int EventManager::GetSignedCount() const {
     std::lock_guard<std::mutex> lock(m_mutex);
     return m_signedCount;
@@ -109,30 +146,57 @@ int EventManager::GetSuspiciousCount() const {
 }
 
 void EventManager::SetMaxEvents(int maxEvents) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_maxEvents = maxEvents;
-    
-    // Trim events if necessary
-    while (m_events.size() > static_cast<size_t>(m_maxEvents)) {
-        EventType removedType = m_events.front().eventType;
-        m_events.erase(m_events.begin());
+    bool trimmed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxEvents = maxEvents;
         
-        switch (removedType) {
-            case EventType::Signed:
-                if (m_signedCount > 0) m_signedCount--;
-                break;
-            case EventType::Unsigned:
-                if (m_unsignedCount > 0) m_unsignedCount--;
-                break;
-            case EventType::Suspicious:
-                if (m_suspiciousCount > 0) m_suspiciousCount--;
-                break;
+        // Trim events if necessary
+        while (m_events.size() > static_cast<size_t>(m_maxEvents)) {
+            EvictOldest();
+            trimmed = true;
         }
-        
-        if (m_lastReadIndex > 0) {
-            m_lastReadIndex--;
+    }
+    if (trimmed) {
+        m_changes.Notify();
+    }
+}
+
+size_t EventManager::EvictOldestBytes(size_t bytes) {
+    size_t evicted = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t target = m_memory.Get() > bytes ? m_memory.Get() - bytes : 0;
+        while (!m_events.empty() && m_memory.Get() > target) {
+            EvictOldest();
+            evicted++;
         }
     }
+    if (evicted > 0) {
+        m_changes.Notify();
+    }
+    return evicted;
+}
+
+void EventManager::EvictOldest() {
+    // Remove oldest event
+    EventType removedType = m_events.front().eventType;
+    m_memory.Subtract(GetEventBytes(m_events.front()));
+    m_events.pop_front();
+    m_firstSequence++;
+    
+    // Update statistics
+    switch (removedType) {
+        case EventType::Signed:
+            if (m_signedCount > 0) m_signedCount--;
+            break;
+        case EventType::Unsigned:
+            if (m_unsignedCount > 0) m_unsignedCount--;
+            break;
+        case EventType::Suspicious:
+            if (m_suspiciousCount > 0) m_suspiciousCount--;
+            break;
+    }
 }
 
 } // namespace DriverMonitor
@@ -1,20 +1,27 @@
 #pragma once
 
 #include "Utils.h"
+#include "ChangeNotifier.h"
+#include "MemoryAccounting.h"
+#include <algorithm>
+#include <cstdint>
+#include <deque>
 #include <vector>
 #include <mutex>
-#include <queue>
 #include <memory>
 
 namespace DriverMonitor {
 
+// Bounded event history. Every stored event gets a sequence ID one above the
+// previous one, so the live history is always the contiguous range
+// [GetFirstSequence(), GetNextSequence()) and a lookup by ID is an index.
 class EventManager {
 public:
     EventManager();
     ~EventManager();
     
-    // Add event to queue
-    void AddEvent(const DriverEvent& event);
+    // Add event to queue; returns the assigned sequence ID
+    uint64_t AddEvent(const DriverEvent& event);
     
     // Get all events
     std::vector<DriverEvent> GetEvents() const;
@@ -22,12 +29,28 @@ public:
     // Get events since last call (for incremental updates)
     std::vector<DriverEvent> GetNewEvents();
     
-    // Clear all events
+    // Clear all events (sequence IDs keep increasing)
     void Clear();
     
     // Get event count
     size_t GetEventCount() const;
     
+    // Sequence ID of the oldest stored event, and one past the newest
+    uint64_t GetFirstSequence() const;
+    uint64_t GetNextSequence() const;
+    
+    // Copy one stored event by sequence ID into event (reusing its string
+    // buffers); false if the ID was evicted or never assigned
+    bool GetEvent(uint64_t sequence, DriverEvent& event) const;
+    
+    // Visit stored events with sequence in [from, to) under the lock; visit(const DriverEvent&)
+    template <typename Visitor>
+    void VisitRange(uint64_t from, uint64_t to, Visitor visit) const;
+    
+    // Visit the stored events among a list of sequence IDs (evicted IDs are skipped)
+    template <typename Iterator, typename Visitor>
+    void VisitSequences(Iterator first, Iterator last, Visitor visit) const;
+    
     // Get statistics
     int GetSignedCount() const;
     int GetUnsignedCount() const;
@@ -36,16 +59,71 @@ public:
     // Set maximum event count
     void SetMaxEvents(int maxEvents);
     
+    // Bytes held by the stored events (charged to MemorySubsystem::EventHistory)
+    size_t GetMemoryBytes() const { return m_memory.Get(); }
+    
+    // Evict the oldest events until at least bytes are freed (memory budget);
+    // returns the number of events evicted
+    size_t EvictOldestBytes(size_t bytes);
+    
+    // Random ID of this history instance; sequence IDs are only comparable
+    // between cursors carrying the same history ID
+    uint64_t GetHistoryId() const { return m_historyId; }
+    
+    // Change generation: bumped by every add, eviction by SetMaxEvents and Clear
+    uint64_t GetChangeGeneration() const { return m_changes.GetGeneration(); }
+    
+    // Wait (up to timeout) for a change after generation; see ChangeNotifier
+    bool WaitForChange(uint64_t& generation, std::chrono::milliseconds timeout) const {
+        return m_changes.WaitForChange(generation, timeout);
+    }
+    
+    // Notifier of history changes (to arm a listener, or wake waiters)
+    ChangeNotifier& GetChangeNotifier() const { return m_changes; }
+    
 private:
     mutable std::mutex m_mutex;
-    std::vector<DriverEvent> m_events;
-    size_t m_lastReadIndex;
+    std::deque<DriverEvent> m_events;
+    uint64_t m_firstSequence;       // Sequence of m_events.front()
+    uint64_t m_lastReadSequence;    // Newest sequence returned by GetNewEvents
     int m_maxEvents;
+    uint64_t m_historyId;
+    mutable ChangeNotifier m_changes;   // Notified after the lock is released
+    MemoryCharge m_memory;
     
     // Statistics counters
     int m_signedCount;
     int m_unsignedCount;
     int m_suspiciousCount;
+    
+    // Append under m_mutex; AddEvent notifies once the lock is released
+    uint64_t StoreEvent(const DriverEvent& event);
+    void EvictOldest();
 };
 
+template <typename Visitor>
+void EventManager::VisitRange(uint64_t from, uint64_t to, Visitor visit) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    uint64_t next = m_firstSequence + m_events.size();
+    from = std::max(from, m_firstSequence);
+    to = std::min(to, next);
+    for (uint64_t sequence = from; sequence < to; ++sequence) {
+        visit(m_events[static_cast<size_t>(sequence - m_firstSequence)]);
+    }
+}
+
+template <typename Iterator, typename Visitor>
+void EventManager::VisitSequences(Iterator first, Iterator last, Visitor visit) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    uint64_t next = m_firstSequence + m_events.size();
+    for (; first != last; ++first) {
+        uint64_t sequence = *first;
+        if (sequence >= m_firstSequence && sequence < next) {
+            visit(m_events[static_cast<size_t>(sequence - m_firstSequence)]);
+        }
+    }
+}
+
 } // namespace DriverMonitor
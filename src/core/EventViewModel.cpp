@@ -0,0 +1,414 @@
+#include "EventViewModel.h"
+#include <algorithm>
+
+namespace DriverMonitor {
+
+namespace {
+    // New arrivals are merged into the bulk run once the tail exceeds
+    // max(kMinTailRun, bulk / kTailRunDivisor)
+    const size_t kMinTailRun = 4096;
+    const size_t kTailRunDivisor = 64;
+
+    // Stable LSD radix sort on the upper 32 bits (11-bit digits); digits equal
+    // in every key are skipped, so few distinct keys cost a single pass
+    void RadixSortHigh(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch) {
+        const int kDigitBits = 11;
+        const int kPasses = 3;
+        const size_t kBuckets = size_t(1) << kDigitBits;
+
+        std::vector<size_t> counts(kPasses * kBuckets, 0);
+        for (uint64_t key : keys) {
+            uint32_t high = static_cast<uint32_t>(key >> 32);
+            for (int pass = 0; pass < kPasses; ++pass) {
+                counts[pass * kBuckets + ((high >> (pass * kDigitBits)) & (kBuckets - 1))]++;
+            }
+        }
+
+        scratch.resize(keys.size());
+        for (int pass = 0; pass < kPasses; ++pass) {
+            size_t* count = &counts[pass * kBuckets];
+            int shift = 32 + pass * kDigitBits;
+            if (count[(keys.front() >> shift) & (kBuckets - 1)] == keys.size()) {
+                continue;
+            }
+            size_t offset = 0;
+            for (size_t digit = 0; digit < kBuckets; ++digit) {
+                size_t digitCount = count[digit];
+                count[digit] = offset;
+                offset += digitCount;
+            }
+            for (uint64_t key : keys) {
+                scratch[count[(key >> shift) & (kBuckets - 1)]++] = key;
+            }
+            keys.swap(scratch);
+        }
+    }
+
+    int CompareValues(uint32_t a, uint32_t b) {
+        return a < b ? -1 : (a > b ? 1 : 0);
+    }
+
+    bool MatchesType(EventTypeFilter filter, EventType type) {
+        switch (filter) {
+            case EventTypeFilter::All: return true;
+            case EventTypeFilter::Signed: return type == EventType::Signed;
+            case EventTypeFilter::Unsigned: return type == EventType::Unsigned;
+            case EventTypeFilter::Suspicious: return type == EventType::Suspicious;
+        }
+        return true;
+    }
+}
+
+bool MatchesEventFilter(const DriverEvent& event, const std::string& foldedSearch, EventTypeFilter typeFilter) {
+    if (!MatchesType(typeFilter, event.eventType)) {
+        return false;
+    }
+
+    return foldedSearch.empty() ||
+           Utils::ContainsFolded(event.driverName, foldedSearch) ||
+           Utils::ContainsFolded(event.installPath, foldedSearch) ||
+           Utils::ContainsFolded(event.signerInfo, foldedSearch);
+}
+
+EventViewModel::EventViewModel(const EventManager* eventManager)
+    : m_eventManager(eventManager)
+    , m_typeFilter(EventTypeFilter::All)
+    , m_needsRebuild(true)
+    , m_nextSequence(0)
+    , m_rowsType(EventTypeFilter::All)
+    , m_rowsValid(false)
+    , m_rebuildCount(0)
+    , m_sortColumn(EventSortColumn::Sequence)
+    , m_sortDescending(false)
+    , m_needsSort(false)
+    , m_sortCount(0) {
+}
+
+void EventViewModel::SetFilter(const std::string& searchText, EventTypeFilter typeFilter) {
+    if (searchText == m_searchText && typeFilter == m_typeFilter) {
+        return;
+    }
+
+    m_searchText = searchText;
+    m_foldedSearch = Utils::FoldCase(searchText);
+    m_typeFilter = typeFilter;
+    m_needsRebuild = true;
+}
+
+void EventViewModel::SetExpression(const FilterExpression& expression) {
+    if (expression.GetText() == m_expression.GetText()) {
+        return;
+    }
+
+    m_expression = expression;
+    m_rowsValid = false;
+    m_needsRebuild = true;
+}
+
+void EventViewModel::SetSort(EventSortColumn column, bool descending) {
+    if (column == m_sortColumn && descending == m_sortDescending) {
+        return;
+    }
+
+    m_sortColumn = column;
+    m_sortDescending = descending;
+    m_needsSort = true;
+}
+
+bool EventViewModel::Update() {
+    bool changed = false;
+
+    m_index.Update(*m_eventManager);
+    m_index.SetQuery(m_foldedSearch);
+    uint64_t first = m_index.GetFirstSequence();
+
+    // Sorted runs are kept in step with the rows unless a full sort is due anyway
+    bool fullSort = m_needsSort;
+
+    if (m_needsRebuild) {
+        // Rows matching the new search are a subset of the shown ones if it
+        // extends the search they were built for; re-checking them only pays
+        // off while they are a minority of the history
+        bool refine = m_rowsValid && m_typeFilter == m_rowsType &&
+                      m_foldedSearch.find(m_rowsSearch) != std::string::npos &&
+                      m_rows.size() < (m_index.GetNextSequence() - first) / 2;
+        if (refine) {
+            auto dropped = [&](uint64_t sequence) {
+                return sequence < first || !MatchesIndexed(sequence);
+            };
+            m_rows.erase(std::remove_if(m_rows.begin(), m_rows.end(), dropped), m_rows.end());
+            m_sorted.erase(std::remove_if(m_sorted.begin(), m_sorted.end(), dropped), m_sorted.end());
+            m_sortedTail.erase(std::remove_if(m_sortedTail.begin(), m_sortedTail.end(), dropped), m_sortedTail.end());
+        } else {
+            m_rows.clear();
+            m_nextSequence = first;
+            m_rebuildCount++;
+            fullSort = true;
+        }
+        m_rowsSearch = m_foldedSearch;
+        m_rowsType = m_typeFilter;
+        m_rowsValid = true;
+        m_needsRebuild = false;
+        changed = true;
+    }
+
+    // Drop evicted (or cleared) events
+    if (!m_rows.empty() && m_rows.front() < first) {
+        while (!m_rows.empty() && m_rows.front() < first) {
+            m_rows.pop_front();
+        }
+        if (IsSorted() && !fullSort) {
+            auto evicted = [first](uint64_t sequence) { return sequence < first; };
+            m_sorted.erase(std::remove_if(m_sorted.begin(), m_sorted.end(), evicted), m_sorted.end());
+            m_sortedTail.erase(std::remove_if(m_sortedTail.begin(), m_sortedTail.end(), evicted), m_sortedTail.end());
+        }
+        changed = true;
+    }
+
+    // Examine new arrivals
+    size_t rowsBefore = m_rows.size();
+    size_t tailBefore = m_sortedTail.size();
+    uint64_t next = m_index.GetNextSequence();
+    auto addRow = [&](uint64_t sequence) {
+        m_rows.push_back(sequence);
+        if (IsSorted() && !fullSort) {
+            m_sortedTail.push_back(sequence);
+        }
+    };
+    if (m_expression.IsEmpty()) {
+        for (uint64_t sequence = std::max(m_nextSequence, first); sequence < next; ++sequence) {
+            if (MatchesIndexed(sequence)) {
+                addRow(sequence);
+            }
+        }
+    } else {
+        // The expression needs the events: index pre-check, then one pass under the history lock
+        m_eventManager->VisitRange(std::max(m_nextSequence, first), next, [&](const DriverEvent& event) {
+            if (MatchesIndexed(event.sequenceId) && m_expression.Matches(event)) {
+                addRow(event.sequenceId);
+            }
+        });
+    }
+    m_nextSequence = std::max(m_nextSequence, next);
+    changed = changed || m_rows.size() != rowsBefore;
+
+    if (fullSort) {
+        SortRows();
+        changed = true;
+    } else if (m_sortedTail.size() != tailBefore) {
+        MergeArrivals(tailBefore);
+    }
+
+    return changed;
+}
+
+uint64_t EventViewModel::GetSequence(size_t row) const {
+    if (!IsSorted()) {
+        return m_sortDescending ? m_rows[m_rows.size() - 1 - row] : m_rows[row];
+    }
+
+    size_t bulk = 0;
+    size_t tail = 0;
+    SplitRow(row, bulk, tail);
+    if (tail >= m_sortedTail.size() || (bulk < m_sorted.size() && SortLess(m_sorted[bulk], m_sortedTail[tail]))) {
+        return m_sorted[bulk];
+    }
+    return m_sortedTail[tail];
+}
+
+bool EventViewModel::FindRow(uint64_t sequence, size_t& row) const {
+    if (!IsSorted()) {
+        auto it = std::lower_bound(m_rows.begin(), m_rows.end(), sequence);
+        if (it == m_rows.end() || *it != sequence) {
+            return false;
+        }
+        row = static_cast<size_t>(it - m_rows.begin());
+        if (m_sortDescending) {
+            row = m_rows.size() - 1 - row;
+        }
+        return true;
+    }
+
+    if (sequence < m_index.GetFirstSequence() || sequence >= m_index.GetNextSequence()) {
+        return false;
+    }
+    auto less = [this](uint64_t a, uint64_t b) { return SortLess(a, b); };
+    auto bulk = std::lower_bound(m_sorted.begin(), m_sorted.end(), sequence, less);
+    auto tail = std::lower_bound(m_sortedTail.begin(), m_sortedTail.end(), sequence, less);
+    if ((bulk == m_sorted.end() || *bulk != sequence) && (tail == m_sortedTail.end() || *tail != sequence)) {
+        return false;
+    }
+    row = static_cast<size_t>(bulk - m_sorted.begin()) + static_cast<size_t>(tail - m_sortedTail.begin());
+    return true;
+}
+
+bool EventViewModel::MatchesIndexed(uint64_t sequence) const {
+    return MatchesType(m_typeFilter, m_index.GetEventType(sequence)) && m_index.Matches(sequence);
+}
+
+bool EventViewModel::SortLess(uint64_t a, uint64_t b) const {
+    const SearchIndex::EventEntry& left = m_index.GetEntry(a);
+    const SearchIndex::EventEntry& right = m_index.GetEntry(b);
+
+    auto compareStrings = [this](uint32_t x, uint32_t y) {
+        return x == y ? 0 : m_index.GetString(x).compare(m_index.GetString(y));
+    };
+
+    int order = 0;
+    switch (m_sortColumn) {
+        case EventSortColumn::Sequence: break;
+        case EventSortColumn::Type: order = CompareValues(left.type, right.type); break;
+        case EventSortColumn::Threat: order = CompareValues(left.threat, right.threat); break;
+        case EventSortColumn::Name: order = compareStrings(left.name, right.name); break;
+        case EventSortColumn::Method: order = compareStrings(left.method, right.method); break;
+        case EventSortColumn::Signer: order = compareStrings(left.signer, right.signer); break;
+        case EventSortColumn::Initiator: order = compareStrings(left.initiator, right.initiator); break;
+    }
+
+    if (order != 0) {
+        return m_sortDescending ? order > 0 : order < 0;
+    }
+    return a < b;
+}
+
+uint32_t EventViewModel::SortKey(uint64_t sequence) const {
+    const SearchIndex::EventEntry& entry = m_index.GetEntry(sequence);
+    uint32_t key = 0;
+    switch (m_sortColumn) {
+        case EventSortColumn::Sequence: break;
+        case EventSortColumn::Type: key = entry.type; break;
+        case EventSortColumn::Threat: key = entry.threat; break;
+        case EventSortColumn::Name: key = m_index.GetRank(entry.name); break;
+        case EventSortColumn::Method: key = m_index.GetRank(entry.method); break;
+        case EventSortColumn::Signer: key = m_index.GetRank(entry.signer); break;
+        case EventSortColumn::Initiator: key = m_index.GetRank(entry.initiator); break;
+    }
+    return m_sortDescending ? UINT32_MAX - key : key;
+}
+
+void EventViewModel::SortRows() {
+    m_needsSort = false;
+    m_sorted.clear();
+    m_sortedTail.clear();
+    if (!IsSorted()) {
+        return;
+    }
+    m_sortCount++;
+    if (m_rows.empty()) {
+        return;
+    }
+
+    m_index.UpdateRanks();
+
+    // Column key above the sequence offset; the rows are in arrival order,
+    // so a stable sort on the key alone keeps ties in arrival order
+    uint64_t base = m_rows.front();
+    m_sortKeys.resize(m_rows.size());
+    for (size_t i = 0; i < m_rows.size(); ++i) {
+        uint64_t sequence = m_rows[i];
+        m_sortKeys[i] = static_cast<uint64_t>(SortKey(sequence)) << 32 | (sequence - base);
+    }
+
+    RadixSortHigh(m_sortKeys, m_sortScratch);
+
+    m_sorted.resize(m_sortKeys.size());
+    for (size_t i = 0; i < m_sortKeys.size(); ++i) {
+        m_sorted[i] = base + (m_sortKeys[i] & UINT32_MAX);
+    }
+}
+
+void EventViewModel::MergeArrivals(size_t tailBefore) {
+    auto less = [this](uint64_t a, uint64_t b) { return SortLess(a, b); };
+
+    // Sort the arrivals, then merge them into the tail from the back: each
+    // arrival costs a binary search and every tail entry moves at most once
+    m_sortScratch.assign(m_sortedTail.begin() + static_cast<ptrdiff_t>(tailBefore), m_sortedTail.end());
+    std::sort(m_sortScratch.begin(), m_sortScratch.end(), less);
+    size_t writeEnd = m_sortedTail.size();
+    size_t readEnd = tailBefore;
+    for (size_t k = m_sortScratch.size(); k-- > 0;) {
+        auto tail = m_sortedTail.begin();
+        size_t position = static_cast<size_t>(std::upper_bound(tail, tail + static_cast<ptrdiff_t>(readEnd), m_sortScratch[k], less) - tail);
+        std::move_backward(tail + static_cast<ptrdiff_t>(position), tail + static_cast<ptrdiff_t>(readEnd), tail + static_cast<ptrdiff_t>(writeEnd));
+        writeEnd -= readEnd - position;
+        m_sortedTail[--writeEnd] = m_sortScratch[k];
+        readEnd = position;
+    }
+
+    if (m_sortedTail.size() <= std::max(kMinTailRun, m_sorted.size() / kTailRunDivisor)) {
+        return;
+    }
+
+    // Merge the tail into the bulk on integer keys (ranks only ever grow
+    // consistently with the string order, so the bulk stays sorted)
+    m_index.UpdateRanks();
+    m_sortKeys.resize(m_sorted.size() + m_sortedTail.size());
+    auto keyOf = [this](uint64_t sequence) { return SortKey(sequence); };
+    size_t bulk = 0;
+    size_t tail = 0;
+    size_t out = 0;
+    uint32_t bulkKey = bulk < m_sorted.size() ? keyOf(m_sorted[bulk]) : 0;
+    uint32_t tailKey = keyOf(m_sortedTail[tail]);
+    while (bulk < m_sorted.size() && tail < m_sortedTail.size()) {
+        bool takeTail = tailKey < bulkKey || (tailKey == bulkKey && m_sortedTail[tail] < m_sorted[bulk]);
+        if (takeTail) {
+            m_sortKeys[out++] = m_sortedTail[tail++];
+            if (tail < m_sortedTail.size()) {
+                tailKey = keyOf(m_sortedTail[tail]);
+            }
+        } else {
+            m_sortKeys[out++] = m_sorted[bulk++];
+            if (bulk < m_sorted.size()) {
+                bulkKey = keyOf(m_sorted[bulk]);
+            }
+        }
+    }
+    while (bulk < m_sorted.size()) {
+        m_sortKeys[out++] = m_sorted[bulk++];
+    }
+    while (tail < m_sortedTail.size()) {
+        m_sortKeys[out++] = m_sortedTail[tail++];
+    }
+    m_sorted.swap(m_sortKeys);
+    m_sortedTail.clear();
+}
+
+void EventViewModel::SplitRow(size_t row, size_t& bulk, size_t& tail) const {
+    // Smallest bulk count i such that bulk[i] does not precede tail[row - i - 1]
+    size_t low = row > m_sortedTail.size() ? row - m_sortedTail.size() : 0;
+    size_t high = std::min(row, m_sorted.size());
+    while (low < high) {
+        size_t i = low + (high - low) / 2;
+        if (SortLess(m_sorted[i], m_sortedTail[row - i - 1])) {
+            low = i + 1;
+        } else {
+            high = i;
+        }
+    }
+    bulk = low;
+    tail = row - low;
+}
+
+void EventViewModel::CollectRows(size_t first, size_t last, std::vector<uint64_t>& sequences) const {
+    sequences.clear();
+
+    if (!IsSorted()) {
+        for (size_t row = first; row < last; ++row) {
+            sequences.push_back(m_rows[m_rows.size() - 1 - row]);
+        }
+        return;
+    }
+
+    size_t bulk = 0;
+    size_t tail = 0;
+    SplitRow(first, bulk, tail);
+    for (size_t row = first; row < last; ++row) {
+        if (tail >= m_sortedTail.size() || (bulk < m_sorted.size() && SortLess(m_sorted[bulk], m_sortedTail[tail]))) {
+            sequences.push_back(m_sorted[bulk++]);
+        } else {
+            sequences.push_back(m_sortedTail[tail++]);
+        }
+    }
+}
+
+} // namespace DriverMonitor
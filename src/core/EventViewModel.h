@@ -0,0 +1,166 @@
+#pragma once
+
+#include "EventManager.h"
+#include "FilterExpression.h"
+#include "SearchIndex.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Event type filter of the event table
+enum class EventTypeFilter {
+    All,
+    Signed,
+    Unsigned,
+    Suspicious
+};
+
+// Check an event against a folded search (substring of name, path or
+// signer) and a type filter; the rule the view and exports apply
+bool MatchesEventFilter(const DriverEvent& event, const std::string& foldedSearch, EventTypeFilter typeFilter);
+
+// Sort column of the event table (Sequence = arrival order)
+enum class EventSortColumn {
+    Sequence,
+    Type,
+    Name,
+    Method,
+    Signer,
+    Threat,
+    Initiator
+};
+
+// Filtered, GUI-independent view of the event history.
+// Holds the sequence IDs of matching events in arrival order. Update() only
+// examines events added since the last call and drops evicted ones. Matching
+// goes through a SearchIndex, so a filter change scans compact index entries
+// instead of the events, and a query that extends the previous one (typing)
+// only re-checks the rows already shown.
+//
+// Sorting by a column other than arrival order keeps the rows as two sorted
+// runs: the bulk, radix-sorted on (key rank, sequence) when the sort or the
+// filter changes, and a small run new arrivals are inserted into. The runs
+// are merged once the small one grows past a fraction of the bulk; row
+// lookups select across both. Ties are broken by ascending sequence in
+// either direction.
+class EventViewModel {
+public:
+    explicit EventViewModel(const EventManager* eventManager);
+
+    // Set search text (case-insensitive substring of name, path or signer)
+    // and type filter; schedules a rebuild only if either changed
+    void SetFilter(const std::string& searchText, EventTypeFilter typeFilter);
+
+    // Set a filter expression applied on top of the search and type filter
+    // (an empty one matches everything); schedules a rebuild only if its text changed
+    void SetExpression(const FilterExpression& expression);
+
+    // Force a rebuild on the next Update (e.g. after a configuration change)
+    void Invalidate() { m_needsRebuild = true; m_rowsValid = false; }
+
+    // Set sort column and direction; schedules a re-sort only if either changed
+    void SetSort(EventSortColumn column, bool descending);
+
+    EventSortColumn GetSortColumn() const { return m_sortColumn; }
+    bool IsSortDescending() const { return m_sortDescending; }
+
+    // Bring the view up to date; returns true if the rows changed
+    bool Update();
+
+    // Get number of rows
+    size_t GetRowCount() const { return m_rows.size(); }
+
+    // Get sequence ID of a row
+    uint64_t GetSequence(size_t row) const;
+
+    // Find the row showing a sequence ID
+    bool FindRow(uint64_t sequence, size_t& row) const;
+
+    // Visit the events of rows [first, last) under the history lock
+    template <typename Visitor>
+    void VisitRows(size_t first, size_t last, Visitor visit) const;
+
+    // Check if an event passes the current filter
+    bool Matches(const DriverEvent& event) const {
+        return MatchesEventFilter(event, m_foldedSearch, m_typeFilter) && m_expression.Matches(event);
+    }
+
+    // Current filter
+    const std::string& GetSearchText() const { return m_searchText; }
+    EventTypeFilter GetTypeFilter() const { return m_typeFilter; }
+    const FilterExpression& GetExpression() const { return m_expression; }
+
+    // Number of full rebuilds so far (refinements of the shown rows excluded)
+    uint64_t GetRebuildCount() const { return m_rebuildCount; }
+
+    // Number of full sorts so far (run merges excluded)
+    uint64_t GetSortCount() const { return m_sortCount; }
+
+    // Get the search index backing the view
+    const SearchIndex& GetIndex() const { return m_index; }
+
+private:
+    const EventManager* m_eventManager;
+
+    std::string m_searchText;
+    std::string m_foldedSearch;
+    EventTypeFilter m_typeFilter;
+    FilterExpression m_expression;
+    bool m_needsRebuild;
+
+    SearchIndex m_index;
+    std::deque<uint64_t> m_rows;        // Ascending sequence IDs
+    uint64_t m_nextSequence;            // First sequence not examined yet
+    std::string m_rowsSearch;           // Folded search the rows were built for
+    EventTypeFilter m_rowsType;
+    bool m_rowsValid;                   // False after Invalidate()
+    uint64_t m_rebuildCount;
+
+    EventSortColumn m_sortColumn;
+    bool m_sortDescending;
+    bool m_needsSort;
+    std::vector<uint64_t> m_sorted;     // Bulk run in sort order
+    std::vector<uint64_t> m_sortedTail; // Recent arrivals in sort order
+    std::vector<uint64_t> m_sortKeys;   // Sort and merge buffers (kept to avoid reallocating)
+    std::vector<uint64_t> m_sortScratch;
+    mutable std::vector<uint64_t> m_visibleRows;
+    uint64_t m_sortCount;
+
+    bool MatchesIndexed(uint64_t sequence) const;
+    bool IsSorted() const { return m_sortColumn != EventSortColumn::Sequence; }
+    bool SortLess(uint64_t a, uint64_t b) const;
+
+    // Integer sort key of an event (needs current string ranks)
+    uint32_t SortKey(uint64_t sequence) const;
+
+    void SortRows();
+
+    // Merge the arrivals appended to the tail run since tailBefore
+    void MergeArrivals(size_t tailBefore);
+
+    // Split a row index into positions in the bulk and tail runs
+    void SplitRow(size_t row, size_t& bulk, size_t& tail) const;
+
+    // Sequence IDs of rows [first, last) in display order
+    void CollectRows(size_t first, size_t last, std::vector<uint64_t>& sequences) const;
+};
+
+template <typename Visitor>
+void EventViewModel::VisitRows(size_t first, size_t last, Visitor visit) const {
+    last = std::min(last, m_rows.size());
+    if (first >= last) {
+        return;
+    }
+    if (!IsSorted() && !m_sortDescending) {
+        m_eventManager->VisitSequences(m_rows.begin() + static_cast<ptrdiff_t>(first),
+                                       m_rows.begin() + static_cast<ptrdiff_t>(last), visit);
+        return;
+    }
+    CollectRows(first, last, m_visibleRows);
+    m_eventManager->VisitSequences(m_visibleRows.begin(), m_visibleRows.end(), visit);
+}
+
+} // namespace DriverMonitor
@@ -0,0 +1,458 @@
+#include "FilterExpression.h"
+#include <cstdlib>
+
+namespace {
+    // Parentheses and negations nested deeper than this are rejected (the parser recurses)
+    const int kMaxDepth = 64;
+
+    // haystack equals an already folded needle, ignoring ASCII case
+    bool EqualsFolded(const std::string& haystack, const std::string& foldedNeedle) {
+        if (haystack.size() != foldedNeedle.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < haystack.size(); ++i) {
+            if (DriverMonitor::Utils::FoldCase(haystack[i]) != foldedNeedle[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool IsWordChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+               c == '_' || c == '.' || c == '-';
+    }
+}
+
+namespace DriverMonitor {
+
+// Recursive descent over the grammar in FilterExpression.h, emitting code as
+// it goes; jumps are patched once the end of their operand list is known
+class FilterExpression::Parser {
+public:
+    Parser(const std::string& text, std::vector<Instruction>& code, std::vector<std::string>& strings)
+        : m_text(text), m_position(0), m_depth(0), m_code(code), m_strings(strings) {}
+
+    bool Parse(std::string& error) {
+        Advance();
+        bool parsed = m_token.kind == TokenKind::End || (ParseOr() && Expect(TokenKind::End, "unexpected input"));
+        if (!parsed) {
+            error = m_error;
+        }
+        return parsed;
+    }
+
+private:
+    enum class TokenKind {
+        End,
+        LeftParen,
+        RightParen,
+        And,
+        Or,
+        Not,
+        Operator,
+        String,
+        Word,
+        Invalid
+    };
+
+    struct Token {
+        TokenKind kind;
+        std::string text;       // Operator, unescaped string or word
+        size_t column;          // 1-based
+    };
+
+    const std::string& m_text;
+    size_t m_position;
+    int m_depth;
+    Token m_token;
+    std::string m_error;
+    std::vector<Instruction>& m_code;
+    std::vector<std::string>& m_strings;
+
+    bool Fail(size_t column, const std::string& message) {
+        if (m_error.empty()) {
+            m_error = "column " + std::to_string(column) + ": " + message;
+        }
+        return false;
+    }
+
+    bool FailInvalid() {
+        return Fail(m_token.column, m_token.text == "\"" ? "unterminated string" : "unexpected '" + m_token.text + "'");
+    }
+
+    bool Expect(TokenKind kind, const char* message) {
+        return m_token.kind == kind || Fail(m_token.column, message);
+    }
+
+    void Advance() {
+        while (m_position < m_text.size() && (m_text[m_position] == ' ' || m_text[m_position] == '\t')) {
+            ++m_position;
+        }
+        m_token.column = m_position + 1;
+        m_token.text.clear();
+        if (m_position >= m_text.size()) {
+            m_token.kind = TokenKind::End;
+            return;
+        }
+
+        char c = m_text[m_position];
+        char next = m_position + 1 < m_text.size() ? m_text[m_position + 1] : '\0';
+        auto take = [&](TokenKind kind, size_t length) {
+            m_token.kind = kind;
+            m_token.text.assign(m_text, m_position, length);
+            m_position += length;
+        };
+
+        if (c == '(') take(TokenKind::LeftParen, 1);
+        else if (c == ')') take(TokenKind::RightParen, 1);
+        else if (c == '&' && next == '&') take(TokenKind::And, 2);
+        else if (c == '|' && next == '|') take(TokenKind::Or, 2);
+        else if (c == '!' && (next == '=' || next == '~')) take(TokenKind::Operator, 2);
+        else if (c == '!') take(TokenKind::Not, 1);
+        else if (c == '=' && next == '=') take(TokenKind::Operator, 2);
+        else if ((c == '<' || c == '>') && next == '=') take(TokenKind::Operator, 2);
+        else if (c == '<' || c == '>' || c == '~') take(TokenKind::Operator, 1);
+        else if (c == '"') ReadString();
+        else if (IsWordChar(c)) {
+            size_t end = m_position;
+            while (end < m_text.size() && IsWordChar(m_text[end])) {
+                ++end;
+            }
+            take(TokenKind::Word, end - m_position);
+            std::string folded = Utils::FoldCase(m_token.text);
+            if (folded == "and") m_token.kind = TokenKind::And;
+            else if (folded == "or") m_token.kind = TokenKind::Or;
+            else if (folded == "not") m_token.kind = TokenKind::Not;
+        } else {
+            take(TokenKind::Invalid, 1);
+        }
+    }
+
+    void ReadString() {
+        size_t position = m_position + 1;
+        while (position < m_text.size() && m_text[position] != '"') {
+            char c = m_text[position++];
+            if (c == '\\' && position < m_text.size() && (m_text[position] == '"' || m_text[position] == '\\')) {
+                c = m_text[position++];
+            }
+            m_token.text += c;
+        }
+        if (position >= m_text.size()) {
+            m_token.kind = TokenKind::Invalid;
+            m_token.text = "\"";
+            m_position = m_text.size();
+            return;
+        }
+        m_token.kind = TokenKind::String;
+        m_position = position + 1;
+    }
+
+    size_t Emit(OpCode op, Field field = Field::Name, Comparison compare = Comparison::Equal, bool negate = false,
+                uint64_t operand = 0) {
+        Instruction instruction;
+        instruction.op = op;
+        instruction.field = field;
+        instruction.compare = compare;
+        instruction.negate = negate;
+        instruction.operand = operand;
+        m_code.push_back(instruction);
+        return m_code.size() - 1;
+    }
+
+    uint64_t AddString(const std::string& value) {
+        m_strings.push_back(Utils::FoldCase(value));
+        return m_strings.size() - 1;
+    }
+
+    // Operands joined by && (jumpOp JumpIfFalse) or || (JumpIfTrue)
+    template <typename ParseOperand>
+    bool ParseList(TokenKind separator, OpCode jumpOp, ParseOperand parseOperand) {
+        std::vector<size_t> jumps;
+        if (!parseOperand()) {
+            return false;
+        }
+        while (m_token.kind == separator) {
+            jumps.push_back(Emit(jumpOp));
+            Advance();
+            if (!parseOperand()) {
+                return false;
+            }
+        }
+        for (size_t jump : jumps) {
+            m_code[jump].operand = m_code.size();
+        }
+        return true;
+    }
+
+    bool ParseOr() {
+        return ParseList(TokenKind::Or, OpCode::JumpIfTrue, [this]() { return ParseAnd(); });
+    }
+
+    bool ParseAnd() {
+        return ParseList(TokenKind::And, OpCode::JumpIfFalse, [this]() { return ParseUnary(); });
+    }
+
+    bool ParseUnary() {
+        if (++m_depth > kMaxDepth) {
+            return Fail(m_token.column, "expression nested too deeply");
+        }
+        bool parsed = ParseUnaryInner();
+        --m_depth;
+        return parsed;
+    }
+
+    bool ParseUnaryInner() {
+        switch (m_token.kind) {
+            case TokenKind::Not:
+                Advance();
+                if (!ParseUnary()) {
+                    return false;
+                }
+                Emit(OpCode::Not);
+                return true;
+
+            case TokenKind::LeftParen: {
+                size_t column = m_token.column;
+                Advance();
+                if (!ParseOr()) {
+                    return false;
+                }
+                if (m_token.kind != TokenKind::RightParen) {
+                    return Fail(column, "unmatched (");
+                }
+                Advance();
+                return true;
+            }
+
+            case TokenKind::String:
+                Emit(OpCode::Search, Field::Name, Comparison::Equal, false, AddString(m_token.text));
+                Advance();
+                return true;
+
+            case TokenKind::Word:
+                return ParseComparison();
+
+            case TokenKind::End:
+                return Fail(m_token.column, "expected a condition at the end");
+
+            case TokenKind::Invalid:
+                return FailInvalid();
+
+            default:
+                return Fail(m_token.column, "expected a condition before '" + m_token.text + "'");
+        }
+    }
+
+    bool ParseComparison() {
+        std::string name = Utils::FoldCase(m_token.text);
+        size_t column = m_token.column;
+        if (name == "removal") {
+            Emit(OpCode::Removal);
+            Advance();
+            return true;
+        }
+
+        Field field;
+        if (name == "name") field = Field::Name;
+        else if (name == "path") field = Field::Path;
+        else if (name == "signer") field = Field::Signer;
+        else if (name == "method") field = Field::Method;
+        else if (name == "initiator") field = Field::Initiator;
+        else if (name == "type") field = Field::Type;
+        else if (name == "threat") field = Field::Threat;
+        else if (name == "source") field = Field::Source;
+        else if (name == "pid") field = Field::ProcessId;
+        else return Fail(column, "unknown field '" + m_token.text + "'");
+
+        Advance();
+        if (m_token.kind != TokenKind::Operator) {
+            return Fail(m_token.column, "expected an operator after '" + name + "'");
+        }
+        std::string op = m_token.text;
+        size_t opColumn = m_token.column;
+        Advance();
+        if (m_token.kind == TokenKind::Invalid) {
+            return FailInvalid();
+        }
+        if (m_token.kind != TokenKind::String && m_token.kind != TokenKind::Word) {
+            return Fail(m_token.column, "expected a value after '" + op + "'");
+        }
+        const std::string& value = m_token.text;
+        size_t valueColumn = m_token.column;
+
+        bool isString = field == Field::Name || field == Field::Path || field == Field::Signer ||
+                        field == Field::Method || field == Field::Initiator;
+        if (isString) {
+            if (op == "==" || op == "!=") {
+                Emit(OpCode::Equals, field, Comparison::Equal, op == "!=", AddString(value));
+            } else if (op == "~" || op == "!~") {
+                Emit(OpCode::Contains, field, Comparison::Equal, op == "!~", AddString(value));
+            } else {
+                return Fail(opColumn, "'" + name + "' takes ==, !=, ~ or !~");
+            }
+            Advance();
+            return true;
+        }
+
+        Comparison compare;
+        if (op == "==") compare = Comparison::Equal;
+        else if (op == "!=") compare = Comparison::NotEqual;
+        else if (op == "<") compare = Comparison::Less;
+        else if (op == "<=") compare = Comparison::LessEqual;
+        else if (op == ">") compare = Comparison::Greater;
+        else if (op == ">=") compare = Comparison::GreaterEqual;
+        else return Fail(opColumn, "'" + name + "' takes ==, !=, <, <=, > or >=");
+
+        bool ordered = compare != Comparison::Equal && compare != Comparison::NotEqual;
+        if (ordered && (field == Field::Type || field == Field::Source)) {
+            return Fail(opColumn, "'" + name + "' takes == or !=");
+        }
+
+        uint64_t operand = 0;
+        if (!ResolveValue(field, value, operand)) {
+            return Fail(valueColumn, "'" + value + "' is not a valid " + name);
+        }
+        Emit(OpCode::Compare, field, compare, false, operand);
+        Advance();
+        return true;
+    }
+
+    static bool ResolveValue(Field field, const std::string& value, uint64_t& operand) {
+        std::string folded = Utils::FoldCase(value);
+        auto matchName = [&](const char* candidate, uint64_t result) {
+            if (Utils::FoldCase(candidate) != folded) {
+                return false;
+            }
+            operand = result;
+            return true;
+        };
+
+        switch (field) {
+            case Field::Type:
+                for (EventType type : { EventType::Signed, EventType::Unsigned, EventType::Suspicious }) {
+                    if (matchName(Utils::GetEventTypeName(type), static_cast<uint64_t>(type))) {
+                        return true;
+                    }
+                }
+                return false;
+            case Field::Threat:
+                for (ThreatLevel level : { ThreatLevel::Low, ThreatLevel::Medium, ThreatLevel::High }) {
+                    if (matchName(Utils::GetThreatLevelName(level), static_cast<uint64_t>(level))) {
+                        return true;
+                    }
+                }
+                return false;
+            case Field::Source:
+                for (EventSource source : { EventSource::Unknown, EventSource::Registry, EventSource::FileSystem,
+                                            EventSource::WMI, EventSource::ETW, EventSource::Synthetic }) {
+                    if (matchName(Utils::GetSourceName(source), static_cast<uint64_t>(source))) {
+                        return true;
+                    }
+                }
+                return false;
+            default: {
+                if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+                    return false;
+                }
+                operand = std::strtoull(value.c_str(), nullptr, 10);
+                return true;
+            }
+        }
+    }
+};
+
+FilterExpression::FilterExpression() {
+}
+
+bool FilterExpression::Compile(const std::string& text, std::string& error) {
+    std::vector<Instruction> code;
+    std::vector<std::string> strings;
+    Parser parser(text, code, strings);
+    if (!parser.Parse(error)) {
+        return false;
+    }
+    m_text = text;
+    m_code.swap(code);
+    m_strings.swap(strings);
+    return true;
+}
+
+void FilterExpression::Clear() {
+    m_text.clear();
+    m_code.clear();
+    m_strings.clear();
+}
+
+bool FilterExpression::Matches(const DriverEvent& event) const {
+    auto stringField = [&event](Field field) -> const std::string& {
+        switch (field) {
+            case Field::Path: return event.installPath;
+            case Field::Signer: return event.signerInfo;
+            case Field::Method: return event.loadingMethod;
+            case Field::Initiator: return event.initiatedBy;
+            default: return event.driverName;
+        }
+    };
+    auto numberField = [&event](Field field) -> uint64_t {
+        switch (field) {
+            case Field::Type: return static_cast<uint64_t>(event.eventType);
+            case Field::Threat: return static_cast<uint64_t>(event.threatLevel);
+            case Field::Source: return static_cast<uint64_t>(event.source);
+            default: return event.processId;
+        }
+    };
+
+    bool result = true;
+    size_t pc = 0;
+    while (pc < m_code.size()) {
+        const Instruction& instruction = m_code[pc++];
+        switch (instruction.op) {
+            case OpCode::Contains:
+                result = Utils::ContainsFolded(stringField(instruction.field), m_strings[instruction.operand]) !=
+                         instruction.negate;
+                break;
+            case OpCode::Equals:
+                result = EqualsFolded(stringField(instruction.field), m_strings[instruction.operand]) != instruction.negate;
+                break;
+            case OpCode::Search: {
+                const std::string& needle = m_strings[instruction.operand];
+                result = Utils::ContainsFolded(event.driverName, needle) ||
+                         Utils::ContainsFolded(event.installPath, needle) ||
+                         Utils::ContainsFolded(event.signerInfo, needle);
+                break;
+            }
+            case OpCode::Compare: {
+                uint64_t value = numberField(instruction.field);
+                switch (instruction.compare) {
+                    case Comparison::Equal: result = value == instruction.operand; break;
+                    case Comparison::NotEqual: result = value != instruction.operand; break;
+                    case Comparison::Less: result = value < instruction.operand; break;
+                    case Comparison::LessEqual: result = value <= instruction.operand; break;
+                    case Comparison::Greater: result = value > instruction.operand; break;
+                    case Comparison::GreaterEqual: result = value >= instruction.operand; break;
+                }
+                break;
+            }
+            case OpCode::Removal:
+                result = event.isRemoval;
+                break;
+            case OpCode::Not:
+                result = !result;
+                break;
+            case OpCode::JumpIfFalse:
+                if (!result) {
+                    pc = static_cast<size_t>(instruction.operand);
+                }
+                break;
+            case OpCode::JumpIfTrue:
+                if (result) {
+                    pc = static_cast<size_t>(instruction.operand);
+                }
+                break;
+        }
+    }
+    return result;
+}
+
+} // namespace DriverMonitor
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Utils.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Event filter expression, parsed once and compiled to bytecode:
+//
+//   type == Suspicious && signer !~ "Microsoft" && path ~ "\\temp\\"
+//
+//   expr       := and ( ("||" | "or") and )*
+//   and        := unary ( ("&&" | "and") unary )*
+//   unary      := ("!" | "not") unary | "(" expr ")" | comparison | "removal" | STRING
+//   comparison := name|path|signer|method|initiator  (== != ~ !~)  STRING
+//               | type|threat|source  (== != < <= > >=)  NAME
+//               | pid  (== != < <= > >=)  NUMBER
+//
+// String comparisons ignore ASCII case; ~ is "contains". A bare STRING
+// matches name, path or signer like the search box. Strings are quoted with
+// " and take \" and \\ escapes (any other backslash is kept). Enum names
+// (Signed, High, Registry, ...) ignore case; threat levels order Low < Medium
+// < High.
+//
+// The bytecode is linear: each instruction sets a single result flag, and
+// && / || compile to conditional jumps over the rest of their operand, so
+// evaluation short-circuits without a stack and never allocates.
+class FilterExpression {
+public:
+    FilterExpression();
+
+    // Parse and compile text; false + error ("column C: ...") leaves the
+    // current expression unchanged. Empty text matches every event.
+    bool Compile(const std::string& text, std::string& error);
+
+    // Match every event
+    void Clear();
+
+    bool IsEmpty() const { return m_code.empty(); }
+    const std::string& GetText() const { return m_text; }
+
+    // Number of bytecode instructions (for tests and benchmarks)
+    size_t GetInstructionCount() const { return m_code.size(); }
+
+    // Evaluate against an event
+    bool Matches(const DriverEvent& event) const;
+
+private:
+    enum class OpCode : uint8_t {
+        Contains,           // Field contains m_strings[operand]
+        Equals,             // Field equals m_strings[operand]
+        Search,             // Name, path or signer contains m_strings[operand]
+        Compare,            // Numeric field <compare> operand
+        Removal,
+        Not,
+        JumpIfFalse,        // To operand
+        JumpIfTrue
+    };
+
+    enum class Field : uint8_t {
+        Name,
+        Path,
+        Signer,
+        Method,
+        Initiator,
+        Type,
+        Threat,
+        Source,
+        ProcessId
+    };
+
+    enum class Comparison : uint8_t {
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual
+    };
+
+    struct Instruction {
+        OpCode op;
+        Field field;
+        Comparison compare;
+        bool negate;        // Invert the result of Contains / Equals
+        uint64_t operand;
+    };
+
+    class Parser;
+
+    std::string m_text;
+    std::vector<Instruction> m_code;
+    std::vector<std::string> m_strings;     // Case-folded literals
+};
+
+} // namespace DriverMonitor
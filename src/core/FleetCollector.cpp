@@ -0,0 +1,317 @@
+#include "FleetCollector.h"
+#include "Trace.h"
+#include <algorithm>
+
+namespace {
+    // Reactors also pick up handed-over connections and notice Stop() this often
+    const std::chrono::milliseconds kPollInterval(50);
+
+    // Receive at least this much per call, and at most this many calls per
+    // readiness (the other connections get their turn)
+    const size_t kReceiveChunk = 64 * 1024;
+    const int kReadRounds = 8;
+
+    // A host that does not read its acknowledgements is disconnected
+    const size_t kMaxOutputBytes = 1 << 20;
+
+    const uint64_t kListenerToken = 0;
+}
+
+namespace DriverMonitor {
+
+FleetCollector::FleetCollector()
+    : m_listener(Socket::kNoSocket)
+    , m_port(0)
+    , m_stop(false)
+    , m_nextToken(kListenerToken + 1)
+    , m_connections(0)
+    , m_connectionsAccepted(0)
+    , m_connectionsMoved(0)
+    , m_batches(0)
+    , m_events(0)
+    , m_bytesReceived(0)
+    , m_malformedFrames(0) {
+}
+
+FleetCollector::~FleetCollector() {
+    Stop();
+}
+
+bool FleetCollector::Start(const FleetCollectorOptions& options) {
+    if (IsRunning()) {
+        return false;
+    }
+    m_options = options;
+    if (m_options.shards == 0) {
+        m_options.shards = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_lastError.clear();
+    if (!Socket::Init()) {
+        m_lastError = "cannot initialize sockets";
+        return false;
+    }
+    m_listener = Socket::Listen(m_options.loopbackOnly, m_options.port, m_port, m_lastError);
+    if (m_listener == Socket::kNoSocket) {
+        Socket::Cleanup();
+        return false;
+    }
+    Socket::SetNonBlocking(m_listener);
+
+    m_store = std::make_unique<FleetStore>(m_options.shards, m_options.capacity);
+    m_stop = false;
+    for (size_t i = 0; i < m_options.shards; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->index = i;
+        if (!worker->poller.IsValid() || (i == 0 && !worker->poller.Add(m_listener, kListenerToken))) {
+            m_lastError = "cannot create socket poller";
+            Stop();
+            return false;
+        }
+        m_workers.push_back(std::move(worker));
+    }
+    try {
+        for (auto& worker : m_workers) {
+            worker->thread = std::thread(&FleetCollector::RunWorker, this, std::ref(*worker));
+        }
+    } catch (...) {
+        m_lastError = "cannot start thread";
+        Stop();
+        return false;
+    }
+    return true;
+}
+
+void FleetCollector::Stop() {
+    if (m_listener == Socket::kNoSocket) {
+        return;
+    }
+    m_stop = true;
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    // Only now: a running reactor may still hand a connection to another
+    for (auto& worker : m_workers) {
+        for (auto& connection : worker->connections) {
+            Socket::Close(connection.second->socket);
+        }
+        for (auto& connection : worker->inbox) {
+            Socket::Close(connection->socket);
+        }
+    }
+    m_workers.clear();
+    m_connections = 0;
+    Socket::Close(m_listener);
+    m_listener = Socket::kNoSocket;
+    Socket::Cleanup();
+}
+
+FleetCollectorStats FleetCollector::GetStats() const {
+    FleetCollectorStats stats;
+    stats.connections = m_connections.load(std::memory_order_relaxed);
+    stats.connectionsAccepted = m_connectionsAccepted.load(std::memory_order_relaxed);
+    stats.connectionsMoved = m_connectionsMoved.load(std::memory_order_relaxed);
+    stats.batches = m_batches.load(std::memory_order_relaxed);
+    stats.events = m_events.load(std::memory_order_relaxed);
+    stats.bytesReceived = m_bytesReceived.load(std::memory_order_relaxed);
+    stats.malformedFrames = m_malformedFrames.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FleetCollector::RunWorker(Worker& worker) {
+    Tracer::SetThreadName("collector");
+    std::vector<SocketPoller::Event> ready;
+    while (!m_stop) {
+        worker.poller.Wait(ready, kPollInterval);
+        AdoptConnections(worker);
+        for (const auto& event : ready) {
+            if (event.token == kListenerToken) {
+                AcceptConnections(worker);
+                continue;
+            }
+            auto it = worker.connections.find(event.token);
+            if (it == worker.connections.end()) {
+                continue;           // Closed earlier in this round
+            }
+            Connection& connection = *it->second;
+            ReadResult result = ReadResult::Keep;
+            if (event.writable && !FlushOutput(worker, event.token, connection)) {
+                result = ReadResult::Close;
+            }
+            if (result == ReadResult::Keep && event.readable) {
+                result = ReadConnection(worker, event.token, connection);
+            }
+            if (result == ReadResult::Close) {
+                CloseConnection(worker, event.token);
+            }
+        }
+    }
+}
+
+void FleetCollector::AcceptConnections(Worker& worker) {
+    for (;;) {
+        intptr_t socket = Socket::Accept(m_listener);
+        if (socket == Socket::kNoSocket) {
+            return;
+        }
+        Socket::SetNonBlocking(socket);
+        m_connectionsAccepted.fetch_add(1, std::memory_order_relaxed);
+        m_connections.fetch_add(1, std::memory_order_relaxed);
+
+        auto connection = std::make_unique<Connection>();
+        connection->socket = socket;
+        connection->host = 0;
+        connection->outputOffset = 0;
+        connection->waitingWritable = false;
+        AddConnection(worker, std::move(connection));
+    }
+}
+
+void FleetCollector::AdoptConnections(Worker& worker) {
+    std::vector<std::unique_ptr<Connection>> adopted;
+    {
+        std::lock_guard<std::mutex> lock(worker.inboxMutex);
+        adopted.swap(worker.inbox);
+    }
+    for (auto& connection : adopted) {
+        AddConnection(worker, std::move(connection));
+    }
+}
+
+bool FleetCollector::AddConnection(Worker& worker, std::unique_ptr<Connection> connection) {
+    uint64_t token = m_nextToken.fetch_add(1, std::memory_order_relaxed);
+    if (!worker.poller.Add(connection->socket, token)) {
+        Socket::Close(connection->socket);
+        m_connections.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    Connection& added = *connection;
+    worker.connections.emplace(token, std::move(connection));
+
+    // A handed-over connection: register its host here and take the frames
+    // that arrived with the hello
+    if (!added.hostName.empty()) {
+        added.host = m_store->GetShard(worker.index).AddHost(added.hostName);
+        if (ProcessFrames(worker, token, added) == ReadResult::Close) {
+            CloseConnection(worker, token);
+            return false;
+        }
+    }
+    return true;
+}
+
+void FleetCollector::CloseConnection(Worker& worker, uint64_t token) {
+    auto it = worker.connections.find(token);
+    if (it == worker.connections.end()) {
+        return;
+    }
+    worker.poller.Remove(it->second->socket);
+    Socket::Close(it->second->socket);
+    worker.connections.erase(it);
+    m_connections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+FleetCollector::ReadResult FleetCollector::ReadConnection(Worker& worker, uint64_t token, Connection& connection) {
+    for (int round = 0; round < kReadRounds; ++round) {
+        size_t available;
+        char* buffer = connection.reader.Reserve(kReceiveChunk, available);
+        int received = Socket::TryReceive(connection.socket, buffer, available);
+        if (received < 0) {
+            return ReadResult::Close;
+        }
+        if (received == 0) {
+            break;
+        }
+        connection.reader.Commit(static_cast<size_t>(received));
+        m_bytesReceived.fetch_add(static_cast<uint64_t>(received), std::memory_order_relaxed);
+
+        ReadResult result = ProcessFrames(worker, token, connection);
+        if (result != ReadResult::Keep || static_cast<size_t>(received) < available) {
+            return result;
+        }
+    }
+    return ReadResult::Keep;
+}
+
+FleetCollector::ReadResult FleetCollector::ProcessFrames(Worker& worker, uint64_t token, Connection& connection) {
+    FleetShard& shard = m_store->GetShard(worker.index);
+    ForwardBatchReader batch;
+    const char* payload;
+    size_t length;
+    while (connection.reader.Next(payload, length)) {
+        if (connection.hostName.empty()) {
+            // First frame: the hello decides the shard, and so the reactor
+            std::string_view hostName;
+            if (!EventForwarder::DecodeHello(payload, length, hostName)) {
+                m_malformedFrames.fetch_add(1, std::memory_order_relaxed);
+                return ReadResult::Close;
+            }
+            connection.hostName.assign(hostName);
+            size_t owner = m_store->GetShardIndex(hostName);
+            if (owner != worker.index) {
+                auto it = worker.connections.find(token);
+                std::unique_ptr<Connection> moved = std::move(it->second);
+                worker.connections.erase(it);
+                worker.poller.Remove(moved->socket);
+                m_connectionsMoved.fetch_add(1, std::memory_order_relaxed);
+                Worker& target = *m_workers[owner];
+                std::lock_guard<std::mutex> lock(target.inboxMutex);
+                target.inbox.push_back(std::move(moved));
+                return ReadResult::Moved;
+            }
+            connection.host = shard.AddHost(hostName);
+            continue;
+        }
+
+        DM_TRACE_SPAN("storeBatch", "collector");
+        if (!batch.Open(payload, length, worker.scratch)) {
+            m_malformedFrames.fetch_add(1, std::memory_order_relaxed);
+            return ReadResult::Close;
+        }
+        FleetShard::BatchResult result = shard.AddBatch(connection.host, batch);
+        if (result == FleetShard::BatchResult::Malformed) {
+            m_malformedFrames.fetch_add(1, std::memory_order_relaxed);
+            return ReadResult::Close;
+        }
+        if (result == FleetShard::BatchResult::Stored) {
+            m_batches.fetch_add(1, std::memory_order_relaxed);
+            m_events.fetch_add(batch.GetEventCount(), std::memory_order_relaxed);
+        }
+        EventForwarder::EncodeAck(batch.GetStream(), batch.GetSequence(), connection.output);
+    }
+    if (connection.reader.HasError()) {
+        m_malformedFrames.fetch_add(1, std::memory_order_relaxed);
+        return ReadResult::Close;
+    }
+    return FlushOutput(worker, token, connection) ? ReadResult::Keep : ReadResult::Close;
+}
+
+bool FleetCollector::FlushOutput(Worker& worker, uint64_t token, Connection& connection) {
+    while (connection.outputOffset < connection.output.size()) {
+        int sent = Socket::TrySend(connection.socket, connection.output.data() + connection.outputOffset,
+                                   connection.output.size() - connection.outputOffset);
+        if (sent < 0) {
+            return false;
+        }
+        if (sent == 0) {
+            break;
+        }
+        connection.outputOffset += static_cast<size_t>(sent);
+    }
+
+    bool pending = connection.outputOffset < connection.output.size();
+    if (!pending) {
+        connection.output.clear();
+        connection.outputOffset = 0;
+    } else if (connection.output.size() - connection.outputOffset > kMaxOutputBytes) {
+        return false;
+    }
+    if (pending != connection.waitingWritable) {
+        worker.poller.SetWritable(connection.socket, token, pending);
+        connection.waitingWritable = pending;
+    }
+    return true;
+}
+
+} // namespace DriverMonitor
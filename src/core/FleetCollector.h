@@ -0,0 +1,125 @@
+#pragma once
+
+#include "EventForwarder.h"
+#include "FleetStore.h"
+#include "Socket.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace DriverMonitor {
+
+struct FleetCollectorOptions {
+    bool loopbackOnly;
+    uint16_t port;                  // 0 = any free port (see GetPort)
+    size_t shards;                  // Reactor threads and store shards (0 = one per core)
+    size_t capacity;                // Events retained across all shards
+
+    FleetCollectorOptions() : loopbackOnly(false), port(0), shards(0), capacity(1000000) {}
+};
+
+struct FleetCollectorStats {
+    uint64_t connections;           // Open now
+    uint64_t connectionsAccepted;
+    uint64_t connectionsMoved;      // Handed to the reactor that owns the host's shard
+    uint64_t batches;               // Stored (duplicates excluded)
+    uint64_t events;
+    uint64_t bytesReceived;
+    uint64_t malformedFrames;       // Each closes its connection
+
+    FleetCollectorStats()
+        : connections(0), connectionsAccepted(0), connectionsMoved(0), batches(0), events(0), bytesReceived(0),
+          malformedFrames(0) {}
+};
+
+// Receiving end of event forwarding (see EventForwarder.h) for a fleet of
+// hosts. One reactor thread per shard waits on its sockets (epoll on
+// Linux); the first reactor also accepts. A connection is handed to the
+// reactor owning its host's shard after the hello, so every shard has one
+// writer. Frames are received straight into the connection's buffer and
+// decoded in place; only strings new to a shard are copied. Each stored or
+// duplicate batch is acknowledged.
+class FleetCollector {
+public:
+    FleetCollector();
+    ~FleetCollector();
+
+    // Listen and start the reactors; false + GetLastError() on failure
+    bool Start(const FleetCollectorOptions& options);
+    void Stop();
+
+    bool IsRunning() const { return !m_workers.empty(); }
+
+    uint16_t GetPort() const { return m_port; }
+    std::string GetLastError() const { return m_lastError; }
+
+    FleetCollectorStats GetStats() const;
+
+    // Queries are safe while the reactors run
+    const FleetStore& GetStore() const { return *m_store; }
+
+private:
+    struct Connection {
+        intptr_t socket;
+        ForwardFrameReader reader;
+        std::string hostName;       // From the hello ("" until then)
+        uint32_t host;              // Shard-local host ID
+        std::string output;         // Acknowledgements not sent yet
+        size_t outputOffset;
+        bool waitingWritable;
+    };
+
+    struct Worker {
+        size_t index;
+        SocketPoller poller;
+        std::thread thread;
+        std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections;   // By poller token
+        std::string scratch;        // Decompressed batch
+
+        // Connections handed over by other reactors
+        std::mutex inboxMutex;
+        std::vector<std::unique_ptr<Connection>> inbox;
+    };
+
+    enum class ReadResult {
+        Keep,
+        Close,
+        Moved
+    };
+
+    FleetCollectorOptions m_options;
+    std::unique_ptr<FleetStore> m_store;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    intptr_t m_listener;
+    uint16_t m_port;
+    std::atomic<bool> m_stop;
+    std::atomic<uint64_t> m_nextToken;
+    std::string m_lastError;
+
+    std::atomic<uint64_t> m_connections;
+    std::atomic<uint64_t> m_connectionsAccepted;
+    std::atomic<uint64_t> m_connectionsMoved;
+    std::atomic<uint64_t> m_batches;
+    std::atomic<uint64_t> m_events;
+    std::atomic<uint64_t> m_bytesReceived;
+    std::atomic<uint64_t> m_malformedFrames;
+
+    void RunWorker(Worker& worker);
+    void AcceptConnections(Worker& worker);
+    void AdoptConnections(Worker& worker);
+    bool AddConnection(Worker& worker, std::unique_ptr<Connection> connection);
+    void CloseConnection(Worker& worker, uint64_t token);
+
+    ReadResult ReadConnection(Worker& worker, uint64_t token, Connection& connection);
+    ReadResult ProcessFrames(Worker& worker, uint64_t token, Connection& connection);
+
+    // Send pending acknowledgements; false if the connection failed
+    bool FlushOutput(Worker& worker, uint64_t token, Connection& connection);
+};
+
+} // namespace DriverMonitor
@@ -0,0 +1,243 @@
+#include "FleetSimulator.h"
+#include "EventForwarder.h"
+#include "Socket.h"
+#include <algorithm>
+#include <deque>
+
+namespace {
+    // Distinct event batches per thread, sent in turn
+    const size_t kBatchVariants = 16;
+
+    const std::chrono::milliseconds kConnectTimeout(5000);
+    const std::chrono::milliseconds kSendTimeout(10000);
+
+    int64_t NowMicroseconds() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+namespace DriverMonitor {
+
+struct FleetSimulator::SimulatedHost {
+    intptr_t socket;
+    uint64_t stream;
+    uint64_t nextSequence;
+    uint64_t nextEventId;
+    std::deque<std::pair<uint64_t, size_t>> inFlight;  // Sequence, events
+    ForwardFrameReader reader;
+};
+
+FleetSimulator::FleetSimulator()
+    : m_stop(false)
+    , m_ready(0)
+    , m_failed(false)
+    , m_eventsSent(0)
+    , m_eventsAcked(0)
+    , m_batchesSent(0)
+    , m_bytesSent(0)
+    , m_hostsConnected(0) {
+}
+
+FleetSimulator::~FleetSimulator() {
+    Stop();
+}
+
+bool FleetSimulator::Start(const FleetSimulatorOptions& options) {
+    if (!m_threads.empty()) {
+        return false;
+    }
+    m_options = options;
+    m_options.hosts = std::max<size_t>(m_options.hosts, 1);
+    m_options.threads = std::min(std::max<size_t>(m_options.threads, 1), m_options.hosts);
+    m_options.batchEvents = std::max<size_t>(m_options.batchEvents, 1);
+    m_options.window = std::max<size_t>(m_options.window, 1);
+    if (!Socket::Init()) {
+        m_lastError = "cannot initialize sockets";
+        return false;
+    }
+
+    m_stop = false;
+    m_failed = false;
+    m_ready = 0;
+    m_eventsSent = 0;
+    m_eventsAcked = 0;
+    m_batchesSent = 0;
+    m_bytesSent = 0;
+    m_hostsConnected = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        m_lastError.clear();
+    }
+    for (size_t i = 0; i < m_options.threads; ++i) {
+        m_threads.emplace_back(&FleetSimulator::RunThread, this, i);
+    }
+
+    // Every host connected (or one failed) before reporting success
+    while (m_ready < m_options.threads && !m_failed) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (m_failed) {
+        Stop();
+        return false;
+    }
+    return true;
+}
+
+void FleetSimulator::Stop() {
+    if (m_threads.empty()) {
+        return;
+    }
+    m_stop = true;
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+    Socket::Cleanup();
+}
+
+FleetSimulatorStats FleetSimulator::GetStats() const {
+    FleetSimulatorStats stats;
+    stats.eventsSent = m_eventsSent.load(std::memory_order_relaxed);
+    stats.eventsAcked = m_eventsAcked.load(std::memory_order_relaxed);
+    stats.batchesSent = m_batchesSent.load(std::memory_order_relaxed);
+    stats.bytesSent = m_bytesSent.load(std::memory_order_relaxed);
+    stats.hostsConnected = m_hostsConnected.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::string FleetSimulator::GetLastError() const {
+    std::lock_guard<std::mutex> lock(m_errorMutex);
+    return m_lastError;
+}
+
+bool FleetSimulator::WaitForAcked(uint64_t count, std::chrono::milliseconds timeout) const {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (m_eventsAcked.load(std::memory_order_relaxed) < count) {
+        if (m_failed || std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void FleetSimulator::RunThread(size_t index) {
+    // This thread's hosts: index, index + threads, ...
+    std::vector<std::unique_ptr<SimulatedHost>> hosts;
+    SocketPoller poller;
+    std::string error;
+    int64_t streamBase = NowMicroseconds();
+    for (size_t i = index; i < m_options.hosts && error.empty(); i += m_options.threads) {
+        intptr_t socket = Socket::Connect(m_options.host, m_options.port, kConnectTimeout, kSendTimeout, error);
+        if (socket == Socket::kNoSocket) {
+            break;
+        }
+        std::string hello;
+        EventForwarder::EncodeHello(m_options.hostPrefix + std::to_string(i), hello);
+        if (!Socket::SendAll(socket, hello.data(), hello.size()) || !poller.Add(socket, hosts.size())) {
+            Socket::Close(socket);
+            error = "cannot say hello to the collector";
+            break;
+        }
+        auto host = std::make_unique<SimulatedHost>();
+        host->socket = socket;
+        host->stream = static_cast<uint64_t>(streamBase) + i;
+        host->nextSequence = 1;
+        host->nextEventId = 1;
+        hosts.push_back(std::move(host));
+        m_hostsConnected.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Classified batches, generated once
+    SyntheticProfile profile = m_options.profile;
+    profile.seed += static_cast<uint64_t>(index) * 0x9E3779B97F4A7C15ULL;
+    SyntheticSource source(profile);
+    std::vector<std::vector<DriverEvent>> batches(kBatchVariants, std::vector<DriverEvent>(m_options.batchEvents));
+    for (auto& batch : batches) {
+        for (auto& event : batch) {
+            source.Generate(event);
+            event.eventType = Utils::DetermineEventType(event.signerInfo, event.loadingMethod);
+            event.threatLevel = Utils::AssessThreatLevel(event);
+        }
+    }
+
+    if (!error.empty()) {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        m_lastError = error;
+        m_failed = true;
+    }
+    m_ready++;
+
+    double rate = m_options.rate / static_cast<double>(m_options.threads);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sent = 0;
+    size_t variant = 0;
+    std::string frame;
+    std::vector<SocketPoller::Event> ready;
+    char buffer[4096];
+    while (error.empty() && !m_stop && !m_failed) {
+        bool sentAny = false;
+        for (auto& host : hosts) {
+            while (host->inFlight.size() < m_options.window) {
+                if (rate > 0.0 &&
+                    sent >= rate * std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) {
+                    break;
+                }
+                std::vector<DriverEvent>& events = batches[variant++ % kBatchVariants];
+                int64_t timestamp = NowMicroseconds();
+                for (auto& event : events) {
+                    event.sequenceId = host->nextEventId++;
+                    event.timestampUs = timestamp;
+                }
+                frame.clear();
+                EventForwarder::EncodeBatch(host->stream, host->nextSequence, events, m_options.compress, frame);
+                if (!Socket::SendAll(host->socket, frame.data(), frame.size())) {
+                    error = "lost the connection to the collector";
+                    break;
+                }
+                host->inFlight.emplace_back(host->nextSequence++, events.size());
+                sent += events.size();
+                sentAny = true;
+                m_eventsSent.fetch_add(events.size(), std::memory_order_relaxed);
+                m_batchesSent.fetch_add(1, std::memory_order_relaxed);
+                m_bytesSent.fetch_add(frame.size(), std::memory_order_relaxed);
+            }
+        }
+
+        poller.Wait(ready, std::chrono::milliseconds(sentAny ? 0 : 1));
+        for (const auto& event : ready) {
+            SimulatedHost& host = *hosts[static_cast<size_t>(event.token)];
+            int received = Socket::Receive(host.socket, buffer, sizeof(buffer));
+            if (received <= 0) {
+                error = "collector closed the connection";
+                break;
+            }
+            host.reader.Append(buffer, static_cast<size_t>(received));
+            const char* payload;
+            size_t length;
+            uint64_t stream;
+            uint64_t sequence;
+            while (host.reader.Next(payload, length)) {
+                if (!EventForwarder::DecodeAck(payload, length, stream, sequence) || stream != host.stream) {
+                    continue;
+                }
+                while (!host.inFlight.empty() && host.inFlight.front().first <= sequence) {
+                    m_eventsAcked.fetch_add(host.inFlight.front().second, std::memory_order_relaxed);
+                    host.inFlight.pop_front();
+                }
+            }
+        }
+    }
+
+    if (!error.empty() && !m_stop) {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        m_lastError = error;
+        m_failed = true;
+    }
+    for (auto& host : hosts) {
+        Socket::Close(host->socket);
+    }
+}
+
+} // namespace DriverMonitor
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "SyntheticSource.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DriverMonitor {
+
+struct FleetSimulatorOptions {
+    std::string host;                       // Collector
+    uint16_t port;
+    size_t hosts;                           // Simulated hosts, one connection each
+    size_t threads;                         // Hosts are spread over the threads
+    size_t batchEvents;
+    size_t window;                          // Unacknowledged batches per host
+    bool compress;
+    double rate;                            // Events/s across all hosts (0 = as fast as acknowledged)
+    std::string hostPrefix;                 // Host names are prefix + index
+    SyntheticProfile profile;
+
+    FleetSimulatorOptions()
+        : port(0), hosts(100), threads(1), batchEvents(256), window(8), compress(true), rate(0.0),
+          hostPrefix("sim-host-") {}
+};
+
+struct FleetSimulatorStats {
+    uint64_t eventsSent;
+    uint64_t eventsAcked;
+    uint64_t batchesSent;
+    uint64_t bytesSent;
+    uint64_t hostsConnected;
+
+    FleetSimulatorStats() : eventsSent(0), eventsAcked(0), batchesSent(0), bytesSent(0), hostsConnected(0) {}
+};
+
+// Simulated monitoring hosts for collector load tests: each host is one
+// connection that says hello and streams classified synthetic events in
+// forwarding batches, keeping up to window of them unacknowledged. Event
+// batches are generated once per thread and re-sent with fresh sequence
+// IDs and timestamps, so the cost per event is encoding (and compression).
+class FleetSimulator {
+public:
+    FleetSimulator();
+    ~FleetSimulator();
+
+    // Connect every host and start streaming; false + GetLastError() if a host cannot connect
+    bool Start(const FleetSimulatorOptions& options);
+    void Stop();
+
+    FleetSimulatorStats GetStats() const;
+    std::string GetLastError() const;
+
+    // Wait until at least count events are acknowledged; false on timeout
+    bool WaitForAcked(uint64_t count, std::chrono::milliseconds timeout) const;
+
+private:
+    struct SimulatedHost;
+
+    FleetSimulatorOptions m_options;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_stop;
+    std::atomic<size_t> m_ready;            // Threads done connecting
+    std::atomic<bool> m_failed;
+
+    mutable std::mutex m_errorMutex;
+    std::string m_lastError;
+
+    std::atomic<uint64_t> m_eventsSent;
+    std::atomic<uint64_t> m_eventsAcked;
+    std::atomic<uint64_t> m_batchesSent;
+    std::atomic<uint64_t> m_bytesSent;
+    std::atomic<uint64_t> m_hostsConnected;
+
+    void RunThread(size_t index);
+};
+
+} // namespace DriverMonitor
@@ -0,0 +1,344 @@
+#include "FleetStore.h"
+#include <algorithm>
+
+namespace {
+    using DriverMonitor::EventType;
+    using DriverMonitor::FleetDriverSummary;
+    using DriverMonitor::ThreatLevel;
+
+    bool IsSuspicious(uint8_t type, uint8_t threat) {
+        return type == static_cast<uint8_t>(EventType::Suspicious) || threat == static_cast<uint8_t>(ThreatLevel::High);
+    }
+
+    void MergeSummary(FleetDriverSummary& into, const FleetDriverSummary& from) {
+        if (from.firstSeenUs < into.firstSeenUs) {
+            into.firstSeenUs = from.firstSeenUs;
+            into.firstHost = from.firstHost;
+        }
+        into.hostsAffected += from.hostsAffected;
+        into.events += from.events;
+        into.suspiciousEvents += from.suspiciousEvents;
+        into.maxThreat = std::max(into.maxThreat, from.maxThreat);
+    }
+}
+
+namespace DriverMonitor {
+
+FleetShard::FleetShard(size_t capacity)
+    : m_capacity(std::max<size_t>(capacity, 1))
+    , m_next(0)
+    , m_stored(0)
+    , m_duplicateBatches(0) {
+}
+
+uint32_t FleetShard::AddHost(std::string_view name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t nameId = m_strings.Intern(name);
+    auto inserted = m_hostIds.emplace(nameId, static_cast<uint32_t>(m_hosts.size()));
+    if (inserted.second) {
+        m_hosts.push_back({ nameId, 0, {} });
+    } else {
+        m_strings.Release(nameId);  // A reconnecting host; its record already holds the name
+    }
+    return inserted.first->second;
+}
+
+FleetShard::BatchResult FleetShard::AddBatch(uint32_t host, ForwardBatchReader& batch) {
+    // Decode the whole batch first: a malformed one stores nothing
+    m_batch.clear();
+    ForwardEventView view;
+    while (batch.Next(view)) {
+        m_batch.push_back(view);
+    }
+    if (batch.HasError() || m_batch.size() != batch.GetEventCount()) {
+        return BatchResult::Malformed;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t& lastSequence = m_hosts[host].streams[batch.GetStream()];
+    if (batch.GetSequence() <= lastSequence) {
+        m_duplicateBatches++;
+        return BatchResult::Duplicate;
+    }
+    lastSequence = batch.GetSequence();
+    for (const auto& event : m_batch) {
+        StoreEvent(host, event);
+    }
+    m_hosts[host].events += m_batch.size();
+
+    if (m_strings.ShouldCompact()) {
+        Compact();
+    }
+    return BatchResult::Stored;
+}
+
+void FleetShard::StoreEvent(uint32_t host, const ForwardEventView& view) {
+    StoredEvent event;
+    event.timestampUs = view.timestampUs;
+    event.sequenceId = view.sequenceId;
+    event.host = host;
+    event.name = m_strings.Intern(view.driverName);
+    event.path = m_strings.Intern(view.installPath);
+    event.method = m_strings.Intern(view.loadingMethod);
+    event.initiator = m_strings.Intern(view.initiatedBy);
+    event.signer = m_strings.Intern(view.signerInfo);
+    event.processId = static_cast<uint32_t>(view.processId);
+    event.type = static_cast<uint8_t>(view.eventType);
+    event.threat = static_cast<uint8_t>(view.threatLevel);
+    event.source = static_cast<uint8_t>(view.source);
+    event.removal = view.isRemoval ? 1 : 0;
+
+    if (m_events.size() < m_capacity) {
+        m_events.push_back(event);
+    } else {
+        ReleaseEvent(m_events[m_next]);
+        m_events[m_next] = event;
+    }
+    m_next = (m_next + 1) % m_capacity;
+    m_stored++;
+
+    auto inserted = m_drivers.try_emplace(event.name);
+    DriverRecord& driver = inserted.first->second;
+    if (inserted.second) {
+        driver = { event.timestampUs, host, 0, 0, 0, event.threat };
+        m_strings.AddRef(event.name);   // The aggregate outlives the event
+    } else if (event.timestampUs < driver.firstSeenUs) {
+        driver.firstSeenUs = event.timestampUs;
+        driver.firstHost = host;
+    }
+    driver.events++;
+    driver.suspicious += IsSuspicious(event.type, event.threat) ? 1 : 0;
+    driver.maxThreat = std::max(driver.maxThreat, event.threat);
+    if (m_driverHosts.insert(static_cast<uint64_t>(event.name) << 32 | host).second) {
+        driver.hosts++;
+    }
+}
+
+void FleetShard::ReleaseEvent(const StoredEvent& event) {
+    m_strings.Release(event.name);
+    m_strings.Release(event.path);
+    m_strings.Release(event.method);
+    m_strings.Release(event.initiator);
+    m_strings.Release(event.signer);
+}
+
+void FleetShard::Compact() {
+    std::vector<uint32_t> remap;
+    m_strings.Compact(remap);
+
+    for (auto& event : m_events) {
+        event.name = remap[event.name];
+        event.path = remap[event.path];
+        event.method = remap[event.method];
+        event.initiator = remap[event.initiator];
+        event.signer = remap[event.signer];
+    }
+
+    m_hostIds.clear();
+    for (uint32_t host = 0; host < m_hosts.size(); ++host) {
+        m_hosts[host].name = remap[m_hosts[host].name];
+        m_hostIds.emplace(m_hosts[host].name, host);
+    }
+
+    std::unordered_map<uint32_t, DriverRecord> drivers;
+    drivers.reserve(m_drivers.size());
+    for (const auto& driver : m_drivers) {
+        drivers.emplace(remap[driver.first], driver.second);
+    }
+    std::unordered_set<uint64_t> driverHosts;
+    driverHosts.reserve(m_driverHosts.size());
+    for (uint64_t key : m_driverHosts) {
+        driverHosts.insert(static_cast<uint64_t>(remap[static_cast<uint32_t>(key >> 32)]) << 32 | (key & 0xFFFFFFFFu));
+    }
+
+    m_drivers.swap(drivers);
+    m_driverHosts.swap(driverHosts);
+}
+
+void FleetShard::FillSummary(uint32_t name, const DriverRecord& record, FleetDriverSummary& summary) const {
+    summary.driverName.assign(m_strings.Get(name));
+    summary.firstSeenUs = record.firstSeenUs;
+    summary.firstHost.assign(m_strings.Get(m_hosts[record.firstHost].name));
+    summary.hostsAffected = record.hosts;
+    summary.events = record.events;
+    summary.suspiciousEvents = record.suspicious;
+    summary.maxThreat = static_cast<ThreatLevel>(record.maxThreat);
+}
+
+bool FleetShard::GetDriver(std::string_view name, FleetDriverSummary& summary) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t id;
+    if (!m_strings.Find(name, id)) {
+        return false;
+    }
+    auto driver = m_drivers.find(id);
+    if (driver == m_drivers.end()) {
+        return false;
+    }
+    FillSummary(driver->first, driver->second, summary);
+    return true;
+}
+
+void FleetShard::GetDrivers(std::vector<FleetDriverSummary>& drivers) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    drivers.reserve(drivers.size() + m_drivers.size());
+    for (const auto& driver : m_drivers) {
+        drivers.emplace_back();
+        FillSummary(driver.first, driver.second, drivers.back());
+    }
+}
+
+void FleetShard::GetHostEvents(std::string_view host, size_t count, std::vector<DriverEvent>& events) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t name;
+    if (!m_strings.Find(host, name)) {
+        return;
+    }
+    auto hostId = m_hostIds.find(name);
+    if (hostId == m_hostIds.end()) {
+        return;
+    }
+
+    // Newest first: back from the slot written last
+    size_t size = m_events.size();
+    for (size_t i = 1; i <= size && events.size() < count; ++i) {
+        const StoredEvent& stored = m_events[(m_next + size - i) % size];
+        if (stored.host != hostId->second) {
+            continue;
+        }
+        events.emplace_back();
+        DriverEvent& event = events.back();
+        event.driverName.assign(m_strings.Get(stored.name));
+        event.installPath.assign(m_strings.Get(stored.path));
+        event.loadingMethod.assign(m_strings.Get(stored.method));
+        event.initiatedBy.assign(m_strings.Get(stored.initiator));
+        event.signerInfo.assign(m_strings.Get(stored.signer));
+        event.processId = stored.processId;
+        event.timestampUs = stored.timestampUs;
+        event.timestamp = Utils::FormatTimestamp(stored.timestampUs);
+        event.eventType = static_cast<EventType>(stored.type);
+        event.threatLevel = static_cast<ThreatLevel>(stored.threat);
+        event.source = static_cast<EventSource>(stored.source);
+        event.isRemoval = stored.removal != 0;
+        event.sequenceId = stored.sequenceId;
+    }
+}
+
+void FleetShard::AddStats(FleetStoreStats& stats) const {
+    // Hash nodes counted as two pointers plus the value
+    const size_t kNodeOverhead = 2 * sizeof(void*);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.hosts += m_hosts.size();
+    stats.eventsStored += m_stored;
+    stats.eventsRetained += m_events.size();
+    stats.duplicateBatches += m_duplicateBatches;
+    stats.driverRecords += m_drivers.size();
+    stats.strings += m_strings.GetSize();
+    stats.memoryBytes += m_events.capacity() * sizeof(StoredEvent) + m_strings.GetMemoryBytes() +
+                         m_drivers.size() * (sizeof(uint32_t) + sizeof(DriverRecord) + kNodeOverhead) +
+                         m_driverHosts.size() * (sizeof(uint64_t) + kNodeOverhead) +
+                         m_hosts.size() * (sizeof(HostRecord) + 64);
+}
+
+FleetStore::FleetStore(size_t shards, size_t capacity) {
+    shards = std::max<size_t>(shards, 1);
+    for (size_t i = 0; i < shards; ++i) {
+        m_shards.push_back(std::make_unique<FleetShard>(capacity / shards));
+    }
+}
+
+size_t FleetStore::GetShardIndex(std::string_view host) const {
+    return static_cast<size_t>(Utils::HashIgnoreCase(host.data(), host.size()) % m_shards.size());
+}
+
+bool FleetStore::GetDriverSummary(std::string_view name, FleetDriverSummary& summary) const {
+    bool found = false;
+    FleetDriverSummary shardSummary;
+    for (const auto& shard : m_shards) {
+        if (!shard->GetDriver(name, shardSummary)) {
+            continue;
+        }
+        if (found) {
+            MergeSummary(summary, shardSummary);
+        } else {
+            summary = shardSummary;
+            found = true;
+        }
+    }
+    return found;
+}
+
+std::vector<FleetDriverSummary> FleetStore::MergeDrivers() const {
+    std::vector<FleetDriverSummary> drivers;
+    if (m_shards.size() == 1) {
+        m_shards[0]->GetDrivers(drivers);
+        return drivers;
+    }
+
+    std::vector<FleetDriverSummary> shardDrivers;
+    std::unordered_map<std::string, size_t> index;      // Name -> position in drivers
+    for (const auto& shard : m_shards) {
+        shardDrivers.clear();
+        shard->GetDrivers(shardDrivers);
+        for (auto& driver : shardDrivers) {
+            auto inserted = index.emplace(driver.driverName, drivers.size());
+            if (inserted.second) {
+                drivers.push_back(std::move(driver));
+            } else {
+                MergeSummary(drivers[inserted.first->second], driver);
+            }
+        }
+    }
+    return drivers;
+}
+
+std::vector<FleetDriverSummary> FleetStore::GetTopSuspicious(size_t count) const {
+    std::vector<FleetDriverSummary> drivers = MergeDrivers();
+    drivers.erase(std::remove_if(drivers.begin(), drivers.end(),
+                                 [](const FleetDriverSummary& driver) { return driver.suspiciousEvents == 0; }),
+                  drivers.end());
+    count = std::min(count, drivers.size());
+    std::partial_sort(drivers.begin(), drivers.begin() + static_cast<std::ptrdiff_t>(count), drivers.end(),
+                      [](const FleetDriverSummary& a, const FleetDriverSummary& b) {
+                          if (a.suspiciousEvents != b.suspiciousEvents) {
+                              return a.suspiciousEvents > b.suspiciousEvents;
+                          }
+                          if (a.hostsAffected != b.hostsAffected) {
+                              return a.hostsAffected > b.hostsAffected;
+                          }
+                          return a.driverName < b.driverName;
+                      });
+    drivers.resize(count);
+    return drivers;
+}
+
+std::vector<FleetDriverSummary> FleetStore::GetNewestDrivers(size_t count) const {
+    std::vector<FleetDriverSummary> drivers = MergeDrivers();
+    count = std::min(count, drivers.size());
+    std::partial_sort(drivers.begin(), drivers.begin() + static_cast<std::ptrdiff_t>(count), drivers.end(),
+                      [](const FleetDriverSummary& a, const FleetDriverSummary& b) {
+                          if (a.firstSeenUs != b.firstSeenUs) {
+                              return a.firstSeenUs > b.firstSeenUs;
+                          }
+                          return a.driverName < b.driverName;
+                      });
+    drivers.resize(count);
+    return drivers;
+}
+
+std::vector<DriverEvent> FleetStore::GetHostEvents(std::string_view host, size_t count) const {
+    std::vector<DriverEvent> events;
+    m_shards[GetShardIndex(host)]->GetHostEvents(host, count, events);
+    return events;
+}
+
+FleetStoreStats FleetStore::GetStats() const {
+    FleetStoreStats stats;
+    for (const auto& shard : m_shards) {
+        shard->AddStats(stats);
+    }
+    return stats;
+}
+
+} // namespace DriverMonitor
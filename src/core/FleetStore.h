@@ -0,0 +1,173 @@
+#pragma once
+
+#include "EventForwarder.h"
+#include "StringInterner.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Fleet-wide aggregate of one driver name
+struct FleetDriverSummary {
+    std::string driverName;
+    int64_t firstSeenUs;            // Earliest event timestamp on any host
+    std::string firstHost;          // Host that reported it then
+    uint64_t hostsAffected;
+    uint64_t events;
+    uint64_t suspiciousEvents;      // Suspicious type or high threat
+    ThreatLevel maxThreat;
+
+    FleetDriverSummary()
+        : firstSeenUs(0), hostsAffected(0), events(0), suspiciousEvents(0), maxThreat(ThreatLevel::Low) {}
+};
+
+struct FleetStoreStats {
+    uint64_t hosts;
+    uint64_t eventsStored;          // Since start
+    uint64_t eventsRetained;        // Still in the shards' rings
+    uint64_t duplicateBatches;      // Resent batches that were already stored
+    uint64_t driverRecords;         // Per-shard driver aggregates (a driver seen in two shards counts twice)
+    uint64_t strings;               // Interned strings, including unreferenced ones not yet compacted
+    size_t memoryBytes;             // Approximate
+
+    FleetStoreStats()
+        : hosts(0), eventsStored(0), eventsRetained(0), duplicateBatches(0), driverRecords(0), strings(0), memoryBytes(0) {}
+};
+
+// Events of the hosts that hash to one shard. One reactor thread writes a
+// shard; queries from other threads take its lock, which the writer holds
+// once per batch. Strings are interned once per shard and reference counted,
+// the newest capacity events are kept in a ring, and the per-driver
+// aggregates (first seen, hosts, counts) live as long as the collector.
+// Strings only evicted events used are dropped by compaction, so unique
+// paths or signers from a fleet do not accumulate.
+class FleetShard {
+public:
+    enum class BatchResult {
+        Stored,
+        Duplicate,                  // At or below the last sequence stored for the host's stream
+        Malformed                   // Nothing was stored
+    };
+
+    explicit FleetShard(size_t capacity);
+
+    // Shard-local ID of a host, registered on first use
+    uint32_t AddHost(std::string_view name);
+
+    // Store the events of an opened batch sent by a host
+    BatchResult AddBatch(uint32_t host, ForwardBatchReader& batch);
+
+    // This shard's aggregate of a driver; false if no host here reported it
+    bool GetDriver(std::string_view name, FleetDriverSummary& summary) const;
+
+    // Append this shard's aggregate of every driver
+    void GetDrivers(std::vector<FleetDriverSummary>& drivers) const;
+
+    // Newest retained events of a host, newest first
+    void GetHostEvents(std::string_view host, size_t count, std::vector<DriverEvent>& events) const;
+
+    // Add this shard's counters to stats
+    void AddStats(FleetStoreStats& stats) const;
+
+private:
+    struct StoredEvent {
+        int64_t timestampUs;
+        uint64_t sequenceId;
+        uint32_t host;
+        uint32_t name;
+        uint32_t path;
+        uint32_t method;
+        uint32_t initiator;
+        uint32_t signer;
+        uint32_t processId;
+        uint8_t type;
+        uint8_t threat;
+        uint8_t source;
+        uint8_t removal;
+    };
+
+    struct HostRecord {
+        uint32_t name;
+        uint64_t events;
+        std::unordered_map<uint64_t, uint64_t> streams;  // Stream -> last stored sequence
+    };
+
+    struct DriverRecord {
+        int64_t firstSeenUs;
+        uint32_t firstHost;
+        uint32_t hosts;
+        uint64_t events;
+        uint64_t suspicious;
+        uint8_t maxThreat;
+    };
+
+    mutable std::mutex m_mutex;
+
+    // Referenced by retained events, host records and driver aggregates
+    StringInterner m_strings;
+
+    std::vector<HostRecord> m_hosts;
+    std::unordered_map<uint32_t, uint32_t> m_hostIds;       // Name string ID -> host ID
+
+    // Ring of the newest events; m_next is the slot written next
+    std::vector<StoredEvent> m_events;
+    size_t m_capacity;
+    size_t m_next;
+    uint64_t m_stored;
+    uint64_t m_duplicateBatches;
+
+    std::unordered_map<uint32_t, DriverRecord> m_drivers;   // Name string ID -> aggregate
+    std::unordered_set<uint64_t> m_driverHosts;              // Name string ID << 32 | host ID
+
+    std::vector<ForwardEventView> m_batch;                   // Writer only
+
+    void ReleaseEvent(const StoredEvent& event);
+    void StoreEvent(uint32_t host, const ForwardEventView& view);
+
+    // Drop the dead strings and renumber the references to the rest
+    void Compact();
+    void FillSummary(uint32_t name, const DriverRecord& record, FleetDriverSummary& summary) const;
+};
+
+// Events from many hosts, sharded by host name so every host's events and
+// aggregates live in exactly one shard. Cross-shard queries merge the
+// per-shard aggregates: host sets are disjoint, so hosts affected add up.
+class FleetStore {
+public:
+    // capacity = events retained across all shards
+    FleetStore(size_t shards, size_t capacity);
+
+    size_t GetShardCount() const { return m_shards.size(); }
+    FleetShard& GetShard(size_t index) { return *m_shards[index]; }
+
+    // Shard that stores a host (case-insensitive)
+    size_t GetShardIndex(std::string_view host) const;
+
+    // Fleet-wide aggregate of a driver; false if no host reported it
+    bool GetDriverSummary(std::string_view name, FleetDriverSummary& summary) const;
+
+    // Drivers with the most suspicious events (then most hosts, then by name)
+    std::vector<FleetDriverSummary> GetTopSuspicious(size_t count) const;
+
+    // Drivers most recently seen for the first time anywhere, newest first
+    std::vector<FleetDriverSummary> GetNewestDrivers(size_t count) const;
+
+    // Newest retained events of a host, newest first
+    std::vector<DriverEvent> GetHostEvents(std::string_view host, size_t count) const;
+
+    FleetStoreStats GetStats() const;
+
+private:
+    std::vector<std::unique_ptr<FleetShard>> m_shards;
+
+    // Every driver, with the aggregates of all shards merged
+    std::vector<FleetDriverSummary> MergeDrivers() const;
+};
+
+} // namespace DriverMonitor
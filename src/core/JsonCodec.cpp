@@ -0,0 +1,442 @@
+#include "JsonCodec.h"
+#include "Utils.h"
+#include <charconv>
+#include <cstring>
+
+namespace {
+    // Deeper documents are rejected instead of growing the stack without bound
+    const size_t kMaxDepth = 256;
+}
+
+namespace DriverMonitor {
+
+void JsonWriter::NewLine() {
+    m_buffer += '\n';
+    m_buffer.append(m_stack.size() * 2, ' ');
+}
+
+void JsonWriter::BeginValue() {
+    if (m_afterKey) {
+        m_afterKey = false;
+        return;
+    }
+    if (m_needComma) {
+        m_buffer += ',';
+    }
+    if (!m_stack.empty()) {
+        NewLine();
+    }
+}
+
+void JsonWriter::Key(const char* name) {
+    BeginValue();
+    Utils::AppendJsonString(m_buffer, name);
+    m_buffer += ": ";
+    m_afterKey = true;
+}
+
+void JsonWriter::BeginContainer(char open) {
+    BeginValue();
+    m_buffer += open;
+    m_stack.push_back(open);
+    m_needComma = false;
+}
+
+void JsonWriter::EndContainer(char close) {
+    bool empty = !m_needComma;
+    m_stack.pop_back();
+    if (!empty) {
+        NewLine();
+    }
+    m_buffer += close;
+    m_needComma = true;
+    if (m_stack.empty()) {
+        m_buffer += '\n';
+    }
+}
+
+void JsonWriter::String(const std::string& value) {
+    BeginValue();
+    Utils::AppendJsonString(m_buffer, value);
+    m_needComma = true;
+}
+
+void JsonWriter::Bool(bool value) {
+    BeginValue();
+    m_buffer += value ? "true" : "false";
+    m_needComma = true;
+}
+
+void JsonWriter::Int(int64_t value) {
+    BeginValue();
+    m_buffer += std::to_string(value);
+    m_needComma = true;
+}
+
+JsonReader::JsonReader(const char* data, size_t length)
+    : m_data(data)
+    , m_length(length)
+    , m_offset(0)
+    , m_tokenOffset(0)
+    , m_state(State::Value)
+    , m_number(0)
+    , m_integer(0)
+    , m_isInteger(false)
+    , m_error(false) {
+    // A UTF-8 byte order mark is not part of the document
+    if (length >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        m_offset = 3;
+    }
+}
+
+JsonToken JsonReader::FailAt(size_t offset, const char* message) {
+    if (m_error) {
+        return JsonToken::Error;
+    }
+    size_t line = 1;
+    size_t lineStart = 0;
+    for (size_t i = 0; i < offset && i < m_length; ++i) {
+        if (m_data[i] == '\n') {
+            line++;
+            lineStart = i + 1;
+        }
+    }
+    m_error = true;
+    m_errorText = "line " + std::to_string(line) + ", column " + std::to_string(offset - lineStart + 1) + ": " + message;
+    return JsonToken::Error;
+}
+
+void JsonReader::Fail(const std::string& message) {
+    FailAt(m_tokenOffset, message.c_str());
+}
+
+bool JsonReader::SkipWhitespace() {
+    while (m_offset < m_length) {
+        char c = m_data[m_offset];
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            m_offset++;
+        } else if (c == '/' && m_offset + 1 < m_length && m_data[m_offset + 1] == '/') {
+            while (m_offset < m_length && m_data[m_offset] != '\n') {
+                m_offset++;
+            }
+        } else if (c == '/' && m_offset + 1 < m_length && m_data[m_offset + 1] == '*') {
+            size_t start = m_offset;
+            m_offset += 2;
+            while (m_offset + 1 < m_length && !(m_data[m_offset] == '*' && m_data[m_offset + 1] == '/')) {
+                m_offset++;
+            }
+            if (m_offset + 1 >= m_length) {
+                FailAt(start, "unterminated comment");
+                return false;
+            }
+            m_offset += 2;
+        } else {
+            break;
+        }
+    }
+    return true;
+}
+
+JsonToken JsonReader::Next() {
+    if (m_error || !SkipWhitespace()) {
+        return JsonToken::Error;
+    }
+    m_tokenOffset = m_offset;
+
+    switch (m_state) {
+        case State::Value:
+            return ReadValue();
+
+        case State::FirstElement:
+            if (m_offset < m_length && m_data[m_offset] == ']') {
+                return Close(']');
+            }
+            return ReadValue();
+
+        case State::FirstMember:
+            if (m_offset < m_length && m_data[m_offset] == '}') {
+                return Close('}');
+            }
+            return ReadMember();
+
+        case State::Member:
+            return ReadMember();
+
+        case State::AfterValue: {
+            char open = m_stack.back();
+            char close = open == '{' ? '}' : ']';
+            if (m_offset >= m_length) {
+                return FailAt(m_offset, open == '{' ? "unterminated object" : "unterminated array");
+            }
+            char c = m_data[m_offset];
+            if (c == close) {
+                return Close(close);
+            }
+            if (c != ',') {
+                return FailAt(m_offset, open == '{' ? "expected ',' or '}'" : "expected ',' or ']'");
+            }
+            m_offset++;
+            m_state = open == '{' ? State::Member : State::Value;
+            return Next();
+        }
+
+        case State::Done:
+            if (m_offset < m_length) {
+                return FailAt(m_offset, "unexpected data after the document");
+            }
+            return JsonToken::End;
+    }
+    return JsonToken::Error;
+}
+
+JsonToken JsonReader::Close(char close) {
+    m_offset++;
+    m_stack.pop_back();
+    ValueDone();
+    return close == '}' ? JsonToken::EndObject : JsonToken::EndArray;
+}
+
+JsonToken JsonReader::ReadMember() {
+    if (m_offset >= m_length || m_data[m_offset] != '"') {
+        return FailAt(m_offset, "expected a member name");
+    }
+    if (!ReadString() || !SkipWhitespace()) {
+        return JsonToken::Error;
+    }
+    if (m_offset >= m_length || m_data[m_offset] != ':') {
+        return FailAt(m_offset, "expected ':'");
+    }
+    m_offset++;
+    m_state = State::Value;
+    return JsonToken::Key;
+}
+
+JsonToken JsonReader::ReadValue() {
+    if (m_offset >= m_length) {
+        return FailAt(m_offset, "unexpected end of input");
+    }
+    switch (m_data[m_offset]) {
+        case '{':
+        case '[': {
+            if (m_stack.size() >= kMaxDepth) {
+                return FailAt(m_offset, "nesting too deep");
+            }
+            char open = m_data[m_offset++];
+            m_stack.push_back(open);
+            m_state = open == '{' ? State::FirstMember : State::FirstElement;
+            return open == '{' ? JsonToken::BeginObject : JsonToken::BeginArray;
+        }
+        case '"':
+            if (!ReadString()) {
+                return JsonToken::Error;
+            }
+            ValueDone();
+            return JsonToken::String;
+        case 't': return ReadLiteral("true", 4, JsonToken::True);
+        case 'f': return ReadLiteral("false", 5, JsonToken::False);
+        case 'n': return ReadLiteral("null", 4, JsonToken::Null);
+        default: return ReadNumber();
+    }
+}
+
+JsonToken JsonReader::ReadLiteral(const char* literal, size_t length, JsonToken token) {
+    if (m_length - m_offset < length || memcmp(m_data + m_offset, literal, length) != 0) {
+        return FailAt(m_offset, "invalid literal");
+    }
+    m_offset += length;
+    ValueDone();
+    return token;
+}
+
+JsonToken JsonReader::ReadNumber() {
+    // Validate the JSON number grammar, then convert the span
+    size_t start = m_offset;
+    size_t i = m_offset;
+    auto digits = [&]() {
+        size_t first = i;
+        while (i < m_length && m_data[i] >= '0' && m_data[i] <= '9') {
+            i++;
+        }
+        return i > first;
+    };
+
+    if (i < m_length && m_data[i] == '-') {
+        i++;
+    }
+    if (i < m_length && m_data[i] == '0') {
+        i++;
+    } else if (!digits()) {
+        return FailAt(start, "expected a value");
+    }
+    bool integer = true;
+    if (i < m_length && m_data[i] == '.') {
+        i++;
+        integer = false;
+        if (!digits()) {
+            return FailAt(i, "expected digits after '.'");
+        }
+    }
+    if (i < m_length && (m_data[i] == 'e' || m_data[i] == 'E')) {
+        i++;
+        integer = false;
+        if (i < m_length && (m_data[i] == '+' || m_data[i] == '-')) {
+            i++;
+        }
+        if (!digits()) {
+            return FailAt(i, "expected exponent digits");
+        }
+    }
+
+    m_isInteger = integer &&
+        std::from_chars(m_data + start, m_data + i, m_integer).ec == std::errc();
+    if (m_isInteger) {
+        m_number = static_cast<double>(m_integer);
+    } else if (std::from_chars(m_data + start, m_data + i, m_number).ec != std::errc()) {
+        return FailAt(start, "number out of range");
+    }
+    m_offset = i;
+    ValueDone();
+    return JsonToken::Number;
+}
+
+namespace {
+    int HexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    void AppendUtf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+}
+
+bool JsonReader::ReadString() {
+    size_t start = m_offset++;
+    m_string.clear();
+
+    for (;;) {
+        // Copy the run up to the next quote, escape or control character
+        size_t run = m_offset;
+        while (m_offset < m_length) {
+            unsigned char c = static_cast<unsigned char>(m_data[m_offset]);
+            if (c == '"' || c == '\\' || c < 0x20) {
+                break;
+            }
+            m_offset++;
+        }
+        m_string.append(m_data + run, m_offset - run);
+
+        if (m_offset >= m_length) {
+            FailAt(start, "unterminated string");
+            return false;
+        }
+        char c = m_data[m_offset];
+        if (c == '"') {
+            m_offset++;
+            return true;
+        }
+        if (c != '\\') {
+            FailAt(m_offset, "control character in string");
+            return false;
+        }
+
+        if (m_offset + 1 >= m_length) {
+            FailAt(start, "unterminated string");
+            return false;
+        }
+        char escape = m_data[m_offset + 1];
+        m_offset += 2;
+        switch (escape) {
+            case '"': m_string += '"'; break;
+            case '\\': m_string += '\\'; break;
+            case '/': m_string += '/'; break;
+            case 'b': m_string += '\b'; break;
+            case 'f': m_string += '\f'; break;
+            case 'n': m_string += '\n'; break;
+            case 'r': m_string += '\r'; break;
+            case 't': m_string += '\t'; break;
+            case 'u': {
+                auto readHex = [&](uint32_t& code) {
+                    if (m_length - m_offset < 4) {
+                        return false;
+                    }
+                    code = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        int digit = HexValue(m_data[m_offset + i]);
+                        if (digit < 0) {
+                            return false;
+                        }
+                        code = code << 4 | static_cast<uint32_t>(digit);
+                    }
+                    m_offset += 4;
+                    return true;
+                };
+                size_t escapeStart = m_offset - 2;
+                uint32_t code;
+                if (!readHex(code)) {
+                    FailAt(escapeStart, "invalid \\u escape");
+                    return false;
+                }
+                if (code >= 0xD800 && code < 0xDC00) {
+                    // High surrogate: must be followed by an escaped low surrogate
+                    uint32_t low;
+                    if (m_length - m_offset < 2 || m_data[m_offset] != '\\' || m_data[m_offset + 1] != 'u') {
+                        FailAt(escapeStart, "unpaired surrogate");
+                        return false;
+                    }
+                    m_offset += 2;
+                    if (!readHex(low) || low < 0xDC00 || low >= 0xE000) {
+                        FailAt(escapeStart, "unpaired surrogate");
+                        return false;
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code < 0xE000) {
+                    FailAt(escapeStart, "unpaired surrogate");
+                    return false;
+                }
+                AppendUtf8(m_string, code);
+                break;
+            }
+            default:
+                FailAt(m_offset - 2, "invalid escape");
+                return false;
+        }
+    }
+}
+
+bool JsonReader::SkipValue(JsonToken first) {
+    if (first != JsonToken::BeginObject && first != JsonToken::BeginArray) {
+        return first != JsonToken::Error && first != JsonToken::End;
+    }
+    size_t depth = 1;
+    while (depth > 0) {
+        switch (Next()) {
+            case JsonToken::BeginObject:
+            case JsonToken::BeginArray: depth++; break;
+            case JsonToken::EndObject:
+            case JsonToken::EndArray: depth--; break;
+            case JsonToken::Error:
+            case JsonToken::End: return false;
+            default: break;
+        }
+    }
+    return true;
+}
+
+} // namespace DriverMonitor
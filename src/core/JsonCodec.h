@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Appends pretty-printed JSON (two-space indent) to a buffer; strings are escaped
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& buffer) : m_buffer(buffer), m_needComma(false), m_afterKey(false) {}
+
+    void BeginObject() { BeginContainer('{'); }
+    void EndObject() { EndContainer('}'); }
+    void BeginArray() { BeginContainer('['); }
+    void EndArray() { EndContainer(']'); }
+
+    // Member name; the next value call writes its value
+    void Key(const char* name);
+
+    void String(const std::string& value);
+    void Bool(bool value);
+    void Int(int64_t value);
+
+private:
+    std::string& m_buffer;
+    std::vector<char> m_stack;      // Open containers
+    bool m_needComma;
+    bool m_afterKey;
+
+    void BeginValue();
+    void BeginContainer(char open);
+    void EndContainer(char close);
+    void NewLine();
+};
+
+enum class JsonToken {
+    BeginObject,
+    EndObject,
+    BeginArray,
+    EndArray,
+    Key,
+    String,
+    Number,
+    True,
+    False,
+    Null,
+    End,            // Document complete
+    Error
+};
+
+// Pull parser: Next() validates and returns one token at a time without
+// building a document, so a caller maps a file straight onto its own
+// structures. Strings without escapes are copied into one reused buffer.
+// Accepts // and /* */ comments. Errors carry line and column.
+class JsonReader {
+public:
+    JsonReader(const char* data, size_t length);
+
+    JsonToken Next();
+
+    // Text of the last Key or String token (valid until the next call)
+    const std::string& GetString() const { return m_string; }
+
+    // Value of the last Number token
+    double GetNumber() const { return m_number; }
+    bool IsInteger() const { return m_isInteger; }
+    int64_t GetInteger() const { return m_integer; }
+
+    // Skip the rest of a value whose first token was just returned
+    bool SkipValue(JsonToken first);
+
+    // Report an error at the start of the last token (schema violations)
+    void Fail(const std::string& message);
+
+    bool HasError() const { return m_error; }
+
+    // "line L, column C: message"
+    const std::string& GetError() const { return m_errorText; }
+
+private:
+    enum class State {
+        Value,          // A value is expected
+        FirstElement,   // After '[': a value or ']'
+        FirstMember,    // After '{': a key or '}'
+        Member,         // After ',' in an object: a key
+        AfterValue,     // After a value: ',' or the container's close
+        Done
+    };
+
+    const char* m_data;
+    size_t m_length;
+    size_t m_offset;
+    size_t m_tokenOffset;
+    State m_state;
+    std::vector<char> m_stack;
+
+    std::string m_string;
+    double m_number;
+    int64_t m_integer;
+    bool m_isInteger;
+
+    bool m_error;
+    std::string m_errorText;
+
+    JsonToken FailAt(size_t offset, const char* message);
+    bool SkipWhitespace();
+    JsonToken ReadValue();
+    JsonToken ReadMember();
+    JsonToken ReadLiteral(const char* literal, size_t length, JsonToken token);
+    JsonToken ReadNumber();
+    bool ReadString();
+    JsonToken Close(char close);
+    void ValueDone() { m_state = m_stack.empty() ? State::Done : State::AfterValue; }
+};
+
+} // namespace DriverMonitor
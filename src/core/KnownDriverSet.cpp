@@ -0,0 +1,142 @@
+#include "KnownDriverSet.h"
+#include "Utils.h"
+
+namespace {
+    const size_t kInitialCapacity = 64; // Power of two
+
+    bool EqualsIgnoreCase(const std::string& stored, const char* name, size_t length) {
+        if (stored.size() != length) {
+            return false;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            if (DriverMonitor::Utils::FoldCase(stored[i]) != DriverMonitor::Utils::FoldCase(name[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+namespace DriverMonitor {
+
+KnownDriverSet::KnownDriverSet()
+    : m_size(0)
+    , m_generation(1)
+    , m_nameBytes(0)
+    , m_memory(MemorySubsystem::KnownDrivers) {
+    m_slots.resize(kInitialCapacity, Slot{ 0, 0, 0, 0 });
+    UpdateMemoryCharge();
+}
+
+KnownDriverSet::~KnownDriverSet() {
+}
+
+void KnownDriverSet::BeginScan() {
+    m_generation++;
+}
+
+size_t KnownDriverSet::FindSlot(uint64_t hash, const char* name, size_t length) const {
+    size_t mask = m_slots.size() - 1;
+    size_t index = static_cast<size_t>(hash) & mask;
+    // A colliding hash with another name keeps probing
+    while (m_slots[index].hash != 0 &&
+           (m_slots[index].hash != hash || !EqualsIgnoreCase(m_names[m_slots[index].nameIndex], name, length))) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+bool KnownDriverSet::Mark(uint64_t nameHash, const char* name, size_t length, uint32_t* flags) {
+    Slot& slot = m_slots[FindSlot(NormalizeHash(nameHash), name, length)];
+    if (slot.hash == 0) {
+        return false;
+    }
+
+    slot.generation = m_generation;
+    if (flags) {
+        *flags = slot.flags;
+    }
+    return true;
+}
+
+void KnownDriverSet::Insert(uint64_t nameHash, const std::string& name, uint32_t flags) {
+    uint64_t hash = NormalizeHash(nameHash);
+    Slot& existing = m_slots[FindSlot(hash, name.data(), name.size())];
+    if (existing.hash != 0) {
+        existing.generation = m_generation;
+        existing.flags = flags;
+        return;
+    }
+
+    // Keep load factor at or below 1/2
+    if ((m_size + 1) * 2 > m_slots.size()) {
+        Grow();
+    }
+
+    Slot slot;
+    slot.hash = hash;
+    slot.generation = m_generation;
+    slot.flags = flags;
+    if (!m_freeNames.empty()) {
+        slot.nameIndex = m_freeNames.back();
+        m_freeNames.pop_back();
+        m_names[slot.nameIndex] = name;
+    } else {
+        slot.nameIndex = static_cast<uint32_t>(m_names.size());
+        m_names.push_back(name);
+    }
+    m_nameBytes += MemoryAccounting::GetHeapBytes(m_names[slot.nameIndex]);
+
+    InsertSlot(slot);
+    m_size++;
+    UpdateMemoryCharge();
+}
+
+void KnownDriverSet::SetFlags(uint64_t nameHash, const char* name, size_t length, uint32_t flags) {
+    Slot& slot = m_slots[FindSlot(NormalizeHash(nameHash), name, length)];
+    if (slot.hash != 0) {
+        slot.flags = flags;
+    }
+}
+
+size_t KnownDriverSet::GetMemoryBytes() const {
+    return m_slots.capacity() * sizeof(Slot) +
+           m_names.capacity() * sizeof(std::string) +
+           m_freeNames.capacity() * sizeof(uint32_t) + m_nameBytes;
+}
+
+void KnownDriverSet::Clear() {
+    m_slots.assign(kInitialCapacity, Slot{ 0, 0, 0, 0 });
+    m_names.clear();
+    m_freeNames.clear();
+    m_size = 0;
+    m_nameBytes = 0;
+    UpdateMemoryCharge();
+}
+
+void KnownDriverSet::Grow() {
+    Rebuild(m_slots.size() * 2);
+}
+
+void KnownDriverSet::Rebuild(size_t capacity) {
+    std::vector<Slot> oldSlots(capacity, Slot{ 0, 0, 0, 0 });
+    oldSlots.swap(m_slots);
+
+    for (const auto& slot : oldSlots) {
+        if (slot.hash != 0) {
+            InsertSlot(slot);
+        }
+    }
+}
+
+void KnownDriverSet::InsertSlot(const Slot& slot) {
+    // Names in the table are distinct: the first empty slot of the chain
+    size_t mask = m_slots.size() - 1;
+    size_t index = static_cast<size_t>(slot.hash) & mask;
+    while (m_slots[index].hash != 0) {
+        index = (index + 1) & mask;
+    }
+    m_slots[index] = slot;
+}
+
+} // namespace DriverMonitor
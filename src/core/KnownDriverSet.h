@@ -0,0 +1,100 @@
+#pragma once
+
+#include "MemoryAccounting.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Flat open-addressing set of driver names keyed by precomputed name hash.
+// Every entry carries the generation of the scan that last saw it, so a
+// mark-and-sweep pass per scan finds drivers that disappeared. A hash match
+// is confirmed by comparing the stored name (ASCII case-insensitive), so a
+// name crafted to collide with a known driver is still reported as new.
+class KnownDriverSet {
+public:
+    KnownDriverSet();
+    ~KnownDriverSet();
+
+    // Start a new scan generation
+    void BeginScan();
+
+    // Mark a known entry as seen in this scan; returns false if unknown.
+    // nameHash is Utils::HashIgnoreCase of the name; flags (optional)
+    // receives the stored flags.
+    bool Mark(uint64_t nameHash, const char* name, size_t length, uint32_t* flags = nullptr);
+    bool Mark(uint64_t nameHash, const std::string& name, uint32_t* flags = nullptr) {
+        return Mark(nameHash, name.data(), name.size(), flags);
+    }
+
+    // Insert a new entry, marked as seen in this scan
+    void Insert(uint64_t nameHash, const std::string& name, uint32_t flags = 0);
+
+    // Replace the flags of a known entry
+    void SetFlags(uint64_t nameHash, const char* name, size_t length, uint32_t flags);
+    void SetFlags(uint64_t nameHash, const std::string& name, uint32_t flags) {
+        SetFlags(nameHash, name.data(), name.size(), flags);
+    }
+
+    // Remove entries not seen since BeginScan; calls onRemoved(name, flags) for each
+    template <typename Callback>
+    void Sweep(Callback onRemoved);
+
+    // Get number of entries
+    size_t GetSize() const { return m_size; }
+
+    // Approximate heap usage in bytes (charged to MemorySubsystem::KnownDrivers)
+    size_t GetMemoryBytes() const;
+
+    void Clear();
+
+private:
+    struct Slot {
+        uint64_t hash;          // 0 = empty
+        uint32_t generation;
+        uint32_t flags;
+        uint32_t nameIndex;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<std::string> m_names;
+    std::vector<uint32_t> m_freeNames;
+    size_t m_size;
+    uint32_t m_generation;
+    size_t m_nameBytes;             // Heap bytes of the names
+    MemoryCharge m_memory;
+
+    static uint64_t NormalizeHash(uint64_t hash) { return hash ? hash : 1; }
+    // Slot holding name, else the empty slot ending its probe chain
+    size_t FindSlot(uint64_t hash, const char* name, size_t length) const;
+    void Grow();
+    void Rebuild(size_t capacity);
+    void InsertSlot(const Slot& slot);
+    void UpdateMemoryCharge() { m_memory.Set(GetMemoryBytes()); }
+};
+
+template <typename Callback>
+void KnownDriverSet::Sweep(Callback onRemoved) {
+    size_t removed = 0;
+    for (auto& slot : m_slots) {
+        if (slot.hash != 0 && slot.generation != m_generation) {
+            onRemoved(m_names[slot.nameIndex], slot.flags);
+            m_nameBytes -= MemoryAccounting::GetHeapBytes(m_names[slot.nameIndex]);
+            m_names[slot.nameIndex].clear();
+            m_names[slot.nameIndex].shrink_to_fit();
+            m_freeNames.push_back(slot.nameIndex);
+            slot.hash = 0;
+            removed++;
+        }
+    }
+
+    if (removed > 0) {
+        // Removal breaks linear probe chains; reinsert the survivors
+        m_size -= removed;
+        Rebuild(m_slots.size());
+        UpdateMemoryCharge();
+    }
+}
+
+} // namespace DriverMonitor
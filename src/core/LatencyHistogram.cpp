@@ -0,0 +1,251 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace DriverMonitor {
+
+// One thread's histograms, one per stage. Only the owning thread writes
+// (plain load + store); readers load concurrently.
+struct LatencyShard {
+    struct Stage {
+        std::atomic<uint64_t> buckets[LatencyHistogram::kBucketCount];
+        std::atomic<uint64_t> total;
+        std::atomic<uint64_t> max;
+    };
+
+    std::atomic<bool> claimed;
+    std::unique_ptr<Stage[]> stages;
+    LatencyShard* next;
+
+    explicit LatencyShard(size_t stageCount) : claimed(true), stages(new Stage[stageCount]), next(nullptr) {}
+};
+
+// Every thread's shard of one recorder: a list that only grows, so readers
+// walk it without a lock while threads join
+struct LatencyShards {
+    size_t stageCount;
+    std::atomic<LatencyShard*> head;
+
+    explicit LatencyShards(size_t count) : stageCount(count), head(nullptr) {}
+
+    ~LatencyShards() {
+        LatencyShard* shard = head.load(std::memory_order_acquire);
+        while (shard) {
+            LatencyShard* next = shard->next;
+            delete shard;
+            shard = next;
+        }
+    }
+};
+
+namespace {
+    std::atomic<uint64_t> g_nextRecorderId(1);
+
+    // Index of the highest set bit (value != 0)
+    int GetHighestBit(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    void Increment(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void ClearStage(LatencyShard::Stage& stage) {
+        for (auto& bucket : stage.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        stage.total.store(0, std::memory_order_relaxed);
+        stage.max.store(0, std::memory_order_relaxed);
+    }
+
+    LatencyShard* ClaimShard(LatencyShards& shards) {
+        for (LatencyShard* shard = shards.head.load(std::memory_order_acquire); shard; shard = shard->next) {
+            bool expected = false;
+            if (!shard->claimed.load(std::memory_order_relaxed) &&
+                shard->claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return shard;
+            }
+        }
+        LatencyShard* shard = new LatencyShard(shards.stageCount);
+        for (size_t i = 0; i < shards.stageCount; ++i) {
+            ClearStage(shard->stages[i]);
+        }
+        LatencyShard* head = shards.head.load(std::memory_order_relaxed);
+        do {
+            shard->next = head;
+        } while (!shards.head.compare_exchange_weak(head, shard, std::memory_order_release, std::memory_order_relaxed));
+        return shard;
+    }
+
+    // The calling thread's shard of each recorder it has recorded into
+    struct ThreadShards {
+        struct Entry {
+            uint64_t recorderId;
+            std::shared_ptr<LatencyShards> shards;
+            LatencyShard* shard;
+        };
+
+        uint64_t lastRecorderId;
+        LatencyShard* lastShard;
+        std::vector<Entry> entries;
+
+        ThreadShards() : lastRecorderId(0), lastShard(nullptr) {}
+
+        ~ThreadShards() {
+            for (auto& entry : entries) {
+                entry.shard->claimed.store(false, std::memory_order_release);
+            }
+        }
+
+        LatencyShard* Find(uint64_t recorderId, const std::shared_ptr<LatencyShards>& shards) {
+            for (auto& entry : entries) {
+                if (entry.recorderId == recorderId) {
+                    return entry.shard;
+                }
+            }
+
+            // Drop recorders that were destroyed (only this thread still holds them)
+            entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                         [](const Entry& entry) { return entry.shards.use_count() == 1; }),
+                          entries.end());
+
+            LatencyShard* shard = ClaimShard(*shards);
+            entries.push_back({ recorderId, shards, shard });
+            return shard;
+        }
+    };
+
+    thread_local ThreadShards t_threadShards;
+}
+
+LatencyHistogram::LatencyHistogram() {
+    Reset();
+}
+
+size_t LatencyHistogram::GetBucketIndex(uint64_t value) {
+    const uint64_t kMaxValue = (uint64_t(1) << kMaxValueBits) - 1;
+    if (value > kMaxValue) {
+        value = kMaxValue;
+    }
+    if (value < (uint64_t(2) << kSubBucketBits)) {
+        return static_cast<size_t>(value);
+    }
+    // [2^k, 2^(k+1)) is split into 2^kSubBucketBits buckets of 2^shift values
+    int highestBit = GetHighestBit(value);
+    int shift = highestBit - kSubBucketBits;
+    return (static_cast<size_t>(shift) << kSubBucketBits) + static_cast<size_t>(value >> shift);
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t index) {
+    if (index < (size_t(2) << kSubBucketBits)) {
+        return index;
+    }
+    int shift = static_cast<int>(index >> kSubBucketBits) - 1;
+    uint64_t subBucket = (index & ((size_t(1) << kSubBucketBits) - 1)) + (uint64_t(1) << kSubBucketBits);
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value) {
+    m_buckets[GetBucketIndex(value)]++;
+    m_count++;
+    m_total += value;
+    m_max = std::max(m_max, value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_total += other.m_total;
+    m_max = std::max(m_max, other.m_max);
+}
+
+void LatencyHistogram::Reset() {
+    m_buckets.fill(0);
+    m_count = 0;
+    m_total = 0;
+    m_max = 0;
+}
+
+uint64_t LatencyHistogram::GetPercentile(double fraction) const {
+    if (m_count == 0) {
+        return 0;
+    }
+    // Rank of the sample that fraction of the samples do not exceed (1-based)
+    uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(m_count) + 0.5);
+    rank = std::min(std::max<uint64_t>(rank, 1), m_count);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            return std::min(GetBucketUpperBound(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+LatencyRecorder::LatencyRecorder(size_t stageCount)
+    : m_stageCount(stageCount)
+    , m_id(g_nextRecorderId.fetch_add(1, std::memory_order_relaxed))
+    , m_shards(std::make_shared<LatencyShards>(stageCount)) {
+}
+
+LatencyRecorder::~LatencyRecorder() {
+}
+
+void LatencyRecorder::Record(size_t stage, uint64_t ns) {
+    ThreadShards& threadShards = t_threadShards;
+    LatencyShard* shard = threadShards.lastShard;
+    if (threadShards.lastRecorderId != m_id) {
+        shard = threadShards.Find(m_id, m_shards);
+        threadShards.lastRecorderId = m_id;
+        threadShards.lastShard = shard;
+    }
+
+    LatencyShard::Stage& histogram = shard->stages[stage];
+    Increment(histogram.buckets[LatencyHistogram::GetBucketIndex(ns)], 1);
+    Increment(histogram.total, ns);
+    if (ns > histogram.max.load(std::memory_order_relaxed)) {
+        histogram.max.store(ns, std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram LatencyRecorder::GetHistogram(size_t stage) const {
+    LatencyHistogram merged;
+    for (const LatencyShard* shard = m_shards->head.load(std::memory_order_acquire); shard; shard = shard->next) {
+        const LatencyShard::Stage& histogram = shard->stages[stage];
+        uint64_t count = 0;
+        for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+            uint64_t buckets = histogram.buckets[i].load(std::memory_order_relaxed);
+            merged.m_buckets[i] += buckets;
+            count += buckets;
+        }
+        // Counted from the buckets, so percentiles stay consistent with a writer mid-update
+        merged.m_count += count;
+        merged.m_total += histogram.total.load(std::memory_order_relaxed);
+        merged.m_max = std::max(merged.m_max, histogram.max.load(std::memory_order_relaxed));
+    }
+    return merged;
+}
+
+void LatencyRecorder::Reset() {
+    for (LatencyShard* shard = m_shards->head.load(std::memory_order_acquire); shard; shard = shard->next) {
+        for (size_t i = 0; i < m_stageCount; ++i) {
+            ClearStage(shard->stages[i]);
+        }
+    }
+}
+
+} // namespace DriverMonitor
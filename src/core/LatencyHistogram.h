@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace DriverMonitor {
+
+// Latency distribution with bounded relative error (HDR-style log-linear
+// buckets). Values below 64 ns are exact; above that every power of two is
+// split into 32 buckets, so a reported percentile is within ~3% of the true
+// value. Values are clamped to about 18 minutes.
+class LatencyHistogram {
+public:
+    static const int kSubBucketBits = 5;
+    static const int kMaxValueBits = 40;
+    static const size_t kBucketCount = static_cast<size_t>(kMaxValueBits - kSubBucketBits + 1) << kSubBucketBits;
+
+    LatencyHistogram();
+
+    // Bucket of a value, and the largest value that lands in a bucket
+    static size_t GetBucketIndex(uint64_t value);
+    static uint64_t GetBucketUpperBound(size_t index);
+
+    void Record(uint64_t value);
+
+    // Add another histogram's samples
+    void Merge(const LatencyHistogram& other);
+
+    void Reset();
+
+    uint64_t GetCount() const { return m_count; }
+    uint64_t GetTotal() const { return m_total; }
+    uint64_t GetMax() const { return m_max; }
+    uint64_t GetBucketCount(size_t index) const { return m_buckets[index]; }
+
+    // Smallest recorded value (bucket upper bound, at most the maximum) that
+    // at least fraction of the samples do not exceed; 0 when empty
+    uint64_t GetPercentile(double fraction) const;
+
+private:
+    friend class LatencyRecorder;
+
+    std::array<uint64_t, kBucketCount> m_buckets;
+    uint64_t m_count;
+    uint64_t m_total;
+    uint64_t m_max;
+};
+
+// Latency histograms for a fixed set of stages, recorded from any thread
+// without locks or shared writes: each thread records into its own
+// histograms (claimed on its first Record, handed to a later thread when it
+// exits), and readers merge all of them on demand, also without locks.
+class LatencyRecorder {
+public:
+    explicit LatencyRecorder(size_t stageCount);
+    ~LatencyRecorder();
+
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    // Record one sample for stage (calling thread's histogram)
+    void Record(size_t stage, uint64_t ns);
+
+    // All threads' samples for stage, merged (any thread)
+    LatencyHistogram GetHistogram(size_t stage) const;
+
+    // Clear every stage; only while no thread records
+    void Reset();
+
+    size_t GetStageCount() const { return m_stageCount; }
+
+private:
+    size_t m_stageCount;
+    uint64_t m_id;                                  // Process-unique, keys the threads' lookup
+    std::shared_ptr<struct LatencyShards> m_shards; // Shared with recording threads, which may outlive this
+};
+
+} // namespace DriverMonitor
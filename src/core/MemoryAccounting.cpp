@@ -0,0 +1,29 @@
+#include "MemoryAccounting.h"
+
+namespace DriverMonitor {
+
+namespace {
+    const char* const kSubsystemNames[] = {
+        "eventHistory", "knownDrivers", "config", "signerCache", "trace", "forwarder",
+        "processCache"
+    };
+    static_assert(sizeof(kSubsystemNames) / sizeof(kSubsystemNames[0]) == static_cast<size_t>(MemorySubsystem::Count),
+                  "every memory subsystem needs a name");
+}
+
+std::atomic<int64_t> MemoryAccounting::s_bytes[static_cast<size_t>(MemorySubsystem::Count)] = {};
+
+const char* GetMemorySubsystemName(MemorySubsystem subsystem) {
+    size_t index = static_cast<size_t>(subsystem);
+    return index < static_cast<size_t>(MemorySubsystem::Count) ? kSubsystemNames[index] : "unknown";
+}
+
+uint64_t MemoryAccounting::GetTotalBytes() {
+    uint64_t total = 0;
+    for (size_t i = 0; i < static_cast<size_t>(MemorySubsystem::Count); ++i) {
+        total += GetBytes(static_cast<MemorySubsystem>(i));
+    }
+    return total;
+}
+
+} // namespace DriverMonitor
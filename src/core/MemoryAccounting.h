@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DriverMonitor {
+
+// Owners of long-lived memory, for per-subsystem accounting
+enum class MemorySubsystem : uint8_t {
+    EventHistory,       // EventManager storage
+    KnownDrivers,       // Sources' known-driver sets and directory snapshots
+    Config,             // Published configuration snapshots and whitelists
+    SignerCache,        // Cached signer verdicts
+    Trace,              // Span trace ring buffers
+    Forwarder,          // Event batches waiting for the collector
+    ProcessCache,       // Cached process images for attribution
+    Count
+};
+
+// Short subsystem name ("eventHistory", "signerCache", ...)
+const char* GetMemorySubsystemName(MemorySubsystem subsystem);
+
+// Process-wide bytes per subsystem. Components count what they hold (element
+// sizes plus heap-allocated string capacity) and charge the changes here;
+// allocator overhead is not included, so the totals are a floor of the real
+// heap use. Reads are relaxed atomic loads.
+class MemoryAccounting {
+public:
+    static void Charge(MemorySubsystem subsystem, int64_t bytes) {
+        s_bytes[static_cast<size_t>(subsystem)].fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    static uint64_t GetBytes(MemorySubsystem subsystem) {
+        int64_t bytes = s_bytes[static_cast<size_t>(subsystem)].load(std::memory_order_relaxed);
+        return bytes > 0 ? static_cast<uint64_t>(bytes) : 0;
+    }
+
+    static uint64_t GetTotalBytes();
+
+    // Heap bytes of a string (0 while it fits the small-string buffer)
+    static size_t GetHeapBytes(const std::string& value) {
+        const char* data = value.data();
+        const char* object = reinterpret_cast<const char*>(&value);
+        bool isInline = data >= object && data < object + sizeof(value);
+        return isInline ? 0 : value.capacity() + 1;
+    }
+
+private:
+    static std::atomic<int64_t> s_bytes[static_cast<size_t>(MemorySubsystem::Count)];
+};
+
+// The bytes one component holds, charged to its subsystem and released when
+// the component is destroyed. A copy charges the same bytes again (it holds
+// a copy of the memory).
+class MemoryCharge {
+public:
+    explicit MemoryCharge(MemorySubsystem subsystem) : m_subsystem(subsystem), m_bytes(0) {}
+    MemoryCharge(const MemoryCharge& other) : m_subsystem(other.m_subsystem), m_bytes(0) { Set(other.Get()); }
+    ~MemoryCharge() { Set(0); }
+
+    MemoryCharge& operator=(const MemoryCharge& other) {
+        Set(other.Get());
+        return *this;
+    }
+
+    void Add(size_t bytes) {
+        m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        MemoryAccounting::Charge(m_subsystem, static_cast<int64_t>(bytes));
+    }
+
+    void Subtract(size_t bytes) {
+        m_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        MemoryAccounting::Charge(m_subsystem, -static_cast<int64_t>(bytes));
+    }
+
+    // Replace the charge (after rebuilding a structure)
+    void Set(size_t bytes) {
+        size_t previous = m_bytes.exchange(bytes, std::memory_order_relaxed);
+        MemoryAccounting::Charge(m_subsystem, static_cast<int64_t>(bytes) - static_cast<int64_t>(previous));
+    }
+
+    size_t Get() const { return m_bytes.load(std::memory_order_relaxed); }
+
+private:
+    MemorySubsystem m_subsystem;
+    std::atomic<size_t> m_bytes;
+};
+
+} // namespace DriverMonitor
@@ -0,0 +1,216 @@
+#include "Metrics.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace DriverMonitor {
+
+namespace {
+    // Histogram bucket bounds in seconds: 1 us to 10 s
+    const double kHistogramBounds[] = {
+        0.000001, 0.000005, 0.00001, 0.00005, 0.0001, 0.0005,
+        0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0, 10.0
+    };
+
+    const char* GetTypeName(MetricType type) {
+        switch (type) {
+            case MetricType::Counter: return "counter";
+            case MetricType::Gauge: return "gauge";
+            case MetricType::Histogram: return "histogram";
+        }
+        return "untyped";
+    }
+
+    void AppendDouble(std::string& out, double value) {
+        char buffer[32];
+        int length = std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+        out.append(buffer, static_cast<size_t>(length));
+    }
+}
+
+void MetricsWriter::BeginFamily(const std::string& name, const std::string& help, MetricType type) {
+    m_out += "# HELP ";
+    m_out += name;
+    m_out += ' ';
+    // Help text escapes only backslash and newline
+    for (char c : help) {
+        if (c == '\\') {
+            m_out += "\\\\";
+        } else if (c == '\n') {
+            m_out += "\\n";
+        } else {
+            m_out += c;
+        }
+    }
+    m_out += "\n# TYPE ";
+    m_out += name;
+    m_out += ' ';
+    m_out += GetTypeName(type);
+    m_out += '\n';
+}
+
+void MetricsWriter::AppendName(const std::string& name, const std::string& labels, const char* extraLabel) {
+    m_out += name;
+    if (labels.empty() && !extraLabel) {
+        return;
+    }
+    m_out += '{';
+    m_out += labels;
+    if (extraLabel) {
+        if (!labels.empty()) {
+            m_out += ',';
+        }
+        m_out += extraLabel;
+    }
+    m_out += '}';
+}
+
+void MetricsWriter::Sample(const std::string& name, const std::string& labels, uint64_t value) {
+    AppendName(name, labels);
+    m_out += ' ';
+    m_out += std::to_string(value);
+    m_out += '\n';
+}
+
+void MetricsWriter::Sample(const std::string& name, const std::string& labels, int64_t value) {
+    AppendName(name, labels);
+    m_out += ' ';
+    m_out += std::to_string(value);
+    m_out += '\n';
+}
+
+void MetricsWriter::Sample(const std::string& name, const std::string& labels, double value) {
+    AppendName(name, labels);
+    m_out += ' ';
+    AppendDouble(m_out, value);
+    m_out += '\n';
+}
+
+void MetricsWriter::Histogram(const std::string& name, const std::string& labels, const LatencyHistogram& histogram) {
+    // Cumulative counts: walk the latency buckets once across all bounds
+    std::string bucketName = name + "_bucket";
+    size_t index = 0;
+    uint64_t cumulative = 0;
+    for (double bound : kHistogramBounds) {
+        uint64_t boundNs = static_cast<uint64_t>(bound * 1e9);
+        size_t last = LatencyHistogram::GetBucketIndex(boundNs);
+        for (; index <= last && index < LatencyHistogram::kBucketCount; ++index) {
+            cumulative += histogram.GetBucketCount(index);
+        }
+        std::string le = "le=\"";
+        AppendDouble(le, bound);
+        le += '"';
+        AppendName(bucketName, labels, le.c_str());
+        m_out += ' ';
+        m_out += std::to_string(cumulative);
+        m_out += '\n';
+    }
+    AppendName(bucketName, labels, "le=\"+Inf\"");
+    m_out += ' ';
+    m_out += std::to_string(histogram.GetCount());
+    m_out += '\n';
+
+    Sample(name + "_sum", labels, static_cast<double>(histogram.GetTotal()) / 1e9);
+    Sample(name + "_count", labels, histogram.GetCount());
+}
+
+std::string MetricsWriter::Label(const char* name, const std::string& value) {
+    std::string label = name;
+    label += "=\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            label += '\\';
+            label += c;
+        } else if (c == '\n') {
+            label += "\\n";
+        } else {
+            label += c;
+        }
+    }
+    label += '"';
+    return label;
+}
+
+MetricsRegistry::MetricsRegistry() : m_nextCollectorId(1) {
+}
+
+MetricsRegistry::~MetricsRegistry() {
+}
+
+MetricsRegistry::Series& MetricsRegistry::AddSeries(const std::string& name, const std::string& help,
+                                                    MetricType type, const std::string& labels) {
+    auto family = std::find_if(m_families.begin(), m_families.end(),
+                               [&](const Family& existing) { return existing.name == name; });
+    if (family == m_families.end()) {
+        m_families.push_back({ name, help, type, {} });
+        family = m_families.end() - 1;
+    }
+    family->series.push_back({ labels, nullptr, nullptr });
+    return family->series.back();
+}
+
+MetricCounter& MetricsRegistry::AddCounter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Series& series = AddSeries(name, help, MetricType::Counter, labels);
+    series.counter = std::make_unique<MetricCounter>();
+    return *series.counter;
+}
+
+MetricGauge& MetricsRegistry::AddGauge(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Series& series = AddSeries(name, help, MetricType::Gauge, labels);
+    series.gauge = std::make_unique<MetricGauge>();
+    return *series.gauge;
+}
+
+int MetricsRegistry::AddCollector(Collector collector) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int id = m_nextCollectorId++;
+    m_collectors.emplace_back(id, std::move(collector));
+    return id;
+}
+
+void MetricsRegistry::RemoveCollector(int id) {
+    // Waits for a scrape in progress, so the collector is not running afterwards
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_collectors.erase(std::remove_if(m_collectors.begin(), m_collectors.end(),
+                                      [id](const std::pair<int, Collector>& entry) { return entry.first == id; }),
+                       m_collectors.end());
+}
+
+std::string MetricsRegistry::Collect() const {
+    std::string out;
+    MetricsWriter writer(out);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& family : m_families) {
+        writer.BeginFamily(family.name, family.help, family.type);
+        for (const auto& series : family.series) {
+            if (series.counter) {
+                writer.Sample(family.name, series.labels, series.counter->Get());
+            } else {
+                writer.Sample(family.name, series.labels, series.gauge->Get());
+            }
+        }
+    }
+    for (const auto& collector : m_collectors) {
+        collector.second(writer);
+    }
+    return out;
+}
+
+void RegisterProcessMetrics(MetricsRegistry& registry) {
+    registry.AddCollector([](MetricsWriter& writer) {
+        uint64_t residentBytes = 0;
+        uint64_t peakBytes = 0;
+        if (!Utils::GetProcessMemory(residentBytes, peakBytes)) {
+            return;
+        }
+        writer.BeginFamily("process_resident_memory_bytes", "Resident memory size in bytes.", MetricType::Gauge);
+        writer.Sample("process_resident_memory_bytes", std::string(), residentBytes);
+        writer.BeginFamily("drivermonitor_peak_resident_memory_bytes", "Peak resident memory size in bytes.", MetricType::Gauge);
+        writer.Sample("drivermonitor_peak_resident_memory_bytes", std::string(), peakBytes);
+    });
+}
+
+} // namespace DriverMonitor
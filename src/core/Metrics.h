@@ -0,0 +1,118 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+enum class MetricType {
+    Counter,
+    Gauge,
+    Histogram
+};
+
+// Appends metric families in the Prometheus text exposition format (0.0.4)
+class MetricsWriter {
+public:
+    explicit MetricsWriter(std::string& out) : m_out(out) {}
+
+    // # HELP and # TYPE lines that start a family
+    void BeginFamily(const std::string& name, const std::string& help, MetricType type);
+
+    // One sample; labels are preformatted (`stage="filter"`, may be empty)
+    void Sample(const std::string& name, const std::string& labels, uint64_t value);
+    void Sample(const std::string& name, const std::string& labels, int64_t value);
+    void Sample(const std::string& name, const std::string& labels, double value);
+
+    // _bucket/_sum/_count samples of a latency histogram (ns) in seconds.
+    // Bucket counts are exact to the histogram's ~3% resolution.
+    void Histogram(const std::string& name, const std::string& labels, const LatencyHistogram& histogram);
+
+    // name="value" with the value escaped
+    static std::string Label(const char* name, const std::string& value);
+
+private:
+    std::string& m_out;
+
+    void AppendName(const std::string& name, const std::string& labels, const char* extraLabel = nullptr);
+};
+
+// Monotonic counter; Increment() is one relaxed atomic add
+class MetricCounter {
+public:
+    MetricCounter() : m_value(0) {}
+    void Increment(uint64_t amount = 1) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+    uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value;
+};
+
+// Value that goes up and down
+class MetricGauge {
+public:
+    MetricGauge() : m_value(0) {}
+    void Set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void Add(int64_t amount) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+    int64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_value;
+};
+
+// Metrics of one process. Counters and gauges are registered up front and
+// then updated with single atomics; collectors produce values computed at
+// scrape time (histograms, stats other components keep). Collect() reads
+// only those atomics and runs the collectors, which must not wait on a lock
+// the detection path holds, so a scrape never stalls detection.
+class MetricsRegistry {
+public:
+    using Collector = std::function<void(MetricsWriter& writer)>;
+
+    MetricsRegistry();
+    ~MetricsRegistry();
+
+    // Register one labeled series of a family (the family is created by its
+    // first series). The returned metric lives as long as the registry.
+    MetricCounter& AddCounter(const std::string& name, const std::string& help, const std::string& labels = std::string());
+    MetricGauge& AddGauge(const std::string& name, const std::string& help, const std::string& labels = std::string());
+
+    // Add a collector; returns an ID for RemoveCollector
+    int AddCollector(Collector collector);
+    void RemoveCollector(int id);
+
+    // Exposition of every metric
+    std::string Collect() const;
+
+private:
+    struct Series {
+        std::string labels;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        MetricType type;
+        std::vector<Series> series;
+    };
+
+    mutable std::mutex m_mutex;             // Registration and scrapes only
+    std::vector<Family> m_families;
+    std::vector<std::pair<int, Collector>> m_collectors;
+    int m_nextCollectorId;
+
+    Series& AddSeries(const std::string& name, const std::string& help, MetricType type, const std::string& labels);
+};
+
+// Process metrics: resident and peak resident memory
+void RegisterProcessMetrics(MetricsRegistry& registry);
+
+} // namespace DriverMonitor
@@ -0,0 +1,198 @@
+#include "MetricsServer.h"
+#include "Socket.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    // Longest the thread waits before checking for Stop()
+    const std::chrono::milliseconds kStopCheckInterval(250);
+
+    // A client gets this long to send its request
+    const int kReceiveTimeoutMs = 1000;
+
+    const size_t kMaxRequestSize = 8192;
+
+    std::string MakeResponse(const char* status, const char* contentType, const std::string& body) {
+        std::string response = "HTTP/1.1 ";
+        response += status;
+        response += "\r\nContent-Type: ";
+        response += contentType;
+        response += "\r\nContent-Length: ";
+        response += std::to_string(body.size());
+        response += "\r\nConnection: close\r\n\r\n";
+        response += body;
+        return response;
+    }
+}
+
+namespace DriverMonitor {
+
+MetricsServer::MetricsServer(const MetricsRegistry* registry)
+    : m_registry(registry)
+    , m_stop(false)
+    , m_listenSocket(Socket::kNoSocket)
+    , m_port(0)
+    , m_scrapes(0)
+    , m_fileWrites(0) {
+}
+
+MetricsServer::~MetricsServer() {
+    Stop();
+}
+
+bool MetricsServer::Start(const MetricsServerOptions& options) {
+    if (m_thread) {
+        return false;
+    }
+    m_options = options;
+    m_lastError.clear();
+
+    if (options.listen) {
+        if (!Socket::Init()) {
+            m_lastError = "cannot initialize sockets";
+            return false;
+        }
+        // Loopback only: the endpoint is for a local agent, not the network
+        m_listenSocket = Socket::Listen(true, options.port, m_port, m_lastError);
+        if (m_listenSocket == Socket::kNoSocket) {
+            Socket::Cleanup();
+            return false;
+        }
+    }
+
+    m_stop = false;
+    try {
+        m_thread = std::make_unique<std::thread>(&MetricsServer::Run, this);
+    } catch (...) {
+        m_lastError = "cannot start thread";
+        if (m_listenSocket != Socket::kNoSocket) {
+            Socket::Close(m_listenSocket);
+            m_listenSocket = Socket::kNoSocket;
+            Socket::Cleanup();
+        }
+        return false;
+    }
+    return true;
+}
+
+void MetricsServer::Stop() {
+    if (!m_thread) {
+        return;
+    }
+    m_stop = true;
+    if (m_thread->joinable()) {
+        m_thread->join();
+    }
+    m_thread.reset();
+
+    if (m_listenSocket != Socket::kNoSocket) {
+        Socket::Close(m_listenSocket);
+        m_listenSocket = Socket::kNoSocket;
+        Socket::Cleanup();
+    }
+}
+
+void MetricsServer::Run() {
+    bool writeFile = !m_options.textFile.empty();
+    auto nextWrite = std::chrono::steady_clock::now();
+
+    while (!m_stop) {
+        auto now = std::chrono::steady_clock::now();
+        if (writeFile && now >= nextWrite) {
+            if (WriteTextFile(m_options.textFile, m_registry->Collect())) {
+                m_fileWrites++;
+            }
+            nextWrite = now + m_options.interval;
+        }
+
+        auto wait = kStopCheckInterval;
+        if (writeFile) {
+            wait = std::min(wait, std::chrono::duration_cast<std::chrono::milliseconds>(nextWrite - now) +
+                                  std::chrono::milliseconds(1));
+        }
+
+        if (m_listenSocket == Socket::kNoSocket) {
+            std::this_thread::sleep_for(wait);
+            continue;
+        }
+        if (!Socket::WaitReadable(m_listenSocket, wait)) {
+            continue;
+        }
+        intptr_t connection = Socket::Accept(m_listenSocket);
+        if (connection != Socket::kNoSocket) {
+            ServeConnection(connection);
+        }
+    }
+}
+
+void MetricsServer::ServeConnection(intptr_t connection) {
+    // Read the request head; the body of a GET is ignored
+    std::string request;
+    char buffer[1024];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kReceiveTimeoutMs);
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestSize) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0 || !Socket::WaitReadable(connection, remaining)) {
+            Socket::Close(connection);
+            return;
+        }
+        int received = Socket::Receive(connection, buffer, sizeof(buffer));
+        if (received <= 0) {
+            Socket::Close(connection);
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    // Request line: METHOD SP TARGET SP VERSION
+    size_t methodEnd = request.find(' ');
+    size_t targetEnd = methodEnd == std::string::npos ? std::string::npos : request.find(' ', methodEnd + 1);
+    std::string response;
+    if (targetEnd == std::string::npos) {
+        response = MakeResponse("400 Bad Request", "text/plain", "Bad request\n");
+    } else {
+        std::string method = request.substr(0, methodEnd);
+        std::string target = request.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+        std::string path = target.substr(0, target.find('?'));
+        if (method != "GET" && method != "HEAD") {
+            response = MakeResponse("405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+        } else if (path != "/metrics") {
+            response = MakeResponse("404 Not Found", "text/plain", "Metrics are at /metrics\n");
+        } else {
+            response = MakeResponse("200 OK", "text/plain; version=0.0.4; charset=utf-8", m_registry->Collect());
+            if (method == "HEAD") {
+                response.resize(response.find("\r\n\r\n") + 4);
+            }
+            m_scrapes++;
+        }
+    }
+    Socket::SendAll(connection, response.data(), response.size());
+    Socket::Close(connection);
+}
+
+bool MetricsServer::WriteTextFile(const std::string& path, const std::string& text) {
+    // The collector reads *.prom files, so the temporary name must not end in .prom
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!file) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace DriverMonitor
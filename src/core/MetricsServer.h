@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Metrics.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace DriverMonitor {
+
+struct MetricsServerOptions {
+    bool listen;                            // Serve GET /metrics on 127.0.0.1
+    uint16_t port;                          // 0 = any free port (see GetPort)
+    std::string textFile;                   // Textfile-collector file ("" = none)
+    std::chrono::milliseconds interval;     // Between textfile rewrites
+
+    MetricsServerOptions() : listen(false), port(9464), interval(15000) {}
+};
+
+// Publishes a MetricsRegistry for Prometheus from one background thread:
+// a loopback-only HTTP listener answering GET /metrics, and/or a
+// node_exporter textfile-collector file rewritten atomically (temporary
+// file + rename) every interval. Connections are served one at a time with
+// a short receive timeout; scrapes only call MetricsRegistry::Collect().
+class MetricsServer {
+public:
+    explicit MetricsServer(const MetricsRegistry* registry);
+    ~MetricsServer();
+
+    // Bind the listener (if any) and start the thread; false + GetLastError() on failure
+    bool Start(const MetricsServerOptions& options);
+
+    // Stop serving (within a quarter second); the textfile is left in place
+    void Stop();
+
+    bool IsRunning() const { return m_thread != nullptr; }
+
+    // Port the listener is bound to
+    uint16_t GetPort() const { return m_port; }
+
+    // Requests answered, and textfile rewrites
+    uint64_t GetScrapeCount() const { return m_scrapes; }
+    uint64_t GetFileWriteCount() const { return m_fileWrites; }
+
+    const std::string& GetLastError() const { return m_lastError; }
+
+    // Write the exposition to path through a temporary file and a rename
+    static bool WriteTextFile(const std::string& path, const std::string& text);
+
+private:
+    const MetricsRegistry* m_registry;
+    MetricsServerOptions m_options;
+    std::unique_ptr<std::thread> m_thread;
+    std::atomic<bool> m_stop;
+    intptr_t m_listenSocket;                // Native socket (-1 = none)
+    uint16_t m_port;
+    std::atomic<uint64_t> m_scrapes;
+    std::atomic<uint64_t> m_fileWrites;
+    std::string m_lastError;
+
+    void Run();
+
+    // Read one request from a connection, answer it and close it
+    void ServeConnection(intptr_t connection);
+};
+
+} // namespace DriverMonitor
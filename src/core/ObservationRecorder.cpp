@@ -0,0 +1,99 @@
+#include "ObservationRecorder.h"
+#include "BinaryCodec.h"
+
+namespace {
+    const size_t kFlushThreshold = 64 * 1024;
+}
+
+namespace DriverMonitor {
+
+ObservationRecorder::ObservationRecorder()
+    : m_lastTime(0)
+    , m_recordCount(0) {
+}
+
+ObservationRecorder::~ObservationRecorder() {
+    Close();
+}
+
+bool ObservationRecorder::Open(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_file.is_open()) {
+        return false;
+    }
+
+    m_file.open(filePath, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open()) {
+        return false;
+    }
+
+    m_buffer.clear();
+    m_recordCount = 0;
+    m_lastTime = 0;
+
+    // Start time is written lazily by the first record
+    BinaryWriter writer(m_buffer);
+    writer.WriteBytes(ObservationLog::kMagic, sizeof(ObservationLog::kMagic));
+    writer.WriteByte(ObservationLog::kVersion);
+    return true;
+}
+
+void ObservationRecorder::Close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_file.is_open()) {
+        return;
+    }
+
+    FlushBuffer();
+    m_file.close();
+}
+
+void ObservationRecorder::BeginRecord(uint8_t type, int64_t timeMicros) {
+    BinaryWriter writer(m_buffer);
+
+    if (m_recordCount == 0) {
+        writer.WriteSignedVarint(timeMicros);
+        m_lastTime = timeMicros;
+    }
+
+    writer.WriteByte(type);
+    writer.WriteSignedVarint(timeMicros - m_lastTime);
+    m_lastTime = timeMicros;
+    m_recordCount++;
+}
+
+void ObservationRecorder::RecordObservation(const DriverEvent& event, int64_t timeMicros) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_file.is_open()) {
+        return;
+    }
+
+    BeginRecord(ObservationLog::kObservation, timeMicros);
+
+    BinaryWriter writer(m_buffer);
+    writer.WriteByte(static_cast<uint8_t>(event.source));
+    writer.WriteString(event.driverName);
+    writer.WriteString(event.installPath);
+    writer.WriteString(event.loadingMethod);
+    writer.WriteString(event.initiatedBy);
+    writer.WriteVarint(event.processId);
+    writer.WriteByte(event.isRemoval ? ObservationLog::kFlagRemoval : 0);
+    writer.WriteString(event.signerInfo);
+
+    if (m_buffer.size() >= kFlushThreshold) {
+        FlushBuffer();
+    }
+}
+
+void ObservationRecorder::FlushBuffer() {
+    if (!m_buffer.empty()) {
+        m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.clear();
+    }
+    m_file.flush();
+}
+
+} // namespace DriverMonitor
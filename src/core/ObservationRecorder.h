@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Utils.h"
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace DriverMonitor {
+
+// Observation log file layout (little endian, LEB128 varints):
+//   header:  "DMOB" magic, u8 version, signed varint start time (us since epoch)
+//   records: u8 record type, signed varint time delta (us) from the previous
+//            record, then the record payload
+namespace ObservationLog {
+    const char kMagic[4] = { 'D', 'M', 'O', 'B' };
+    const uint8_t kVersion = 2;
+
+    enum RecordType : uint8_t {
+        // u8 source, str name, str path, str method, str initiatedBy, varint pid,
+        // u8 flags, str signer (verification result on the recording host)
+        kObservation = 1
+    };
+
+    const uint8_t kFlagRemoval = 1;
+}
+
+// Captures the raw observations produced by the monitoring sources into a
+// compact binary file so they can be replayed later (see ReplaySource)
+class ObservationRecorder {
+public:
+    ObservationRecorder();
+    ~ObservationRecorder();
+
+    // Create/truncate the log file
+    bool Open(const std::string& filePath);
+
+    // Flush and close
+    void Close();
+
+    bool IsOpen() const { return m_file.is_open(); }
+
+    // Record a source observation and its signature verification result
+    // (called before classification, so replays rerun the whole pipeline)
+    void RecordObservation(const DriverEvent& event, int64_t timeMicros);
+
+    // Get number of records written
+    uint64_t GetRecordCount() const { return m_recordCount; }
+
+private:
+    std::mutex m_mutex;
+    std::ofstream m_file;
+    std::string m_buffer;
+    int64_t m_lastTime;
+    uint64_t m_recordCount;
+
+    void BeginRecord(uint8_t type, int64_t timeMicros);
+    void FlushBuffer();
+};
+
+} // namespace DriverMonitor
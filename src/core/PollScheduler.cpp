@@ -0,0 +1,249 @@
+#include "PollScheduler.h"
+#include "Trace.h"
+#include <algorithm>
+#include <climits>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace DriverMonitor {
+
+PollScheduler::PollScheduler()
+    : m_running(false)
+    , m_wakeups(0)
+    , m_random(static_cast<unsigned int>(std::chrono::steady_clock::now().time_since_epoch().count())) {
+#ifdef _WIN32
+    m_wakeEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+#else
+    m_wakePipe[0] = -1;
+    m_wakePipe[1] = -1;
+    if (pipe(m_wakePipe) == 0) {
+        for (int fd : m_wakePipe) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+#endif
+}
+
+PollScheduler::~PollScheduler() {
+    Stop();
+#ifdef _WIN32
+    if (m_wakeEvent) {
+        CloseHandle(m_wakeEvent);
+    }
+#else
+    for (int fd : m_wakePipe) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+int PollScheduler::AddSource(const PollSource& source) {
+    if (m_running) {
+        return -1;
+    }
+
+    auto state = std::make_unique<SourceState>();
+    state->source = source;
+    state->interval = source.minInterval;
+    m_sources.push_back(std::move(state));
+    return static_cast<int>(m_sources.size() - 1);
+}
+
+bool PollScheduler::Start() {
+    if (m_running) {
+        return false;
+    }
+
+    m_running = true;
+    try {
+        m_thread = std::make_unique<std::thread>(&PollScheduler::Run, this);
+    } catch (...) {
+        m_running = false;
+        return false;
+    }
+    return true;
+}
+
+void PollScheduler::Stop() {
+    if (!m_running) {
+        return;
+    }
+
+    m_running = false;
+    SignalWake();
+
+    if (m_thread && m_thread->joinable()) {
+        m_thread->join();
+    }
+    m_thread.reset();
+}
+
+void PollScheduler::Wake(int sourceId) {
+    if (sourceId < 0 || sourceId >= static_cast<int>(m_sources.size())) {
+        return;
+    }
+    m_sources[sourceId]->wakeRequested = true;
+    SignalWake();
+}
+
+std::vector<PollSourceStats> PollScheduler::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+
+    std::vector<PollSourceStats> stats;
+    for (const auto& state : m_sources) {
+        PollSourceStats entry;
+        entry.name = state->source.name;
+        entry.polls = state->polls;
+        entry.detections = state->detections;
+        entry.currentInterval = state->interval;
+        stats.push_back(entry);
+    }
+    return stats;
+}
+
+void PollScheduler::Run() {
+    Tracer::SetThreadName("poll");
+    auto now = std::chrono::steady_clock::now();
+    for (auto& state : m_sources) {
+        state->nextDue = now;
+    }
+
+    while (m_running) {
+        now = std::chrono::steady_clock::now();
+
+        for (auto& state : m_sources) {
+            if (!m_running) {
+                break;
+            }
+            if (state->wakeRequested.exchange(false) || state->nextDue <= now) {
+                PollSourceNow(*state);
+            }
+        }
+
+        if (m_sources.empty() || !m_running) {
+            WaitUntil(now + std::chrono::hours(1));
+        } else {
+            auto deadline = m_sources.front()->nextDue;
+            for (const auto& state : m_sources) {
+                deadline = std::min(deadline, state->nextDue);
+            }
+            WaitUntil(deadline);
+        }
+        m_wakeups++;
+    }
+}
+
+void PollScheduler::PollSourceNow(SourceState& state) {
+    bool changed = state.source.poll();
+    state.polls++;
+
+    std::chrono::milliseconds interval;
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        if (changed) {
+            // Speed up after a detection
+            state.detections++;
+            state.interval = state.source.minInterval;
+        } else {
+            // Back off while idle
+            state.interval = std::min(state.interval * 2, state.source.maxInterval);
+        }
+        interval = state.interval;
+    }
+
+    state.nextDue = std::chrono::steady_clock::now() + Jitter(interval);
+}
+
+std::chrono::milliseconds PollScheduler::Jitter(std::chrono::milliseconds interval) {
+    // +/-10% so sources with equal intervals drift apart
+    long long spread = interval.count() / 10;
+    if (spread <= 0) {
+        return interval;
+    }
+    std::uniform_int_distribution<long long> distribution(-spread, spread);
+    return interval + std::chrono::milliseconds(distribution(m_random));
+}
+
+void PollScheduler::WaitUntil(std::chrono::steady_clock::time_point deadline) {
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    if (remaining.count() < 0) {
+        remaining = std::chrono::milliseconds(0);
+    }
+
+#ifdef _WIN32
+    std::vector<HANDLE> handles;
+    std::vector<SourceState*> owners;
+    handles.push_back(m_wakeEvent);
+    owners.push_back(nullptr);
+
+    for (auto& state : m_sources) {
+        NativeWaitHandle handle = nullptr;
+        if (state->source.waitHandle && state->source.waitHandle(handle) &&
+            handles.size() < MAXIMUM_WAIT_OBJECTS) {
+            handles.push_back(handle);
+            owners.push_back(state.get());
+        }
+    }
+
+    DWORD timeout = static_cast<DWORD>(std::min<long long>(remaining.count(), INFINITE - 1));
+    DWORD result = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, timeout);
+    if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + handles.size()) {
+        owners[result - WAIT_OBJECT_0]->wakeRequested = true;
+    }
+#else
+    std::vector<struct pollfd> fds;
+    std::vector<SourceState*> owners;
+    fds.push_back({ m_wakePipe[0], POLLIN, 0 });
+    owners.push_back(nullptr);
+
+    for (auto& state : m_sources) {
+        NativeWaitHandle fd = -1;
+        if (state->source.waitHandle && state->source.waitHandle(fd) && fd >= 0) {
+            fds.push_back({ fd, POLLIN, 0 });
+            owners.push_back(state.get());
+        }
+    }
+
+    int timeout = static_cast<int>(std::min<long long>(remaining.count(), INT_MAX));
+    int result = poll(fds.data(), fds.size(), timeout);
+    if (result <= 0) {
+        return;
+    }
+
+    if (fds[0].revents & POLLIN) {
+        char buffer[64];
+        while (read(m_wakePipe[0], buffer, sizeof(buffer)) > 0) {
+        }
+    }
+    for (size_t i = 1; i < fds.size(); ++i) {
+        if (fds[i].revents) {
+            owners[i]->wakeRequested = true;
+        }
+    }
+#endif
+}
+
+void PollScheduler::SignalWake() {
+#ifdef _WIN32
+    if (m_wakeEvent) {
+        SetEvent(m_wakeEvent);
+    }
+#else
+    if (m_wakePipe[1] >= 0) {
+        char byte = 1;
+        ssize_t written = write(m_wakePipe[1], &byte, 1);
+        (void)written; // Pipe full means a wakeup is already pending
+    }
+#endif
+}
+
+} // namespace DriverMonitor
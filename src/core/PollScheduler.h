@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DriverMonitor {
+
+// OS object the scheduler can wait on (change notification handle / fd)
+#ifdef _WIN32
+using NativeWaitHandle = void*;
+#else
+using NativeWaitHandle = int;
+#endif
+
+// Polled monitoring source
+struct PollSource {
+    std::string name;
+
+    // Poll the source; return true if it detected a change
+    std::function<bool()> poll;
+
+    // Optional: provide a handle that becomes signaled when the source has work
+    std::function<bool(NativeWaitHandle&)> waitHandle;
+
+    // Interval after a detection, and upper bound of the idle back-off
+    std::chrono::milliseconds minInterval;
+    std::chrono::milliseconds maxInterval;
+
+    PollSource() : minInterval(500), maxInterval(8000) {}
+};
+
+// Per-source scheduling statistics
+struct PollSourceStats {
+    std::string name;
+    uint64_t polls;
+    uint64_t detections;
+    std::chrono::milliseconds currentInterval;
+};
+
+// Runs all polling sources on a single thread.
+// Each source backs off exponentially while idle, returns to its minimum
+// interval after a detection, and is woken early by its change notification
+// handle or by Wake(). Stop() interrupts the wait immediately.
+class PollScheduler {
+public:
+    PollScheduler();
+    ~PollScheduler();
+
+    // Register a source (only before Start); returns source id
+    int AddSource(const PollSource& source);
+
+    // Start scheduler thread
+    bool Start();
+
+    // Stop scheduler thread (returns without waiting for the next deadline)
+    void Stop();
+
+    // Poll source as soon as possible (thread-safe)
+    void Wake(int sourceId);
+
+    // Number of times the scheduler thread woke up
+    uint64_t GetWakeupCount() const { return m_wakeups; }
+
+    // Get per-source statistics
+    std::vector<PollSourceStats> GetStats() const;
+
+private:
+    struct SourceState {
+        PollSource source;
+        std::chrono::steady_clock::time_point nextDue;
+        std::chrono::milliseconds interval;
+        std::atomic<bool> wakeRequested;
+        std::atomic<uint64_t> polls;
+        std::atomic<uint64_t> detections;
+
+        SourceState() : interval(0), wakeRequested(false), polls(0), detections(0) {}
+    };
+
+    std::vector<std::unique_ptr<SourceState>> m_sources;
+    mutable std::mutex m_statsMutex;
+    std::atomic<bool> m_running;
+    std::atomic<uint64_t> m_wakeups;
+    std::unique_ptr<std::thread> m_thread;
+    std::minstd_rand m_random;
+
+    // Self-signal used to interrupt the wait
+#ifdef _WIN32
+    void* m_wakeEvent;
+#else
+    int m_wakePipe[2];
+#endif
+
+    void Run();
+    void PollSourceNow(SourceState& state);
+    std::chrono::milliseconds Jitter(std::chrono::milliseconds interval);
+    void WaitUntil(std::chrono::steady_clock::time_point deadline);
+    void SignalWake();
+};
+
+} // namespace DriverMonitor
@@ -0,0 +1,280 @@
+#include "ProcessInfo.h"
+#include "Trace.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Map node (key, entry) and list node, with the entry's heap strings
+    size_t GetEntryBytes(const DriverMonitor::ProcessInfo& info) {
+        using DriverMonitor::MemoryAccounting;
+        return sizeof(unsigned long) + sizeof(DriverMonitor::ProcessInfo) + sizeof(int64_t) + sizeof(unsigned long) +
+               6 * sizeof(void*) + MemoryAccounting::GetHeapBytes(info.imagePath) +
+               MemoryAccounting::GetHeapBytes(info.imageName);
+    }
+
+    // Final path component
+    std::string GetFileName(const std::string& path) {
+        size_t pos = path.find_last_of("\\/");
+        return pos == std::string::npos ? path : path.substr(pos + 1);
+    }
+
+#ifndef _WIN32
+    // Whole small /proc file into buffer (NUL-terminated); length or -1
+    ssize_t ReadProcFile(unsigned long pid, const char* name, char* buffer, size_t size) {
+        char path[64];
+        std::snprintf(path, sizeof(path), "/proc/%lu/%s", pid, name);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+        ssize_t length = read(fd, buffer, size - 1);
+        close(fd);
+        if (length < 0) {
+            return -1;
+        }
+        buffer[length] = '\0';
+        return length;
+    }
+#endif
+}
+
+namespace DriverMonitor {
+
+#ifdef _WIN32
+
+namespace {
+    // Creation time of a process that has not exited
+    bool ReadStartTime(HANDLE process, uint64_t& startTime) {
+        DWORD exitCode = 0;
+        FILETIME created, exited, kernel, user;
+        if (!GetExitCodeProcess(process, &exitCode) || exitCode != STILL_ACTIVE ||
+            !GetProcessTimes(process, &created, &exited, &kernel, &user)) {
+            return false;
+        }
+        startTime = (static_cast<uint64_t>(created.dwHighDateTime) << 32) | created.dwLowDateTime;
+        return true;
+    }
+}
+
+bool SystemProcessInfoProvider::GetStartTime(unsigned long pid, uint64_t& startTime) {
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process) {
+        return false;
+    }
+    bool running = ReadStartTime(process, startTime);
+    CloseHandle(process);
+    return running;
+}
+
+bool SystemProcessInfoProvider::Query(unsigned long pid, ProcessInfo& info) {
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process) {
+        return false;
+    }
+
+    uint64_t startTime = 0;
+    char imagePath[MAX_PATH] = {0};
+    DWORD size = MAX_PATH;
+    bool running = ReadStartTime(process, startTime);
+    bool haveImage = running && QueryFullProcessImageNameA(process, 0, imagePath, &size);
+    CloseHandle(process);
+    if (!running) {
+        return false;
+    }
+
+    info.processId = pid;
+    info.startTime = startTime;
+    if (haveImage) {
+        info.imagePath.assign(imagePath, size);
+        info.imageName = GetFileName(info.imagePath);
+    } else {
+        // The System process has no image file
+        info.imagePath.clear();
+        info.imageName = (pid == 4) ? "System" : "Unknown";
+    }
+    return true;
+}
+
+#else
+
+bool SystemProcessInfoProvider::GetStartTime(unsigned long pid, uint64_t& startTime) {
+    // "pid (comm) state ppid ... starttime ...": comm may hold spaces and
+    // parentheses, so fields are counted from the last ')'. starttime is
+    // field 22, in clock ticks since boot.
+    char buffer[1024];
+    if (ReadProcFile(pid, "stat", buffer, sizeof(buffer)) < 0) {
+        return false;
+    }
+    const char* cursor = std::strrchr(buffer, ')');
+    if (!cursor || cursor[1] != ' ' || cursor[2] == 'Z' || cursor[2] == 'X') {
+        return false;       // Malformed, or exited and not yet reaped
+    }
+    cursor += 2;
+    for (int field = 3; field < 22; ++field) {
+        cursor = std::strchr(cursor, ' ');
+        if (!cursor) {
+            return false;
+        }
+        ++cursor;
+    }
+    startTime = std::strtoull(cursor, nullptr, 10);
+    return true;
+}
+
+bool SystemProcessInfoProvider::Query(unsigned long pid, ProcessInfo& info) {
+    uint64_t startTime = 0;
+    if (!GetStartTime(pid, startTime)) {
+        return false;
+    }
+
+    info.processId = pid;
+    info.startTime = startTime;
+    char path[64];
+    char image[PATH_MAX];
+    std::snprintf(path, sizeof(path), "/proc/%lu/exe", pid);
+    ssize_t length = readlink(path, image, sizeof(image));
+    if (length > 0 && static_cast<size_t>(length) < sizeof(image)) {
+        // An image replaced or removed since the process started
+        const char deleted[] = " (deleted)";
+        size_t suffix = sizeof(deleted) - 1;
+        if (static_cast<size_t>(length) > suffix && std::memcmp(image + length - suffix, deleted, suffix) == 0) {
+            length -= static_cast<ssize_t>(suffix);
+        }
+        info.imagePath.assign(image, static_cast<size_t>(length));
+        info.imageName = GetFileName(info.imagePath);
+        return true;
+    }
+
+    // Kernel threads have no image; other users' processes need privileges
+    info.imagePath.clear();
+    char comm[64];
+    ssize_t commLength = ReadProcFile(pid, "comm", comm, sizeof(comm));
+    while (commLength > 0 && comm[commLength - 1] == '\n') {
+        --commLength;
+    }
+    if (commLength > 0) {
+        info.imageName.assign(comm, static_cast<size_t>(commLength));
+    } else {
+        info.imageName = "Unknown";
+    }
+    return true;
+}
+
+#endif
+
+ProcessInfoCache::ProcessInfoCache(size_t capacity, ProcessInfoProvider* provider, Clock* clock,
+                                   int64_t revalidateMicros)
+    : m_capacity(capacity > 0 ? capacity : 1)
+    , m_revalidateMicros(revalidateMicros)
+    , m_systemProvider(provider ? nullptr : new SystemProcessInfoProvider())
+    , m_provider(provider ? provider : m_systemProvider.get())
+    , m_clock(clock ? clock : &m_systemClock)
+    , m_memory(MemorySubsystem::ProcessCache)
+    , m_hits(0)
+    , m_misses(0)
+    , m_reused(0)
+    , m_size(0) {
+}
+
+const ProcessInfo* ProcessInfoCache::Lookup(unsigned long pid) {
+    int64_t now = m_clock->NowMicros();
+    auto it = m_entries.find(pid);
+    if (it != m_entries.end()) {
+        Entry& entry = it->second;
+        if (now - entry.verifiedMicros < m_revalidateMicros) {
+            m_order.splice(m_order.begin(), m_order, entry.order);
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return &entry.info;
+        }
+
+        // Still the same process?
+        uint64_t startTime = 0;
+        if (!m_provider->GetStartTime(pid, startTime)) {
+            Erase(it);
+            m_size.store(m_entries.size(), std::memory_order_relaxed);
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (startTime == entry.info.startTime) {
+            entry.verifiedMicros = now;
+            m_order.splice(m_order.begin(), m_order, entry.order);
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return &entry.info;
+        }
+        m_reused.fetch_add(1, std::memory_order_relaxed);
+        Erase(it);
+    }
+
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    ProcessInfo info;
+    bool found;
+    {
+        DM_TRACE_SPAN("queryProcess", "process");
+        found = m_provider->Query(pid, info);
+    }
+    if (!found) {
+        m_size.store(m_entries.size(), std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    if (m_entries.size() >= m_capacity) {
+        Erase(m_entries.find(m_order.back()));
+    }
+    m_order.push_front(pid);
+    Entry& entry = m_entries.emplace(pid, Entry{ std::move(info), now, m_order.begin() }).first->second;
+    m_memory.Add(GetEntryBytes(entry.info));
+    m_size.store(m_entries.size(), std::memory_order_relaxed);
+    return &entry.info;
+}
+
+bool ProcessInfoCache::Attribute(DriverEvent& event) {
+    const ProcessInfo* info = Lookup(event.processId);
+    if (!info) {
+        return false;
+    }
+    event.initiatedBy = info->imageName;
+    return true;
+}
+
+void ProcessInfoCache::Invalidate(unsigned long pid) {
+    auto it = m_entries.find(pid);
+    if (it != m_entries.end()) {
+        Erase(it);
+        m_size.store(m_entries.size(), std::memory_order_relaxed);
+    }
+}
+
+void ProcessInfoCache::Clear() {
+    m_entries.clear();
+    m_order.clear();
+    m_memory.Set(0);
+    m_size.store(0, std::memory_order_relaxed);
+}
+
+size_t ProcessInfoCache::Trim(size_t bytes) {
+    size_t freed = 0;
+    while (freed < bytes && !m_entries.empty()) {
+        freed += Erase(m_entries.find(m_order.back()));
+    }
+    m_size.store(m_entries.size(), std::memory_order_relaxed);
+    return freed;
+}
+
+size_t ProcessInfoCache::Erase(std::unordered_map<unsigned long, Entry>::iterator it) {
+    size_t bytes = GetEntryBytes(it->second.info);
+    m_memory.Subtract(bytes);
+    m_order.erase(it->second.order);
+    m_entries.erase(it);
+    return bytes;
+}
+
+} // namespace DriverMonitor
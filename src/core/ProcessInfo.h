@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Clock.h"
+#include "MemoryAccounting.h"
+#include "Utils.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace DriverMonitor {
+
+// A running process as seen by attribution
+struct ProcessInfo {
+    unsigned long processId;
+    std::string imagePath;      // Empty when it cannot be read (kernel threads, access denied)
+    std::string imageName;      // File name of the image, or the kernel's short name
+    uint64_t startTime;         // Opaque; compared for equality to detect PID reuse
+
+    ProcessInfo() : processId(0), startTime(0) {}
+};
+
+// Operating system queries behind ProcessInfoCache
+class ProcessInfoProvider {
+public:
+    virtual ~ProcessInfoProvider() {}
+
+    // Start time of the running process pid; false when there is none.
+    // Cheaper than Query: used to revalidate a cached entry.
+    virtual bool GetStartTime(unsigned long pid, uint64_t& startTime) = 0;
+
+    // Image and start time of the running process pid; false when there is none
+    virtual bool Query(unsigned long pid, ProcessInfo& info) = 0;
+};
+
+// /proc/<pid>/stat and /proc/<pid>/exe on Linux; OpenProcess,
+// GetProcessTimes and QueryFullProcessImageName on Windows
+class SystemProcessInfoProvider : public ProcessInfoProvider {
+public:
+    bool GetStartTime(unsigned long pid, uint64_t& startTime) override;
+    bool Query(unsigned long pid, ProcessInfo& info) override;
+};
+
+// Process image by PID, so attributing an event to its initiator does not
+// open the process every time. A hit younger than the revalidation interval
+// costs one hash lookup and no system call; an older one re-reads only the
+// start time, and a changed start time means the PID was reused, so the
+// image is queried again. An exited process is dropped; the least recently
+// used entry is evicted at capacity.
+//
+// A PID reused within the interval is reported with the previous image;
+// sources that see process exits close that window with Invalidate().
+//
+// Lookups come from one thread (the pipeline); the counters can be read
+// from any thread.
+class ProcessInfoCache {
+public:
+    static const size_t kDefaultCapacity = 4096;
+    static const int64_t kDefaultRevalidateMicros = 1000000;
+
+    // provider / clock: the system's unless replaced (tests, benchmarks);
+    // both must outlive the cache
+    explicit ProcessInfoCache(size_t capacity = kDefaultCapacity, ProcessInfoProvider* provider = nullptr,
+                              Clock* clock = nullptr, int64_t revalidateMicros = kDefaultRevalidateMicros);
+
+    // Cached info for pid, queried on a miss; nullptr when no such process
+    // is running. Valid until the next call.
+    const ProcessInfo* Lookup(unsigned long pid);
+
+    // Set event.initiatedBy to the image name of event.processId; false
+    // (event unchanged) when the process cannot be found
+    bool Attribute(DriverEvent& event);
+
+    // Forget pid (the process exited)
+    void Invalidate(unsigned long pid);
+
+    // Drop every entry (counters are kept)
+    void Clear();
+
+    // Evict least recently used entries until at least bytes are freed
+    // (memory budget); returns the bytes freed
+    size_t Trim(size_t bytes);
+
+    // Bytes held by the entries (charged to MemorySubsystem::ProcessCache)
+    size_t GetMemoryBytes() const { return m_memory.Get(); }
+
+    uint64_t GetHits() const { return m_hits.load(std::memory_order_relaxed); }
+    uint64_t GetMisses() const { return m_misses.load(std::memory_order_relaxed); }
+    uint64_t GetReused() const { return m_reused.load(std::memory_order_relaxed); }
+    size_t GetSize() const { return m_size.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        ProcessInfo info;
+        int64_t verifiedMicros;     // When the start time was last checked
+        std::list<unsigned long>::iterator order;
+    };
+
+    size_t m_capacity;
+    int64_t m_revalidateMicros;
+    std::unique_ptr<ProcessInfoProvider> m_systemProvider;
+    ProcessInfoProvider* m_provider;
+    SystemClock m_systemClock;
+    Clock* m_clock;
+    std::unordered_map<unsigned long, Entry> m_entries;
+    std::list<unsigned long> m_order;       // Most recently used first
+    MemoryCharge m_memory;
+
+    std::atomic<uint64_t> m_hits;
+    std::atomic<uint64_t> m_misses;
+    std::atomic<uint64_t> m_reused;
+    std::atomic<size_t> m_size;
+
+    // Remove an entry; returns its bytes
+    size_t Erase(std::unordered_map<unsigned long, Entry>::iterator it);
+};
+
+} // namespace DriverMonitor
@@ -0,0 +1,143 @@
+#include "Rcu.h"
+#include <mutex>
+#include <vector>
+
+namespace DriverMonitor {
+
+// One per reader thread; slots are reused by later threads, never freed
+struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> epoch;    // Epoch announced on entry (0 = not reading)
+    std::atomic<bool> claimed;
+    ReaderSlot* next;
+    unsigned depth;                 // Nesting, touched only by the owning thread
+
+    ReaderSlot() : epoch(0), claimed(true), next(nullptr), depth(0) {}
+};
+
+namespace {
+    // Reclamation state (function statics: usable during static initialization)
+    struct RcuState {
+        std::atomic<uint64_t> epoch;
+        std::atomic<ReaderSlot*> slots;
+
+        struct RetiredObject {
+            void* object;
+            void (*deleter)(void*);
+            uint64_t epoch;         // Global epoch when it was unpublished
+        };
+        std::mutex retiredMutex;
+        std::vector<RetiredObject> retired;
+
+        RcuState() : epoch(1), slots(nullptr) {}
+    };
+
+    RcuState& GetState() {
+        static RcuState* state = new RcuState();   // Outlives thread-local slot owners
+        return *state;
+    }
+
+    ReaderSlot* ClaimSlot() {
+        RcuState& state = GetState();
+        for (ReaderSlot* slot = state.slots.load(std::memory_order_acquire); slot; slot = slot->next) {
+            bool expected = false;
+            if (!slot->claimed.load(std::memory_order_relaxed) &&
+                slot->claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return slot;
+            }
+        }
+        ReaderSlot* slot = new ReaderSlot();
+        ReaderSlot* head = state.slots.load(std::memory_order_relaxed);
+        do {
+            slot->next = head;
+        } while (!state.slots.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+        return slot;
+    }
+
+    // Claims a slot on the thread's first read and returns it at thread exit
+    struct ThreadSlot {
+        ReaderSlot* slot;
+
+        ThreadSlot() : slot(ClaimSlot()) {}
+        ~ThreadSlot() { slot->claimed.store(false, std::memory_order_release); }
+    };
+
+    ReaderSlot* GetThreadSlot() {
+        thread_local ThreadSlot threadSlot;
+        return threadSlot.slot;
+    }
+
+    // Oldest epoch a reader still inside a guard announced (UINT64_MAX if none)
+    uint64_t GetOldestReaderEpoch(RcuState& state) {
+        uint64_t oldest = UINT64_MAX;
+        for (ReaderSlot* slot = state.slots.load(std::memory_order_acquire); slot; slot = slot->next) {
+            uint64_t epoch = slot->epoch.load(std::memory_order_seq_cst);
+            if (epoch != 0 && epoch < oldest) {
+                oldest = epoch;
+            }
+        }
+        return oldest;
+    }
+
+    size_t ReclaimLocked(RcuState& state) {
+        // A reader that announced epoch e may hold anything retired at epoch >= e
+        uint64_t oldest = GetOldestReaderEpoch(state);
+        size_t kept = 0;
+        size_t freed = 0;
+        for (auto& retired : state.retired) {
+            if (retired.epoch < oldest) {
+                retired.deleter(retired.object);
+                freed++;
+            } else {
+                state.retired[kept++] = retired;
+            }
+        }
+        state.retired.resize(kept);
+        return freed;
+    }
+}
+
+RcuReadGuard::RcuReadGuard() : m_slot(GetThreadSlot()) {
+    if (m_slot->depth++ == 0) {
+        // Announce before the caller loads the pointer: a writer that
+        // unpublished it afterwards sees this slot when it scans
+        RcuState& state = GetState();
+        m_slot->epoch.store(state.epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+}
+
+RcuReadGuard::~RcuReadGuard() {
+    if (--m_slot->depth == 0) {
+        m_slot->epoch.store(0, std::memory_order_release);
+    }
+}
+
+namespace Rcu {
+
+void Retire(void* object, void (*deleter)(void*)) {
+    if (!object) {
+        return;
+    }
+    RcuState& state = GetState();
+    // Readers announcing from now on see a later epoch and the new pointer
+    uint64_t epoch = state.epoch.fetch_add(1, std::memory_order_seq_cst);
+
+    std::lock_guard<std::mutex> lock(state.retiredMutex);
+    state.retired.push_back({ object, deleter, epoch });
+    ReclaimLocked(state);
+}
+
+size_t Reclaim() {
+    RcuState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.retiredMutex);
+    return ReclaimLocked(state);
+}
+
+size_t GetRetiredCount() {
+    RcuState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.retiredMutex);
+    return state.retired.size();
+}
+
+} // namespace Rcu
+
+} // namespace DriverMonitor
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace DriverMonitor {
+
+// Read-copy-update for data that is read on hot paths and replaced rarely.
+// Writers publish a new immutable object with one atomic exchange and retire
+// the old one; readers load the current pointer inside an RcuReadGuard and
+// may use it until the guard ends. A retired object is freed once no reader
+// that could have loaded it is still inside its guard (epoch-based
+// reclamation over per-thread reader slots, process-wide).
+//
+// Reader cost: announcing the epoch in the thread's own slot (no shared
+// writes) plus the pointer load. Guards nest.
+class RcuReadGuard {
+public:
+    RcuReadGuard();
+    ~RcuReadGuard();
+
+    RcuReadGuard(const RcuReadGuard&) = delete;
+    RcuReadGuard& operator=(const RcuReadGuard&) = delete;
+
+private:
+    struct ReaderSlot* m_slot;
+};
+
+namespace Rcu {
+    // Hand an unpublished object to reclamation; it is deleted once no
+    // reader can still hold it. Also reclaims whatever became safe since.
+    void Retire(void* object, void (*deleter)(void*));
+
+    template<typename T>
+    void Retire(const T* object) {
+        Retire(const_cast<T*>(object), [](void* retired) { delete static_cast<T*>(retired); });
+    }
+
+    // Free retired objects no reader can still hold; returns how many
+    size_t Reclaim();
+
+    // Retired objects still waiting for readers
+    size_t GetRetiredCount();
+}
+
+} // namespace DriverMonitor
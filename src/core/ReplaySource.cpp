@@ -0,0 +1,99 @@
+#include "ReplaySource.h"
+#include "ObservationRecorder.h"
+#include "BinaryCodec.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace DriverMonitor {
+
+ReplaySource::ReplaySource()
+    : m_headerSize(0)
+    , m_offset(0)
+    , m_startTime(0)
+    , m_currentTime(0)
+    , m_error(false) {
+}
+
+ReplaySource::~ReplaySource() {
+}
+
+bool ReplaySource::Open(const std::string& filePath) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    m_data = contents.str();
+
+    BinaryReader reader(m_data.data(), m_data.size());
+    char magic[sizeof(ObservationLog::kMagic)];
+    if (!reader.ReadBytes(magic, sizeof(magic)) ||
+        memcmp(magic, ObservationLog::kMagic, sizeof(magic)) != 0 ||
+        reader.ReadByte() != ObservationLog::kVersion) {
+        m_data.clear();
+        return false;
+    }
+
+    // Empty log has no start time
+    m_startTime = reader.AtEnd() ? 0 : reader.ReadSignedVarint();
+    if (reader.HasError()) {
+        m_data.clear();
+        return false;
+    }
+
+    m_headerSize = reader.GetOffset();
+    Rewind();
+    return true;
+}
+
+void ReplaySource::Rewind() {
+    m_offset = m_headerSize;
+    m_currentTime = m_startTime;
+    m_error = false;
+}
+
+bool ReplaySource::Next(ReplayRecord& record) {
+    if (m_offset >= m_data.size() || m_error) {
+        return false;
+    }
+
+    BinaryReader reader(m_data.data() + m_offset, m_data.size() - m_offset);
+    uint8_t type = reader.ReadByte();
+    m_currentTime += reader.ReadSignedVarint();
+    record.timeMicros = m_currentTime;
+
+    if (type != ObservationLog::kObservation) {
+        m_error = true;
+        return false;
+    }
+
+    // The source indexes per-source counters: out of range is corrupt
+    uint8_t source = reader.ReadByte();
+    if (source > static_cast<uint8_t>(EventSource::Synthetic)) {
+        m_error = true;
+        return false;
+    }
+    record.event = DriverEvent();
+    record.event.source = static_cast<EventSource>(source);
+    record.event.driverName = reader.ReadString();
+    record.event.installPath = reader.ReadString();
+    record.event.loadingMethod = reader.ReadString();
+    record.event.initiatedBy = reader.ReadString();
+    record.event.processId = static_cast<unsigned long>(reader.ReadVarint());
+    record.event.isRemoval = (reader.ReadByte() & ObservationLog::kFlagRemoval) != 0;
+    record.event.signerInfo = reader.ReadString();
+    record.event.timestampUs = record.timeMicros;
+
+    if (reader.HasError()) {
+        m_error = true;
+        return false;
+    }
+
+    m_offset += reader.GetOffset();
+    return true;
+}
+
+} // namespace DriverMonitor
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Utils.h"
+#include <string>
+
+namespace DriverMonitor {
+
+// One record read back from an observation log
+struct ReplayRecord {
+    int64_t timeMicros;
+    DriverEvent event;          // Raw observation with the recorded signer verdict
+
+    ReplayRecord() : timeMicros(0) {}
+};
+
+// Reads an observation log written by ObservationRecorder
+class ReplaySource {
+public:
+    ReplaySource();
+    ~ReplaySource();
+
+    // Load log file into memory and validate the header
+    bool Open(const std::string& filePath);
+
+    // Read next record; returns false at end of log or on a corrupt record
+    bool Next(ReplayRecord& record);
+
+    // Restart from the first record
+    void Rewind();
+
+    // Time of the first record (us since epoch)
+    int64_t GetStartTime() const { return m_startTime; }
+
+    // Check if the log ended with a corrupt record
+    bool HasError() const { return m_error; }
+
+private:
+    std::string m_data;
+    size_t m_headerSize;
+    size_t m_offset;
+    int64_t m_startTime;
+    int64_t m_currentTime;
+    bool m_error;
+};
+
+} // namespace DriverMonitor
@@ -0,0 +1,253 @@
+#include "SearchIndex.h"
+#include <algorithm>
+
+namespace {
+    // Index in chunks so the history lock is released regularly
+    const uint64_t kIndexChunk = 65536;
+}
+
+namespace DriverMonitor {
+
+SearchIndex::SearchIndex()
+    : m_firstSequence(0)
+    , m_ranksValid(true) {
+}
+
+void SearchIndex::Update(const EventManager& eventManager) {
+    // Forget evicted events
+    uint64_t first = eventManager.GetFirstSequence();
+    while (!m_events.empty() && m_firstSequence < first) {
+        ReleaseEntry(m_events.front());
+        m_events.pop_front();
+        m_firstSequence++;
+    }
+    if (m_events.empty() && m_firstSequence < first) {
+        m_firstSequence = first;
+    }
+    
+    // Index new arrivals
+    uint64_t next = eventManager.GetNextSequence();
+    while (GetNextSequence() < next) {
+        uint64_t from = GetNextSequence();
+        uint64_t chunkEnd = std::min(next, from + kIndexChunk);
+        size_t before = m_events.size();
+        eventManager.VisitRange(from, chunkEnd, [this](const DriverEvent& event) {
+            AddEvent(event);
+        });
+        if (m_events.size() == before && GetNextSequence() < chunkEnd) {
+            // Everything in this chunk was evicted meanwhile
+            ClearEvents();
+            m_firstSequence = chunkEnd;
+        }
+    }
+    
+    if (m_strings.ShouldCompact()) {
+        Compact();
+    }
+}
+
+void SearchIndex::SetQuery(const std::string& foldedQuery) {
+    if (foldedQuery == m_query) {
+        return;
+    }
+    
+    for (uint32_t id : m_matches) {
+        m_marks[id] = 0;
+    }
+    
+    // Every string containing the new query also contains a query it extends
+    std::vector<uint32_t> candidates;
+    if (!m_query.empty() && foldedQuery.find(m_query) != std::string::npos) {
+        candidates.swap(m_matches);
+    } else if (!foldedQuery.empty()) {
+        FindCandidates(foldedQuery, candidates);
+    }
+    
+    m_matches.clear();
+    m_query = foldedQuery;
+    for (uint32_t id : candidates) {
+        if (m_strings.Get(id).find(m_query) != std::string::npos) {
+            m_marks[id] = 1;
+            m_matches.push_back(id);
+        }
+    }
+}
+
+void SearchIndex::UpdateRanks() {
+    if (!m_ranksValid) {
+        m_order.clear();
+        m_ranksValid = true;
+    }
+    if (m_order.size() == m_strings.GetSize()) {
+        return;
+    }
+    
+    auto less = [this](uint32_t a, uint32_t b) { return m_strings.Get(a) < m_strings.Get(b); };
+    
+    // Sort the new IDs, then merge them into the existing order
+    size_t ranked = m_order.size();
+    for (uint32_t id = static_cast<uint32_t>(ranked); id < m_strings.GetSize(); ++id) {
+        m_order.push_back(id);
+    }
+    std::sort(m_order.begin() + static_cast<ptrdiff_t>(ranked), m_order.end(), less);
+    std::inplace_merge(m_order.begin(), m_order.begin() + static_cast<ptrdiff_t>(ranked), m_order.end(), less);
+    
+    m_ranks.resize(m_order.size());
+    for (uint32_t rank = 0; rank < m_order.size(); ++rank) {
+        m_ranks[m_order[rank]] = rank;
+    }
+}
+
+size_t SearchIndex::GetMemoryBytes() const {
+    size_t bytes = m_events.size() * sizeof(EventEntry);
+    bytes += m_strings.GetMemoryBytes();
+    bytes += m_marks.capacity() + m_matches.capacity() * sizeof(uint32_t);
+    bytes += (m_order.capacity() + m_ranks.capacity()) * sizeof(uint32_t);
+    
+    for (const auto& posting : m_postings) {
+        bytes += sizeof(posting) + 2 * sizeof(void*) + posting.second.capacity() * sizeof(uint32_t);
+    }
+    bytes += m_postings.bucket_count() * sizeof(void*);
+    return bytes;
+}
+
+uint32_t SearchIndex::Intern(const std::string& value) {
+    m_scratch.assign(value);
+    for (auto& c : m_scratch) {
+        c = Utils::FoldCase(c);
+    }
+    
+    bool inserted = false;
+    uint32_t id = m_strings.Intern(m_scratch, &inserted);
+    if (!inserted) {
+        return id;
+    }
+    m_marks.push_back(0);
+    IndexString(id);
+    
+    // New strings are matched against the current query right away
+    if (!m_query.empty() && m_strings.Get(id).find(m_query) != std::string::npos) {
+        m_marks[id] = 1;
+        m_matches.push_back(id);
+    }
+    return id;
+}
+
+void SearchIndex::ReleaseEntry(const EventEntry& entry) {
+    m_strings.Release(entry.name);
+    m_strings.Release(entry.path);
+    m_strings.Release(entry.signer);
+    m_strings.Release(entry.method);
+    m_strings.Release(entry.initiator);
+}
+
+void SearchIndex::IndexString(uint32_t id) {
+    const std::string& value = m_strings.Get(id);
+    for (size_t i = 0; i + 3 <= value.size(); ++i) {
+        std::vector<uint32_t>& posting = m_postings[Trigram(value.data() + i)];
+        // IDs are indexed in ascending order; skip repeats within one string
+        if (posting.empty() || posting.back() != id) {
+            posting.push_back(id);
+        }
+    }
+}
+
+void SearchIndex::AddEvent(const DriverEvent& event) {
+    if (event.sequenceId != GetNextSequence()) {
+        // Indexed events were evicted while we were not looking; restart the range
+        ClearEvents();
+        m_firstSequence = event.sequenceId;
+    }
+    
+    EventEntry entry;
+    entry.name = Intern(event.driverName);
+    entry.path = Intern(event.installPath);
+    entry.signer = Intern(event.signerInfo);
+    entry.method = Intern(event.loadingMethod);
+    entry.initiator = Intern(event.initiatedBy);
+    entry.type = static_cast<uint8_t>(event.eventType);
+    entry.threat = static_cast<uint8_t>(event.threatLevel);
+    m_events.push_back(entry);
+}
+
+void SearchIndex::ClearEvents() {
+    for (const auto& entry : m_events) {
+        ReleaseEntry(entry);
+    }
+    m_firstSequence += m_events.size();
+    m_events.clear();
+}
+
+void SearchIndex::Compact() {
+    std::vector<uint32_t> remap;
+    m_strings.Compact(remap);
+    
+    for (auto& entry : m_events) {
+        entry.name = remap[entry.name];
+        entry.path = remap[entry.path];
+        entry.signer = remap[entry.signer];
+        entry.method = remap[entry.method];
+        entry.initiator = remap[entry.initiator];
+    }
+    
+    m_ranksValid = false;
+    
+    m_postings.clear();
+    for (uint32_t id = 0; id < m_strings.GetSize(); ++id) {
+        IndexString(id);
+    }
+    
+    // Recompute the marks for the new IDs
+    std::string query;
+    query.swap(m_query);
+    m_matches.clear();
+    m_marks.assign(m_strings.GetSize(), 0);
+    SetQuery(query);
+}
+
+void SearchIndex::FindCandidates(const std::string& query, std::vector<uint32_t>& candidates) const {
+    candidates.clear();
+    
+    if (query.size() < 3) {
+        // Too short for a trigram: every string is a candidate
+        candidates.resize(m_strings.GetSize());
+        for (uint32_t id = 0; id < m_strings.GetSize(); ++id) {
+            candidates[id] = id;
+        }
+        return;
+    }
+    
+    std::vector<const std::vector<uint32_t>*> postings;
+    for (size_t i = 0; i + 3 <= query.size(); ++i) {
+        auto it = m_postings.find(Trigram(query.data() + i));
+        if (it == m_postings.end()) {
+            return; // A trigram no string contains
+        }
+        postings.push_back(&it->second);
+    }
+    
+    // Intersect starting from the shortest list; gallop through the longer ones
+    std::sort(postings.begin(), postings.end(), [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) {
+        return a->size() < b->size();
+    });
+    postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+    
+    candidates = *postings[0];
+    for (size_t i = 1; i < postings.size() && !candidates.empty(); ++i) {
+        const std::vector<uint32_t>& posting = *postings[i];
+        auto position = posting.begin();
+        size_t kept = 0;
+        for (uint32_t id : candidates) {
+            position = std::lower_bound(position, posting.end(), id);
+            if (position == posting.end()) {
+                break;
+            }
+            if (*position == id) {
+                candidates[kept++] = id;
+            }
+        }
+        candidates.resize(kept);
+    }
+}
+
+} // namespace DriverMonitor
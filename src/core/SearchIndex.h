@@ -0,0 +1,119 @@
+#pragma once
+
+#include "EventManager.h"
+#include "StringInterner.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Incrementally maintained substring index over the event history.
+// Driver name, install path, signer, loading method and initiator are
+// case-folded and interned; every distinct string is indexed once by its
+// trigrams (only name, path and signer take part in matching). A query intersects the
+// posting lists of its trigrams, verifies the candidate strings, and marks
+// the matching ones, so testing an event is three table lookups. A query
+// that extends the previous one only re-verifies the previous matches.
+class SearchIndex {
+public:
+    // Interned string IDs and classification of one event
+    struct EventEntry {
+        uint32_t name;
+        uint32_t path;
+        uint32_t signer;
+        uint32_t method;
+        uint32_t initiator;
+        uint8_t type;
+        uint8_t threat;
+    };
+
+    SearchIndex();
+
+    // Index events that arrived since the last call and forget evicted ones
+    void Update(const EventManager& eventManager);
+
+    // Set the current query (already case-folded; empty matches everything)
+    void SetQuery(const std::string& foldedQuery);
+
+    // Indexed sequence range [first, next)
+    uint64_t GetFirstSequence() const { return m_firstSequence; }
+    uint64_t GetNextSequence() const { return m_firstSequence + m_events.size(); }
+
+    // Check if an indexed event matches the current query
+    bool Matches(uint64_t sequence) const {
+        if (m_query.empty()) {
+            return true;
+        }
+        const EventEntry& entry = m_events[static_cast<size_t>(sequence - m_firstSequence)];
+        return m_marks[entry.name] | m_marks[entry.path] | m_marks[entry.signer];
+    }
+
+    // Get the event type of an indexed event
+    EventType GetEventType(uint64_t sequence) const {
+        return static_cast<EventType>(m_events[static_cast<size_t>(sequence - m_firstSequence)].type);
+    }
+
+    // Get the entry of an indexed event
+    const EventEntry& GetEntry(uint64_t sequence) const {
+        return m_events[static_cast<size_t>(sequence - m_firstSequence)];
+    }
+
+    // Get an interned (folded) string
+    const std::string& GetString(uint32_t id) const { return m_strings.Get(id); }
+
+    // Rank every interned string in lexicographic order (incremental: only
+    // strings interned since the last call are sorted and merged in)
+    void UpdateRanks();
+
+    // Lexicographic rank of a string as of the last UpdateRanks()
+    uint32_t GetRank(uint32_t id) const { return m_ranks[id]; }
+
+    // Get number of distinct strings currently referenced
+    size_t GetStringCount() const { return m_strings.GetLiveCount(); }
+
+    // Approximate heap usage in bytes
+    size_t GetMemoryBytes() const;
+
+private:
+    std::deque<EventEntry> m_events;
+    uint64_t m_firstSequence;
+
+    StringInterner m_strings;       // Folded strings, referenced by the indexed events
+    std::string m_scratch;
+
+    // Trigram (three folded bytes) -> ascending string IDs
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_postings;
+
+    // Current query and the strings it matches
+    std::string m_query;
+    std::vector<uint32_t> m_matches;
+    std::vector<uint8_t> m_marks;
+
+    // String IDs in lexicographic order and the rank of each ID
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_ranks;
+    bool m_ranksValid;              // False once compaction renumbered the strings
+
+    uint32_t Intern(const std::string& value);
+    void ReleaseEntry(const EventEntry& entry);
+    void IndexString(uint32_t id);
+    void AddEvent(const DriverEvent& event);
+    void ClearEvents();
+
+    // Drop the dead strings and rebuild the postings
+    void Compact();
+
+    // Candidate string IDs for a query (superset of the matches)
+    void FindCandidates(const std::string& query, std::vector<uint32_t>& candidates) const;
+
+    static uint32_t Trigram(const char* text) {
+        return static_cast<uint32_t>(static_cast<unsigned char>(text[0])) << 16 |
+               static_cast<uint32_t>(static_cast<unsigned char>(text[1])) << 8 |
+               static_cast<uint32_t>(static_cast<unsigned char>(text[2]));
+    }
+};
+
+} // namespace DriverMonitor
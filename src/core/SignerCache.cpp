@@ -0,0 +1,95 @@
+#include "SignerCache.h"
+#include "Trace.h"
+#include "Utils.h"
+#include <filesystem>
+
+namespace {
+    // Map node (key, entry) and list node (key copy), with their heap strings
+    size_t GetEntryBytes(const std::string& filePath, const std::string& signerInfo) {
+        using DriverMonitor::MemoryAccounting;
+        return 3 * sizeof(std::string) + sizeof(uint64_t) + sizeof(int64_t) + 6 * sizeof(void*) +
+               2 * MemoryAccounting::GetHeapBytes(filePath) + MemoryAccounting::GetHeapBytes(signerInfo);
+    }
+}
+
+namespace DriverMonitor {
+
+SignerCache::SignerCache(size_t capacity, Verifier verifier)
+    : m_capacity(capacity > 0 ? capacity : 1)
+    , m_verifier(verifier ? std::move(verifier) : Verifier(&Utils::GetSignerInfo))
+    , m_memory(MemorySubsystem::SignerCache)
+    , m_hits(0)
+    , m_misses(0)
+    , m_size(0) {
+}
+
+std::string SignerCache::GetSignerInfo(const std::string& filePath) {
+    // The file's identity: a replaced or rewritten driver is verified again
+    std::error_code error;
+    uint64_t fileSize = std::filesystem::file_size(filePath, error);
+    int64_t modified = 0;
+    if (!error) {
+        modified = static_cast<int64_t>(std::filesystem::last_write_time(filePath, error).time_since_epoch().count());
+    }
+    if (error) {
+        // Nothing to key the verdict on (file gone or unreadable)
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        DM_TRACE_SPAN("verifySignature", "signer");
+        return m_verifier(filePath);
+    }
+
+    auto it = m_entries.find(filePath);
+    if (it != m_entries.end()) {
+        if (it->second.fileSize == fileSize && it->second.modified == modified) {
+            m_order.splice(m_order.begin(), m_order, it->second.order);
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second.signerInfo;
+        }
+        m_memory.Subtract(GetEntryBytes(it->first, it->second.signerInfo));
+        m_order.erase(it->second.order);
+        m_entries.erase(it);
+    }
+
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    std::string signerInfo;
+    {
+        DM_TRACE_SPAN("verifySignature", "signer");
+        signerInfo = m_verifier(filePath);
+    }
+
+    if (m_entries.size() >= m_capacity) {
+        EvictOldest();
+    }
+    m_order.push_front(filePath);
+    auto inserted = m_entries.emplace(filePath, Entry{ signerInfo, fileSize, modified, m_order.begin() }).first;
+    m_memory.Add(GetEntryBytes(inserted->first, inserted->second.signerInfo));
+    m_size.store(m_entries.size(), std::memory_order_relaxed);
+    return signerInfo;
+}
+
+void SignerCache::Clear() {
+    m_entries.clear();
+    m_order.clear();
+    m_memory.Set(0);
+    m_size.store(0, std::memory_order_relaxed);
+}
+
+size_t SignerCache::Trim(size_t bytes) {
+    size_t freed = 0;
+    while (freed < bytes && !m_entries.empty()) {
+        freed += EvictOldest();
+    }
+    m_size.store(m_entries.size(), std::memory_order_relaxed);
+    return freed;
+}
+
+size_t SignerCache::EvictOldest() {
+    auto it = m_entries.find(m_order.back());
+    size_t bytes = GetEntryBytes(it->first, it->second.signerInfo);
+    m_memory.Subtract(bytes);
+    m_entries.erase(it);
+    m_order.pop_back();
+    return bytes;
+}
+
+} // namespace DriverMonitor
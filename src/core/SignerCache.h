@@ -0,0 +1,68 @@
+#pragma once
+
+#include "MemoryAccounting.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace DriverMonitor {
+
+// Authenticode verdicts by file, so a driver that several sources report,
+// or that is loaded again, is verified once. An entry is dropped when the
+// file's size or modification time changes; the least recently used entry
+// is evicted at capacity.
+//
+// Lookups come from one thread (the pipeline); the counters can be read
+// from any thread.
+class SignerCache {
+public:
+    using Verifier = std::function<std::string(const std::string& filePath)>;
+
+    static const size_t kDefaultCapacity = 4096;
+
+    // verifier: Utils::GetSignerInfo unless replaced (tests, benchmarks)
+    explicit SignerCache(size_t capacity = kDefaultCapacity, Verifier verifier = nullptr);
+
+    // Cached verdict for the file, verified on a miss
+    std::string GetSignerInfo(const std::string& filePath);
+
+    // Drop every entry (counters are kept)
+    void Clear();
+    
+    // Evict least recently used entries until at least bytes are freed
+    // (memory budget); returns the bytes freed
+    size_t Trim(size_t bytes);
+    
+    // Bytes held by the entries (charged to MemorySubsystem::SignerCache)
+    size_t GetMemoryBytes() const { return m_memory.Get(); }
+
+    uint64_t GetHits() const { return m_hits.load(std::memory_order_relaxed); }
+    uint64_t GetMisses() const { return m_misses.load(std::memory_order_relaxed); }
+    size_t GetSize() const { return m_size.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        std::string signerInfo;
+        uint64_t fileSize;
+        int64_t modified;
+        std::list<std::string>::iterator order;
+    };
+
+    size_t m_capacity;
+    Verifier m_verifier;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::list<std::string> m_order;         // Most recently used first
+    MemoryCharge m_memory;
+
+    std::atomic<uint64_t> m_hits;
+    std::atomic<uint64_t> m_misses;
+    std::atomic<size_t> m_size;
+    
+    // Evict the least recently used entry; returns its bytes
+    size_t EvictOldest();
+};
+
+} // namespace DriverMonitor
@@ -0,0 +1,387 @@
+#include "Socket.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    using NativeSocket = SOCKET;
+
+    bool IsConnectPending() {
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+
+    bool WouldBlock() {
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+
+    int PollSockets(WSAPOLLFD* sockets, size_t count, int timeoutMs) {
+        return WSAPoll(sockets, static_cast<ULONG>(count), timeoutMs);
+    }
+    using PollEntry = WSAPOLLFD;
+
+    void SetBlocking(NativeSocket socket, bool blocking) {
+        u_long nonBlocking = blocking ? 0 : 1;
+        ioctlsocket(socket, FIONBIO, &nonBlocking);
+    }
+
+    void SetSendTimeout(NativeSocket socket, std::chrono::milliseconds timeout) {
+        DWORD value = static_cast<DWORD>(timeout.count());
+        setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+#else
+    using NativeSocket = int;
+
+    bool IsConnectPending() {
+        return errno == EINPROGRESS;
+    }
+
+    bool WouldBlock() {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+#ifndef __linux__
+    int PollSockets(pollfd* sockets, size_t count, int timeoutMs) {
+        return poll(sockets, static_cast<nfds_t>(count), timeoutMs);
+    }
+    using PollEntry = pollfd;
+#endif
+
+    void SetBlocking(NativeSocket socket, bool blocking) {
+        int flags = fcntl(socket, F_GETFL, 0);
+        fcntl(socket, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+    }
+
+    void SetSendTimeout(NativeSocket socket, std::chrono::milliseconds timeout) {
+        timeval value;
+        value.tv_sec = static_cast<long>(timeout.count() / 1000);
+        value.tv_usec = static_cast<long>(timeout.count() % 1000) * 1000;
+        setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &value, sizeof(value));
+    }
+#endif
+
+#ifdef MSG_NOSIGNAL
+    const int kSendFlags = MSG_NOSIGNAL;    // A peer that hung up must not raise SIGPIPE
+#else
+    const int kSendFlags = 0;
+#endif
+
+    timeval ToTimeval(std::chrono::milliseconds timeout) {
+        timeval value;
+        value.tv_sec = static_cast<long>(timeout.count() / 1000);
+        value.tv_usec = static_cast<long>(timeout.count() % 1000) * 1000;
+        return value;
+    }
+}
+
+namespace DriverMonitor {
+
+bool Socket::Init() {
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+void Socket::Cleanup() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void Socket::Close(intptr_t socket) {
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(socket));
+#else
+    close(static_cast<int>(socket));
+#endif
+}
+
+intptr_t Socket::Listen(bool loopbackOnly, uint16_t port, uint16_t& boundPort, std::string& error) {
+    NativeSocket listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (static_cast<intptr_t>(listener) == kNoSocket) {
+        error = "cannot create socket";
+        return kNoSocket;
+    }
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(loopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+    address.sin_port = htons(port);
+    socklen_t length = sizeof(address);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, 64) != 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        error = std::string("cannot listen on ") + (loopbackOnly ? "127.0.0.1:" : "port ") + std::to_string(port);
+        Close(static_cast<intptr_t>(listener));
+        return kNoSocket;
+    }
+    boundPort = ntohs(address.sin_port);
+    return static_cast<intptr_t>(listener);
+}
+
+intptr_t Socket::Accept(intptr_t listener) {
+    NativeSocket connection = accept(static_cast<NativeSocket>(listener), nullptr, nullptr);
+    return static_cast<intptr_t>(connection);
+}
+
+intptr_t Socket::Connect(const std::string& host, uint16_t port, std::chrono::milliseconds timeout,
+                         std::chrono::milliseconds sendTimeout, std::string& error) {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    addrinfo* addresses = nullptr;
+    std::string service = std::to_string(port);
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses) != 0 || !addresses) {
+        error = "cannot resolve " + host;
+        return kNoSocket;
+    }
+
+    // First address that accepts within the timeout
+    intptr_t connected = kNoSocket;
+    error = "cannot connect to " + host + ":" + service;
+    for (addrinfo* address = addresses; address && connected == kNoSocket; address = address->ai_next) {
+        NativeSocket candidate = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (static_cast<intptr_t>(candidate) == kNoSocket) {
+            continue;
+        }
+        SetBlocking(candidate, false);
+        bool ready = connect(candidate, address->ai_addr, static_cast<socklen_t>(address->ai_addrlen)) == 0;
+        if (!ready && IsConnectPending()) {
+            fd_set writable;
+            FD_ZERO(&writable);
+            FD_SET(candidate, &writable);
+            timeval wait = ToTimeval(timeout);
+            int socketError = 0;
+            socklen_t length = sizeof(socketError);
+            ready = select(static_cast<int>(candidate) + 1, nullptr, &writable, nullptr, &wait) > 0 &&
+                    getsockopt(candidate, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&socketError), &length) == 0 &&
+                    socketError == 0;
+        }
+        if (!ready) {
+            Close(static_cast<intptr_t>(candidate));
+            continue;
+        }
+        SetBlocking(candidate, true);
+        int noDelay = 1;
+        setsockopt(candidate, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+        SetSendTimeout(candidate, sendTimeout);
+        connected = static_cast<intptr_t>(candidate);
+    }
+    freeaddrinfo(addresses);
+    if (connected != kNoSocket) {
+        error.clear();
+    }
+    return connected;
+}
+
+bool Socket::WaitReadable(intptr_t socket, std::chrono::milliseconds timeout) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(static_cast<NativeSocket>(socket), &readable);
+    timeval wait = ToTimeval(timeout);
+    return select(static_cast<int>(socket) + 1, &readable, nullptr, nullptr, &wait) > 0;
+}
+
+bool Socket::SendAll(intptr_t socket, const char* data, size_t length) {
+    size_t sent = 0;
+    while (sent < length) {
+        int chunk = static_cast<int>(std::min<size_t>(length - sent, 1 << 20));
+        int result = static_cast<int>(send(static_cast<NativeSocket>(socket), data + sent, chunk, kSendFlags));
+        if (result <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+int Socket::Receive(intptr_t socket, char* data, size_t length) {
+    int chunk = static_cast<int>(std::min<size_t>(length, 1 << 30));
+    int result = static_cast<int>(recv(static_cast<NativeSocket>(socket), data, chunk, 0));
+    return result < 0 ? -1 : result;
+}
+
+void Socket::SetNonBlocking(intptr_t socket) {
+    SetBlocking(static_cast<NativeSocket>(socket), false);
+    int noDelay = 1;
+    setsockopt(static_cast<NativeSocket>(socket), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay),
+               sizeof(noDelay));
+}
+
+int Socket::TryReceive(intptr_t socket, char* data, size_t length) {
+    int chunk = static_cast<int>(std::min<size_t>(length, 1 << 30));
+    int result = static_cast<int>(recv(static_cast<NativeSocket>(socket), data, chunk, 0));
+    if (result > 0) {
+        return result;
+    }
+    return result < 0 && WouldBlock() ? 0 : -1;
+}
+
+int Socket::TrySend(intptr_t socket, const char* data, size_t length) {
+    int chunk = static_cast<int>(std::min<size_t>(length, 1 << 30));
+    int result = static_cast<int>(send(static_cast<NativeSocket>(socket), data, chunk, kSendFlags));
+    if (result >= 0) {
+        return result;
+    }
+    return WouldBlock() ? 0 : -1;
+}
+
+bool Socket::ParseEndpoint(const std::string& endpoint, std::string& host, uint16_t& port) {
+    size_t colon = endpoint.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 >= endpoint.size()) {
+        return false;
+    }
+    host = endpoint.substr(0, colon);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+        host = host.substr(1, host.size() - 2);
+    }
+    unsigned long value = 0;
+    for (size_t i = colon + 1; i < endpoint.size(); ++i) {
+        char c = endpoint[i];
+        if (c < '0' || c > '9' || value > 65535) {
+            return false;
+        }
+        value = value * 10 + static_cast<unsigned long>(c - '0');
+    }
+    if (value == 0 || value > 65535) {
+        return false;
+    }
+    port = static_cast<uint16_t>(value);
+    return !host.empty();
+}
+
+std::string Socket::GetHostName() {
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0) {
+        return std::string();
+    }
+    return name;
+}
+
+SocketPoller::SocketPoller() : m_epoll(Socket::kNoSocket) {
+#ifdef __linux__
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+#endif
+}
+
+SocketPoller::~SocketPoller() {
+#ifdef __linux__
+    if (m_epoll != Socket::kNoSocket) {
+        close(static_cast<int>(m_epoll));
+    }
+#endif
+}
+
+bool SocketPoller::IsValid() const {
+#ifdef __linux__
+    return m_epoll != Socket::kNoSocket;
+#else
+    return true;
+#endif
+}
+
+bool SocketPoller::Add(intptr_t socket, uint64_t token) {
+#ifdef __linux__
+    epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.u64 = token;
+    return epoll_ctl(static_cast<int>(m_epoll), EPOLL_CTL_ADD, static_cast<int>(socket), &event) == 0;
+#else
+    m_entries.push_back({ socket, token, false });
+    return true;
+#endif
+}
+
+void SocketPoller::SetWritable(intptr_t socket, uint64_t token, bool writable) {
+#ifdef __linux__
+    epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP | (writable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    event.data.u64 = token;
+    epoll_ctl(static_cast<int>(m_epoll), EPOLL_CTL_MOD, static_cast<int>(socket), &event);
+#else
+    (void)token;
+    for (auto& entry : m_entries) {
+        if (entry.socket == socket) {
+            entry.writable = writable;
+        }
+    }
+#endif
+}
+
+void SocketPoller::Remove(intptr_t socket) {
+#ifdef __linux__
+    epoll_event event = {};
+    epoll_ctl(static_cast<int>(m_epoll), EPOLL_CTL_DEL, static_cast<int>(socket), &event);
+#else
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                                   [socket](const Entry& entry) { return entry.socket == socket; }),
+                    m_entries.end());
+#endif
+}
+
+size_t SocketPoller::Wait(std::vector<Event>& events, std::chrono::milliseconds timeout) {
+    events.clear();
+    int timeoutMs = static_cast<int>(timeout.count());
+#ifdef __linux__
+    epoll_event ready[256];
+    int count = epoll_wait(static_cast<int>(m_epoll), ready, 256, timeoutMs);
+    for (int i = 0; i < count; ++i) {
+        bool failed = (ready[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) != 0;
+        events.push_back({ ready[i].data.u64, failed || (ready[i].events & EPOLLIN) != 0,
+                           (ready[i].events & EPOLLOUT) != 0 });
+    }
+#else
+    // O(sockets) per wait: fine for the few hundred connections this is used with
+    std::vector<PollEntry> sockets(m_entries.size());
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        sockets[i].fd = static_cast<NativeSocket>(m_entries[i].socket);
+        sockets[i].events = static_cast<short>(POLLIN | (m_entries[i].writable ? POLLOUT : 0));
+        sockets[i].revents = 0;
+    }
+    if (sockets.empty()) {
+        std::this_thread::sleep_for(timeout);
+        return 0;
+    }
+    if (PollSockets(sockets.data(), sockets.size(), timeoutMs) > 0) {
+        for (size_t i = 0; i < sockets.size(); ++i) {
+            short revents = sockets[i].revents;
+            if (revents != 0) {
+                bool failed = (revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+                events.push_back({ m_entries[i].token, failed || (revents & POLLIN) != 0, (revents & POLLOUT) != 0 });
+            }
+        }
+    }
+#endif
+    return events.size();
+}
+
+} // namespace DriverMonitor
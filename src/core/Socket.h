@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Thin portable layer over BSD sockets / Winsock for the metrics listener
+// and event forwarding. Sockets are native handles widened to intptr_t
+// (kNoSocket when invalid); every call is blocking unless noted.
+class Socket {
+public:
+    static constexpr intptr_t kNoSocket = -1;
+
+    // Winsock startup/cleanup (reference counted); no-ops elsewhere
+    static bool Init();
+    static void Cleanup();
+
+    static void Close(intptr_t socket);
+
+    // Listen on address:port (port 0 = any free port, reported in boundPort)
+    static intptr_t Listen(bool loopbackOnly, uint16_t port, uint16_t& boundPort, std::string& error);
+
+    // Accept a connection (kNoSocket on failure)
+    static intptr_t Accept(intptr_t listener);
+
+    // Connect to host:port within timeout. The connection has Nagle disabled
+    // and sends time out after sendTimeout (a stalled peer is an error).
+    static intptr_t Connect(const std::string& host, uint16_t port, std::chrono::milliseconds timeout,
+                            std::chrono::milliseconds sendTimeout, std::string& error);
+
+    // Wait until the socket is readable (or the peer closed it)
+    static bool WaitReadable(intptr_t socket, std::chrono::milliseconds timeout);
+
+    // Send everything; false if the connection failed or the send timed out
+    static bool SendAll(intptr_t socket, const char* data, size_t length);
+
+    // Receive up to length bytes; 0 when the peer closed, -1 on error
+    static int Receive(intptr_t socket, char* data, size_t length);
+
+    // Make a socket non-blocking (reactor use; Nagle is disabled too)
+    static void SetNonBlocking(intptr_t socket);
+
+    // Non-blocking receive/send: bytes transferred, 0 if the call would
+    // block, -1 when the peer closed or the connection failed
+    static int TryReceive(intptr_t socket, char* data, size_t length);
+    static int TrySend(intptr_t socket, const char* data, size_t length);
+
+    // Split "host:port" ("[v6]:port" too); false if the port is missing or invalid
+    static bool ParseEndpoint(const std::string& endpoint, std::string& host, uint16_t& port);
+
+    // Name of this machine ("" if unknown)
+    static std::string GetHostName();
+};
+
+// Readiness of many sockets for one reactor thread: epoll on Linux,
+// poll() / WSAPoll() elsewhere. Sockets are identified to the caller by a
+// token given when they are added.
+class SocketPoller {
+public:
+    struct Event {
+        uint64_t token;
+        bool readable;              // Or closed / failed: the next receive tells
+        bool writable;
+    };
+
+    SocketPoller();
+    ~SocketPoller();
+
+    SocketPoller(const SocketPoller&) = delete;
+    SocketPoller& operator=(const SocketPoller&) = delete;
+
+    bool IsValid() const;
+
+    // Watch a socket for readability
+    bool Add(intptr_t socket, uint64_t token);
+
+    // Also watch for writability (pending output), or stop doing so
+    void SetWritable(intptr_t socket, uint64_t token, bool writable);
+
+    void Remove(intptr_t socket);
+
+    // Wait up to timeout for ready sockets; events is replaced
+    size_t Wait(std::vector<Event>& events, std::chrono::milliseconds timeout);
+
+private:
+    struct Entry {
+        intptr_t socket;
+        uint64_t token;
+        bool writable;
+    };
+
+    intptr_t m_epoll;               // Linux
+    std::vector<Entry> m_entries;   // Elsewhere
+};
+
+} // namespace DriverMonitor
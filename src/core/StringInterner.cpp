@@ -0,0 +1,96 @@
+#include "StringInterner.h"
+
+namespace {
+    // Compact once this many strings are dead and they outnumber the live ones
+    const size_t kMinDeadStrings = 4096;
+}
+
+namespace DriverMonitor {
+
+StringInterner::StringInterner()
+    : m_deadStrings(0) {
+}
+
+uint32_t StringInterner::Intern(std::string_view value, bool* inserted) {
+    auto it = m_ids.find(value);
+    if (it != m_ids.end()) {
+        AddRef(it->second);
+        if (inserted) {
+            *inserted = false;
+        }
+        return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(m_data.size());
+    m_data.emplace_back(value);
+    m_ids.emplace(m_data.back(), id);
+    m_refCounts.push_back(1);
+    if (inserted) {
+        *inserted = true;
+    }
+    return id;
+}
+
+void StringInterner::AddRef(uint32_t id) {
+    if (m_refCounts[id]++ == 0) {
+        m_deadStrings--;
+    }
+}
+
+void StringInterner::Release(uint32_t id) {
+    if (--m_refCounts[id] == 0) {
+        m_deadStrings++;
+    }
+}
+
+bool StringInterner::Find(std::string_view value, uint32_t& id) const {
+    auto it = m_ids.find(value);
+    if (it == m_ids.end()) {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+size_t StringInterner::GetMemoryBytes() const {
+    size_t bytes = m_refCounts.capacity() * sizeof(uint32_t);
+
+    // Strings (long ones on the heap), map nodes (key, value, next pointer, cached hash)
+    for (const auto& value : m_data) {
+        bytes += sizeof(std::string) + sizeof(std::string_view) + sizeof(uint32_t) + 2 * sizeof(void*);
+        if (value.capacity() > 15) {
+            bytes += value.capacity() + 1;
+        }
+    }
+    bytes += m_ids.bucket_count() * sizeof(void*);
+    return bytes;
+}
+
+bool StringInterner::ShouldCompact() const {
+    return m_deadStrings > kMinDeadStrings && m_deadStrings * 2 > m_data.size();
+}
+
+void StringInterner::Compact(std::vector<uint32_t>& remap) {
+    std::deque<std::string> data;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::vector<uint32_t> refCounts;
+    remap.assign(m_data.size(), 0);
+
+    for (uint32_t id = 0; id < m_data.size(); ++id) {
+        if (m_refCounts[id] == 0) {
+            continue;
+        }
+        uint32_t newId = static_cast<uint32_t>(data.size());
+        data.push_back(std::move(m_data[id]));
+        ids.emplace(data.back(), newId);
+        refCounts.push_back(m_refCounts[id]);
+        remap[id] = newId;
+    }
+
+    m_data.swap(data);
+    m_ids.swap(ids);
+    m_refCounts.swap(refCounts);
+    m_deadStrings = 0;
+}
+
+} // namespace DriverMonitor
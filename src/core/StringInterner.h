@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Reference-counted string dictionary: equal strings share one ID, and an
+// ID stays valid while referenced. A string whose last reference is released
+// stays in the dictionary (interning it again revives it) until Compact drops
+// the dead strings and renumbers the live ones, after which the owner remaps
+// the IDs it holds. Not thread safe.
+class StringInterner {
+public:
+    StringInterner();
+
+    // ID of value with one more reference; inserted (optional) is set when
+    // the string was not in the dictionary
+    uint32_t Intern(std::string_view value, bool* inserted = nullptr);
+
+    // Take / drop a reference to an interned string
+    void AddRef(uint32_t id);
+    void Release(uint32_t id);
+
+    // ID of value, referenced or not; false if it is not in the dictionary
+    bool Find(std::string_view value, uint32_t& id) const;
+
+    const std::string& Get(uint32_t id) const { return m_data[id]; }
+
+    // IDs in use, including unreferenced strings not yet compacted
+    size_t GetSize() const { return m_data.size(); }
+
+    // Strings still referenced
+    size_t GetLiveCount() const { return m_data.size() - m_deadStrings; }
+
+    // Approximate heap usage in bytes
+    size_t GetMemoryBytes() const;
+
+    // True once enough strings are dead to be worth a Compact
+    bool ShouldCompact() const;
+
+    // Drop unreferenced strings and renumber the rest: remap[old ID] = new ID
+    // (the entries of dropped strings are meaningless)
+    void Compact(std::vector<uint32_t>& remap);
+
+private:
+    std::deque<std::string> m_data;                         // By ID; elements never move
+    std::unordered_map<std::string_view, uint32_t> m_ids;   // Views of m_data
+    std::vector<uint32_t> m_refCounts;
+    size_t m_deadStrings;                                   // Strings nothing references
+};
+
+} // namespace DriverMonitor
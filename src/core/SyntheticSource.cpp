@@ -0,0 +1,148 @@
+#include "SyntheticSource.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const char* const kInitiators[] = {
+        "services.exe", "System", "svchost.exe", "explorer.exe", "msiexec.exe", "loader.exe"
+    };
+
+#ifdef _WIN32
+    const char* const kPathRoot = "C:\\Windows\\System32\\drivers\\synthetic";
+    const char kPathSeparator = '\\';
+#else
+    const char* const kPathRoot = "/lib/modules/synthetic";
+    const char kPathSeparator = '/';
+#endif
+}
+
+namespace DriverMonitor {
+
+SyntheticProfile::SyntheticProfile()
+    : nameCount(1000)
+    , nameSkew(1.0)
+    , pathCount(16)
+    , removalRatio(0.05)
+    , seed(1) {
+    signers = {
+        { "Microsoft Windows", 70.0 },
+        { "Signed by Contoso Ltd", 20.0 },
+        { "Not Signed", 10.0 }
+    };
+    methods = {
+        { "Registry - Service Installation", 40.0 },
+        { "File System - New Driver File", 30.0 },
+        { "WMI - Driver Started", 25.0 },
+        { "Direct Load", 4.0 },
+        { "Manual Map", 1.0 }
+    };
+}
+
+SyntheticSource::SyntheticSource(const SyntheticProfile& profile)
+    : m_removalRatio(profile.removalRatio)
+    , m_state(profile.seed) {
+    size_t nameCount = std::max<size_t>(profile.nameCount, 1);
+    size_t pathCount = std::max<size_t>(profile.pathCount, 1);
+
+    std::vector<double> signerWeights;
+    for (const auto& signer : profile.signers) {
+        m_signers.push_back(signer.value);
+        signerWeights.push_back(signer.weight);
+    }
+    if (m_signers.empty()) {
+        m_signers.push_back("Not Signed");
+        signerWeights.push_back(1.0);
+    }
+    std::vector<double> signerCdf = BuildCdf(signerWeights);
+
+    std::vector<double> methodWeights;
+    for (const auto& method : profile.methods) {
+        m_methods.push_back(method.value);
+        methodWeights.push_back(method.weight);
+    }
+    if (m_methods.empty()) {
+        m_methods.push_back("Unknown");
+        methodWeights.push_back(1.0);
+    }
+    m_methodCdf = BuildCdf(methodWeights);
+
+    for (const char* initiator : kInitiators) {
+        m_initiators.push_back(initiator);
+    }
+
+    // A driver keeps its directory and signer across events, like a real one
+    m_names.resize(nameCount);
+    for (size_t i = 0; i < nameCount; ++i) {
+        NameEntry& entry = m_names[i];
+        entry.name = "syn" + std::to_string(i) + ".sys";
+        entry.path = std::string(kPathRoot) + std::to_string(i % pathCount) + kPathSeparator + entry.name;
+        entry.signerIndex = static_cast<uint32_t>(Pick(signerCdf, NextUnit()));
+    }
+
+    if (profile.nameSkew > 0.0 && nameCount > 1) {
+        // Zipf: rank r is drawn with weight 1 / r^s
+        std::vector<double> nameWeights(nameCount);
+        for (size_t i = 0; i < nameCount; ++i) {
+            nameWeights[i] = 1.0 / std::pow(static_cast<double>(i + 1), profile.nameSkew);
+        }
+        m_nameCdf = BuildCdf(nameWeights);
+    }
+}
+
+void SyntheticSource::Generate(DriverEvent& event) {
+    size_t nameIndex = m_nameCdf.empty()
+        ? static_cast<size_t>(NextRandom() % m_names.size())
+        : Pick(m_nameCdf, NextUnit());
+    const NameEntry& entry = m_names[nameIndex];
+
+    event.driverName = entry.name;
+    event.installPath = entry.path;
+    event.loadingMethod = m_methods[Pick(m_methodCdf, NextUnit())];
+
+    uint64_t bits = NextRandom();
+    event.initiatedBy = m_initiators[bits % m_initiators.size()];
+    event.processId = static_cast<unsigned long>(4 + ((bits >> 8) % 65536) * 4);
+    event.isRemoval = NextUnit() < m_removalRatio;
+    event.signerInfo = event.isRemoval ? std::string() : m_signers[entry.signerIndex];
+    event.source = EventSource::Synthetic;
+    event.timestampUs = 0;
+}
+
+uint64_t SyntheticSource::NextRandom() {
+    // splitmix64
+    uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+double SyntheticSource::NextUnit() {
+    // 53 random bits -> [0, 1)
+    return static_cast<double>(NextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+std::vector<double> SyntheticSource::BuildCdf(const std::vector<double>& weights) {
+    std::vector<double> cdf(weights.size());
+    double total = 0.0;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        total += std::max(weights[i], 0.0);
+        cdf[i] = total;
+    }
+    for (auto& value : cdf) {
+        value = total > 0.0 ? value / total : 1.0;
+    }
+    if (!cdf.empty()) {
+        cdf.back() = 1.0;
+    }
+    return cdf;
+}
+
+size_t SyntheticSource::Pick(const std::vector<double>& cdf, double u) {
+    auto it = std::upper_bound(cdf.begin(), cdf.end(), u);
+    if (it == cdf.end()) {
+        return cdf.size() - 1;
+    }
+    return static_cast<size_t>(it - cdf.begin());
+}
+
+} // namespace DriverMonitor
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Utils.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+// String value drawn with a relative weight
+struct WeightedValue {
+    std::string value;
+    double weight;
+};
+
+// Shape of a synthetic observation stream
+struct SyntheticProfile {
+    size_t nameCount;                       // Distinct driver names
+    double nameSkew;                        // Zipf exponent over names (0 = uniform)
+    size_t pathCount;                       // Distinct install directories
+    std::vector<WeightedValue> signers;     // Signer verdicts (fixed per driver name)
+    std::vector<WeightedValue> methods;     // Loading methods (drawn per event)
+    double removalRatio;                    // Fraction of removal observations
+    uint64_t seed;
+
+    // Defaults: a mostly Microsoft-signed population with a small suspicious tail
+    SyntheticProfile();
+};
+
+// Deterministic generator of raw observations for load testing.
+// Names, paths and signer verdicts are precomputed, so generating an event
+// costs a few random draws and string copies. Not thread-safe; use one
+// instance (with its own seed) per producer thread.
+class SyntheticSource {
+public:
+    explicit SyntheticSource(const SyntheticProfile& profile);
+
+    // Fill event with the next observation (signer verdict preset, source Synthetic)
+    void Generate(DriverEvent& event);
+
+    // Get number of distinct names
+    size_t GetNameCount() const { return m_names.size(); }
+
+    // Cumulative distribution normalized to 1
+    static std::vector<double> BuildCdf(const std::vector<double>& weights);
+
+    // Index of the first CDF entry > u (the last one if none): entry i owns
+    // [cdf[i - 1], cdf[i]), so a zero-weight entry is never picked
+    static size_t Pick(const std::vector<double>& cdf, double u);
+
+private:
+    struct NameEntry {
+        std::string name;
+        std::string path;
+        uint32_t signerIndex;
+    };
+
+    std::vector<NameEntry> m_names;
+    std::vector<double> m_nameCdf;          // Empty = uniform
+    std::vector<std::string> m_signers;
+    std::vector<std::string> m_methods;
+    std::vector<double> m_methodCdf;
+    std::vector<std::string> m_initiators;
+    double m_removalRatio;
+    uint64_t m_state;
+
+    uint64_t NextRandom();
+    double NextUnit();
+};
+
+} // namespace DriverMonitor
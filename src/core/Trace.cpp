@@ -0,0 +1,312 @@
+#include "Trace.h"
+#include "MemoryAccounting.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace DriverMonitor {
+
+namespace {
+    static_assert((Tracer::kBufferEvents & (Tracer::kBufferEvents - 1)) == 0, "trace buffer size must be a power of two");
+
+    // Slow cycles in a row dump once
+    const std::chrono::seconds kSlowDumpCooldown(10);
+
+    // Fields are atomics so a dump may read a slot while its thread rewrites
+    // it; the dump discards such slots (see CopyRecords)
+    struct TraceRecord {
+        std::atomic<const char*> name;
+        std::atomic<const char*> category;
+        std::atomic<int64_t> startNs;
+        std::atomic<int64_t> durationNs;
+    };
+
+    // One thread's ring buffer; reused by a later thread once its owner exits
+    struct TraceBuffer {
+        TraceRecord records[Tracer::kBufferEvents];
+        std::atomic<uint64_t> written;      // Spans ever recorded (next index)
+        std::atomic<uint64_t> clearedBelow; // Clear(): indices below are dropped
+        std::atomic<bool> inUse;
+        std::atomic<const char*> threadName;
+        uint32_t trackId;                   // "tid" of the trace
+        TraceBuffer* next;
+
+        TraceBuffer() : written(0), clearedBelow(0), inUse(true), threadName(nullptr), trackId(0), next(nullptr) {}
+    };
+
+    // Buffers are never freed: a dump can walk the list without a lock
+    std::atomic<TraceBuffer*> g_buffers(nullptr);
+    std::atomic<uint32_t> g_bufferCount(0);
+
+    // Timestamps are written relative to the first time tracing was enabled
+    std::atomic<int64_t> g_originNs(0);
+
+    std::atomic<int64_t> g_slowThresholdNs(0);
+    std::atomic<uint64_t> g_slowDumps(0);
+    std::mutex g_slowMutex;                 // Guards the fields below
+    std::string g_slowPath;
+    int g_nextSlowFile = 0;
+    std::chrono::steady_clock::time_point g_lastSlowDump;
+    bool g_slowDumped = false;
+
+    int64_t ToNanoseconds(std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    TraceBuffer* ClaimBuffer() {
+        for (TraceBuffer* buffer = g_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+            bool expected = false;
+            if (!buffer->inUse.load(std::memory_order_relaxed) &&
+                buffer->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return buffer;
+            }
+        }
+        TraceBuffer* buffer = new TraceBuffer();
+        MemoryAccounting::Charge(MemorySubsystem::Trace, sizeof(TraceBuffer));
+        buffer->trackId = g_bufferCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        buffer->next = g_buffers.load(std::memory_order_relaxed);
+        while (!g_buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        return buffer;
+    }
+
+    // The calling thread's buffer, claimed on its first span
+    struct ThreadTrace {
+        TraceBuffer* buffer;
+        const char* name;
+
+        ThreadTrace() : buffer(nullptr), name(nullptr) {}
+        ~ThreadTrace() {
+            if (buffer) {
+                buffer->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local ThreadTrace t_trace;
+
+    struct CopiedRecord {
+        const char* name;
+        const char* category;
+        int64_t startNs;
+        int64_t durationNs;
+    };
+
+    // Copy the buffer's spans without stopping its writer. A slot is kept
+    // only if the writer had not started overwriting it by the time the copy
+    // finished: with n spans published the writer may be writing slot n, which
+    // held n - kBufferEvents, so at most kBufferEvents - 1 spans are returned.
+    void CopyRecords(TraceBuffer& buffer, std::vector<CopiedRecord>& out) {
+        uint64_t end = buffer.written.load(std::memory_order_acquire);
+        uint64_t begin = end > Tracer::kBufferEvents ? end - Tracer::kBufferEvents : 0;
+        begin = std::max(begin, buffer.clearedBelow.load(std::memory_order_relaxed));
+        size_t first = out.size();
+        for (uint64_t index = begin; index < end; ++index) {
+            const TraceRecord& record = buffer.records[index & (Tracer::kBufferEvents - 1)];
+            out.push_back({ record.name.load(std::memory_order_relaxed), record.category.load(std::memory_order_relaxed),
+                            record.startNs.load(std::memory_order_relaxed), record.durationNs.load(std::memory_order_relaxed) });
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t now = buffer.written.load(std::memory_order_relaxed);
+        uint64_t firstValid = now >= Tracer::kBufferEvents ? now - Tracer::kBufferEvents + 1 : 0;
+        if (firstValid > begin) {
+            size_t overwritten = static_cast<size_t>(std::min(firstValid, end) - begin);
+            out.erase(out.begin() + first, out.begin() + first + overwritten);
+        }
+    }
+
+    void AppendJsonText(std::string& out, const char* text) {
+        for (; *text; ++text) {
+            char c = *text;
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) >= 0x20) {
+                out += c;
+            }
+        }
+    }
+
+    unsigned long GetProcessId() {
+#ifdef _WIN32
+        return static_cast<unsigned long>(::GetCurrentProcessId());
+#else
+        return static_cast<unsigned long>(getpid());
+#endif
+    }
+
+    // path with "-slow-N" inserted before the extension
+    std::string GetSlowDumpPath(const std::string& path, int number) {
+        std::filesystem::path base(path);
+        std::string name = base.stem().string() + "-slow-" + std::to_string(number) + base.extension().string();
+        return (base.parent_path() / name).string();
+    }
+}
+
+std::atomic<bool> Tracer::s_enabled(false);
+
+bool Tracer::SetEnabled(bool enabled) {
+    if (!IsAvailable()) {
+        return false;
+    }
+    if (enabled) {
+        int64_t unset = 0;
+        g_originNs.compare_exchange_strong(unset, ToNanoseconds(std::chrono::steady_clock::now()));
+    }
+    s_enabled.store(enabled, std::memory_order_relaxed);
+    return true;
+}
+
+void Tracer::SetThreadName(const char* name) {
+    t_trace.name = name;
+    if (t_trace.buffer) {
+        t_trace.buffer->threadName.store(name, std::memory_order_relaxed);
+    }
+}
+
+void Tracer::Record(const char* name, const char* category,
+                    std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    TraceBuffer* buffer = t_trace.buffer;
+    if (!buffer) {
+        buffer = ClaimBuffer();
+        buffer->threadName.store(t_trace.name, std::memory_order_relaxed);
+        t_trace.buffer = buffer;
+    }
+
+    // Seqlock-style: the count published last is ordered before the slot
+    // stores, so a dump that sees any of them also sees the slot as taken
+    uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    TraceRecord& record = buffer->records[index & (kBufferEvents - 1)];
+    int64_t startNs = ToNanoseconds(start);
+    record.name.store(name, std::memory_order_relaxed);
+    record.category.store(category, std::memory_order_relaxed);
+    record.startNs.store(startNs, std::memory_order_relaxed);
+    record.durationNs.store(ToNanoseconds(end) - startNs, std::memory_order_relaxed);
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::EndCycle(const char* name, std::chrono::steady_clock::time_point start,
+                      std::chrono::steady_clock::time_point end) {
+    Record(name, "cycle", start, end);
+
+    int64_t threshold = g_slowThresholdNs.load(std::memory_order_relaxed);
+    if (threshold <= 0 || ToNanoseconds(end) - ToNanoseconds(start) <= threshold) {
+        return;
+    }
+
+    // Another thread's slow cycle is being dumped: this one is in it too
+    std::unique_lock<std::mutex> lock(g_slowMutex, std::try_to_lock);
+    if (!lock.owns_lock() || (g_slowDumped && end - g_lastSlowDump < kSlowDumpCooldown)) {
+        return;
+    }
+    std::string path = GetSlowDumpPath(g_slowPath, g_nextSlowFile);
+    g_nextSlowFile = (g_nextSlowFile + 1) % kSlowDumpFiles;
+    g_lastSlowDump = end;
+    g_slowDumped = true;
+    if (Dump(path)) {
+        g_slowDumps.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Tracer::SetSlowCycleDump(std::chrono::milliseconds threshold, const std::string& path) {
+    std::lock_guard<std::mutex> lock(g_slowMutex);
+    g_slowPath = path;
+    g_slowDumped = false;
+    g_slowThresholdNs.store(path.empty() ? 0 : std::chrono::duration_cast<std::chrono::nanoseconds>(threshold).count(),
+                            std::memory_order_relaxed);
+}
+
+uint64_t Tracer::GetRecordedCount() {
+    uint64_t count = 0;
+    for (TraceBuffer* buffer = g_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        count += buffer->written.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+uint64_t Tracer::GetSlowDumpCount() {
+    return g_slowDumps.load(std::memory_order_relaxed);
+}
+
+void Tracer::WriteJson(std::ostream& out) {
+    unsigned long pid = GetProcessId();
+    int64_t origin = g_originNs.load(std::memory_order_relaxed);
+    std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    char number[160];
+    std::vector<CopiedRecord> records;
+
+    for (TraceBuffer* buffer = g_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        records.clear();
+        CopyRecords(*buffer, records);
+        if (records.empty()) {
+            continue;
+        }
+
+        const char* threadName = buffer->threadName.load(std::memory_order_relaxed);
+        std::snprintf(number, sizeof(number), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%u,\"args\":{\"name\":\"",
+                      first ? "" : ",", pid, buffer->trackId);
+        json += number;
+        if (threadName) {
+            AppendJsonText(json, threadName);
+        } else {
+            json += "thread " + std::to_string(buffer->trackId);
+        }
+        json += "\"}}";
+        first = false;
+
+        // Complete events; ts and dur in microseconds
+        for (const CopiedRecord& record : records) {
+            json += ",{\"name\":\"";
+            AppendJsonText(json, record.name ? record.name : "?");
+            json += "\",\"cat\":\"";
+            AppendJsonText(json, record.category ? record.category : "");
+            std::snprintf(number, sizeof(number), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%u}",
+                          (record.startNs - origin) / 1000.0, record.durationNs / 1000.0, pid, buffer->trackId);
+            json += number;
+        }
+        out.write(json.data(), static_cast<std::streamsize>(json.size()));
+        json.clear();
+    }
+    json += "]}\n";
+    out.write(json.data(), static_cast<std::streamsize>(json.size()));
+}
+
+bool Tracer::Dump(const std::string& path) {
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        WriteJson(file);
+        if (!file) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void Tracer::Clear() {
+    for (TraceBuffer* buffer = g_buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        buffer->clearedBelow.store(buffer->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+} // namespace DriverMonitor
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// DRIVERMONITOR_TRACING (CMake option, on by default) compiles the span
+// macros below in; without it they expand to nothing and Tracer only
+// reports that tracing is unavailable.
+#ifndef DRIVERMONITOR_TRACING
+#define DRIVERMONITOR_TRACING 0
+#endif
+
+namespace DriverMonitor {
+
+// Span tracing in the Chrome trace-event format (chrome://tracing, Perfetto).
+//
+// Each thread records complete spans (name, category, start, duration) into
+// its own ring buffer of its most recent spans (kBufferEvents - 1): four relaxed
+// stores and a release store, no lock and no allocation after the thread's
+// first span. Disabled, a span costs one relaxed load. Names and categories
+// must be string literals (or otherwise outlive the trace).
+//
+// A dump copies every buffer without stopping the writers; spans overwritten
+// while it copies are skipped. Buffers of exited threads are reused, so
+// memory stays at one buffer per concurrently tracing thread.
+class Tracer {
+public:
+    static const size_t kBufferEvents = 8192;
+
+    // Compiled in (DRIVERMONITOR_TRACING)
+    static bool IsAvailable() { return DRIVERMONITOR_TRACING != 0; }
+
+    static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Start or stop recording; false if tracing is not compiled in
+    static bool SetEnabled(bool enabled);
+
+    // Name shown for the calling thread ("pipeline", "poll", ...)
+    static void SetThreadName(const char* name);
+
+    // Record one span of the calling thread
+    static void Record(const char* name, const char* category,
+                       std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    // Poll cycle: recorded as a span, and the trace is dumped when it took
+    // longer than the slow-cycle threshold (at most once per cooldown)
+    static void EndCycle(const char* name, std::chrono::steady_clock::time_point start,
+                         std::chrono::steady_clock::time_point end);
+
+    // Dump on slow cycles to path with "-slow-N" before the extension, N
+    // cycling through kSlowDumpFiles; a zero threshold turns it off
+    static const int kSlowDumpFiles = 8;
+    static void SetSlowCycleDump(std::chrono::milliseconds threshold, const std::string& path);
+
+    // Spans recorded so far, and slow-cycle dumps written
+    static uint64_t GetRecordedCount();
+    static uint64_t GetSlowDumpCount();
+
+    // The buffered spans as trace-event JSON ({"traceEvents":[...]})
+    static void WriteJson(std::ostream& out);
+
+    // WriteJson to path through a temporary file and a rename
+    static bool Dump(const std::string& path);
+
+    // Drop every buffered span
+    static void Clear();
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// Records the span from construction (or the given start) to destruction
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category)
+        : m_name(Tracer::IsEnabled() ? name : nullptr)
+        , m_category(category) {
+        if (m_name) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    TraceSpan(const char* name, const char* category, std::chrono::steady_clock::time_point start)
+        : m_name(Tracer::IsEnabled() ? name : nullptr)
+        , m_category(category)
+        , m_start(start) {
+    }
+
+    ~TraceSpan() {
+        if (m_name) {
+            Tracer::Record(m_name, m_category, m_start, std::chrono::steady_clock::now());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name;                     // nullptr = not recording
+    const char* m_category;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace DriverMonitor
+
+#define DM_TRACE_CONCAT_INNER(a, b) a##b
+#define DM_TRACE_CONCAT(a, b) DM_TRACE_CONCAT_INNER(a, b)
+
+#if DRIVERMONITOR_TRACING
+// Span until the end of the enclosing scope (optionally from a given start)
+#define DM_TRACE_SPAN(...) \
+    ::DriverMonitor::TraceSpan DM_TRACE_CONCAT(dmTraceSpan, __LINE__)(__VA_ARGS__)
+// Span between two timestamps the caller already has
+#define DM_TRACE_RECORD(name, category, start, end) \
+    do { if (::DriverMonitor::Tracer::IsEnabled()) ::DriverMonitor::Tracer::Record(name, category, start, end); } while (0)
+#define DM_TRACE_CYCLE(name, start, end) \
+    do { if (::DriverMonitor::Tracer::IsEnabled()) ::DriverMonitor::Tracer::EndCycle(name, start, end); } while (0)
+#else
+// Arguments stay unevaluated, so nothing is computed and nothing is unused
+#define DM_TRACE_SPAN(...) ((void)sizeof((__VA_ARGS__)))
+#define DM_TRACE_RECORD(name, category, start, end) ((void)sizeof(((name), (category), (start), (end))))
+#define DM_TRACE_CYCLE(name, start, end) ((void)sizeof(((name), (start), (end))))
+#endif
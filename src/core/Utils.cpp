@@ -1,28 +1,160 @@
 #include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+
+#ifdef _WIN32
 #include <Windows.h>
 #include <WinTrust.h>
 #include <SoftPub.h>
 #include <wincrypt.h>
 #include <psapi.h>
-#include <algorithm>
-#include <sstream>
-#include <iomanip>
+#include <io.h>
 
 #pragma comment(lib, "wintrust.lib")
 #pragma comment(lib, "crypt32.lib")
+#else
+#include <unistd.h>
+#endif
 
 namespace DriverMonitor {
 
 std::string Utils::GetTimestamp() {
-    time_t now = time(nullptr);
+    return FormatTimestamp(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+std::string Utils::FormatTimestamp(int64_t micros) {
+    time_t seconds = static_cast<time_t>(micros / 1000000);
     struct tm timeInfo;
-    localtime_s(&timeInfo, &now);
+#ifdef _WIN32
+    localtime_s(&timeInfo, &seconds);
+#else
+    localtime_r(&seconds, &timeInfo);
+#endif
     
     char buffer[64];
     strftime(buffer, sizeof(buffer), "[%H:%M:%S]", &timeInfo);
     return std::string(buffer);
 }
 
+const char* Utils::GetSourceName(EventSource source) {
+    switch (source) {
+        case EventSource::Registry: return "Registry";
+        case EventSource::FileSystem: return "FileSystem";
+        case EventSource::WMI: return "WMI";
+        case EventSource::ETW: return "ETW";
+        case EventSource::Synthetic: return "Synthetic";
+        case EventSource::Unknown: break;
+    }
+    return "Unknown";
+}
+
+const char* Utils::GetEventTypeName(EventType type) {
+    switch (type) {
+        case EventType::Signed: return "SIGNED";
+        case EventType::Unsigned: return "UNSIGNED";
+        case EventType::Suspicious: return "SUSPICIOUS";
+    }
+    return "UNKNOWN";
+}
+
+const char* Utils::GetThreatLevelName(ThreatLevel level) {
+    switch (level) {
+        case ThreatLevel::Low: return "Low";
+        case ThreatLevel::Medium: return "Medium";
+        case ThreatLevel::High: return "High";
+    }
+    return "Unknown";
+}
+
+std::string Utils::FormatLogLine(const DriverEvent& event) {
+    const char* typeName = GetEventTypeName(event.eventType);
+    
+    std::string line;
+    line.reserve(event.timestamp.size() + event.driverName.size() + event.loadingMethod.size() +
+                 event.signerInfo.size() + 24);
+    line += event.timestamp;
+    line += " [";
+    line += typeName;
+    line += "] ";
+    line += event.driverName;
+    line += " - ";
+    line += event.loadingMethod;
+    line += " - ";
+    line += event.signerInfo;
+    line += '\n';
+    return line;
+}
+
+void Utils::AppendJsonString(std::string& out, const std::string& value) {
+    static const char kHex[] = "0123456789abcdef";
+    
+    out += '"';
+    for (char c : value) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (byte < 0x20) {
+                    out += "\\u00";
+                    out += kHex[byte >> 4];
+                    out += kHex[byte & 0xF];
+                } else {
+                    out += c;
+                }
+                break;
+        }
+    }
+    out += '"';
+}
+
+std::string Utils::FormatJsonLine(const DriverEvent& event) {
+    std::string line;
+    line.reserve(256);
+    AppendJsonLine(line, event);
+    return line;
+}
+
+void Utils::AppendJsonLine(std::string& line, const DriverEvent& event) {
+    line += "{\"sequenceId\":";
+    line += std::to_string(event.sequenceId);
+    line += ",\"timestampUs\":";
+    line += std::to_string(event.timestampUs);
+    line += ",\"time\":";
+    AppendJsonString(line, event.timestamp);
+    line += ",\"driverName\":";
+    AppendJsonString(line, event.driverName);
+    line += ",\"installPath\":";
+    AppendJsonString(line, event.installPath);
+    line += ",\"loadingMethod\":";
+    AppendJsonString(line, event.loadingMethod);
+    line += ",\"initiatedBy\":";
+    AppendJsonString(line, event.initiatedBy);
+    line += ",\"processId\":";
+    line += std::to_string(event.processId);
+    line += ",\"signerInfo\":";
+    AppendJsonString(line, event.signerInfo);
+    line += ",\"eventType\":\"";
+    line += GetEventTypeName(event.eventType);
+    line += "\",\"threatLevel\":\"";
+    line += GetThreatLevelName(event.threatLevel);
+    line += "\",\"source\":\"";
+    line += GetSourceName(event.source);
+    line += "\",\"removal\":";
+    line += event.isRemoval ? "true" : "false";
+    line += "}\n";
+}
+
+#ifdef _WIN32
+
 std::string Utils::GetProcessName(unsigned long pid) {
     HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, pid);
     if (!hProcess) {
@@ -139,6 +271,65 @@ std::string Utils::GetSignerInfo(const std::string& filePath) {
     return "Not Signed";
 }
 
+bool Utils::GetProcessMemory(uint64_t& residentBytes, uint64_t& peakBytes) {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return false;
+    }
+    residentBytes = counters.WorkingSetSize;
+    peakBytes = counters.PeakWorkingSetSize;
+    return true;
+}
+
+bool Utils::SyncFile(std::FILE* file) {
+    return std::fflush(file) == 0 && _commit(_fileno(file)) == 0;
+}
+
+#else
+
+std::string Utils::GetProcessName(unsigned long pid) {
+    std::ifstream comm("/proc/" + std::to_string(pid) + "/comm");
+    std::string name;
+    if (!comm.is_open() || !std::getline(comm, name) || name.empty()) {
+        return "Unknown";
+    }
+    return name;
+}
+
+std::string Utils::GetSignerInfo(const std::string& filePath) {
+    // Authenticode verification is only available on Windows
+    (void)filePath;
+    return "Not Verified";
+}
+
+bool Utils::GetProcessMemory(uint64_t& residentBytes, uint64_t& peakBytes) {
+    // VmRSS / VmHWM are reported in kB
+    std::ifstream status("/proc/self/status");
+    if (!status.is_open()) {
+        return false;
+    }
+    
+    bool haveResident = false;
+    bool havePeak = false;
+    std::string line;
+    while (std::getline(status, line) && !(haveResident && havePeak)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            residentBytes = std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+            haveResident = true;
+        } else if (line.compare(0, 6, "VmHWM:") == 0) {
+            peakBytes = std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+            havePeak = true;
+        }
+    }
+    return haveResident && havePeak;
+}
+
+bool Utils::SyncFile(std::FILE* file) {
+    return std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+#endif
+
 bool Utils::IsMicrosoftSigned(const std::string& signerInfo) {
     return ContainsIgnoreCase(signerInfo, "Microsoft");
 }
@@ -203,9 +394,57 @@ std::string Utils::ToLower(const std::string& str) {
 }
 
 bool Utils::ContainsIgnoreCase(const std::string& haystack, const std::string& needle) {
-    std::string lowerHaystack = ToLower(haystack);
-    std::string lowerNeedle = ToLower(needle);
-    return lowerHaystack.find(lowerNeedle) != std::string::npos;
+    if (needle.size() > haystack.size()) {
+        return false;
+    }
+    
+    size_t last = haystack.size() - needle.size();
+    for (size_t start = 0; start <= last; ++start) {
+        size_t i = 0;
+        while (i < needle.size() && FoldCase(haystack[start + i]) == FoldCase(needle[i])) {
+            ++i;
+        }
+        if (i == needle.size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string Utils::FoldCase(const std::string& str) {
+    std::string result = str;
+    for (auto& c : result) {
+        c = FoldCase(c);
+    }
+    return result;
+}
+
+bool Utils::ContainsFolded(const std::string& haystack, const std::string& foldedNeedle) {
+    if (foldedNeedle.empty()) {
+        return true;
+    }
+    if (foldedNeedle.size() > haystack.size()) {
+        return false;
+    }
+    
+    // Scan for the first needle character in either case, then compare the rest
+    char first = foldedNeedle[0];
+    char firstUpper = (first >= 'a' && first <= 'z') ? static_cast<char>(first - ('a' - 'A')) : first;
+    size_t last = haystack.size() - foldedNeedle.size();
+    for (size_t start = 0; start <= last; ++start) {
+        char c = haystack[start];
+        if (c != first && c != firstUpper) {
+            continue;
+        }
+        size_t i = 1;
+        while (i < foldedNeedle.size() && FoldCase(haystack[start + i]) == foldedNeedle[i]) {
+            ++i;
+        }
+        if (i == foldedNeedle.size()) {
+            return true;
+        }
+    }
+    return false;
 }
 
 std::string Utils::FormatUptime(int seconds) {
@@ -220,4 +459,17 @@ std::string Utils::FormatUptime(int seconds) {
     return oss.str();
 }
 
+uint64_t Utils::HashIgnoreCase(const char* data, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<unsigned char>(c + ('a' - 'A'));
+        }
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 } // namespace DriverMonitor
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <ctime>
@@ -20,6 +23,16 @@ enum class EventType {
     Suspicious   // Red - Potentially dangerous
 };
 
+// Monitoring source that produced an observation
+enum class EventSource : uint8_t {
+    Unknown,
+    Registry,
+    FileSystem,
+    WMI,
+    ETW,
+    Synthetic
+};
+
 // Driver event structure
 struct DriverEvent {
     std::string driverName;
@@ -29,10 +42,21 @@ struct DriverEvent {
     unsigned long processId;
     std::string signerInfo;
     std::string timestamp;
+    int64_t timestampUs;    // Observation time, microseconds since the Unix epoch
     EventType eventType;
     ThreatLevel threatLevel;
+    EventSource source;
+    bool isRemoval;         // Driver disappeared (file removed, service deleted, unloaded)
+    uint64_t sequenceId;    // Assigned by EventManager when stored (0 = not stored)
     
-    DriverEvent() : processId(0), eventType(EventType::Unsigned), threatLevel(ThreatLevel::Medium) {}
+    DriverEvent()
+        : processId(0)
+        , timestampUs(0)
+        , eventType(EventType::Unsigned)
+        , threatLevel(ThreatLevel::Medium)
+        , source(EventSource::Unknown)
+        , isRemoval(false)
+        , sequenceId(0) {}
 };
 
 // Configuration structure
@@ -42,10 +66,17 @@ struct MonitorConfig {
     bool ignoreMicrosoft;
     bool blockUnsigned;
     bool verboseMode;
+    std::string driversPath;    // Empty = platform default
+    int memoryBudgetMB;         // Accounted memory limit (0 = none); see MemoryAccounting.h
     
-    // Alert settings
+    // Alert settings (rate limits: see AlertThrottle.h; read when monitoring starts)
     bool playSound;
     bool showNotifications;
+    int alertsPerMinute;                // Per driver (0 = no limit)
+    int alertBurst;
+    int globalAlertsPerMinute;          // Across drivers (0 = no limit)
+    int globalAlertBurst;
+    int alertQuietSeconds;              // Suppressed alerts are summarized after this long without one
     
     // UI settings
     bool autoScroll;
@@ -56,6 +87,14 @@ struct MonitorConfig {
     std::string logFile;
     int maxLogSize;
     
+    // Forwarding settings (see EventForwarder.h; read when monitoring starts)
+    std::string forwardEndpoint;        // Collector "host:port" (empty = no forwarding)
+    std::string forwardSpoolPath;       // Spool directory while the collector is unreachable
+    int forwardBatchEvents;
+    int forwardFlushIntervalMs;
+    int forwardBufferMB;
+    int forwardSpoolMB;
+    
     // Whitelist
     std::vector<std::string> whitelist;
     
@@ -64,13 +103,24 @@ struct MonitorConfig {
         , ignoreMicrosoft(true)
         , blockUnsigned(false)
         , verboseMode(false)
+        , memoryBudgetMB(0)
         , playSound(true)
         , showNotifications(true)
+        , alertsPerMinute(2)
+        , alertBurst(3)
+        , globalAlertsPerMinute(30)
+        , globalAlertBurst(10)
+        , alertQuietSeconds(30)
         , autoScroll(true)
         , maxEvents(1000)
         , loggingEnabled(true)
         , logFile("driver_monitor.log")
         , maxLogSize(10485760)
+        , forwardSpoolPath("forward_spool")
+        , forwardBatchEvents(256)
+        , forwardFlushIntervalMs(1000)
+        , forwardBufferMB(4)
+        , forwardSpoolMB(256)
     {}
 };
 
@@ -80,6 +130,34 @@ public:
     // Get current timestamp string
     static std::string GetTimestamp();
     
+    // Format a time in microseconds since the epoch as a local timestamp string
+    static std::string FormatTimestamp(int64_t micros);
+    
+    // Get source name
+    static const char* GetSourceName(EventSource source);
+    
+    // Get event type name as written to the log ("SIGNED", "UNSIGNED", "SUSPICIOUS")
+    static const char* GetEventTypeName(EventType type);
+    
+    // Get threat level name ("Low", "Medium", "High")
+    static const char* GetThreatLevelName(ThreatLevel level);
+    
+    // Format an event as one log file line (including the newline)
+    static std::string FormatLogLine(const DriverEvent& event);
+    
+    // Append value as a quoted, escaped JSON string
+    static void AppendJsonString(std::string& out, const std::string& value);
+    
+    // Format an event as one JSON Lines record (including the newline)
+    static std::string FormatJsonLine(const DriverEvent& event);
+    static void AppendJsonLine(std::string& out, const DriverEvent& event);
+    
+    // Get resident and peak resident memory of this process in bytes
+    static bool GetProcessMemory(uint64_t& residentBytes, uint64_t& peakBytes);
+    
+    // Flush a stdio file through to the storage device (fsync / _commit)
+    static bool SyncFile(std::FILE* file);
+    
     // Get process name by PID
     static std::string GetProcessName(unsigned long pid);
     
@@ -104,8 +182,19 @@ public:
     // Check if string contains substring (case-insensitive)
     static bool ContainsIgnoreCase(const std::string& haystack, const std::string& needle);
     
+    // ASCII case folding (locale independent, matches HashIgnoreCase)
+    static char FoldCase(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c; }
+    static std::string FoldCase(const std::string& str);
+    
+    // Check if haystack contains an already folded needle, without allocating
+    static bool ContainsFolded(const std::string& haystack, const std::string& foldedNeedle);
+    
     // Format uptime as HH:MM:SS
     static std::string FormatUptime(int seconds);
+    
+    // 64-bit FNV-1a hash of an ASCII case-folded name
+    static uint64_t HashIgnoreCase(const char* data, size_t length);
+    static uint64_t HashIgnoreCase(const std::string& str) { return HashIgnoreCase(str.data(), str.size()); }
 };
 
 } // namespace DriverMonitor
@@ -1,19 +1,35 @@
 #include "MainWindow.h"
+#include "../core/Trace.h"
 #include <imgui.h>
-#include <fstream>
 #include <algorithm>
+#include <cstdio>
 #include <Windows.h>
 
+namespace {
+    // Notifications shown at once, and for how long
+    const size_t kMaxNotifications = 5;
+    const std::chrono::seconds kNotificationDuration(10);
+}
+
 namespace DriverMonitor {
 
 MainWindow::MainWindow(EventManager* eventManager, Config* config, DriverMonitor* monitor)
     : m_eventManager(eventManager)
     , m_config(config)
     , m_monitor(monitor)
-    , m_selectedEventIndex(-1)
+    , m_selectedSequence(0)
+    , m_selectedEventStored(false)
     , m_filterType(0)
-    , m_showDetailsPanel(false) {
+    , m_showDetailsPanel(false)
+    , m_eventView(eventManager)
+    , m_exporter(eventManager)
+    , m_exportFormat(static_cast<int>(ExportFormat::Csv))
+    , m_exportFiltered(false)
+    , m_exportIncremental(false)
+    , m_traceSaveResult(0) {
     memset(m_searchBuffer, 0, sizeof(m_searchBuffer));
+    memset(m_expressionBuffer, 0, sizeof(m_expressionBuffer));
+    m_monitor->SetAlertCallback([this](const Alert& alert) { OnAlert(alert); });
 }
 
 MainWindow::~MainWindow() {
@@ -56,9 +72,48 @@ void MainWindow::Render() {
     RenderFilterPanel();
     RenderEventLogPanel();
     
-    if (m_showDetailsPanel && m_selectedEventIndex >= 0) {
+    if (m_showDetailsPanel && m_selectedSequence != 0) {
         RenderDetailsPanel();
     }
+    
+    RenderNotifications();
+}
+
+void MainWindow::OnAlert(const Alert& alert) {
+    // Shown or not is decided when rendering (the UI thread owns the settings)
+    std::lock_guard<std::mutex> lock(m_notificationMutex);
+    m_notifications.push_front({ alert.Describe(), alert.IsSummary(), std::chrono::steady_clock::now() });
+    if (m_notifications.size() > kMaxNotifications) {
+        m_notifications.pop_back();
+    }
+}
+
+void MainWindow::RenderNotifications() {
+    std::lock_guard<std::mutex> lock(m_notificationMutex);
+    auto expired = std::chrono::steady_clock::now() - kNotificationDuration;
+    while (!m_notifications.empty() && m_notifications.back().raised < expired) {
+        m_notifications.pop_back();
+    }
+    if (m_notifications.empty() || !m_config->GetConfig().showNotifications) {
+        return;
+    }
+    
+    // Top right corner, over the panels
+    ImGuiViewport* viewport = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(viewport->Pos.x + viewport->Size.x - 16.0f, viewport->Pos.y + 32.0f),
+                            ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+    ImGui::SetNextWindowBgAlpha(0.9f);
+    ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                             ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing |
+                             ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoDocking;
+    if (ImGui::Begin("Notifications", nullptr, flags)) {
+        for (const auto& notification : m_notifications) {
+            // Summaries of suppressed alerts in amber, alerts in red
+            ImVec4 color = notification.summary ? ImVec4(1.0f, 0.75f, 0.2f, 1.0f) : ImVec4(1.0f, 0.35f, 0.35f, 1.0f);
+            ImGui::TextColored(color, "%s", notification.text.c_str());
+        }
+    }
+    ImGui::End();
 }
 
 void MainWindow::RenderControlPanel() {
@@ -99,14 +154,54 @@ void MainWindow::RenderControlPanel() {
         
         ImGui::Spacing();
         
-        // Export logs button
-        if (ImGui::Button("Export Logs", ImVec2(-1, 0))) {
-            ExportLogs();
-        }
+        RenderExportControls();
     }
     ImGui::End();
 }
 
+void MainWindow::RenderExportControls() {
+    ImGui::Separator();
+    
+    if (m_exporter.IsRunning()) {
+        ExportProgress progress = m_exporter.GetProgress();
+        float fraction = progress.total > 0 ? static_cast<float>(progress.examined) / progress.total : 0.0f;
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%llu events", static_cast<unsigned long long>(progress.written));
+        ImGui::ProgressBar(fraction, ImVec2(-1, 0), overlay);
+        if (ImGui::Button("Cancel Export", ImVec2(-1, 0))) {
+            m_exporter.Cancel();
+        }
+        return;
+    }
+    
+    const char* formats[] = { "CSV", "JSON Lines", "Columnar" };
+    ImGui::Combo("Format", &m_exportFormat, formats, IM_ARRAYSIZE(formats));
+    ImGui::Checkbox("Only filtered events", &m_exportFiltered);
+    ImGui::Checkbox("Only new events", &m_exportIncremental);
+    
+    // Export logs button
+    if (ImGui::Button("Export Logs", ImVec2(-1, 0))) {
+        ExportLogs();
+    }
+    
+    ExportProgress progress = m_exporter.GetProgress();
+    switch (progress.state) {
+        case ExportState::Idle:
+            break;
+        case ExportState::Completed:
+            ImGui::Text("Exported %llu events", static_cast<unsigned long long>(progress.written));
+            break;
+        case ExportState::Cancelled:
+            ImGui::Text("Cancelled after %llu events", static_cast<unsigned long long>(progress.written));
+            break;
+        case ExportState::Failed:
+            ImGui::TextColored(ImVec4(0.957f, 0.529f, 0.443f, 1.0f), "%s", progress.error.c_str());
+            break;
+        case ExportState::Running:
+            break;
+    }
+}
+
 void MainWindow::RenderStatisticsPanel() {
     ImGui::SetNextWindowSize(ImVec2(300, 150), ImGuiCond_FirstUseEver);
     
@@ -130,6 +225,107 @@ void MainWindow::RenderStatisticsPanel() {
         } else {
             ImGui::TextDisabled("Not monitoring");
         }
+        
+        // Per-stage latency since monitoring started (merged only while shown)
+        if (ImGui::CollapsingHeader("Pipeline Latency")) {
+            ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+            if (ImGui::BeginTable("LatencyTable", 6, flags)) {
+                ImGui::TableSetupColumn("Stage");
+                ImGui::TableSetupColumn("Count");
+                ImGui::TableSetupColumn("p50 (us)");
+                ImGui::TableSetupColumn("p99 (us)");
+                ImGui::TableSetupColumn("p99.9 (us)");
+                ImGui::TableSetupColumn("Max (us)");
+                ImGui::TableHeadersRow();
+                
+                for (size_t i = 0; i < static_cast<size_t>(PipelineStage::Count); ++i) {
+                    PipelineStage stage = static_cast<PipelineStage>(i);
+                    StageTiming timing = m_monitor->GetStageTiming(stage);
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::TextUnformatted(GetPipelineStageName(stage));
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%llu", static_cast<unsigned long long>(timing.count));
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::Text("%.1f", timing.p50Ns / 1000.0);
+                    ImGui::TableSetColumnIndex(3);
+                    ImGui::Text("%.1f", timing.p99Ns / 1000.0);
+                    ImGui::TableSetColumnIndex(4);
+                    ImGui::Text("%.1f", timing.p999Ns / 1000.0);
+                    ImGui::TableSetColumnIndex(5);
+                    ImGui::Text("%.1f", timing.maxNs / 1000.0);
+                }
+                ImGui::EndTable();
+            }
+            
+            // Span trace of the detection path, for chrome://tracing or Perfetto
+            if (Tracer::IsAvailable()) {
+                bool tracing = Tracer::IsEnabled();
+                if (ImGui::Checkbox("Record trace", &tracing)) {
+                    Tracer::SetEnabled(tracing);
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Save trace")) {
+                    m_traceSaveResult = Tracer::Dump("driver_monitor_trace.json") ? 1 : -1;
+                }
+                if (m_traceSaveResult > 0) {
+                    ImGui::TextDisabled("Saved driver_monitor_trace.json");
+                } else if (m_traceSaveResult < 0) {
+                    ImGui::TextDisabled("Cannot write driver_monitor_trace.json");
+                }
+            }
+        }
+        
+        // Delivery to the collector (forwarding.endpoint)
+        if (m_monitor->IsForwarding() && ImGui::CollapsingHeader("Forwarding")) {
+            ForwarderStats forward = m_monitor->GetForwarder().GetStats();
+            ImGui::Text("Collector: %s", forward.connected ? "connected" : "disconnected");
+            ImGui::Text("Events: %llu acknowledged, %llu dropped, %zu batches pending",
+                        static_cast<unsigned long long>(forward.eventsAcked),
+                        static_cast<unsigned long long>(forward.eventsDropped), forward.pendingBatches);
+            if (forward.rawBytes > 0) {
+                ImGui::Text("Compression: %.1f:1", static_cast<double>(forward.rawBytes) /
+                            static_cast<double>(std::max<uint64_t>(forward.compressedBytes, 1)));
+            }
+            ImGui::Text("Spooled: %.1f KB", forward.spooledBytes / 1024.0);
+            std::string error = m_monitor->GetForwarder().GetLastError();
+            if (!forward.connected && !error.empty()) {
+                ImGui::TextDisabled("%s", error.c_str());
+            }
+        }
+        
+        // Accounted memory per subsystem and what the budget reclaimed
+        if (ImGui::CollapsingHeader("Memory")) {
+            MemoryStats memory = m_monitor->GetMemoryStats();
+            ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+            if (ImGui::BeginTable("MemoryTable", 2, flags)) {
+                ImGui::TableSetupColumn("Subsystem");
+                ImGui::TableSetupColumn("KB");
+                ImGui::TableHeadersRow();
+                
+                for (size_t i = 0; i < static_cast<size_t>(MemorySubsystem::Count); ++i) {
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::TextUnformatted(GetMemorySubsystemName(static_cast<MemorySubsystem>(i)));
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%.1f", memory.bytes[i] / 1024.0);
+                }
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted("total");
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.1f", memory.totalBytes / 1024.0);
+                ImGui::EndTable();
+            }
+            
+            if (memory.budgetBytes > 0) {
+                ImGui::Text("Budget: %llu MB", static_cast<unsigned long long>(memory.budgetBytes >> 20));
+                ImGui::Text("Cache trimmed: %.1f KB, events evicted: %llu", memory.cacheBytesReclaimed / 1024.0,
+                            static_cast<unsigned long long>(memory.eventsEvicted));
+            } else {
+                ImGui::TextDisabled("No memory budget");
+            }
+        }
     }
     ImGui::End();
 }
@@ -139,63 +335,92 @@ void MainWindow::RenderSettingsPanel() {
     
     if (ImGui::Begin("Settings")) {
         auto& config = m_config->GetConfig();
+        bool changed = false;
         
         ImGui::Text("MONITORING OPTIONS");
         ImGui::Separator();
         
         if (ImGui::Checkbox("Ignore Windows Signed Drivers", &config.ignoreWindowsSigned)) {
-            // Configuration changed
+            changed = true;
         }
         if (ImGui::IsItemHovered()) {
             ImGui::SetTooltip("Filter out drivers signed by Microsoft Windows");
         }
         
         if (ImGui::Checkbox("Ignore Microsoft Drivers", &config.ignoreMicrosoft)) {
-            // Configuration changed
+            changed = true;
         }
         if (ImGui::IsItemHovered()) {
             ImGui::SetTooltip("Filter out all Microsoft signed drivers");
         }
         
-        ImGui::Checkbox("Block Unsigned Drivers", &config.blockUnsigned);
+        changed |= ImGui::Checkbox("Block Unsigned Drivers", &config.blockUnsigned);
         if (ImGui::IsItemHovered()) {
             ImGui::SetTooltip("Attempt to block unsigned driver loading (requires admin)");
         }
         
-        ImGui::Checkbox("Verbose Mode", &config.verboseMode);
+        changed |= ImGui::Checkbox("Verbose Mode", &config.verboseMode);
         if (ImGui::IsItemHovered()) {
             ImGui::SetTooltip("Show all events including filtered ones");
         }
         
+        int memoryBudgetMB = config.memoryBudgetMB;
+        if (ImGui::InputInt("Memory Budget (MB)", &memoryBudgetMB, 16, 256)) {
+            config.memoryBudgetMB = std::max(0, std::min(memoryBudgetMB, 1048576));
+            changed = true;
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("0 = no limit. Over the budget, caches are trimmed, then the oldest events evicted");
+        }
+        
         ImGui::Spacing();
         ImGui::Text("ALERT OPTIONS");
         ImGui::Separator();
         
-        ImGui::Checkbox("Play Alert Sound", &config.playSound);
-        ImGui::Checkbox("Show Notifications", &config.showNotifications);
+        changed |= ImGui::Checkbox("Play Alert Sound", &config.playSound);
+        changed |= ImGui::Checkbox("Show Notifications", &config.showNotifications);
+        
+        int alertsPerMinute = config.alertsPerMinute;
+        if (ImGui::InputInt("Alerts per Driver/min", &alertsPerMinute, 1, 10)) {
+            config.alertsPerMinute = std::max(0, std::min(alertsPerMinute, 60000));
+            changed = true;
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("0 = no limit. Further alerts are summarized; applies when monitoring starts");
+        }
+        int alertQuietSeconds = config.alertQuietSeconds;
+        if (ImGui::InputInt("Alert Quiet Period (s)", &alertQuietSeconds, 5, 60)) {
+            config.alertQuietSeconds = std::max(1, std::min(alertQuietSeconds, 86400));
+            changed = true;
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Suppressed alerts are summarized once none has arrived for this long");
+        }
         
         ImGui::Spacing();
         ImGui::Text("UI OPTIONS");
         ImGui::Separator();
         
-        ImGui::Checkbox("Auto-scroll Log", &config.autoScroll);
+        changed |= ImGui::Checkbox("Auto-scroll Log", &config.autoScroll);
         
         int maxEvents = config.maxEvents;
         if (ImGui::SliderInt("Max Events", &maxEvents, 100, 5000)) {
             config.maxEvents = maxEvents;
             m_eventManager->SetMaxEvents(maxEvents);
+            changed = true;
         }
         
         ImGui::Spacing();
         ImGui::Text("LOGGING OPTIONS");
         ImGui::Separator();
         
-        ImGui::Checkbox("Enable Logging", &config.loggingEnabled);
+        changed |= ImGui::Checkbox("Enable Logging", &config.loggingEnabled);
         
         char logFilePath[256];
         strncpy_s(logFilePath, config.logFile.c_str(), sizeof(logFilePath) - 1);
         if (ImGui::InputText("Log File", logFilePath, sizeof(logFilePath))) {
             config.logFile = std::string(logFilePath);
+            changed = true;
         }
         
         ImGui::Spacing();
@@ -222,6 +447,10 @@ void MainWindow::RenderSettingsPanel() {
             }
         }
         ImGui::EndChild();
+        
+        if (changed) {
+            m_config->NotifyChanged();
+        }
     }
     ImGui::End();
 }
@@ -246,9 +475,32 @@ void MainWindow::RenderFilterPanel() {
         ImGui::SameLine();
         if (ImGui::Button("Clear")) {
             memset(m_searchBuffer, 0, sizeof(m_searchBuffer));
+            memset(m_expressionBuffer, 0, sizeof(m_expressionBuffer));
+        }
+        
+        // e.g. type == Suspicious && signer !~ "Microsoft" && path ~ "\\temp\\"
+        ImGui::Text("Expression:");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(-1);
+        ImGui::InputText("##Expression", m_expressionBuffer, sizeof(m_expressionBuffer));
+        if (!m_expressionError.empty()) {
+            ImGui::TextColored(ImVec4(0.957f, 0.529f, 0.443f, 1.0f), "%s", m_expressionError.c_str());
         }
     }
     ImGui::End();
+    
+    // Compiled once per edit; an invalid expression keeps the last valid one
+    if (m_expressionText != m_expressionBuffer) {
+        m_expressionText = m_expressionBuffer;
+        FilterExpression expression;
+        m_expressionError.clear();
+        if (expression.Compile(m_expressionText, m_expressionError)) {
+            m_eventView.SetExpression(expression);
+        }
+    }
+    
+    // Rebuilds the view only when the filter actually changed
+    m_eventView.SetFilter(m_searchBuffer, static_cast<EventTypeFilter>(m_filterType));
 }
 
 void MainWindow::RenderEventLogPanel() {
@@ -258,40 +510,59 @@ void MainWindow::RenderEventLogPanel() {
         // Clear button
         if (ImGui::Button("Clear Log")) {
             m_eventManager->Clear();
-            m_selectedEventIndex = -1;
+            m_selectedSequence = 0;
             m_showDetailsPanel = false;
         }
         
         ImGui::Separator();
         
-        // Get filtered events
-        auto filteredEvents = GetFilteredEvents();
+        // Extend the filtered view with new arrivals
+        m_eventView.Update();
+        size_t rowCount = m_eventView.GetRowCount();
         
         // Event log table
-        if (ImGui::BeginTable("EventTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable)) {
-            ImGui::TableSetupColumn("Time", ImGuiTableColumnFlags_WidthFixed, 80.0f);
-            ImGui::TableSetupColumn("Status", ImGuiTableColumnFlags_WidthFixed, 60.0f);
-            ImGui::TableSetupColumn("Driver", ImGuiTableColumnFlags_WidthStretch);
-            ImGui::TableSetupColumn("Method", ImGuiTableColumnFlags_WidthStretch);
-            ImGui::TableSetupColumn("Signer", ImGuiTableColumnFlags_WidthStretch);
+        if (ImGui::BeginTable("EventTable", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable | ImGuiTableFlags_Sortable)) {
+            // Column user IDs are the EventSortColumn each header sorts by
+            ImGui::TableSetupColumn("Time", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_DefaultSort, 80.0f, static_cast<ImGuiID>(EventSortColumn::Sequence));
+            ImGui::TableSetupColumn("Status", ImGuiTableColumnFlags_WidthFixed, 60.0f, static_cast<ImGuiID>(EventSortColumn::Type));
+            ImGui::TableSetupColumn("Driver", ImGuiTableColumnFlags_WidthStretch, 0.0f, static_cast<ImGuiID>(EventSortColumn::Name));
+            ImGui::TableSetupColumn("Method", ImGuiTableColumnFlags_WidthStretch, 0.0f, static_cast<ImGuiID>(EventSortColumn::Method));
+            ImGui::TableSetupColumn("Signer", ImGuiTableColumnFlags_WidthStretch, 0.0f, static_cast<ImGuiID>(EventSortColumn::Signer));
+            ImGui::TableSetupColumn("Threat", ImGuiTableColumnFlags_WidthFixed, 60.0f, static_cast<ImGuiID>(EventSortColumn::Threat));
+            ImGui::TableSetupColumn("Initiated By", ImGuiTableColumnFlags_WidthStretch, 0.0f, static_cast<ImGuiID>(EventSortColumn::Initiator));
+            ImGui::TableSetupScrollFreeze(0, 1);
             ImGui::TableHeadersRow();
             
+            // Apply a header click; the view re-sorts on its next update
+            ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs();
+            if (sortSpecs && sortSpecs->SpecsDirty) {
+                if (sortSpecs->SpecsCount > 0) {
+                    const ImGuiTableColumnSortSpecs& spec = sortSpecs->Specs[0];
+                    m_eventView.SetSort(static_cast<EventSortColumn>(spec.ColumnUserID),
+                                        spec.SortDirection == ImGuiSortDirection_Descending);
+                }
+                sortSpecs->SpecsDirty = false;
+                m_eventView.Update();
+                rowCount = m_eventView.GetRowCount();
+            }
+            
             ImGuiListClipper clipper;
-            clipper.Begin(static_cast<int>(filteredEvents.size()));
+            clipper.Begin(static_cast<int>(rowCount));
             
             while (clipper.Step()) {
-                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
-                    const DriverEvent* event = filteredEvents[row];
+                int row = clipper.DisplayStart;
+                m_eventView.VisitRows(clipper.DisplayStart, clipper.DisplayEnd, [&](const DriverEvent& visited) {
+                    const DriverEvent* event = &visited;
                     
                     ImGui::TableNextRow();
                     ImGui::TableNextColumn();
                     
-                    // Make row selectable
+                    // Make row selectable; selection follows the event, not the row
                     ImGui::PushID(row);
-                    bool isSelected = (row == m_selectedEventIndex);
+                    bool isSelected = (event->sequenceId == m_selectedSequence);
                     
                     if (ImGui::Selectable("##row", isSelected, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowItemOverlap)) {
-                        m_selectedEventIndex = row;
+                        m_selectedSequence = event->sequenceId;
                         m_showDetailsPanel = true;
                     }
                     
@@ -336,19 +607,29 @@ void MainWindow::RenderEventLogPanel() {
                     ImGui::TableNextColumn();
                     ImGui::TextColored(color, "%s", event->signerInfo.c_str());
                     
+                    // Threat level
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", GetThreatLevelString(event->threatLevel));
+                    
+                    // Initiating process
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", event->initiatedBy.c_str());
+                    
                     ImGui::PopID();
-                }
+                    row++;
+                });
             }
             
-            // Auto-scroll
-            if (m_config->GetConfig().autoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
+            // Auto-scroll (only meaningful while new events append at the bottom)
+            bool appendsAtBottom = m_eventView.GetSortColumn() == EventSortColumn::Sequence && !m_eventView.IsSortDescending();
+            if (appendsAtBottom && m_config->GetConfig().autoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
                 ImGui::SetScrollHereY(1.0f);
             }
             
             ImGui::EndTable();
         }
         
-        ImGui::Text("Total Events: %zu", filteredEvents.size());
+        ImGui::Text("Total Events: %zu", rowCount);
     }
     ImGui::End();
 }
@@ -357,10 +638,21 @@ void MainWindow::RenderDetailsPanel() {
     ImGui::SetNextWindowSize(ImVec2(500, 300), ImGuiCond_FirstUseEver);
     
     if (ImGui::Begin("Event Details", &m_showDetailsPanel)) {
-        auto allEvents = m_eventManager->GetEvents();
+        // Stored events never change, so the selected one is copied (into the
+        // reused buffers) only when the selection changes; once evicted, the
+        // last copy stays on screen
+        if (m_selectedEvent.sequenceId != m_selectedSequence) {
+            m_selectedEventStored = m_eventManager->GetEvent(m_selectedSequence, m_selectedEvent);
+        } else if (m_selectedEventStored) {
+            m_selectedEventStored = m_selectedSequence >= m_eventManager->GetFirstSequence();
+        }
         
-        if (m_selectedEventIndex >= 0 && m_selectedEventIndex < static_cast<int>(allEvents.size())) {
-            const auto& event = allEvents[m_selectedEventIndex];
+        if (m_selectedEvent.sequenceId == m_selectedSequence) {
+            const DriverEvent& event = m_selectedEvent;
+            
+            if (!m_selectedEventStored) {
+                ImGui::TextDisabled("(no longer in the event history)");
+            }
             
             ImGui::Text("Driver Name:");
             ImGui::SameLine();
@@ -433,74 +725,23 @@ void MainWindow::RenderDetailsPanel() {
     ImGui::End();
 }
 
-std::vector<const DriverEvent*> MainWindow::GetFilteredEvents() const {
-    std::vector<const DriverEvent*> filtered;
-    auto allEvents = m_eventManager->GetEvents();
-    
-    for (const auto& event : allEvents) {
-        // Apply search filter
-        if (!MatchesSearch(event)) {
-            continue;
-        }
-        
-        // Apply type filter
-        if (!MatchesTypeFilter(event)) {
-            continue;
-        }
-        
-        filtered.push_back(&event);
-    }
-    
-    return filtered;
-}
-
-bool MainWindow::MatchesSearch(const DriverEvent& event) const {
-    if (strlen(m_searchBuffer) == 0) {
-        return true;
-    }
-    
-    std::string search = Utils::ToLower(m_searchBuffer);
-    std::string driverName = Utils::ToLower(event.driverName);
-    std::string path = Utils::ToLower(event.installPath);
-    
-    return driverName.find(search) != std::string::npos ||
-           path.find(search) != std::string::npos;
-}
-
-bool MainWindow::MatchesTypeFilter(const DriverEvent& event) const {
-    if (m_filterType == 0) {
-        return true; // All
-    } else if (m_filterType == 1) {
-        return event.eventType == EventType::Signed;
-    } else if (m_filterType == 2) {
-        return event.eventType == EventType::Unsigned;
-    } else if (m_filterType == 3) {
-        return event.eventType == EventType::Suspicious;
-    }
-    return true;
-}
-
 void MainWindow::ExportLogs() {
-    auto events = m_eventManager->GetEvents();
+    static const char* const extensions[] = { ".csv", ".jsonl", ".dmex" };
     
-    std::ofstream file("driver_monitor_export.txt");
-    if (!file.is_open()) {
-        return;
+    ExportOptions options;
+    options.format = static_cast<ExportFormat>(m_exportFormat);
+    options.filePath = std::string("driver_monitor_export") + extensions[m_exportFormat];
+    if (m_exportFiltered) {
+        options.searchText = m_eventView.GetSearchText();
+        options.typeFilter = m_eventView.GetTypeFilter();
+        options.filterExpression = m_eventView.GetExpression().GetText();
     }
-    
-    file << "Driver Monitor Event Log Export\n";
-    file << "================================\n\n";
-    
-    for (const auto& event : events) {
-        file << event.timestamp << " [" << GetEventIcon(event.eventType) << "] "
-             << event.driverName << "\n";
-        file << "  Path: " << event.installPath << "\n";
-        file << "  Method: " << event.loadingMethod << "\n";
-        file << "  Signer: " << event.signerInfo << "\n";
-        file << "  Threat: " << GetThreatLevelString(event.threatLevel) << "\n\n";
+    if (m_exportIncremental) {
+        options.cursorPath = options.filePath + ".cursor";
     }
     
-    file.close();
+    // Runs on a background thread; the table stays responsive
+    m_exporter.Start(options);
 }
 
 ImVec4 MainWindow::GetEventColor(EventType type) const {
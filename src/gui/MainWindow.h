@@ -3,6 +3,11 @@
 #include "../core/EventManager.h"
 #include "../core/Config.h"
 #include "../core/DriverMonitor.h"
+#include "../core/EventViewModel.h"
+#include "../core/EventExporter.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -16,16 +21,44 @@ public:
     // Render the main window
     void Render();
     
+    // True while the window shows progress that needs periodic redraws
+    bool IsBusy() const { return m_exporter.IsRunning(); }
+    
 private:
     EventManager* m_eventManager;
     Config* m_config;
     DriverMonitor* m_monitor;
     
     // UI state
-    int m_selectedEventIndex;
+    uint64_t m_selectedSequence;    // Sequence ID of the selected event (0 = none)
+    DriverEvent m_selectedEvent;    // Copy shown by the details panel (buffers reused)
+    bool m_selectedEventStored;     // False once the selected event was evicted
     char m_searchBuffer[256];
     int m_filterType; // 0=All, 1=Signed, 2=Unsigned, 3=Suspicious
+    char m_expressionBuffer[512];
+    std::string m_expressionText;   // Last text compiled from the buffer
+    std::string m_expressionError;  // Compile error of m_expressionText ("" = valid)
     bool m_showDetailsPanel;
+    EventViewModel m_eventView;
+    
+    // Export state
+    EventExporter m_exporter;
+    int m_exportFormat;             // ExportFormat
+    bool m_exportFiltered;          // Only events matching the table filter
+    bool m_exportIncremental;       // Append events not exported yet
+    int m_traceSaveResult;          // Last "Save trace": 0 = none, 1 = saved, -1 = failed
+    
+    // Alerts shown as notifications (newest first); the alert thread adds them
+    struct Notification {
+        std::string text;
+        bool summary;
+        std::chrono::steady_clock::time_point raised;
+    };
+    std::mutex m_notificationMutex;
+    std::deque<Notification> m_notifications;   // Guarded by m_notificationMutex
+    
+    // Alert callback (alert thread)
+    void OnAlert(const Alert& alert);
     
     // Render panels
     void RenderControlPanel();
@@ -34,19 +67,14 @@ private:
     void RenderFilterPanel();
     void RenderEventLogPanel();
     void RenderDetailsPanel();
+    void RenderNotifications();
     
-    // Get filtered events
-    std::vector<const DriverEvent*> GetFilteredEvents() const;
-    
-    // Apply search filter
-    bool MatchesSearch(const DriverEvent& event) const;
-    
-    // Apply type filter
-    bool MatchesTypeFilter(const DriverEvent& event) const;
-    
-    // Export logs to file
+    // Start a background export of the logs to file
     void ExportLogs();
     
+    // Export options, progress and cancellation
+    void RenderExportControls();
+    
     // Get color for event type
     ImVec4 GetEventColor(EventType type) const;
     
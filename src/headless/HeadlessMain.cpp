@@ -0,0 +1,534 @@
+// Headless monitoring: DriverMonitor + EventManager + logging without the GUI.
+// Stored events are streamed as JSON Lines to stdout or a file.
+//
+// POSIX: SIGHUP reloads the configuration, SIGINT/SIGTERM stop, SIGUSR1 dumps self-stats
+// and stage latencies, SIGUSR2 dumps the span trace.
+// Windows: Ctrl+Break reloads the configuration, Ctrl+C / console close stop.
+
+#include "../core/DriverMonitor.h"
+#include "../core/EventManager.h"
+#include "../core/Config.h"
+#include "../core/ConfigWatcher.h"
+#include "../core/ObservationRecorder.h"
+#include "../core/EventViewModel.h"
+#include "../core/FilterExpression.h"
+#include "../core/Metrics.h"
+#include "../core/MetricsServer.h"
+#include "../core/Trace.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <csignal>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace DriverMonitor;
+
+namespace {
+
+struct HeadlessOptions {
+    std::string configFile;
+    std::string outputFile;     // Empty = stdout
+    std::string recordFile;
+    bool selfStats;
+    bool latency;               // Report per-stage latency percentiles with the self-stats
+    int statsInterval;          // Seconds between self-stats lines (0 = startup and exit only)
+    bool watchChanges;          // Run a GUI-like view consumer driven by change waits
+    bool watchConfig;           // Reload the configuration file when it changes
+    int metricsPort;            // Serve Prometheus metrics on 127.0.0.1 (0 = off)
+    std::string metricsFile;    // Rewrite a textfile-collector file
+    int metricsInterval;        // Seconds between textfile rewrites
+    std::string traceFile;      // Record spans and dump them here (empty = off)
+    int traceSlowMs;            // Also dump after a poll cycle this slow (0 = off)
+    std::string filter;         // Filter expression for streamed events (see FilterExpression.h)
+
+    HeadlessOptions() : configFile("config.json"), selfStats(false), latency(false), statsInterval(0), watchChanges(false), watchConfig(true),
+                        metricsPort(0), metricsInterval(15), traceSlowMs(0) {}
+};
+
+// The GUI redraws at least this often while monitoring (uptime counter)
+const std::chrono::milliseconds kWatchTimeout(1000);
+
+// How often the configuration file is checked for changes
+const std::chrono::milliseconds kConfigCheckInterval(1000);
+
+// Wakeups of the --watch-changes consumer, and how many found new data
+std::atomic<uint64_t> g_watchWakeups(0);
+std::atomic<uint64_t> g_watchUpdates(0);
+
+enum class ControlAction {
+    None,
+    Stop,
+    Reload,
+    Stats,
+    DumpTrace
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+        "Usage: DriverMonitorHeadless [options]\n"
+        "  --config FILE          configuration file (default config.json)\n"
+        "  --output FILE          append JSON Lines to FILE instead of stdout\n"
+        "  --record FILE          record raw observations for replay\n"
+        "  --self-stats           report startup time, RSS and CPU time on stderr\n"
+        "  --stats-interval SEC   repeat the self-stats report every SEC seconds\n"
+        "  --latency              report p50/p99/p999/max latency of every pipeline stage\n"
+        "                         on stderr (at the self-stats times, SIGUSR1 and exit)\n"
+        "  --watch-changes        keep a filtered view updated like the GUI does, waking\n"
+        "                         only on history changes (wakeups are in the self-stats)\n"
+        "  --no-config-watch      do not reload the configuration file when it changes\n"
+        "                         (SIGHUP still reloads it)\n"
+        "  --metrics-port PORT    serve Prometheus metrics at http://127.0.0.1:PORT/metrics\n"
+        "  --metrics-file FILE    rewrite FILE (node_exporter textfile collector, *.prom)\n"
+        "  --metrics-interval SEC textfile rewrite interval (default 15)\n"
+        "  --trace FILE           record pipeline spans; write them to FILE as Chrome\n"
+        "                         trace-event JSON on SIGUSR2 and at exit\n"
+        "  --trace-slow-ms MS     also write FILE-slow-N.json when a poll cycle takes\n"
+        "                         longer than MS milliseconds\n"
+        "  --filter EXPR          stream only events matching EXPR, e.g.\n"
+        "                         'type == Suspicious && signer !~ \"Microsoft\"'\n");
+}
+
+bool ParseOptions(int argc, char* argv[], HeadlessOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--self-stats") {
+            options.selfStats = true;
+            continue;
+        }
+        if (arg == "--latency") {
+            options.latency = true;
+            continue;
+        }
+        if (arg == "--watch-changes") {
+            options.watchChanges = true;
+            continue;
+        }
+        if (arg == "--no-config-watch") {
+            options.watchConfig = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if (arg == "--config") options.configFile = value;
+        else if (arg == "--output") options.outputFile = value;
+        else if (arg == "--record") options.recordFile = value;
+        else if (arg == "--stats-interval") options.statsInterval = std::atoi(value);
+        else if (arg == "--metrics-port") options.metricsPort = std::atoi(value);
+        else if (arg == "--metrics-file") options.metricsFile = value;
+        else if (arg == "--metrics-interval") options.metricsInterval = std::atoi(value);
+        else if (arg == "--trace") options.traceFile = value;
+        else if (arg == "--trace-slow-ms") options.traceSlowMs = std::atoi(value);
+        else if (arg == "--filter") options.filter = value;
+        else return false;
+    }
+    return true;
+}
+
+// Process CPU time (user + kernel) in milliseconds
+double GetCpuMillis() {
+#ifdef _WIN32
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user)) {
+        return 0.0;
+    }
+    ULARGE_INTEGER kernelTime, userTime;
+    kernelTime.LowPart = kernel.dwLowDateTime;
+    kernelTime.HighPart = kernel.dwHighDateTime;
+    userTime.LowPart = user.dwLowDateTime;
+    userTime.HighPart = user.dwHighDateTime;
+    return (kernelTime.QuadPart + userTime.QuadPart) / 10000.0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+#endif
+}
+
+void ReportSelfStats(const char* phase, double startupMs, double firstPollMs,
+                     const DriverMonitor::DriverMonitor& monitor, const EventManager& eventManager) {
+    uint64_t residentBytes = 0;
+    uint64_t peakBytes = 0;
+    Utils::GetProcessMemory(residentBytes, peakBytes);
+
+    uint64_t wakeups = 0;
+    for (const auto& source : monitor.GetPollStats()) {
+        wakeups += source.polls;
+    }
+
+    PipelineStats pipeline = monitor.GetPipelineStats();
+    
+    // "memory":{"eventHistory":N,...,"totalBytes":N,"budgetBytes":N,...}
+    MemoryStats memoryStats = monitor.GetMemoryStats();
+    std::string memory;
+    for (size_t i = 0; i < static_cast<size_t>(MemorySubsystem::Count); ++i) {
+        memory += "\"";
+        memory += GetMemorySubsystemName(static_cast<MemorySubsystem>(i));
+        memory += "\":" + std::to_string(memoryStats.bytes[i]) + ",";
+    }
+    memory += "\"totalBytes\":" + std::to_string(memoryStats.totalBytes) +
+              ",\"budgetBytes\":" + std::to_string(memoryStats.budgetBytes) +
+              ",\"cacheBytesReclaimed\":" + std::to_string(memoryStats.cacheBytesReclaimed) +
+              ",\"eventsEvicted\":" + std::to_string(memoryStats.eventsEvicted);
+
+    // ,"forward":{"submitted":N,"acked":N,"dropped":N,...} while forwarding
+    std::string forward;
+    if (monitor.IsForwarding()) {
+        ForwarderStats stats = monitor.GetForwarder().GetStats();
+        forward = ",\"forward\":{\"connected\":" + std::string(stats.connected ? "true" : "false") +
+                  ",\"submitted\":" + std::to_string(stats.eventsSubmitted) +
+                  ",\"acked\":" + std::to_string(stats.eventsAcked) +
+                  ",\"dropped\":" + std::to_string(stats.eventsDropped) +
+                  ",\"pendingBatches\":" + std::to_string(stats.pendingBatches) +
+                  ",\"rawBytes\":" + std::to_string(stats.rawBytes) +
+                  ",\"compressedBytes\":" + std::to_string(stats.compressedBytes) +
+                  ",\"spooledBytes\":" + std::to_string(stats.spooledBytes) +
+                  ",\"connectFailures\":" + std::to_string(stats.connectFailures) + "}";
+    }
+    
+    std::fprintf(stderr,
+        "{\"selfStats\":{\"phase\":\"%s\",\"startupMs\":%.2f,\"firstPollMs\":%.2f,"
+        "\"rssBytes\":%llu,\"peakRssBytes\":%llu,\"cpuMs\":%.1f,\"uptimeSeconds\":%d,"
+        "\"polls\":%llu,\"processed\":%llu,\"stored\":%llu,\"watchWakeups\":%llu,\"watchUpdates\":%llu,"
+        "\"memory\":{%s}%s}}\n",
+        phase, startupMs, firstPollMs,
+        static_cast<unsigned long long>(residentBytes), static_cast<unsigned long long>(peakBytes),
+        GetCpuMillis(), monitor.GetUptimeSeconds(),
+        static_cast<unsigned long long>(wakeups),
+        static_cast<unsigned long long>(pipeline.processed),
+        static_cast<unsigned long long>(eventManager.GetEventCount()),
+        static_cast<unsigned long long>(g_watchWakeups.load()),
+        static_cast<unsigned long long>(g_watchUpdates.load()),
+        memory.c_str(), forward.c_str());
+    std::fflush(stderr);
+}
+
+// One line: {"latency":{"phase":...,"stages":{"queueWait":{"count":N,"p50Us":...},...}}}
+void ReportLatency(const char* phase, const DriverMonitor::DriverMonitor& monitor) {
+    std::string line = "{\"latency\":{\"phase\":\"";
+    line += phase;
+    line += "\",\"stages\":{";
+    for (size_t i = 0; i < static_cast<size_t>(PipelineStage::Count); ++i) {
+        PipelineStage stage = static_cast<PipelineStage>(i);
+        StageTiming timing = monitor.GetStageTiming(stage);
+        char buffer[256];
+        std::snprintf(buffer, sizeof(buffer),
+            "%s\"%s\":{\"count\":%llu,\"p50Us\":%.2f,\"p99Us\":%.2f,\"p999Us\":%.2f,\"maxUs\":%.2f}",
+            i ? "," : "", GetPipelineStageName(stage), static_cast<unsigned long long>(timing.count),
+            timing.p50Ns / 1000.0, timing.p99Ns / 1000.0, timing.p999Ns / 1000.0, timing.maxNs / 1000.0);
+        line += buffer;
+    }
+    line += "}}}\n";
+    std::fputs(line.c_str(), stderr);
+    std::fflush(stderr);
+}
+
+#ifdef _WIN32
+
+HANDLE g_controlEvent = nullptr;
+std::atomic<int> g_controlAction(static_cast<int>(ControlAction::None));
+
+BOOL WINAPI ConsoleHandler(DWORD type) {
+    ControlAction action = type == CTRL_BREAK_EVENT ? ControlAction::Reload : ControlAction::Stop;
+    g_controlAction = static_cast<int>(action);
+    SetEvent(g_controlEvent);
+    // Give the main thread time to stop cleanly before the console closes the process
+    if (type == CTRL_CLOSE_EVENT || type == CTRL_SHUTDOWN_EVENT) {
+        Sleep(5000);
+    }
+    return TRUE;
+}
+
+bool InitControl() {
+    g_controlEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    return g_controlEvent && SetConsoleCtrlHandler(ConsoleHandler, TRUE);
+}
+
+void ArmStatsTimer(int seconds) {
+    (void)seconds; // WaitForControl times out instead
+}
+
+ControlAction WaitForControl(int statsInterval) {
+    DWORD timeout = statsInterval > 0 ? static_cast<DWORD>(statsInterval) * 1000 : INFINITE;
+    if (WaitForSingleObject(g_controlEvent, timeout) == WAIT_TIMEOUT) {
+        return ControlAction::Stats;
+    }
+    return static_cast<ControlAction>(g_controlAction.exchange(static_cast<int>(ControlAction::None)));
+}
+
+#else
+
+sigset_t g_controlSignals;
+
+bool InitControl() {
+    // Block before any thread starts so every thread inherits the mask and
+    // the signals are only consumed by sigwait() on the main thread
+    sigemptyset(&g_controlSignals);
+    sigaddset(&g_controlSignals, SIGINT);
+    sigaddset(&g_controlSignals, SIGTERM);
+    sigaddset(&g_controlSignals, SIGHUP);
+    sigaddset(&g_controlSignals, SIGUSR1);
+    sigaddset(&g_controlSignals, SIGUSR2);
+    sigaddset(&g_controlSignals, SIGALRM);
+
+    sigset_t blocked = g_controlSignals;
+    sigaddset(&blocked, SIGPIPE); // A closed output pipe fails the write instead
+    return pthread_sigmask(SIG_BLOCK, &blocked, nullptr) == 0;
+}
+
+void ArmStatsTimer(int seconds) {
+    if (seconds > 0) {
+        alarm(static_cast<unsigned int>(seconds));
+    }
+}
+
+ControlAction WaitForControl(int statsInterval) {
+    (void)statsInterval; // Driven by SIGALRM
+    int signal = 0;
+    if (sigwait(&g_controlSignals, &signal) != 0) {
+        return ControlAction::Stop;
+    }
+    switch (signal) {
+        case SIGHUP: return ControlAction::Reload;
+        case SIGUSR1:
+        case SIGALRM: return ControlAction::Stats;
+        case SIGUSR2: return ControlAction::DumpTrace;
+        default: return ControlAction::Stop;
+    }
+}
+
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto processStart = std::chrono::steady_clock::now();
+
+    HeadlessOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+    FilterExpression filter;
+    std::string filterError;
+    if (!filter.Compile(options.filter, filterError)) {
+        std::fprintf(stderr, "Invalid --filter: %s\n", filterError.c_str());
+        return 2;
+    }
+
+    if (!InitControl()) {
+        std::fprintf(stderr, "Cannot install control handlers\n");
+        return 1;
+    }
+
+    FILE* output = stdout;
+    if (!options.outputFile.empty()) {
+        output = std::fopen(options.outputFile.c_str(), "a");
+        if (!output) {
+            std::fprintf(stderr, "Cannot open %s\n", options.outputFile.c_str());
+            return 1;
+        }
+    }
+
+    Config config;
+    if (!config.Load(options.configFile)) {
+        std::fprintf(stderr, "Using default configuration (%s)\n", config.GetLastError().c_str());
+    }
+    config.GetConfig().playSound = false;
+    config.NotifyChanged();
+
+    EventManager eventManager;
+    eventManager.SetMaxEvents(config.GetConfig().maxEvents);
+
+    DriverMonitor::DriverMonitor monitor(&eventManager, &config);
+
+    // Metrics are read by the server thread from atomics only
+    MetricsRegistry metrics;
+    RegisterProcessMetrics(metrics);
+    monitor.RegisterMetrics(metrics);
+    MetricCounter& reloadCount = metrics.AddCounter("drivermonitor_config_reloads_total",
+                                                    "Configuration reloads applied.");
+    MetricCounter& reloadErrorCount = metrics.AddCounter("drivermonitor_config_reload_errors_total",
+                                                         "Configuration reloads rejected as invalid.");
+    MetricsServer metricsServer(&metrics);
+
+    ObservationRecorder recorder;
+    if (!options.recordFile.empty()) {
+        if (!recorder.Open(options.recordFile)) {
+            std::fprintf(stderr, "Cannot open %s\n", options.recordFile.c_str());
+            return 1;
+        }
+        monitor.SetRecorder(&recorder);
+    }
+
+    // Detections are rare; flush each line so consumers see it immediately
+    monitor.SetEventCallback([output, filter](const DriverEvent& event) {
+        if (!filter.Matches(event)) {
+            return;
+        }
+        std::string line = Utils::FormatJsonLine(event);
+        std::fwrite(line.data(), 1, line.size(), output);
+        std::fflush(output);
+    });
+
+    // Recording starts before the sources' baseline scans
+    if (!options.traceFile.empty()) {
+        if (!Tracer::SetEnabled(true)) {
+            std::fprintf(stderr, "Tracing is not compiled in (DRIVERMONITOR_TRACING)\n");
+        } else if (options.traceSlowMs > 0) {
+            Tracer::SetSlowCycleDump(std::chrono::milliseconds(options.traceSlowMs), options.traceFile);
+        }
+    }
+
+    if (!monitor.Start()) {
+        std::fprintf(stderr, "Failed to start monitoring\n");
+        return 1;
+    }
+    if (!config.GetConfig().forwardEndpoint.empty() && !monitor.IsForwarding()) {
+        std::fprintf(stderr, "Cannot forward events: %s\n", monitor.GetForwarder().GetLastError().c_str());
+    }
+
+    if (options.metricsPort > 0 || !options.metricsFile.empty()) {
+        MetricsServerOptions metricsOptions;
+        metricsOptions.listen = options.metricsPort > 0;
+        metricsOptions.port = static_cast<uint16_t>(options.metricsPort);
+        metricsOptions.textFile = options.metricsFile;
+        metricsOptions.interval = std::chrono::seconds(options.metricsInterval > 0 ? options.metricsInterval : 15);
+        if (!metricsServer.Start(metricsOptions)) {
+            std::fprintf(stderr, "Cannot serve metrics: %s\n", metricsServer.GetLastError().c_str());
+        }
+    }
+
+    // Hot reload: settings and whitelist edits apply without a restart
+    ConfigWatcher configWatcher;
+    if (options.watchConfig) {
+        configWatcher.Start(options.configFile, kConfigCheckInterval,
+            [&monitor, &options, &reloadCount](MonitorConfig& reloaded) {
+                reloaded.playSound = false;
+                monitor.ApplyConfig(reloaded);
+                reloadCount.Increment();
+                std::fprintf(stderr, "Configuration reloaded from %s\n", options.configFile.c_str());
+            },
+            [&reloadErrorCount](const std::string& error) {
+                reloadErrorCount.Increment();
+                std::fprintf(stderr, "Cannot reload %s; keeping current configuration\n", error.c_str());
+            });
+    }
+
+    // The GUI's render loop without the GUI: sleep until the history changes
+    std::atomic<bool> stopWatching(false);
+    std::thread watcher;
+    if (options.watchChanges) {
+        watcher = std::thread([&eventManager, &stopWatching, &filter]() {
+            EventViewModel view(&eventManager);
+            view.SetExpression(filter);
+            uint64_t generation = eventManager.GetChangeGeneration();
+            while (!stopWatching) {
+                bool changed = eventManager.WaitForChange(generation, kWatchTimeout);
+                g_watchWakeups++;
+                if (changed) {
+                    view.Update();
+                    g_watchUpdates++;
+                }
+            }
+        });
+    }
+
+    double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - processStart).count();
+    double firstPollMs = 0.0;
+
+    if (options.selfStats) {
+        // Ready = every source finished its baseline scan
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        for (;;) {
+            bool allPolled = true;
+            for (const auto& source : monitor.GetPollStats()) {
+                allPolled = allPolled && source.polls > 0;
+            }
+            if (allPolled || std::chrono::steady_clock::now() > deadline) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        firstPollMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - processStart).count();
+        ReportSelfStats("startup", startupMs, firstPollMs, monitor, eventManager);
+    }
+    bool reportStats = options.selfStats || options.latency;
+    if (reportStats) {
+        ArmStatsTimer(options.statsInterval);
+    }
+
+    for (;;) {
+        ControlAction action = WaitForControl(reportStats ? options.statsInterval : 0);
+        if (action == ControlAction::Stop) {
+            break;
+        }
+
+        if (action == ControlAction::Reload) {
+            Config reloaded;
+            if (reloaded.Load(options.configFile)) {
+                reloaded.GetConfig().playSound = false;
+                monitor.ApplyConfig(reloaded.GetConfig());
+                reloadCount.Increment();
+                std::fprintf(stderr, "Configuration reloaded from %s\n", options.configFile.c_str());
+            } else {
+                reloadErrorCount.Increment();
+                std::fprintf(stderr, "Cannot reload %s; keeping current configuration\n", reloaded.GetLastError().c_str());
+            }
+        } else if (action == ControlAction::DumpTrace) {
+            if (Tracer::IsEnabled() && !Tracer::Dump(options.traceFile)) {
+                std::fprintf(stderr, "Cannot write %s\n", options.traceFile.c_str());
+            }
+        } else if (action == ControlAction::Stats && reportStats) {
+            if (options.selfStats) {
+                ReportSelfStats("running", startupMs, firstPollMs, monitor, eventManager);
+            }
+            if (options.latency) {
+                ReportLatency("running", monitor);
+            }
+            ArmStatsTimer(options.statsInterval);
+        }
+    }
+
+    if (options.selfStats) {
+        ReportSelfStats("exit", startupMs, firstPollMs, monitor, eventManager);
+    }
+    if (options.latency) {
+        ReportLatency("exit", monitor);
+    }
+
+    configWatcher.Stop();
+    metricsServer.Stop();
+    monitor.Stop();
+    recorder.Close();
+
+    if (Tracer::IsEnabled() && !Tracer::Dump(options.traceFile)) {
+        std::fprintf(stderr, "Cannot write %s\n", options.traceFile.c_str());
+    }
+
+    if (watcher.joinable()) {
+        stopWatching = true;
+        eventManager.GetChangeNotifier().Notify();
+        watcher.join();
+    }
+
+    if (output != stdout) {
+        std::fclose(output);
+    }
+    return 0;
+}
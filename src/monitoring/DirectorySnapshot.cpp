@@ -0,0 +1,180 @@
+#include "DirectorySnapshot.h"
+#include "../core/Utils.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+    bool HasExtension(const char* name, size_t nameLength, const std::string& extension) {
+        if (nameLength < extension.size()) {
+            return false;
+        }
+        const char* suffix = name + nameLength - extension.size();
+        for (size_t i = 0; i < extension.size(); ++i) {
+            if (::tolower(static_cast<unsigned char>(suffix[i])) !=
+                ::tolower(static_cast<unsigned char>(extension[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+namespace DriverMonitor {
+
+DirectorySnapshot::DirectorySnapshot() : m_memory(MemorySubsystem::KnownDrivers) {
+}
+
+DirectorySnapshot::~DirectorySnapshot() {
+}
+
+void DirectorySnapshot::AddEntry(const char* name, size_t nameLength, uint64_t size, int64_t modifiedTime, uint64_t fileId) {
+    FileSnapshotEntry entry;
+    entry.nameHash = Utils::HashIgnoreCase(name, nameLength);
+    entry.size = size;
+    entry.modifiedTime = modifiedTime;
+    entry.fileId = fileId;
+    entry.nameOffset = static_cast<uint32_t>(m_names.size());
+    entry.nameLength = static_cast<uint32_t>(nameLength);
+    m_names.append(name, nameLength);
+    m_entries.push_back(entry);
+}
+
+bool DirectorySnapshot::Capture(const std::string& directory, const std::string& extension) {
+    m_entries.clear();
+    m_names.clear();
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    std::string searchPath = directory + "\\*" + extension;
+
+    HANDLE hFind = FindFirstFileExA(searchPath.c_str(), FindExInfoBasic, &findData,
+                                    FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (hFind == INVALID_HANDLE_VALUE) {
+        return GetLastError() == ERROR_FILE_NOT_FOUND;
+    }
+
+    do {
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            continue;
+        }
+        size_t nameLength = strlen(findData.cFileName);
+        // The pattern also matches 8.3 names, so recheck the long name
+        if (!HasExtension(findData.cFileName, nameLength, extension)) {
+            continue;
+        }
+        uint64_t size = (static_cast<uint64_t>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+        int64_t modifiedTime = static_cast<int64_t>(
+            (static_cast<uint64_t>(findData.ftLastWriteTime.dwHighDateTime) << 32) |
+            findData.ftLastWriteTime.dwLowDateTime);
+        AddEntry(findData.cFileName, nameLength, size, modifiedTime, 0);
+    } while (FindNextFileA(hFind, &findData));
+
+    FindClose(hFind);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return false;
+    }
+
+    int dirFd = dirfd(dir);
+    while (struct dirent* entry = readdir(dir)) {
+        size_t nameLength = strlen(entry->d_name);
+        if (!HasExtension(entry->d_name, nameLength, extension)) {
+            continue;
+        }
+        struct stat st;
+        if (fstatat(dirFd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || S_ISDIR(st.st_mode)) {
+            continue;
+        }
+        int64_t modifiedTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+        AddEntry(entry->d_name, nameLength, static_cast<uint64_t>(st.st_size), modifiedTime,
+                 static_cast<uint64_t>(st.st_ino));
+    }
+
+    closedir(dir);
+#endif
+
+    std::sort(m_entries.begin(), m_entries.end(), [this](const FileSnapshotEntry& a, const FileSnapshotEntry& b) {
+        return Compare(a, *this, b) < 0;
+    });
+    UpdateMemoryCharge();
+    return true;
+}
+
+int DirectorySnapshot::Compare(const FileSnapshotEntry& a, const DirectorySnapshot& other, const FileSnapshotEntry& b) const {
+    if (a.nameHash != b.nameHash) {
+        return a.nameHash < b.nameHash ? -1 : 1;
+    }
+    // Hash collision or same name: fall back to exact name order
+    size_t length = std::min(a.nameLength, b.nameLength);
+    int result = memcmp(m_names.data() + a.nameOffset, other.m_names.data() + b.nameOffset, length);
+    if (result != 0) {
+        return result;
+    }
+    if (a.nameLength != b.nameLength) {
+        return a.nameLength < b.nameLength ? -1 : 1;
+    }
+    return 0;
+}
+
+void DirectorySnapshot::Diff(const DirectorySnapshot& previous, const DirectorySnapshot& current,
+                             std::vector<FileChange>& changes) {
+    size_t i = 0;
+    size_t j = 0;
+
+    while (i < previous.m_entries.size() || j < current.m_entries.size()) {
+        if (j == current.m_entries.size()) {
+            changes.push_back({ FileChangeKind::Removed, previous.GetName(previous.m_entries[i++]) });
+            continue;
+        }
+        if (i == previous.m_entries.size()) {
+            changes.push_back({ FileChangeKind::Added, current.GetName(current.m_entries[j++]) });
+            continue;
+        }
+
+        const FileSnapshotEntry& oldEntry = previous.m_entries[i];
+        const FileSnapshotEntry& newEntry = current.m_entries[j];
+        int order = previous.Compare(oldEntry, current, newEntry);
+
+        if (order < 0) {
+            changes.push_back({ FileChangeKind::Removed, previous.GetName(oldEntry) });
+            ++i;
+        } else if (order > 0) {
+            changes.push_back({ FileChangeKind::Added, current.GetName(newEntry) });
+            ++j;
+        } else {
+            if (oldEntry.size != newEntry.size ||
+                oldEntry.modifiedTime != newEntry.modifiedTime ||
+                oldEntry.fileId != newEntry.fileId) {
+                changes.push_back({ FileChangeKind::Modified, current.GetName(newEntry) });
+            }
+            ++i;
+            ++j;
+        }
+    }
+}
+
+std::string DirectorySnapshot::GetName(const FileSnapshotEntry& entry) const {
+    return m_names.substr(entry.nameOffset, entry.nameLength);
+}
+
+void DirectorySnapshot::Swap(DirectorySnapshot& other) {
+    m_entries.swap(other.m_entries);
+    m_names.swap(other.m_names);
+    UpdateMemoryCharge();
+    other.UpdateMemoryCharge();
+}
+
+void DirectorySnapshot::UpdateMemoryCharge() {
+    m_memory.Set(m_entries.capacity() * sizeof(FileSnapshotEntry) + MemoryAccounting::GetHeapBytes(m_names));
+}
+
+} // namespace DriverMonitor
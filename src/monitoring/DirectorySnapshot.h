@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../core/MemoryAccounting.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DriverMonitor {
+
+// Compact record of one directory entry
+struct FileSnapshotEntry {
+    uint64_t nameHash;      // Case-insensitive hash of the file name
+    uint64_t size;
+    int64_t modifiedTime;   // Platform native timestamp (FILETIME ticks / ns since epoch)
+    uint64_t fileId;        // Inode number where cheaply available, 0 otherwise
+    uint32_t nameOffset;    // Offset of the name in the snapshot name pool
+    uint32_t nameLength;
+};
+
+enum class FileChangeKind {
+    Added,
+    Modified,
+    Removed
+};
+
+struct FileChange {
+    FileChangeKind kind;
+    std::string fileName;
+};
+
+// Sorted snapshot of the files in a directory matching an extension
+class DirectorySnapshot {
+public:
+    DirectorySnapshot();
+    ~DirectorySnapshot();
+
+    // Enumerate directory (non-recursive); returns false if it cannot be opened
+    bool Capture(const std::string& directory, const std::string& extension);
+
+    // Sorted-merge diff of two snapshots, appends to changes
+    static void Diff(const DirectorySnapshot& previous, const DirectorySnapshot& current,
+                     std::vector<FileChange>& changes);
+
+    // Get number of entries
+    size_t GetEntryCount() const { return m_entries.size(); }
+
+    // Get entry name
+    std::string GetName(const FileSnapshotEntry& entry) const;
+
+    void Swap(DirectorySnapshot& other);
+
+private:
+    std::vector<FileSnapshotEntry> m_entries;
+    std::string m_names;
+    MemoryCharge m_memory;                  // MemorySubsystem::KnownDrivers
+
+    void AddEntry(const char* name, size_t nameLength, uint64_t size, int64_t modifiedTime, uint64_t fileId);
+    int Compare(const FileSnapshotEntry& a, const DirectorySnapshot& other, const FileSnapshotEntry& b) const;
+    void UpdateMemoryCharge();
+};
+
+} // namespace DriverMonitor
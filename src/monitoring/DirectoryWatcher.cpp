@@ -0,0 +1,179 @@
+#include "DirectoryWatcher.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace DriverMonitor {
+
+bool DirectoryWatcher::Start(const std::string& directory) {
+    m_directory = directory;
+    return Open();
+}
+
+void DirectoryWatcher::Stop() {
+    m_directory.clear();
+    Close();
+}
+
+#ifdef _WIN32
+
+DirectoryWatcher::DirectoryWatcher() : m_handle(INVALID_HANDLE_VALUE) {
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    Stop();
+}
+
+bool DirectoryWatcher::Open() {
+    Close();
+
+    m_handle = FindFirstChangeNotificationA(m_directory.c_str(), FALSE,
+                                            FILE_NOTIFY_CHANGE_FILE_NAME |
+                                            FILE_NOTIFY_CHANGE_SIZE |
+                                            FILE_NOTIFY_CHANGE_LAST_WRITE);
+    return m_handle != INVALID_HANDLE_VALUE;
+}
+
+void DirectoryWatcher::Close() {
+    if (m_handle != INVALID_HANDLE_VALUE) {
+        FindCloseChangeNotification(m_handle);
+        m_handle = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool DirectoryWatcher::IsActive() const {
+    return m_handle != INVALID_HANDLE_VALUE;
+}
+
+bool DirectoryWatcher::ConsumeChanges() {
+    if (!IsActive()) {
+        // Lost (directory deleted) or never armed: retry, rescan regardless
+        if (!m_directory.empty()) {
+            Open();
+        }
+        return true;
+    }
+
+    if (WaitForSingleObject(m_handle, 0) != WAIT_OBJECT_0) {
+        return false;
+    }
+
+    // Re-arm for the next change; fails once the directory is gone
+    if (!FindNextChangeNotification(m_handle)) {
+        Close();
+    }
+    return true;
+}
+
+bool DirectoryWatcher::GetWaitHandle(NativeWaitHandle& handle) const {
+    if (!IsActive()) {
+        return false;
+    }
+    handle = m_handle;
+    return true;
+}
+
+#else
+
+DirectoryWatcher::DirectoryWatcher() : m_fd(-1) {
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    Stop();
+}
+
+bool DirectoryWatcher::Open() {
+    Close();
+
+#ifdef __linux__
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        return false;
+    }
+
+    // Completed changes only: a file being written is reported once, at
+    // close, rather than created empty and then modified half-written
+    uint32_t mask = IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                    IN_DELETE_SELF | IN_MOVE_SELF;
+    if (inotify_add_watch(m_fd, m_directory.c_str(), mask) < 0) {
+        Close();
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void DirectoryWatcher::Close() {
+#ifdef __linux__
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+#endif
+    m_fd = -1;
+}
+
+bool DirectoryWatcher::IsActive() const {
+    return m_fd >= 0;
+}
+
+bool DirectoryWatcher::ConsumeChanges() {
+    if (!IsActive()) {
+        // Lost (directory deleted or moved) or never armed: retry, rescan regardless
+        if (!m_directory.empty()) {
+            Open();
+        }
+        return true;
+    }
+
+#ifdef __linux__
+    // Drain all pending notifications; any record (including overflow) means rescan
+    alignas(struct inotify_event) char buffer[4096];
+    bool changed = false;
+    bool lost = false;
+    for (;;) {
+        ssize_t bytesRead = read(m_fd, buffer, sizeof(buffer));
+        if (bytesRead > 0) {
+            changed = true;
+            for (ssize_t offset = 0; offset < bytesRead;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+                // The kernel drops the watch (IN_IGNORED follows); a moved
+                // directory is still watched, but no longer at the path
+                if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                    lost = true;
+                }
+                offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+            }
+            continue;
+        }
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        break;
+    }
+    if (lost) {
+        Open();
+    }
+    return changed;
+#else
+    return true;
+#endif
+}
+
+bool DirectoryWatcher::GetWaitHandle(NativeWaitHandle& handle) const {
+    if (!IsActive()) {
+        return false;
+    }
+    handle = m_fd;
+    return true;
+}
+
+#endif
+
+} // namespace DriverMonitor
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../core/PollScheduler.h"
+#include <string>
+
+namespace DriverMonitor {
+
+// Change notification for a single directory
+// Uses FindFirstChangeNotification on Windows and inotify on Linux; inotify
+// reports a written file once it is closed, not while it is being written.
+// When the directory is deleted or moved away the watch is lost; the
+// watcher then reports a change on every call and re-arms as soon as the
+// directory exists again.
+class DirectoryWatcher {
+public:
+    DirectoryWatcher();
+    ~DirectoryWatcher();
+
+    // Start watching directory; returns false if no backend is available
+    bool Start(const std::string& directory);
+
+    // Stop watching (and stop re-arming)
+    void Stop();
+
+    // Check if a notification backend is active
+    bool IsActive() const;
+
+    // Returns true if the directory may have changed since the last call.
+    // Never blocks. Always true when no backend is active.
+    bool ConsumeChanges();
+
+    // Handle that becomes signaled on change; false when no backend is active
+    bool GetWaitHandle(NativeWaitHandle& handle) const;
+
+private:
+    std::string m_directory;        // Watched path; empty after Stop()
+
+    // Create / close the backend handle for m_directory
+    bool Open();
+    void Close();
+
+#ifdef _WIN32
+    void* m_handle;
+#else
+    int m_fd;
+#endif
+};
+
+} // namespace DriverMonitor
@@ -1,12 +1,44 @@
 #include "FileSystemMonitor.h"
+#include "../core/Trace.h"
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/utsname.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    const char kPathSeparator = '\\';
+#else
+    const char kPathSeparator = '/';
+#endif
+}
 
 namespace DriverMonitor {
 
-FileSystemMonitor::FileSystemMonitor() : m_initialized(false) {
-    // Get Windows directory
-    char winDir[MAX_PATH];
-    GetWindowsDirectoryA(winDir, MAX_PATH);
-    m_driversPath = std::string(winDir) + "\\System32\\drivers";
+FileSystemMonitor::FileSystemMonitor(const std::string& driversPath)
+    : m_initialized(false)
+    , m_driversPath(driversPath) {
+#ifdef _WIN32
+    m_extension = ".sys";
+    if (m_driversPath.empty()) {
+        // Get Windows directory
+        char winDir[MAX_PATH];
+        GetWindowsDirectoryA(winDir, MAX_PATH);
+        m_driversPath = std::string(winDir) + "\\System32\\drivers";
+    }
+#else
+    m_extension = ".ko";
+    if (m_driversPath.empty()) {
+        // Out-of-tree modules for the running kernel
+        struct utsname name;
+        if (uname(&name) == 0) {
+            m_driversPath = std::string("/lib/modules/") + name.release + "/extra";
+        }
+    }
+#endif
 }
 
 FileSystemMonitor::~FileSystemMonitor() {
@@ -17,23 +49,44 @@ void FileSystemMonitor::Initialize() {
         return;
     }
     
-    ScanDirectory();
+    // Arm notifications before the baseline scan so no change is missed
+    m_watcher.Start(m_driversPath);
+    m_snapshot.Capture(m_driversPath, m_extension);
     m_initialized = true;
 }
 
 void FileSystemMonitor::ScanDirectory() {
-    WIN32_FIND_DATAA findData;
-    std::string searchPath = m_driversPath + "\\*.sys";
+    DM_TRACE_SPAN("directoryScan", "source");
+    DirectorySnapshot current;
+    if (!current.Capture(m_driversPath, m_extension)) {
+        return;
+    }
+    
+    std::vector<FileChange> changes;
+    DirectorySnapshot::Diff(m_snapshot, current, changes);
+    m_snapshot.Swap(current);
     
-    HANDLE hFind = FindFirstFileA(searchPath.c_str(), &findData);
-    if (hFind != INVALID_HANDLE_VALUE) {
-        do {
-            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                m_knownDriverFiles.insert(std::string(findData.cFileName));
-            }
-        } while (FindNextFileA(hFind, &findData));
+    for (const auto& change : changes) {
+        DriverEvent event;
+        event.driverName = change.fileName;
+        event.installPath = m_driversPath + kPathSeparator + change.fileName;
+        event.initiatedBy = "Unknown";
+        event.processId = 0;
+        
+        switch (change.kind) {
+            case FileChangeKind::Added:
+                event.loadingMethod = "File System - New Driver File";
+                break;
+            case FileChangeKind::Modified:
+                event.loadingMethod = "File System - Driver File Modified";
+                break;
+            case FileChangeKind::Removed:
+                event.loadingMethod = "File System - Driver File Removed";
+                event.isRemoval = true;
+                break;
+        }
         
-        FindClose(hFind);
+        m_pendingEvents.push_back(event);
     }
 }
 
@@ -42,36 +95,17 @@ DriverEvent FileSystemMonitor::CheckForNewDrivers() {
         Initialize();
     }
     
-    DriverEvent event;
-    
-    WIN32_FIND_DATAA findData;
-    std::string searchPath = m_driversPath + "\\*.sys";
+    // Rescan only when the directory reported a change (or has no watcher)
+    if (m_pendingEvents.empty() && m_watcher.ConsumeChanges()) {
+        ScanDirectory();
+    }
     
-    HANDLE hFind = FindFirstFileA(searchPath.c_str(), &findData);
-    if (hFind != INVALID_HANDLE_VALUE) {
-        do {
-            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                std::string fileName(findData.cFileName);
-                
-                // Check if this is a new file
-                if (m_knownDriverFiles.find(fileName) == m_knownDriverFiles.end()) {
-                    m_knownDriverFiles.insert(fileName);
-                    
-                    event.driverName = fileName;
-                    event.installPath = m_driversPath + "\\" + fileName;
-                    event.loadingMethod = "File System - New Driver File";
-                    event.initiatedBy = "Unknown";
-                    event.processId = 0;
-                    
-                    FindClose(hFind);
-                    return event;
-                }
-            }
-        } while (FindNextFileA(hFind, &findData));
-        
-        FindClose(hFind);
+    if (m_pendingEvents.empty()) {
+        return DriverEvent();
     }
     
+    DriverEvent event = m_pendingEvents.front();
+    m_pendingEvents.pop_front();
     return event;
 }
 
@@ -1,24 +1,35 @@
 #pragma once
 
 #include "../core/Utils.h"
-#include <Windows.h>
-#include <set>
+#include "DirectorySnapshot.h"
+#include "DirectoryWatcher.h"
+#include <deque>
 #include <string>
 
 namespace DriverMonitor {
 
 class FileSystemMonitor {
 public:
-    FileSystemMonitor();
+    // Empty path selects the platform drivers directory
+    explicit FileSystemMonitor(const std::string& driversPath = "");
     ~FileSystemMonitor();
     
-    // Check for new drivers in file system
+    // Check for new, modified or removed drivers in file system
     DriverEvent CheckForNewDrivers();
     
+    // Change notification handle, available after the first check
+    bool GetWaitHandle(NativeWaitHandle& handle) const { return m_watcher.GetWaitHandle(handle); }
+    
+    // Get monitored directory
+    const std::string& GetDriversPath() const { return m_driversPath; }
+    
 private:
-    std::set<std::string> m_knownDriverFiles;
+    DirectorySnapshot m_snapshot;
+    DirectoryWatcher m_watcher;
+    std::deque<DriverEvent> m_pendingEvents;
     bool m_initialized;
     std::string m_driversPath;
+    std::string m_extension;
     
     void Initialize();
     void ScanDirectory();
@@ -1,12 +1,48 @@
 #include "RegistryMonitor.h"
-#include <vector>
+#include "../core/Trace.h"
 
 namespace DriverMonitor {
 
-RegistryMonitor::RegistryMonitor() : m_initialized(false) {
+RegistryMonitor::RegistryMonitor()
+    : m_initialized(false)
+    , m_servicesKey(nullptr)
+    , m_changeEvent(nullptr) {
 }
 
 RegistryMonitor::~RegistryMonitor() {
+    if (m_servicesKey) {
+        RegCloseKey(m_servicesKey);
+    }
+    if (m_changeEvent) {
+        CloseHandle(m_changeEvent);
+    }
+}
+
+void RegistryMonitor::ArmNotification() {
+    if (!m_servicesKey || !m_changeEvent) {
+        return;
+    }
+    
+    // One-shot: must be re-armed after every signal. The whole subtree is
+    // watched, values included, so a service whose Type changes to a
+    // driver type signals too.
+    ResetEvent(m_changeEvent);
+    LONG result = RegNotifyChangeKeyValue(m_servicesKey, TRUE,
+                                          REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET | REG_NOTIFY_THREAD_AGNOSTIC,
+                                          m_changeEvent, TRUE);
+    if (result != ERROR_SUCCESS) {
+        // Fall back to plain polling
+        CloseHandle(m_changeEvent);
+        m_changeEvent = nullptr;
+    }
+}
+
+bool RegistryMonitor::GetWaitHandle(NativeWaitHandle& handle) const {
+    if (!m_changeEvent) {
+        return false;
+    }
+    handle = m_changeEvent;
+    return true;
 }
 
 void RegistryMonitor::Initialize() {
@@ -14,41 +50,116 @@ void RegistryMonitor::Initialize() {
         return;
     }
     
+    // Arm change notification before the baseline scan so no change is missed
+    if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, "SYSTEM\\CurrentControlSet\\Services", 0, KEY_NOTIFY, &m_servicesKey) == ERROR_SUCCESS) {
+        // Manual reset so the scheduler wait does not consume the signal
+        m_changeEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        ArmNotification();
+    }
+    
     // Scan current drivers to populate known list
+    ScanRegistry(false, false);
+    
+    m_initialized = true;
+}
+
+bool RegistryMonitor::ReadService(const char* serviceName, DWORD& serviceType, std::string& imagePath) {
+    HKEY hSubKey;
+    std::string subKeyPath = "SYSTEM\\CurrentControlSet\\Services\\";
+    subKeyPath += serviceName;
+    
+    if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, subKeyPath.c_str(), 0, KEY_READ, &hSubKey) != ERROR_SUCCESS) {
+        return false;
+    }
+    
+    DWORD dataSize = sizeof(DWORD);
+    bool hasType = RegQueryValueExA(hSubKey, "Type", nullptr, nullptr, (LPBYTE)&serviceType, &dataSize) == ERROR_SUCCESS;
+    
+    if (hasType) {
+        char path[MAX_PATH] = {0};
+        DWORD pathSize = sizeof(path) - 1;
+        if (RegQueryValueExA(hSubKey, "ImagePath", nullptr, nullptr, (LPBYTE)path, &pathSize) == ERROR_SUCCESS) {
+            imagePath = std::string(path);
+        }
+    }
+    
+    RegCloseKey(hSubKey);
+    return hasType;
+}
+
+void RegistryMonitor::ScanRegistry(bool reportChanges, bool recheckServices) {
+    DM_TRACE_SPAN("registryEnumerate", "source");
     HKEY hKey;
-    if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, "SYSTEM\\CurrentControlSet\\Services", 0, KEY_READ, &hKey) == ERROR_SUCCESS) {
-        DWORD index = 0;
-        char subKeyName[256];
-        DWORD subKeyNameSize = sizeof(subKeyName);
+    if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, "SYSTEM\\CurrentControlSet\\Services", 0, KEY_READ, &hKey) != ERROR_SUCCESS) {
+        return;
+    }
+    
+    m_knownDrivers.BeginScan();
+    
+    DWORD index = 0;
+    char subKeyName[256];
+    DWORD subKeyNameSize = sizeof(subKeyName);
+    LONG result;
+    
+    while ((result = RegEnumKeyExA(hKey, index++, subKeyName, &subKeyNameSize, nullptr, nullptr, nullptr, nullptr)) == ERROR_SUCCESS) {
+        uint64_t nameHash = Utils::HashIgnoreCase(subKeyName, subKeyNameSize);
         
-        while (RegEnumKeyExA(hKey, index++, subKeyName, &subKeyNameSize, nullptr, nullptr, nullptr, nullptr) == ERROR_SUCCESS) {
-            // Check if it's a driver service
-            HKEY hSubKey;
-            std::string subKeyPath = "SYSTEM\\CurrentControlSet\\Services\\";
-            subKeyPath += subKeyName;
+        // Known drivers cost one hash probe; known services that are not
+        // drivers are read again only after a change under the Services key
+        uint32_t flags = 0;
+        bool known = m_knownDrivers.Mark(nameHash, subKeyName, subKeyNameSize, &flags);
+        if (!known || (recheckServices && !(flags & kDriverService))) {
+            DWORD serviceType = 0;
+            std::string imagePath;
             
-            if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, subKeyPath.c_str(), 0, KEY_READ, &hSubKey) == ERROR_SUCCESS) {
-                DWORD serviceType = 0;
-                DWORD dataSize = sizeof(DWORD);
-                
-                if (RegQueryValueExA(hSubKey, "Type", nullptr, nullptr, (LPBYTE)&serviceType, &dataSize) == ERROR_SUCCESS) {
-                    // SERVICE_KERNEL_DRIVER = 0x00000001
-                    // SERVICE_FILE_SYSTEM_DRIVER = 0x00000002
-                    if (serviceType == 1 || serviceType == 2) {
-                        m_knownDrivers.insert(std::string(subKeyName));
-                    }
+            // Services without a Type value yet are re-examined next scan
+            if (ReadService(subKeyName, serviceType, imagePath)) {
+                // SERVICE_KERNEL_DRIVER = 0x00000001
+                // SERVICE_FILE_SYSTEM_DRIVER = 0x00000002
+                bool isDriver = (serviceType == 1 || serviceType == 2);
+                if (known) {
+                    m_knownDrivers.SetFlags(nameHash, subKeyName, subKeyNameSize, isDriver ? kDriverService : 0);
+                } else {
+                    m_knownDrivers.Insert(nameHash, std::string(subKeyName, subKeyNameSize), isDriver ? kDriverService : 0);
                 }
                 
-                RegCloseKey(hSubKey);
+                if (isDriver && reportChanges) {
+                    // Found a new driver!
+                    DriverEvent event;
+                    event.driverName = std::string(subKeyName, subKeyNameSize);
+                    event.loadingMethod = "Registry - Service Installation";
+                    event.installPath = imagePath;
+                    
+                    // Get process info (usually services.exe)
+                    event.initiatedBy = "services.exe";
+                    event.processId = 0; // Unknown
+                    
+                    m_pendingEvents.push_back(event);
+                }
             }
-            
-            subKeyNameSize = sizeof(subKeyName);
         }
         
-        RegCloseKey(hKey);
+        subKeyNameSize = sizeof(subKeyName);
     }
     
-    m_initialized = true;
+    RegCloseKey(hKey);
+    
+    // Only sweep after a complete enumeration
+    if (result != ERROR_NO_MORE_ITEMS) {
+        return;
+    }
+    
+    m_knownDrivers.Sweep([this, reportChanges](const std::string& name, uint32_t flags) {
+        if (reportChanges && (flags & kDriverService)) {
+            DriverEvent event;
+            event.driverName = name;
+            event.loadingMethod = "Registry - Service Removed";
+            event.initiatedBy = "services.exe";
+            event.processId = 0;
+            event.isRemoval = true;
+            m_pendingEvents.push_back(event);
+        }
+    });
 }
 
 DriverEvent RegistryMonitor::CheckForNewDrivers() {
@@ -56,62 +167,26 @@ DriverEvent RegistryMonitor::CheckForNewDrivers() {
         Initialize();
     }
     
-    DriverEvent event;
-    
-    // Check for new drivers
-    HKEY hKey;
-    if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, "SYSTEM\\CurrentControlSet\\Services", 0, KEY_READ, &hKey) == ERROR_SUCCESS) {
-        DWORD index = 0;
-        char subKeyName[256];
-        DWORD subKeyNameSize = sizeof(subKeyName);
-        
-        while (RegEnumKeyExA(hKey, index++, subKeyName, &subKeyNameSize, nullptr, nullptr, nullptr, nullptr) == ERROR_SUCCESS) {
-            // Check if it's a new driver
-            if (m_knownDrivers.find(std::string(subKeyName)) == m_knownDrivers.end()) {
-                // Check if it's a driver service
-                HKEY hSubKey;
-                std::string subKeyPath = "SYSTEM\\CurrentControlSet\\Services\\";
-                subKeyPath += subKeyName;
-                
-                if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, subKeyPath.c_str(), 0, KEY_READ, &hSubKey) == ERROR_SUCCESS) {
-                    DWORD serviceType = 0;
-                    DWORD dataSize = sizeof(DWORD);
-                    
-                    if (RegQueryValueExA(hSubKey, "Type", nullptr, nullptr, (LPBYTE)&serviceType, &dataSize) == ERROR_SUCCESS) {
-                        if (serviceType == 1 || serviceType == 2) {
-                            // Found a new driver!
-                            m_knownDrivers.insert(std::string(subKeyName));
-                            
-                            event.driverName = std::string(subKeyName);
-                            event.loadingMethod = "Registry - Service Installation";
-                            
-                            // Try to get image path
-                            char imagePath[MAX_PATH] = {0};
-                            DWORD imagePathSize = sizeof(imagePath);
-                            if (RegQueryValueExA(hSubKey, "ImagePath", nullptr, nullptr, (LPBYTE)imagePath, &imagePathSize) == ERROR_SUCCESS) {
-                                event.installPath = std::string(imagePath);
-                            }
-                            
-                            // Get process info (usually services.exe)
-                            event.initiatedBy = "services.exe";
-                            event.processId = 0; // Unknown
-                            
-                            RegCloseKey(hSubKey);
-                            RegCloseKey(hKey);
-                            return event;
-                        }
-                    }
-                    
-                    RegCloseKey(hSubKey);
-                }
-            }
-            
-            subKeyNameSize = sizeof(subKeyName);
+    if (m_pendingEvents.empty()) {
+        // Consume and re-arm the notification before scanning, so a change
+        // during the scan signals again. The scan itself is not gated on it:
+        // a new key may get its Type value after the signal fired. Without
+        // notification every scan re-reads the services that are not drivers.
+        bool changed = !m_changeEvent;
+        if (m_changeEvent && WaitForSingleObject(m_changeEvent, 0) == WAIT_OBJECT_0) {
+            changed = true;
+            ArmNotification();
         }
         
-        RegCloseKey(hKey);
+        ScanRegistry(true, changed);
+    }
+    
+    if (m_pendingEvents.empty()) {
+        return DriverEvent();
     }
     
+    DriverEvent event = m_pendingEvents.front();
+    m_pendingEvents.pop_front();
     return event;
 }
 
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "../core/Utils.h"
+#include "../core/PollScheduler.h"
+#include "../core/KnownDriverSet.h"
 #include <Windows.h>
-#include <set>
+#include <deque>
 #include <string>
 
 namespace DriverMonitor {
@@ -12,15 +14,30 @@ public:
     RegistryMonitor();
     ~RegistryMonitor();
     
-    // Check for new drivers in registry
+    // Check for new or removed drivers in registry
     DriverEvent CheckForNewDrivers();
     
+    // Change notification handle for the Services key, available after the first check
+    bool GetWaitHandle(NativeWaitHandle& handle) const;
+    
 private:
-    std::set<std::string> m_knownDrivers;
+    // All services seen, drivers flagged with kDriverService. A service
+    // may become a driver later (its Type changed), so the others are read
+    // again whenever the Services subtree changed.
+    static const uint32_t kDriverService = 1;
+    KnownDriverSet m_knownDrivers;
+    std::deque<DriverEvent> m_pendingEvents;
     bool m_initialized;
     
+    // Services key change notification
+    HKEY m_servicesKey;
+    HANDLE m_changeEvent;
+    
     void Initialize();
-    void ScanRegistry();
+    void ArmNotification();
+    // recheckServices: read Type again for known services that are not drivers
+    void ScanRegistry(bool reportChanges, bool recheckServices);
+    static bool ReadService(const char* serviceName, DWORD& serviceType, std::string& imagePath);
 };
 
 } // namespace DriverMonitor
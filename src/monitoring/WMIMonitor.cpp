@@ -1,4 +1,5 @@
 #include "WMIMonitor.h"
+#include "../core/Trace.h"
 #include <Windows.h>
 #include <comdef.h>
 #include <Wbemidl.h>
@@ -22,50 +23,138 @@ void WMIMonitor::Initialize() {
     CoInitializeEx(nullptr, COINIT_MULTITHREADED);
     
     // Query current drivers using WMI
+    QueryDrivers(false);
+    
+    m_initialized = true;
+}
+
+void WMIMonitor::QueryDrivers(bool reportChanges) {
+    DM_TRACE_SPAN("wmiQuery", "source");
     HRESULT hr;
     IWbemLocator* pLoc = nullptr;
     IWbemServices* pSvc = nullptr;
     
     hr = CoCreateInstance(CLSID_WbemLocator, nullptr, CLSCTX_INPROC_SERVER, IID_IWbemLocator, (LPVOID*)&pLoc);
+    if (FAILED(hr)) {
+        return;
+    }
+    
+    hr = pLoc->ConnectServer(_bstr_t(L"ROOT\\CIMV2"), nullptr, nullptr, nullptr, 0, nullptr, nullptr, &pSvc);
+    if (FAILED(hr)) {
+        pLoc->Release();
+        return;
+    }
+    
+    CoSetProxyBlanket(pSvc, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, nullptr, RPC_C_AUTHN_LEVEL_CALL, RPC_C_IMP_LEVEL_IMPERSONATE, nullptr, EOAC_NONE);
+    
+    IEnumWbemClassObject* pEnumerator = nullptr;
+    hr = pSvc->ExecQuery(bstr_t("WQL"), bstr_t("SELECT Name, State, PathName FROM Win32_SystemDriver"), WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY, nullptr, &pEnumerator);
+    
+    bool complete = false;
     
     if (SUCCEEDED(hr)) {
-        hr = pLoc->ConnectServer(_bstr_t(L"ROOT\\CIMV2"), nullptr, nullptr, nullptr, 0, nullptr, nullptr, &pSvc);
+        m_knownDrivers.BeginScan();
+        
+        IWbemClassObject* pclsObj = nullptr;
+        ULONG uReturn = 0;
         
-        if (SUCCEEDED(hr)) {
-            CoSetProxyBlanket(pSvc, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, nullptr, RPC_C_AUTHN_LEVEL_CALL, RPC_C_IMP_LEVEL_IMPERSONATE, nullptr, EOAC_NONE);
+        while (pEnumerator) {
+            hr = pEnumerator->Next(WBEM_INFINITE, 1, &pclsObj, &uReturn);
+            if (uReturn == 0) {
+                complete = SUCCEEDED(hr);
+                break;
+            }
             
-            IEnumWbemClassObject* pEnumerator = nullptr;
-            hr = pSvc->ExecQuery(bstr_t("WQL"), bstr_t("SELECT * FROM Win32_SystemDriver"), WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY, nullptr, &pEnumerator);
+            VARIANT vtName, vtState;
+            VariantInit(&vtName);
+            VariantInit(&vtState);
             
-            if (SUCCEEDED(hr)) {
-                IWbemClassObject* pclsObj = nullptr;
-                ULONG uReturn = 0;
+            if (SUCCEEDED(pclsObj->Get(L"Name", 0, &vtName, nullptr, nullptr)) && vtName.vt == VT_BSTR) {
+                _bstr_t bstrName(vtName.bstrVal);
+                const char* name = (const char*)bstrName;
+                size_t nameLength = strlen(name);
+                uint64_t nameHash = Utils::HashIgnoreCase(name, nameLength);
+                
+                bool running = SUCCEEDED(pclsObj->Get(L"State", 0, &vtState, nullptr, nullptr)) &&
+                               vtState.vt == VT_BSTR && _wcsicmp(vtState.bstrVal, L"Running") == 0;
+                uint32_t flags = 0;
                 
-                while (pEnumerator) {
-                    hr = pEnumerator->Next(WBEM_INFINITE, 1, &pclsObj, &uReturn);
-                    if (uReturn == 0) break;
+                if (!m_knownDrivers.Mark(nameHash, name, nameLength, &flags)) {
+                    // Check if this is a new driver
+                    m_knownDrivers.Insert(nameHash, name, running ? kRunning : 0);
                     
-                    VARIANT vtProp;
-                    hr = pclsObj->Get(L"Name", 0, &vtProp, nullptr, nullptr);
-                    if (SUCCEEDED(hr) && vtProp.vt == VT_BSTR) {
-                        _bstr_t bstrName(vtProp.bstrVal);
-                        m_knownDrivers.insert((const char*)bstrName);
+                    if (reportChanges) {
+                        DriverEvent event;
+                        event.driverName = name;
+                        event.loadingMethod = "WMI - System Driver Query";
+                        event.installPath = GetPathName(pclsObj);
+                        event.initiatedBy = "WMI Service";
+                        event.processId = 0;
+                        m_pendingEvents.push_back(event);
                     }
-                    VariantClear(&vtProp);
+                } else if (running != ((flags & kRunning) != 0)) {
+                    // Known driver changed state: loaded or unloaded
+                    m_knownDrivers.SetFlags(nameHash, name, nameLength, running ? kRunning : 0);
                     
-                    pclsObj->Release();
+                    if (reportChanges) {
+                        DriverEvent event;
+                        event.driverName = name;
+                        event.initiatedBy = "WMI Service";
+                        event.processId = 0;
+                        if (running) {
+                            event.loadingMethod = "WMI - Driver Started";
+                            event.installPath = GetPathName(pclsObj);
+                        } else {
+                            event.loadingMethod = "WMI - Driver Unloaded";
+                            event.isRemoval = true;
+                        }
+                        m_pendingEvents.push_back(event);
+                    }
                 }
-                
-                pEnumerator->Release();
             }
             
-            pSvc->Release();
+            VariantClear(&vtState);
+            VariantClear(&vtName);
+            pclsObj->Release();
         }
         
-        pLoc->Release();
+        pEnumerator->Release();
     }
     
-    m_initialized = true;
+    pSvc->Release();
+    pLoc->Release();
+    
+    // Only sweep after a complete enumeration
+    if (!complete) {
+        return;
+    }
+    
+    m_knownDrivers.Sweep([this, reportChanges](const std::string& name, uint32_t flags) {
+        (void)flags;
+        if (reportChanges) {
+            DriverEvent event;
+            event.driverName = name;
+            event.loadingMethod = "WMI - Driver Removed";
+            event.initiatedBy = "WMI Service";
+            event.processId = 0;
+            event.isRemoval = true;
+            m_pendingEvents.push_back(event);
+        }
+    });
+}
+
+std::string WMIMonitor::GetPathName(IWbemClassObject* driver) {
+    std::string path;
+    VARIANT vtPath;
+    VariantInit(&vtPath);
+    
+    if (SUCCEEDED(driver->Get(L"PathName", 0, &vtPath, nullptr, nullptr)) && vtPath.vt == VT_BSTR) {
+        _bstr_t bstrPath(vtPath.bstrVal);
+        path = (const char*)bstrPath;
+    }
+    
+    VariantClear(&vtPath);
+    return path;
 }
 
 DriverEvent WMIMonitor::CheckForNewDrivers() {
@@ -73,79 +162,16 @@ DriverEvent WMIMonitor::CheckForNewDrivers() {
         Initialize();
     }
     
-    DriverEvent event;
-    
-    // Query WMI for drivers
-    HRESULT hr;
-    IWbemLocator* pLoc = nullptr;
-    IWbemServices* pSvc = nullptr;
-    
-    hr = CoCreateInstance(CLSID_WbemLocator, nullptr, CLSCTX_INPROC_SERVER, IID_IWbemLocator, (LPVOID*)&pLoc);
+    if (m_pendingEvents.empty()) {
+        QueryDrivers(true);
+    }
     
-    if (SUCCEEDED(hr)) {
-        hr = pLoc->ConnectServer(_bstr_t(L"ROOT\\CIMV2"), nullptr, nullptr, nullptr, 0, nullptr, nullptr, &pSvc);
-        
-        if (SUCCEEDED(hr)) {
-            CoSetProxyBlanket(pSvc, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, nullptr, RPC_C_AUTHN_LEVEL_CALL, RPC_C_IMP_LEVEL_IMPERSONATE, nullptr, EOAC_NONE);
-            
-            IEnumWbemClassObject* pEnumerator = nullptr;
-            hr = pSvc->ExecQuery(bstr_t("WQL"), bstr_t("SELECT * FROM Win32_SystemDriver"), WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY, nullptr, &pEnumerator);
-            
-            if (SUCCEEDED(hr)) {
-                IWbemClassObject* pclsObj = nullptr;
-                ULONG uReturn = 0;
-                
-                while (pEnumerator) {
-                    hr = pEnumerator->Next(WBEM_INFINITE, 1, &pclsObj, &uReturn);
-                    if (uReturn == 0) break;
-                    
-                    VARIANT vtName, vtPath;
-                    hr = pclsObj->Get(L"Name", 0, &vtName, nullptr, nullptr);
-                    
-                    if (SUCCEEDED(hr) && vtName.vt == VT_BSTR) {
-                        _bstr_t bstrName(vtName.bstrVal);
-                        std::string driverName = (const char*)bstrName;
-                        
-                        // Check if this is a new driver
-                        if (m_knownDrivers.find(driverName) == m_knownDrivers.end()) {
-                            m_knownDrivers.insert(driverName);
-                            
-                            event.driverName = driverName;
-                            event.loadingMethod = "WMI - System Driver Query";
-                            event.initiatedBy = "WMI Service";
-                            event.processId = 0;
-                            
-                            // Try to get path
-                            hr = pclsObj->Get(L"PathName", 0, &vtPath, nullptr, nullptr);
-                            if (SUCCEEDED(hr) && vtPath.vt == VT_BSTR) {
-                                _bstr_t bstrPath(vtPath.bstrVal);
-                                event.installPath = (const char*)bstrPath;
-                            }
-                            VariantClear(&vtPath);
-                            
-                            VariantClear(&vtName);
-                            pclsObj->Release();
-                            pEnumerator->Release();
-                            pSvc->Release();
-                            pLoc->Release();
-                            
-                            return event;
-                        }
-                    }
-                    VariantClear(&vtName);
-                    
-                    pclsObj->Release();
-                }
-                
-                pEnumerator->Release();
-            }
-            
-            pSvc->Release();
-        }
-        
-        pLoc->Release();
+    if (m_pendingEvents.empty()) {
+        return DriverEvent();
     }
     
+    DriverEvent event = m_pendingEvents.front();
+    m_pendingEvents.pop_front();
     return event;
 }
 
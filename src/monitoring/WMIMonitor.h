@@ -1,9 +1,12 @@
 #pragma once
 
 #include "../core/Utils.h"
-#include <set>
+#include "../core/KnownDriverSet.h"
+#include <deque>
 #include <string>
 
+struct IWbemClassObject;
+
 namespace DriverMonitor {
 
 class WMIMonitor {
@@ -11,14 +14,19 @@ public:
     WMIMonitor();
     ~WMIMonitor();
     
-    // Check for new drivers via WMI
+    // Check for new, started, unloaded or removed drivers via WMI
     DriverEvent CheckForNewDrivers();
     
 private:
-    std::set<std::string> m_knownDrivers;
+    // Drivers seen, with kRunning set while the driver is loaded
+    static const uint32_t kRunning = 1;
+    KnownDriverSet m_knownDrivers;
+    std::deque<DriverEvent> m_pendingEvents;
     bool m_initialized;
     
     void Initialize();
+    void QueryDrivers(bool reportChanges);
+    static std::string GetPathName(IWbemClassObject* driver);
 };
 
 } // namespace DriverMonitor
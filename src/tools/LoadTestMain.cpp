@@ -0,0 +1,374 @@
+// Headless load test: drives the ingestion pipeline with synthetic or
+// replayed observations, or a fleet collector with simulated hosts, and
+// prints a JSON report to stdout.
+
+#include "../core/DriverMonitor.h"
+#include "../core/EventManager.h"
+#include "../core/Config.h"
+#include "../core/FleetSimulator.h"
+#include "../core/SyntheticSource.h"
+#include "../core/ObservationRecorder.h"
+#include "../core/ReplaySource.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DriverMonitor;
+
+namespace {
+
+struct LoadTestOptions {
+    double rate;            // Offered events/s across all producers (0 = unthrottled)
+    double duration;        // Seconds
+    int threads;
+    bool wait;              // Producers wait for queue room instead of dropping
+    size_t queueCapacity;
+    int maxEvents;
+    std::string logFile;    // Empty = logging disabled
+    uint64_t suspiciousEvery;   // Every Nth observation a manual map load (0 = as the profile draws)
+    std::string recordFile;
+    std::string replayFile;
+    double speed;           // Replay speed (0 = as fast as possible)
+    std::string collector;  // HOST:PORT; simulated hosts forward to it instead
+    size_t hosts;
+    size_t batchEvents;
+    size_t window;
+    bool compress;
+    SyntheticProfile profile;
+
+    LoadTestOptions()
+        : rate(0.0), duration(5.0), threads(1), wait(false),
+          queueCapacity(65536), maxEvents(1000), suspiciousEvery(0), speed(0.0),
+          hosts(100), batchEvents(256), window(8), compress(true) {}
+};
+
+const size_t kProducerBatch = 256;
+
+void PrintUsage() {
+    std::cerr <<
+        "Usage: DriverMonitorLoadTest [options]\n"
+        "  --rate N          offered events/s, all threads (default: unthrottled)\n"
+        "  --duration S      seconds to generate (default 5)\n"
+        "  --threads N       producer threads (default 1)\n"
+        "  --names N         distinct driver names (default 1000)\n"
+        "  --skew X          Zipf exponent over names, 0 = uniform (default 1.0)\n"
+        "  --paths N         distinct install directories (default 16)\n"
+        "  --removals R      fraction of removal observations (default 0.05)\n"
+        "  --signers LIST    value:weight,... signer verdicts\n"
+        "  --methods LIST    value:weight,... loading methods\n"
+        "  --suspicious-every N  make every Nth observation a Manual Map load\n"
+        "  --seed N          generator seed (default 1)\n"
+        "  --queue N         ingestion queue capacity (default 65536)\n"
+        "  --block           producers wait for queue room instead of dropping\n"
+        "  --max-events N    event history size (default 1000)\n"
+        "  --log FILE        enable event logging to FILE\n"
+        "  --record FILE     record processed observations\n"
+        "  --replay FILE     replay an observation log instead of generating\n"
+        "  --speed X         replay speed, 0 = as fast as possible (default 0)\n"
+        "  --collector H:P   simulate hosts forwarding to a fleet collector instead\n"
+        "  --hosts N         simulated hosts, one connection each (default 100)\n"
+        "  --batch N         events per forwarded batch (default 256)\n"
+        "  --window N        unacknowledged batches per host (default 8)\n"
+        "  --raw             forward uncompressed batches\n";
+}
+
+bool ParseWeightedList(const std::string& text, std::vector<WeightedValue>& values) {
+    values.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t colon = item.rfind(':');
+        WeightedValue value;
+        value.value = item.substr(0, colon);
+        value.weight = colon == std::string::npos ? 1.0 : std::atof(item.c_str() + colon + 1);
+        if (value.value.empty()) {
+            return false;
+        }
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+bool ParseOptions(int argc, char* argv[], LoadTestOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (arg == "--block") {
+            options.wait = true;
+            continue;
+        }
+        if (arg == "--raw") {
+            options.compress = false;
+            continue;
+        }
+        if (!value) {
+            return false;
+        }
+        ++i;
+
+        if (arg == "--rate") options.rate = std::atof(value);
+        else if (arg == "--duration") options.duration = std::atof(value);
+        else if (arg == "--threads") options.threads = std::max(1, std::atoi(value));
+        else if (arg == "--names") options.profile.nameCount = std::strtoull(value, nullptr, 10);
+        else if (arg == "--skew") options.profile.nameSkew = std::atof(value);
+        else if (arg == "--paths") options.profile.pathCount = std::strtoull(value, nullptr, 10);
+        else if (arg == "--removals") options.profile.removalRatio = std::atof(value);
+        else if (arg == "--seed") options.profile.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--queue") options.queueCapacity = std::strtoull(value, nullptr, 10);
+        else if (arg == "--max-events") options.maxEvents = std::atoi(value);
+        else if (arg == "--log") options.logFile = value;
+        else if (arg == "--suspicious-every") options.suspiciousEvery = std::strtoull(value, nullptr, 10);
+        else if (arg == "--record") options.recordFile = value;
+        else if (arg == "--replay") options.replayFile = value;
+        else if (arg == "--speed") options.speed = std::atof(value);
+        else if (arg == "--collector") options.collector = value;
+        else if (arg == "--hosts") options.hosts = std::strtoull(value, nullptr, 10);
+        else if (arg == "--batch") options.batchEvents = std::strtoull(value, nullptr, 10);
+        else if (arg == "--window") options.window = std::strtoull(value, nullptr, 10);
+        else if (arg == "--signers") {
+            if (!ParseWeightedList(value, options.profile.signers)) return false;
+        } else if (arg == "--methods") {
+            if (!ParseWeightedList(value, options.profile.methods)) return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Generate at the offered rate until the deadline
+void ProducerThread(DriverMonitor::DriverMonitor& monitor, SyntheticProfile profile, double rate,
+                    std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+                    bool wait, uint64_t suspiciousEvery, std::atomic<uint64_t>& generated) {
+    SyntheticSource source(profile);
+    uint64_t count = 0;
+
+    while (std::chrono::steady_clock::now() < end) {
+        for (size_t i = 0; i < kProducerBatch; ++i) {
+            DriverEvent event;
+            source.Generate(event);
+            if (suspiciousEvery > 0 && (count + i + 1) % suspiciousEvery == 0) {
+                event.loadingMethod = "Manual Map";
+                event.isRemoval = false;
+            }
+            monitor.SubmitObservation(std::move(event), wait);
+        }
+        count += kProducerBatch;
+
+        if (rate > 0.0) {
+            // Pace against the schedule rather than per batch so sleeps do not accumulate error
+            auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(count / rate));
+            if (due > end) {
+                due = end;
+            }
+            std::this_thread::sleep_until(due);
+        }
+    }
+
+    generated += count;
+}
+
+void WriteStage(std::ostream& out, const char* name, const StageTiming& timing, bool last = false) {
+    double meanUs = timing.count ? timing.totalNs / 1000.0 / timing.count : 0.0;
+    out << "    \"" << name << "\": { \"count\": " << timing.count
+        << ", \"meanUs\": " << meanUs
+        << ", \"p50Us\": " << timing.p50Ns / 1000.0
+        << ", \"p99Us\": " << timing.p99Ns / 1000.0
+        << ", \"p999Us\": " << timing.p999Ns / 1000.0
+        << ", \"maxUs\": " << timing.maxNs / 1000.0 << " }" << (last ? "\n" : ",\n");
+}
+
+// Simulated hosts forward to a running collector for the duration
+int RunFleet(const LoadTestOptions& options) {
+    size_t colon = options.collector.rfind(':');
+    int port = colon == std::string::npos ? 0 : std::atoi(options.collector.c_str() + colon + 1);
+    if (port <= 0 || port > 65535) {
+        PrintUsage();
+        return 2;
+    }
+
+    FleetSimulatorOptions fleetOptions;
+    fleetOptions.host = options.collector.substr(0, colon);
+    fleetOptions.port = static_cast<uint16_t>(port);
+    fleetOptions.hosts = options.hosts;
+    fleetOptions.threads = static_cast<size_t>(options.threads);
+    fleetOptions.batchEvents = options.batchEvents;
+    fleetOptions.window = options.window;
+    fleetOptions.compress = options.compress;
+    fleetOptions.rate = options.rate;
+    fleetOptions.profile = options.profile;
+
+    FleetSimulator fleet;
+    if (!fleet.Start(fleetOptions)) {
+        std::cerr << "Cannot start simulated hosts: " << fleet.GetLastError() << "\n";
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.duration));
+    FleetSimulatorStats stats = fleet.GetStats();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::string error = fleet.GetLastError();
+    fleet.Stop();
+
+    std::ostringstream out;
+    out << "{\n"
+        << "  \"mode\": \"fleet\",\n"
+        << "  \"collector\": \"" << options.collector << "\",\n"
+        << "  \"hosts\": " << stats.hostsConnected << ",\n"
+        << "  \"threads\": " << options.threads << ",\n"
+        << "  \"batchEvents\": " << options.batchEvents << ",\n"
+        << "  \"window\": " << options.window << ",\n"
+        << "  \"compressed\": " << (options.compress ? "true" : "false") << ",\n"
+        << "  \"offeredRate\": " << options.rate << ",\n"
+        << "  \"seconds\": " << seconds << ",\n"
+        << "  \"batchesSent\": " << stats.batchesSent << ",\n"
+        << "  \"eventsSent\": " << stats.eventsSent << ",\n"
+        << "  \"eventsAcked\": " << stats.eventsAcked << ",\n"
+        << "  \"ackedRate\": " << (seconds > 0 ? stats.eventsAcked / seconds : 0.0) << ",\n"
+        << "  \"bytesSent\": " << stats.bytesSent << ",\n"
+        << "  \"bytesPerEvent\": " << (stats.eventsSent ? static_cast<double>(stats.bytesSent) / stats.eventsSent : 0.0)
+        << (error.empty() ? "\n" : ",\n");
+    if (!error.empty()) {
+        out << "  \"error\": \"" << error << "\"\n";
+    }
+    out << "}\n";
+    std::cout << out.str();
+    return error.empty() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    LoadTestOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+    if (!options.collector.empty()) {
+        return RunFleet(options);
+    }
+
+    Config config;
+    config.GetConfig().loggingEnabled = !options.logFile.empty();
+    config.GetConfig().logFile = options.logFile;
+    config.GetConfig().playSound = false;
+    config.NotifyChanged();
+
+    EventManager eventManager;
+    eventManager.SetMaxEvents(options.maxEvents);
+
+    DriverMonitor::DriverMonitor monitor(&eventManager, &config);
+    monitor.SetQueueCapacity(options.queueCapacity);
+
+    ObservationRecorder recorder;
+    if (!options.recordFile.empty()) {
+        if (!recorder.Open(options.recordFile)) {
+            std::cerr << "Cannot open " << options.recordFile << "\n";
+            return 1;
+        }
+        monitor.SetRecorder(&recorder);
+    }
+
+    std::atomic<uint64_t> generated(0);
+    auto start = std::chrono::steady_clock::now();
+
+    if (!options.replayFile.empty()) {
+        auto replay = std::make_unique<ReplaySource>();
+        if (!replay->Open(options.replayFile)) {
+            std::cerr << "Cannot read observation log " << options.replayFile << "\n";
+            return 1;
+        }
+
+        std::unique_ptr<Clock> clock;
+        if (options.speed > 0.0) {
+            clock = std::make_unique<ScaledClock>(replay->GetStartTime(), options.speed);
+        } else {
+            clock = std::make_unique<VirtualClock>(replay->GetStartTime());
+        }
+
+        if (!monitor.StartReplay(std::move(replay), std::move(clock))) {
+            std::cerr << "Cannot start replay\n";
+            return 1;
+        }
+        while (!monitor.IsReplayComplete()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        generated = monitor.GetReplayedCount();
+    } else {
+        if (!monitor.StartIngestion()) {
+            std::cerr << "Cannot start ingestion pipeline\n";
+            return 1;
+        }
+
+        auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(options.duration));
+        std::vector<std::thread> producers;
+        for (int i = 0; i < options.threads; ++i) {
+            SyntheticProfile profile = options.profile;
+            profile.seed += static_cast<uint64_t>(i) * 0x9E3779B97F4A7C15ULL;
+            producers.emplace_back(ProducerThread, std::ref(monitor), profile,
+                                   options.rate / options.threads, start, end,
+                                   options.wait, options.suspiciousEvery, std::ref(generated));
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+    }
+
+    auto producedAt = std::chrono::steady_clock::now();
+    monitor.Stop(); // Drains the queue
+    auto drainedAt = std::chrono::steady_clock::now();
+    recorder.Close();
+
+    PipelineStats stats = monitor.GetPipelineStats();
+    double produceSeconds = std::chrono::duration<double>(producedAt - start).count();
+    double totalSeconds = std::chrono::duration<double>(drainedAt - start).count();
+
+    std::ostringstream out;
+    out << "{\n"
+        << "  \"mode\": \"" << (options.replayFile.empty() ? "synthetic" : "replay") << "\",\n"
+        << "  \"threads\": " << options.threads << ",\n"
+        << "  \"names\": " << options.profile.nameCount << ",\n"
+        << "  \"skew\": " << options.profile.nameSkew << ",\n"
+        << "  \"paths\": " << options.profile.pathCount << ",\n"
+        << "  \"offeredRate\": " << options.rate << ",\n"
+        << "  \"generated\": " << generated << ",\n"
+        << "  \"submitted\": " << stats.submitted << ",\n"
+        << "  \"dropped\": " << stats.dropped << ",\n"
+        << "  \"processed\": " << stats.processed << ",\n"
+        << "  \"filtered\": " << stats.filtered << ",\n"
+        << "  \"prioritized\": " << stats.prioritized << ",\n"
+        << "  \"alerts\": " << stats.alerts << ",\n"
+        << "  \"alertsDropped\": " << stats.alertsDropped << ",\n"
+        << "  \"alertsSuppressed\": " << stats.alertsSuppressed << ",\n"
+        << "  \"alertSummaries\": " << stats.alertSummaries << ",\n"
+        << "  \"stored\": " << eventManager.GetEventCount() << ",\n"
+        << "  \"generateSeconds\": " << produceSeconds << ",\n"
+        << "  \"drainSeconds\": " << totalSeconds - produceSeconds << ",\n"
+        << "  \"generatedRate\": " << (produceSeconds > 0 ? generated / produceSeconds : 0.0) << ",\n"
+        << "  \"sustainedRate\": " << (totalSeconds > 0 ? stats.processed / totalSeconds : 0.0) << ",\n"
+        << "  \"queueCapacity\": " << stats.queueCapacity << ",\n"
+        << "  \"maxQueueDepth\": " << stats.maxQueueDepth << ",\n"
+        << "  \"stages\": {\n";
+    for (size_t i = 0; i < static_cast<size_t>(PipelineStage::Count); ++i) {
+        PipelineStage stage = static_cast<PipelineStage>(i);
+        WriteStage(out, GetPipelineStageName(stage), monitor.GetStageTiming(stage),
+                   i + 1 == static_cast<size_t>(PipelineStage::Count));
+    }
+    out << "  }\n"
+        << "}\n";
+
+    std::cout << out.str();
+    return 0;
+}